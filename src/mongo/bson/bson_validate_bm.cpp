@@ -0,0 +1,101 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bson_validate.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Builds a log-style document: an _id, a timestamp, a handful of short string and numeric fields
+ * and a nested object, padded out with 'numExtraFields' more short fields.
+ */
+BSONObj makeLogDocument(int i, int numExtraFields) {
+    BSONObjBuilder bob;
+    bob.append("_id", OID::gen());
+    bob.appendDate("ts", Date_t::fromMillisSinceEpoch(1546300800000LL + i));
+    bob.append("level", i % 10 == 0 ? "WARN" : "INFO");
+    bob.append("component", "NETWORK");
+    bob.append("msg", "connection accepted from 127.0.0.1:51234 #1234 (12 connections now open)");
+    bob.append("conn", i);
+    {
+        BSONObjBuilder attr(bob.subobjStart("attr"));
+        attr.append("remote", "127.0.0.1:51234");
+        attr.append("durationMillis", static_cast<long long>(i * 7));
+        attr.append("ok", true);
+    }
+    for (int j = 0; j < numExtraFields; j++) {
+        bob.append("field" + std::to_string(j), j);
+    }
+    return bob.obj();
+}
+
+void BM_validateLogDocuments(benchmark::State& state) {
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 1000; i++) {
+        docs.push_back(makeLogDocument(i, state.range(0)));
+    }
+
+    size_t totalBytes = 0;
+    for (auto _ : state) {
+        for (auto&& doc : docs) {
+            invariant(validateBSON(doc.objdata(), doc.objsize(), BSONVersion::kLatest).isOK());
+            totalBytes += doc.objsize();
+        }
+    }
+    state.SetBytesProcessed(totalBytes);
+    state.SetItemsProcessed(state.iterations() * docs.size());
+}
+
+void BM_validateLongFieldNames(benchmark::State& state) {
+    BSONObjBuilder bob;
+    for (int j = 0; j < 100; j++) {
+        bob.append(std::string(state.range(0), 'a' + j % 26) + std::to_string(j), j);
+    }
+    BSONObj doc = bob.obj();
+
+    size_t totalBytes = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(validateBSON(doc.objdata(), doc.objsize(), BSONVersion::kLatest));
+        totalBytes += doc.objsize();
+    }
+    state.SetBytesProcessed(totalBytes);
+}
+
+BENCHMARK(BM_validateLogDocuments)->Arg(0)->Arg(16)->Arg(128);
+BENCHMARK(BM_validateLongFieldNames)->Arg(4)->Arg(14)->Arg(32)->Arg(256);
+
+}  // namespace
+}  // namespace mongo
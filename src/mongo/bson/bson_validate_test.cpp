@@ -251,6 +251,23 @@ TEST(BSONValidateFast, NestedObject) {
     ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() / 2, BSONVersion::kLatest));
 }
 
+TEST(BSONValidateFast, FieldNamesOfAllLengths) {
+    // Field names are found with vector comparisons when enough of the buffer remains, so cover
+    // names on either side of the vector width and names that end near the end of the buffer.
+    for (size_t len = 1; len <= 40; len++) {
+        BSONObjBuilder b;
+        b.append(std::string(len, 'f'), 1);
+        b.appendNull(std::string(len, 'g'));
+        BSONObj x = b.obj();
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize(), BSONVersion::kLatest));
+
+        // Truncating the buffer within the last field name must be detected.
+        for (int truncated = x.objsize() - 2; truncated > x.objsize() - 2 - int(len); truncated--) {
+            ASSERT_NOT_OK(validateBSON(x.objdata(), truncated, BSONVersion::kLatest));
+        }
+    }
+}
+
 TEST(BSONValidateFast, ErrorWithId) {
     BufBuilder bb;
     BSONObjBuilder ob(bb);
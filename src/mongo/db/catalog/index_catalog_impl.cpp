@@ -33,6 +33,7 @@
 
 #include "mongo/db/catalog/index_catalog_impl.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "mongo/base/init.h"
@@ -44,6 +45,7 @@
 #include "mongo/db/catalog/disable_index_spec_namespace_generation_gen.h"
 #include "mongo/db/catalog/index_build_block.h"
 #include "mongo/db/catalog/index_catalog_entry_impl.h"
+#include "mongo/db/catalog/index_catalog_impl_gen.h"
 #include "mongo/db/catalog/index_key_validate.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
@@ -1290,33 +1292,63 @@ Status IndexCatalogImpl::_indexFilteredRecords(OperationContext* opCtx,
     InsertDeleteOptions options;
     prepareInsertDeleteOptions(opCtx, index->descriptor(), &options);
 
-    for (auto bsonRecord : bsonRecords) {
-        invariant(bsonRecord.id != RecordId());
+    const size_t minBatchSize = batchedIndexInsertMinDocuments.load();
+    auto runBegin = bsonRecords.begin();
+    while (runBegin != bsonRecords.end()) {
+        // Index keys must be written at the timestamp of the document they point to, so only
+        // consecutive records sharing a timestamp can have their keys reordered together.
+        const auto runEnd =
+            std::find_if(runBegin, bsonRecords.end(), [&](const BsonRecord& bsonRecord) {
+                return bsonRecord.ts != runBegin->ts;
+            });
 
-        if (!bsonRecord.ts.isNull()) {
-            Status status = opCtx->recoveryUnit()->setTimestamp(bsonRecord.ts);
+        if (!runBegin->ts.isNull()) {
+            Status status = opCtx->recoveryUnit()->setTimestamp(runBegin->ts);
             if (!status.isOK())
                 return status;
         }
 
-        BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
-        BSONObjSet multikeyMetadataKeys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
-        MultikeyPaths multikeyPaths;
-
-        index->accessMethod()->getKeys(
-            *bsonRecord.docPtr, options.getKeysMode, &keys, &multikeyMetadataKeys, &multikeyPaths);
-
-        Status status = _indexKeys(opCtx,
-                                   index,
-                                   {keys.begin(), keys.end()},
-                                   multikeyMetadataKeys,
-                                   multikeyPaths,
-                                   *bsonRecord.docPtr,
-                                   bsonRecord.id,
-                                   options,
-                                   keysInsertedOut);
-        if (!status.isOK()) {
-            return status;
+        const size_t runSize = std::distance(runBegin, runEnd);
+        if (minBatchSize > 0 && runSize >= minBatchSize && !index->isHybridBuilding()) {
+            InsertResult result;
+            Status status =
+                index->accessMethod()->insertBatch(opCtx, {runBegin, runEnd}, options, &result);
+            if (keysInsertedOut) {
+                *keysInsertedOut += result.numInserted;
+            }
+            if (!status.isOK()) {
+                return status;
+            }
+            runBegin = runEnd;
+            continue;
+        }
+
+        for (; runBegin != runEnd; ++runBegin) {
+            const auto& bsonRecord = *runBegin;
+            invariant(bsonRecord.id != RecordId());
+
+            BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+            BSONObjSet multikeyMetadataKeys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+            MultikeyPaths multikeyPaths;
+
+            index->accessMethod()->getKeys(*bsonRecord.docPtr,
+                                           options.getKeysMode,
+                                           &keys,
+                                           &multikeyMetadataKeys,
+                                           &multikeyPaths);
+
+            Status status = _indexKeys(opCtx,
+                                       index,
+                                       {keys.begin(), keys.end()},
+                                       multikeyMetadataKeys,
+                                       multikeyPaths,
+                                       *bsonRecord.docPtr,
+                                       bsonRecord.id,
+                                       options,
+                                       keysInsertedOut);
+            if (!status.isOK()) {
+                return status;
+            }
         }
     }
 
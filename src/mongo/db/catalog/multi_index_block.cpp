@@ -40,6 +40,7 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/multi_index_block_gen.h"
 #include "mongo/db/client.h"
+#include "mongo/db/concurrency/locker_noop.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/index/index_build_interceptor.h"
 #include "mongo/db/index/multikey_paths.h"
@@ -51,7 +52,9 @@
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/db/storage/write_unit_of_work.h"
 #include "mongo/logger/redaction.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/log.h"
 #include "mongo/util/progress_meter.h"
@@ -69,6 +72,131 @@ MONGO_FAIL_POINT_DEFINE(hangAfterIndexBuildOf);
 MONGO_FAIL_POINT_DEFINE(hangAndThenFailIndexBuild);
 MONGO_FAIL_POINT_DEFINE(leaveIndexBuildUnfinishedForShutdown);
 
+namespace {
+
+// Documents are handed to the key generation threads in batches of this many documents or bytes,
+// whichever is reached first.
+const size_t kKeyGenerationBatchDocs = 1024;
+const size_t kKeyGenerationBatchBytes = 16 * 1024 * 1024;
+
+}  // namespace
+
+/**
+ * Inserts the documents scanned by an index build into the bulk builders of its indexes on a pool
+ * of worker threads, with one task per index. Documents are collected into batches; while the
+ * workers generate the keys for one batch, the collection scan fills the next one.
+ */
+class MultiIndexBlock::ParallelKeyGenerator {
+public:
+    ParallelKeyGenerator(OperationContext* opCtx, MultiIndexBlock* block, size_t numThreads)
+        : _opCtx(opCtx), _block(block), _statuses(block->_indexes.size(), Status::OK()) {
+        ThreadPool::Options options;
+        options.poolName = "IndexBuildKeyGeneration";
+        options.threadNamePrefix = "indexBuildKeyGeneration-";
+        options.minThreads = 0;
+        options.maxThreads = numThreads;
+        _workers = std::make_unique<ThreadPool>(options);
+        _workers->startup();
+    }
+
+    ~ParallelKeyGenerator() {
+        _workers->shutdown();
+        _workers->join();
+    }
+
+    /**
+     * Adds an owned copy of 'doc' to the current batch and hands the batch to the workers once it
+     * is full. Returns an error if inserting an earlier batch failed.
+     */
+    Status insert(const BSONObj& doc, const RecordId& loc) {
+        _batchBytes += doc.objsize();
+        _batch.emplace_back(doc.getOwned(), loc);
+        if (_batch.size() < kKeyGenerationBatchDocs && _batchBytes < kKeyGenerationBatchBytes) {
+            return Status::OK();
+        }
+        return _flush();
+    }
+
+    /**
+     * Hands the last batch to the workers and waits for them to finish.
+     */
+    Status finish() {
+        Status status = _flush();
+        if (!status.isOK()) {
+            return status;
+        }
+        return _wait();
+    }
+
+private:
+    Status _flush() {
+        Status status = _wait();
+        if (!status.isOK()) {
+            return status;
+        }
+
+        if (State::kAborted == _block->_getState()) {
+            return {ErrorCodes::IndexBuildAborted,
+                    str::stream() << "Index build aborted: " << _block->_abortReason};
+        }
+
+        _inProgress.swap(_batch);
+        _batch.clear();
+        _batchBytes = 0;
+
+        for (size_t i = 0; i < _block->_indexes.size(); i++) {
+            _workers->schedule([this, i](auto scheduleStatus) {
+                invariant(scheduleStatus);
+                _statuses[i] = _insertBatch(&_block->_indexes[i]);
+            });
+        }
+        return Status::OK();
+    }
+
+    Status _insertBatch(IndexToBuild* index) {
+        try {
+            for (auto&& doc : _inProgress) {
+                if (index->filterExpression && !index->filterExpression->matchesBSON(doc.first)) {
+                    continue;
+                }
+
+                // The bulk builders only generate keys and add them to their external sorters, so
+                // they do not use the OperationContext.
+                Status status = index->bulk->insert(_opCtx, doc.first, doc.second, index->options);
+                if (!status.isOK()) {
+                    return status;
+                }
+            }
+        } catch (...) {
+            return exceptionToStatus();
+        }
+        return Status::OK();
+    }
+
+    Status _wait() {
+        _workers->waitForIdle();
+        for (auto&& status : _statuses) {
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+        return Status::OK();
+    }
+
+    OperationContext* const _opCtx;
+    MultiIndexBlock* const _block;
+
+    std::unique_ptr<ThreadPool> _workers;
+
+    // The batch being filled by the collection scan, and the batch the workers are inserting.
+    std::vector<std::pair<BSONObj, RecordId>> _batch;
+    size_t _batchBytes = 0;
+    std::vector<std::pair<BSONObj, RecordId>> _inProgress;
+
+    // The result of the last batch inserted into each index.
+    std::vector<Status> _statuses;
+};
+
 MultiIndexBlock::~MultiIndexBlock() {
     invariant(_buildIsCleanedUp);
 }
@@ -421,6 +549,15 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(OperationContext* opCtx,
         _method != IndexBuildMethod::kBackground && useReadOnceCursorsForIndexBuilds.load();
     opCtx->recoveryUnit()->setReadOnce(readOnce);
 
+    // Bulk builders only add keys to external sorters, so unless this is a background build the
+    // keys can be generated on other threads while this one continues scanning the collection.
+    std::unique_ptr<ParallelKeyGenerator> keyGenerator;
+    const size_t maxThreads = maxIndexBuildThreads.load();
+    if (_method != IndexBuildMethod::kBackground && maxThreads > 1) {
+        keyGenerator = std::make_unique<ParallelKeyGenerator>(
+            opCtx, this, std::min(maxThreads, _indexes.size()));
+    }
+
     Snapshotted<BSONObj> objToIndex;
     RecordId loc;
     PlanExecutor::ExecState state;
@@ -450,20 +587,27 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(OperationContext* opCtx,
 
             failPointHangDuringBuild(&hangBeforeIndexBuildOf, "before", objToIndex.value());
 
-            WriteUnitOfWork wunit(opCtx);
-            Status ret = insert(opCtx, objToIndex.value(), loc);
-            if (_method == IndexBuildMethod::kBackground)
-                exec->saveState();
-            if (!ret.isOK()) {
-                // Fail the index build hard.
-                return ret;
-            }
-            wunit.commit();
-            if (_method == IndexBuildMethod::kBackground) {
-                try {
-                    exec->restoreState();  // Handles any WCEs internally.
-                } catch (...) {
-                    return exceptionToStatus();
+            if (keyGenerator) {
+                Status ret = keyGenerator->insert(objToIndex.value(), loc);
+                if (!ret.isOK()) {
+                    return ret;
+                }
+            } else {
+                WriteUnitOfWork wunit(opCtx);
+                Status ret = insert(opCtx, objToIndex.value(), loc);
+                if (_method == IndexBuildMethod::kBackground)
+                    exec->saveState();
+                if (!ret.isOK()) {
+                    // Fail the index build hard.
+                    return ret;
+                }
+                wunit.commit();
+                if (_method == IndexBuildMethod::kBackground) {
+                    try {
+                        exec->restoreState();  // Handles any WCEs internally.
+                    } catch (...) {
+                        return exceptionToStatus();
+                    }
                 }
             }
 
@@ -498,6 +642,13 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(OperationContext* opCtx,
         return exec->getMemberObjectStatus(objToIndex.value());
     }
 
+    if (keyGenerator) {
+        Status ret = keyGenerator->finish();
+        if (!ret.isOK()) {
+            return ret;
+        }
+    }
+
     if (MONGO_FAIL_POINT(leaveIndexBuildUnfinishedForShutdown)) {
         log() << "Index build interrupted due to 'leaveIndexBuildUnfinishedForShutdown' failpoint. "
                  "Mimicing shutdown error code.";
@@ -575,41 +726,68 @@ Status MultiIndexBlock::dumpInsertsFromBulk(OperationContext* opCtx,
     }
 
     invariant(opCtx->lockState()->isNoop() || !opCtx->lockState()->inAWriteUnitOfWork());
+
+    std::vector<size_t> bulkIndexes;
     for (size_t i = 0; i < _indexes.size(); i++) {
-        if (_indexes[i].bulk == nullptr)
-            continue;
+        if (_indexes[i].bulk)
+            bulkIndexes.push_back(i);
+    }
 
-        // If 'dupRecords' is provided, it will be used to store all records that would result in
-        // duplicate key errors. Only pass 'dupKeysInserted', which stores inserted duplicate keys,
-        // when 'dupRecords' is not used because these two vectors are mutually incompatible.
-        std::vector<BSONObj> dupKeysInserted;
+    // If 'dupRecords' is provided, it will be used to store all records that would result in
+    // duplicate key errors. Only pass 'dupKeysInserted', which stores inserted duplicate keys,
+    // when 'dupRecords' is not used because these two vectors are mutually incompatible. Each index
+    // gets its own output so that the indexes can be loaded concurrently.
+    std::vector<std::set<RecordId>> dupRecordsPerIndex(_indexes.size());
+    std::vector<std::vector<BSONObj>> dupKeysInserted(_indexes.size());
 
+    auto commitBulk = [&](OperationContext* indexOpCtx, size_t i) {
         // When dupRecords is passed, 'dupsAllowed' should be passed to reflect whether or not the
         // index is unique.
         bool dupsAllowed = (dupRecords) ? !_indexes[i].block->getEntry()->descriptor()->unique()
                                         : _indexes[i].options.dupsAllowed;
 
-        IndexCatalogEntry* entry = _indexes[i].block->getEntry();
         LOG(1) << "index build: inserting from external sorter into index: "
-               << entry->descriptor()->indexName();
-        Status status = _indexes[i].real->commitBulk(opCtx,
-                                                     _indexes[i].bulk.get(),
-                                                     dupsAllowed,
-                                                     dupRecords,
-                                                     (dupRecords) ? nullptr : &dupKeysInserted);
+               << _indexes[i].block->getEntry()->descriptor()->indexName();
+        return _indexes[i].real->commitBulk(indexOpCtx,
+                                            _indexes[i].bulk.get(),
+                                            dupsAllowed,
+                                            (dupRecords) ? &dupRecordsPerIndex[i] : nullptr,
+                                            (dupRecords) ? nullptr : &dupKeysInserted[i]);
+    };
+
+    // Each index is loaded through its own bulk cursor, so several indexes can be loaded at once.
+    // Writes which must be timestamped are left on this operation.
+    const size_t maxThreads = maxIndexBuildThreads.load();
+    if (maxThreads > 1 && bulkIndexes.size() > 1 &&
+        opCtx->recoveryUnit()->getCommitTimestamp().isNull()) {
+        Status status = _runPerIndexConcurrently(
+            opCtx, bulkIndexes, std::min(maxThreads, bulkIndexes.size()), commitBulk);
         if (!status.isOK()) {
             return status;
         }
+    } else {
+        for (size_t i : bulkIndexes) {
+            Status status = commitBulk(opCtx, i);
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+    }
+
+    for (size_t i : bulkIndexes) {
+        if (dupRecords) {
+            dupRecords->insert(dupRecordsPerIndex[i].begin(), dupRecordsPerIndex[i].end());
+        }
 
         // Do not record duplicates when explicitly ignored. This may be the case on secondaries.
-        auto interceptor = entry->indexBuildInterceptor();
+        auto interceptor = _indexes[i].block->getEntry()->indexBuildInterceptor();
         if (!interceptor || _ignoreUnique) {
             continue;
         }
 
         // Record duplicate key insertions for later verification.
-        if (dupKeysInserted.size()) {
-            status = interceptor->recordDuplicateKeys(opCtx, dupKeysInserted);
+        if (dupKeysInserted[i].size()) {
+            Status status = interceptor->recordDuplicateKeys(opCtx, dupKeysInserted[i]);
             if (!status.isOK()) {
                 return status;
             }
@@ -619,6 +797,91 @@ Status MultiIndexBlock::dumpInsertsFromBulk(OperationContext* opCtx,
     return Status::OK();
 }
 
+Status MultiIndexBlock::_runPerIndexConcurrently(
+    OperationContext* opCtx,
+    const std::vector<size_t>& indexes,
+    size_t numThreads,
+    const std::function<Status(OperationContext*, size_t)>& fn) {
+    struct Worker {
+        ServiceContext::UniqueClient client;
+        Client* clientPtr = nullptr;
+        ServiceContext::UniqueOperationContext opCtx;
+        Status status = Status::OK();
+    };
+
+    // The workers run while this operation holds its locks, so they do not lock anything
+    // themselves.
+    std::vector<Worker> workers(indexes.size());
+    for (size_t i = 0; i < indexes.size(); i++) {
+        auto& worker = workers[i];
+        worker.client = opCtx->getServiceContext()->makeClient(
+            str::stream() << "indexBuildBulkLoad-"
+                          << _indexes[indexes[i]].block->getEntry()->descriptor()->indexName());
+        worker.clientPtr = worker.client.get();
+        worker.opCtx = worker.client->makeOperationContext();
+        worker.opCtx->swapLockState(std::make_unique<LockerNoop>());
+    }
+
+    ThreadPool::Options options;
+    options.poolName = "IndexBuildBulkLoad";
+    options.threadNamePrefix = "indexBuildBulkLoad-";
+    options.minThreads = 0;
+    options.maxThreads = numThreads;
+    ThreadPool pool(options);
+    pool.startup();
+
+    stdx::mutex mutex;
+    stdx::condition_variable finishedCV;
+    size_t numRunning = workers.size();
+    for (size_t i = 0; i < workers.size(); i++) {
+        pool.schedule([&, i](auto scheduleStatus) {
+            invariant(scheduleStatus);
+            {
+                AlternativeClientRegion acr(workers[i].client);
+                try {
+                    workers[i].status = fn(workers[i].opCtx.get(), indexes[i]);
+                } catch (...) {
+                    workers[i].status = exceptionToStatus();
+                }
+            }
+
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            if (--numRunning == 0) {
+                finishedCV.notify_all();
+            }
+        });
+    }
+
+    // If this operation is interrupted while it waits, interrupt the workers too, but still wait
+    // for them to stop before returning.
+    Status interruptStatus = Status::OK();
+    {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        interruptStatus = opCtx->waitForConditionOrInterruptNoAssert(
+            finishedCV, lk, [&] { return numRunning == 0; });
+        if (!interruptStatus.isOK()) {
+            for (auto&& worker : workers) {
+                stdx::lock_guard<Client> clientLock(*worker.clientPtr);
+                opCtx->getServiceContext()->killOperation(
+                    clientLock, worker.opCtx.get(), interruptStatus.code());
+            }
+            finishedCV.wait(lk, [&] { return numRunning == 0; });
+        }
+    }
+    pool.shutdown();
+    pool.join();
+
+    if (!interruptStatus.isOK()) {
+        return interruptStatus;
+    }
+    for (auto&& worker : workers) {
+        if (!worker.status.isOK()) {
+            return worker.status;
+        }
+    }
+    return Status::OK();
+}
+
 Status MultiIndexBlock::drainBackgroundWrites(OperationContext* opCtx,
                                               RecoveryUnit::ReadSource readSource) {
     if (State::kAborted == _getState()) {
@@ -305,6 +305,18 @@ private:
         InsertDeleteOptions options;
     };
 
+    class ParallelKeyGenerator;
+
+    /**
+     * Calls 'fn' for each of the positions in '_indexes' listed in 'indexes' on a pool of up to
+     * 'numThreads' threads. Each call is given an OperationContext of its own, which is interrupted
+     * if 'opCtx' is. Returns the first error any of the calls returned.
+     */
+    Status _runPerIndexConcurrently(OperationContext* opCtx,
+                                    const std::vector<size_t>& indexes,
+                                    size_t numThreads,
+                                    const std::function<Status(OperationContext*, size_t)>& fn);
+
     Status _dumpInsertsFromBulk(std::set<RecordId>* dupRecords,
                                 std::vector<BSONObj>* dupKeysInserted);
 
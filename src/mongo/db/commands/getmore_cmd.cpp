@@ -50,6 +50,7 @@
 #include "mongo/db/query/getmore_request.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/read_concern.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator.h"
@@ -528,7 +529,9 @@ public:
 
             CursorId respondWithId = 0;
 
-            CursorResponseBuilder nextBatch(reply, CursorResponseBuilder::Options());
+            CursorResponseBuilder::Options batchOptions;
+            batchOptions.spliceThresholdBytes = internalQueryReplySpliceThresholdBytes.load();
+            CursorResponseBuilder nextBatch(reply, batchOptions);
             BSONObj obj;
             PlanExecutor::ExecState state = PlanExecutor::ADVANCED;
             std::uint64_t numResults = 0;
@@ -42,6 +42,11 @@ namespace {
 
 const int kMaxPerfThreads = 16;  // max number of threads to use for lock perf
 
+// Thread counts for measuring how intent locks on the global, RSTL and database resources scale on
+// machines with many cores.
+const int kManyCoreThreads = 64;
+const int kMaxManyCoreThreads = 128;
+
 
 class DConcurrencyTest : public benchmark::Fixture {
 public:
@@ -128,6 +133,23 @@ BENCHMARK_DEFINE_F(DConcurrencyTest, BM_CollectionIntentExclusiveLock)(benchmark
     }
 }
 
+BENCHMARK_DEFINE_F(DConcurrencyTest, BM_DBIntentExclusiveLock)(benchmark::State& state) {
+    std::unique_ptr<ForceSupportsDocLocking> supportDocLocking;
+
+    if (state.thread_index == 0) {
+        makeKClientsWithLockers(state.threads);
+        supportDocLocking = std::make_unique<ForceSupportsDocLocking>(true);
+    }
+
+    for (auto keepRunning : state) {
+        Lock::DBLock dlk(clients[state.thread_index].second.get(), "test", MODE_IX);
+    }
+
+    if (state.thread_index == 0) {
+        clients.clear();
+    }
+}
+
 BENCHMARK_DEFINE_F(DConcurrencyTest, BM_MMAPv1CollectionSharedLock)(benchmark::State& state) {
     std::unique_ptr<ForceSupportsDocLocking> supportDocLocking;
 
@@ -176,6 +198,17 @@ BENCHMARK_REGISTER_F(DConcurrencyTest, BM_CollectionIntentSharedLock)
 BENCHMARK_REGISTER_F(DConcurrencyTest, BM_CollectionIntentExclusiveLock)
     ->ThreadRange(1, kMaxPerfThreads);
 
+BENCHMARK_REGISTER_F(DConcurrencyTest, BM_DBIntentExclusiveLock)
+    ->ThreadRange(1, kMaxPerfThreads)
+    ->Threads(kManyCoreThreads)
+    ->Threads(kMaxManyCoreThreads);
+BENCHMARK_REGISTER_F(DConcurrencyTest, BM_CollectionIntentSharedLock)
+    ->Threads(kManyCoreThreads)
+    ->Threads(kMaxManyCoreThreads);
+BENCHMARK_REGISTER_F(DConcurrencyTest, BM_CollectionIntentExclusiveLock)
+    ->Threads(kManyCoreThreads)
+    ->Threads(kMaxManyCoreThreads);
+
 BENCHMARK_REGISTER_F(DConcurrencyTest, BM_MMAPv1CollectionSharedLock)
     ->ThreadRange(1, kMaxPerfThreads);
 BENCHMARK_REGISTER_F(DConcurrencyTest, BM_MMAPv1CollectionExclusiveLock)
@@ -33,6 +33,10 @@
 
 #include "mongo/db/concurrency/lock_manager.h"
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 #include "mongo/base/data_type_endian.h"
 #include "mongo/base/data_view.h"
 #include "mongo/base/static_assert.h"
@@ -41,6 +45,7 @@
 #include "mongo/db/catalog/collection_catalog.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/locker.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/str.h"
@@ -393,11 +398,27 @@ void LockHead::migratePartitionedLockHeads() {
 // Have more buckets than CPUs to reduce contention on lock and caches
 const unsigned LockManager::_numLockBuckets(128);
 
-// Balance scalability of intent locks against potential added cost of conflicting locks.
-// The exact value doesn't appear very important, but should be power of two
-const unsigned LockManager::_numPartitions = 32;
+namespace {
+
+// Balance scalability of intent locks against potential added cost of conflicting locks, which
+// must migrate every partition in use. Intent partitions are keyed by CPU, so there should be at
+// least one per CPU for the intent fast path to stay uncontended on large machines. The number
+// must be a power of two.
+const unsigned kMinNumPartitions = 32;
+const unsigned kMaxNumPartitions = 1024;
+
+unsigned computeNumPartitions() {
+    const unsigned numCpus = stdx::thread::hardware_concurrency();
+    unsigned numPartitions = kMinNumPartitions;
+    while (numPartitions < numCpus && numPartitions < kMaxNumPartitions) {
+        numPartitions *= 2;
+    }
+    return numPartitions;
+}
+
+}  // namespace
 
-LockManager::LockManager() {
+LockManager::LockManager() : _numPartitions(computeNumPartitions()) {
     _lockBuckets = new LockBucket[_numLockBuckets];
     _partitions = new Partition[_numPartitions];
 }
@@ -424,6 +445,7 @@ LockResult LockManager::lock(ResourceId resId, LockRequest* request, LockMode mo
 
     // For intent modes, try the PartitionedLockHead
     if (request->partitioned) {
+        request->partitionIndex = _choosePartition(request);
         Partition* partition = _getPartition(request);
         stdx::lock_guard<SimpleMutex> scopedLock(partition->mutex);
 
@@ -792,8 +814,21 @@ LockManager::LockBucket* LockManager::_getBucket(ResourceId resId) const {
     return &_lockBuckets[resId % _numLockBuckets];
 }
 
+unsigned LockManager::_choosePartition(LockRequest* request) const {
+#if defined(__linux__)
+    const int cpu = sched_getcpu();
+    if (cpu >= 0) {
+        return static_cast<unsigned>(cpu) & (_numPartitions - 1);
+    }
+#elif defined(_WIN32)
+    return static_cast<unsigned>(GetCurrentProcessorNumber()) & (_numPartitions - 1);
+#endif
+    return request->locker->getId() & (_numPartitions - 1);
+}
+
 LockManager::Partition* LockManager::_getPartition(LockRequest* request) const {
-    return &_partitions[request->locker->getId() % _numPartitions];
+    invariant(request->partitionIndex < _numPartitions);
+    return &_partitions[request->partitionIndex];
 }
 
 void LockManager::dump() const {
@@ -996,6 +1031,7 @@ void LockRequest::initNew(Locker* locker, LockGrantNotification* notify) {
     next = nullptr;
     status = STATUS_NEW;
     partitioned = false;
+    partitionIndex = 0;
     mode = MODE_NONE;
     convertMode = MODE_NONE;
     unlockPending = 0;
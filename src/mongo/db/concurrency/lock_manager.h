@@ -42,6 +42,7 @@
 #include "mongo/platform/compiler.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/stdx/new.h"
 #include "mongo/stdx/unordered_map.h"
 #include "mongo/util/concurrency/mutex.h"
 
@@ -146,10 +147,11 @@ private:
         LockHead* findOrInsert(ResourceId resId);
     };
 
-    // Each locker maps to a partition that is used for resources acquired in intent modes
-    // modes and potentially other modes that don't conflict with themselves. This avoids
-    // contention on the regular LockHead in the lock manager.
-    struct Partition {
+    // Each request for a resource in intent modes (and potentially other modes that don't conflict
+    // with themselves) maps to a partition chosen by the CPU the locking thread runs on. This
+    // avoids contention on the regular LockHead in the lock manager. Partitions are cache line
+    // aligned so that neighbouring partition mutexes do not share a line.
+    struct alignas(stdx::hardware_destructive_interference_size) Partition {
         PartitionedLockHead* find(ResourceId resId);
         PartitionedLockHead* findOrInsert(ResourceId resId);
         typedef stdx::unordered_map<ResourceId, PartitionedLockHead*> Map;
@@ -164,6 +166,14 @@ private:
     LockBucket* _getBucket(ResourceId resId) const;
 
 
+    /**
+     * Assigns a partition to a LockRequest which is about to be locked in an intent mode. The
+     * partition is keyed by the CPU the calling thread currently runs on, so that threads running
+     * concurrently on different CPUs rarely share a partition mutex. Falls back to the locker id
+     * on platforms which cannot report the current CPU.
+     */
+    unsigned _choosePartition(LockRequest* request) const;
+
     /**
      * Retrieves the Partition that a particular LockRequest should use for intent locking.
      */
@@ -213,7 +223,8 @@ private:
     static const unsigned _numLockBuckets;
     LockBucket* _lockBuckets;
 
-    static const unsigned _numPartitions;
+    // Always a power of two, so that a CPU number can be mapped to a partition with a mask
+    const unsigned _numPartitions;
     Partition* _partitions;
 };
 }  // namespace mongo
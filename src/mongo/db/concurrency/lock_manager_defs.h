@@ -398,6 +398,15 @@ struct LockRequest {
     // No synchronization
     bool partitioned;
 
+    // Index of the LockManager partition which this request was assigned to when it was first
+    // locked, so that unlock finds the same partition even if the thread has since moved to a
+    // different CPU. Only meaningful if 'partitioned' is set.
+    //
+    // Written by LockManager on Locker thread
+    // Read by LockManager on Locker thread
+    // No synchronization
+    unsigned partitionIndex;
+
     // How many times has LockManager::lock been called for this request. Locks are released when
     // their recursive count drops to zero.
     //
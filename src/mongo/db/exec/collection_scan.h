@@ -33,6 +33,7 @@
 
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/requires_collection_stage.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
 #include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/record_id.h"
 
@@ -60,6 +61,7 @@ public:
                    const MatchExpression* filter);
 
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxBatchSize, std::vector<WorkingSetID>* out) final;
     bool isEOF() final;
 
     void doDetachFromOperationContext() final;
@@ -73,6 +75,14 @@ public:
         return _latestOplogEntryTimestamp;
     }
 
+    bool isTailable() const {
+        return _params.tailable;
+    }
+
+    bool tracksLatestOplogTimestamp() const {
+        return _params.shouldTrackLatestOplogTimestamp;
+    }
+
     std::unique_ptr<PlanStageStats> getStats() final;
 
     const SpecificStats* getSpecificStats() const final;
@@ -102,6 +112,9 @@ private:
     // The filter is not owned by us.
     const MatchExpression* _filter;
 
+    // The compiled form of '_filter', or null if it was not compiled.
+    std::unique_ptr<CompiledMatchExpression> _compiledFilter;
+
     // If a document does not pass '_filter' but passes '_endCondition', stop scanning and return
     // IS_EOF.
     BSONObj _endConditionBSON;
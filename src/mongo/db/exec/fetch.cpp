@@ -38,6 +38,7 @@
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/str.h"
 
@@ -59,6 +60,9 @@ FetchStage::FetchStage(OperationContext* opCtx,
       _filter(filter),
       _idRetrying(WorkingSet::INVALID_ID) {
     _children.emplace_back(child);
+    if (_filter && internalQueryCompileMatchExpressions.load()) {
+        _compiledFilter = CompiledMatchExpression::compile(_filter);
+    }
 }
 
 FetchStage::~FetchStage() {}
@@ -69,7 +73,7 @@ bool FetchStage::isEOF() {
         return false;
     }
 
-    return child()->isEOF();
+    return _lookahead.empty() && child()->isEOF();
 }
 
 PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
@@ -80,12 +84,17 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     // Either retry the last WSM we worked on or get a new one from our child.
     WorkingSetID id;
     StageState status;
-    if (_idRetrying == WorkingSet::INVALID_ID) {
-        status = child()->work(&id);
-    } else {
+    if (_idRetrying != WorkingSet::INVALID_ID) {
         status = ADVANCED;
         id = _idRetrying;
         _idRetrying = WorkingSet::INVALID_ID;
+    } else if (!_lookahead.empty()) {
+        status = ADVANCED;
+        id = _lookahead.front();
+        _lookahead.pop_front();
+    } else {
+        const int batchSize = internalQueryFetchPrefetchBatchSize.load();
+        status = batchSize > 1 ? readAhead(batchSize, &id) : child()->work(&id);
     }
 
     if (PlanStage::ADVANCED == status) {
@@ -131,6 +140,65 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState FetchStage::doWorkBatch(size_t maxBatchSize,
+                                              std::vector<WorkingSetID>* out) {
+    return fillBatch(
+        _ws, maxBatchSize, out, [this](WorkingSetID* id) { return FetchStage::doWork(id); });
+}
+
+PlanStage::StageState FetchStage::readAhead(size_t batchSize, WorkingSetID* out) {
+    invariant(_lookahead.empty());
+
+    std::vector<RecordId> toPrefetch;
+    StageState status = NEED_TIME;
+    WorkingSetID id = WorkingSet::INVALID_ID;
+
+    // Each call to the child counts against the batch, so that a child which mostly returns
+    // NEED_TIME does not hold up this call for long.
+    for (size_t i = 0; i < batchSize; ++i) {
+        id = WorkingSet::INVALID_ID;
+        status = child()->work(&id);
+        if (ADVANCED == status) {
+            _lookahead.push_back(id);
+            WorkingSetMember* member = _ws->get(id);
+            // Ensure that the BSONObj underlying the WorkingSetMember is owned in case we yield
+            // before it is returned.
+            member->makeObjOwnedIfNeeded();
+            if (!member->hasObj()) {
+                toPrefetch.push_back(member->recordId);
+            }
+        } else if (NEED_TIME != status) {
+            break;
+        }
+    }
+
+    if (!toPrefetch.empty()) {
+        try {
+            if (!_cursor)
+                _cursor = collection()->getCursor(getOpCtx());
+            _cursor->prefetch(toPrefetch);
+            _specificStats.docsPrefetched += toPrefetch.size();
+        } catch (const WriteConflictException&) {
+            // Prefetching is only a hint, so it is fine to skip it.
+        }
+    }
+
+    if (NEED_YIELD == status || FAILURE == status) {
+        // The buffered results are returned after the yield. On failure they are never returned.
+        *out = id;
+        return status;
+    }
+
+    if (_lookahead.empty()) {
+        *out = WorkingSet::INVALID_ID;
+        return IS_EOF == status ? IS_EOF : NEED_TIME;
+    }
+
+    *out = _lookahead.front();
+    _lookahead.pop_front();
+    return ADVANCED;
+}
+
 void FetchStage::doSaveStateRequiresCollection() {
     if (_cursor) {
         _cursor->saveUnpositioned();
@@ -173,7 +241,7 @@ PlanStage::StageState FetchStage::returnIfMatches(WorkingSetMember* member,
     // predicate.
     ++_specificStats.docsExamined;
 
-    if (Filter::passes(member, _filter)) {
+    if (Filter::passes(member, _filter, _compiledFilter.get())) {
         *out = memberID;
         return PlanStage::ADVANCED;
     } else {
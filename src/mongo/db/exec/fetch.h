@@ -29,10 +29,12 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 
 #include "mongo/db/exec/requires_collection_stage.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
 
@@ -60,6 +62,7 @@ public:
 
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxBatchSize, std::vector<WorkingSetID>* out) final;
 
     void doDetachFromOperationContext() final;
     void doReattachToOperationContext() final;
@@ -86,6 +89,14 @@ private:
      */
     StageState returnIfMatches(WorkingSetMember* member, WorkingSetID memberID, WorkingSetID* out);
 
+    /**
+     * Works the child until up to 'batchSize' results are buffered in '_lookahead', asks the
+     * storage engine to prefetch the documents they need, and then returns the first of them.
+     * Follows the same contract as child()->work(), so that yields, failures and EOF from the
+     * child are returned as soon as they happen.
+     */
+    StageState readAhead(size_t batchSize, WorkingSetID* out);
+
     // Used to fetch Records from _collection.
     std::unique_ptr<SeekableRecordCursor> _cursor;
 
@@ -95,9 +106,16 @@ private:
     // The filter is not owned by us.
     const MatchExpression* _filter;
 
+    // The compiled form of '_filter', or null if it was not compiled.
+    std::unique_ptr<CompiledMatchExpression> _compiledFilter;
+
     // If not Null, we use this rather than asking our child what to do next.
     WorkingSetID _idRetrying;
 
+    // Results which readAhead() read from the child but which have not been returned yet, in the
+    // order in which the child returned them.
+    std::deque<WorkingSetID> _lookahead;
+
     // Stats
     FetchStats _specificStats;
 };
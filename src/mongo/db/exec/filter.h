@@ -30,6 +30,7 @@
 #pragma once
 
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/matcher/matchable.h"
 
@@ -158,6 +159,19 @@ public:
         return filter->matches(&doc, nullptr);
     }
 
+    /**
+     * Like passes() above, but if 'wsm' has a document, evaluates 'compiled' against it instead.
+     * 'compiled' must be null or have been compiled from 'filter'.
+     */
+    static bool passes(WorkingSetMember* wsm,
+                       const MatchExpression* filter,
+                       CompiledMatchExpression* compiled) {
+        if (compiled && wsm->hasObj()) {
+            return compiled->matchesBSON(wsm->obj.value());
+        }
+        return passes(wsm, filter);
+    }
+
     static bool passes(const BSONObj& keyData,
                        const BSONObj& keyPattern,
                        const MatchExpression* filter) {
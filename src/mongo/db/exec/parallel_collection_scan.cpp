@@ -0,0 +1,456 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/parallel_collection_scan.h"
+
+#include <algorithm>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/concurrency/locker_noop.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/db/service_context.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+
+namespace {
+
+// The number of RecordIds sampled for each range when choosing the range boundaries.
+const size_t kSamplesPerPartition = 8;
+
+/**
+ * The worker threads are shared by every ParallelCollectionScan in the process, so that concurrent
+ * scans cannot start more threads than there are cores to run them. The pool is started the first
+ * time a scan needs it.
+ */
+class WorkerPool {
+public:
+    ~WorkerPool() {
+        if (_pool) {
+            _pool->shutdown();
+            _pool->join();
+        }
+    }
+
+    ThreadPool* get() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (!_pool) {
+            ThreadPool::Options options;
+            options.poolName = "ParallelCollectionScan";
+            options.threadNamePrefix = "parallelCollectionScan-";
+            options.minThreads = 0;
+            options.maxThreads = std::max(ProcessInfo::getNumAvailableCores(), 1UL);
+            _pool = std::make_unique<ThreadPool>(options);
+            _pool->startup();
+        }
+        return _pool.get();
+    }
+
+private:
+    stdx::mutex _mutex;
+    std::unique_ptr<ThreadPool> _pool;
+};
+
+const auto getWorkerPool = ServiceContext::declareDecoration<WorkerPool>();
+
+/**
+ * Returns false if 'expr' contains a predicate which cannot be evaluated concurrently on another
+ * thread: $expr and $where depend on per-operation state, and $text needs the text index.
+ */
+bool canMatchOffThread(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::EXPRESSION:
+        case MatchExpression::TEXT:
+        case MatchExpression::WHERE:
+            return false;
+        default:
+            break;
+    }
+
+    for (size_t i = 0; i < expr->numChildren(); ++i) {
+        if (!canMatchOffThread(expr->getChild(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+// static
+const char* ParallelCollectionScan::kStageType = "PARALLEL_COLLSCAN";
+
+struct ParallelCollectionScan::Partition {
+    // The first RecordId in the range, or null for the first range.
+    RecordId start;
+
+    // The RecordId which follows the range, or null for the last range.
+    RecordId end;
+
+    ServiceContext::UniqueClient client;
+    ServiceContext::UniqueOperationContext opCtx;
+    std::unique_ptr<SeekableRecordCursor> cursor;
+
+    // This partition's own copy of the stage's filter. MatchExpressions are not safe to evaluate
+    // on several threads at once, so the workers never share one.
+    std::unique_ptr<MatchExpression> filter;
+
+    // Set once the cursor has been positioned at 'start'.
+    bool positioned = false;
+
+    // Set if the record at 'start' was deleted before the cursor could be positioned.
+    bool startMissing = false;
+
+    // Set once the cursor has read past 'end'.
+    bool exhausted = false;
+
+    size_t docsTested = 0;
+    Status status = Status::OK();
+
+    // The matching records read during the last round, owned.
+    std::vector<std::pair<RecordId, BSONObj>> results;
+};
+
+ParallelCollectionScan::ParallelCollectionScan(OperationContext* opCtx,
+                                               const Collection* collection,
+                                               WorkingSet* workingSet,
+                                               const MatchExpression* filter)
+    : RequiresCollectionStage(kStageType, opCtx, collection),
+      _workingSet(workingSet),
+      _filter(filter),
+      _maxParallelism(internalQueryMaxParallelCollectionScanThreads.load()),
+      _recordsPerRound(internalQueryParallelCollectionScanRecordsPerRound.load()) {}
+
+// Every round waits for its workers to finish, so no worker can be running on behalf of this stage
+// by the time it is destroyed.
+ParallelCollectionScan::~ParallelCollectionScan() = default;
+
+// static
+bool ParallelCollectionScan::canScanInParallel(OperationContext* opCtx,
+                                               const Collection* collection,
+                                               const CollectionScanParams& params,
+                                               const MatchExpression* filter) {
+    if (internalQueryMaxParallelCollectionScanThreads.load() <= 1) {
+        return false;
+    }
+
+    if (params.direction != CollectionScanParams::FORWARD || params.tailable || params.maxTs ||
+        !params.start.isNull() || params.shouldTrackLatestOplogTimestamp ||
+        params.shouldWaitForOplogVisibility) {
+        return false;
+    }
+
+    if (collection->isCapped() || collection->ns().isOplog()) {
+        return false;
+    }
+
+    // Each worker reads the latest data on its own snapshot, which is only acceptable for reads
+    // that would otherwise observe the same data across yields.
+    if (opCtx->getTxnNumber() || opCtx->lockState()->inAWriteUnitOfWork()) {
+        return false;
+    }
+    const auto readSource = opCtx->recoveryUnit()->getTimestampReadSource();
+    if (readSource != RecoveryUnit::ReadSource::kUnset &&
+        readSource != RecoveryUnit::ReadSource::kNoTimestamp) {
+        return false;
+    }
+
+    return !filter || canMatchOffThread(filter);
+}
+
+PlanStage::StageState ParallelCollectionScan::doWork(WorkingSetID* out) {
+    if (_commonStats.isEOF) {
+        return PlanStage::IS_EOF;
+    }
+
+    if (_partitions.empty()) {
+        try {
+            initPartitions();
+        } catch (const WriteConflictException&) {
+            *out = WorkingSet::INVALID_ID;
+            return PlanStage::NEED_YIELD;
+        }
+        return PlanStage::NEED_TIME;
+    }
+
+    // Return the results of the last round before starting the next one.
+    while (_currentPartition < _partitions.size()) {
+        auto& results = _partitions[_currentPartition]->results;
+        if (_currentResult < results.size()) {
+            auto& result = results[_currentResult++];
+
+            WorkingSetID id = _workingSet->allocate();
+            WorkingSetMember* member = _workingSet->get(id);
+            member->recordId = result.first;
+            member->obj = {getOpCtx()->recoveryUnit()->getSnapshotId(), std::move(result.second)};
+            _workingSet->transitionToRecordIdAndObj(id);
+
+            *out = id;
+            return PlanStage::ADVANCED;
+        }
+        ++_currentPartition;
+        _currentResult = 0;
+    }
+
+    const bool positioning = std::any_of(
+        _partitions.begin(), _partitions.end(), [](const auto& p) { return !p->positioned; });
+    if (!positioning && std::all_of(_partitions.begin(), _partitions.end(), [](const auto& p) {
+            return p->exhausted;
+        })) {
+        _commonStats.isEOF = true;
+        return PlanStage::IS_EOF;
+    }
+
+    runRound(positioning);
+    _currentPartition = 0;
+    _currentResult = 0;
+
+    for (auto&& partition : _partitions) {
+        if (!partition->status.isOK()) {
+            *out = WorkingSetCommon::allocateStatusMember(_workingSet, partition->status);
+            return PlanStage::FAILURE;
+        }
+    }
+
+    if (positioning && std::all_of(_partitions.begin(), _partitions.end(), [](const auto& p) {
+            return p->positioned;
+        })) {
+        mergeUnpositionedPartitions();
+    }
+
+    return PlanStage::NEED_TIME;
+}
+
+void ParallelCollectionScan::initPartitions() {
+    OperationContext* opCtx = getOpCtx();
+    const RecordStore* rs = collection()->getRecordStore();
+
+    // Split the collection at RecordIds chosen from a random sample. Collections which are too
+    // small to give every worker a full round, or whose storage engine cannot sample them, are
+    // read as a single range.
+    std::vector<RecordId> boundaries;
+    const size_t parallelism = std::min(
+        _maxParallelism, static_cast<size_t>(rs->numRecords(opCtx)) / _recordsPerRound);
+    if (parallelism > 1) {
+        if (auto randomCursor = rs->getRandomCursor(opCtx)) {
+            std::vector<RecordId> samples;
+            while (samples.size() < parallelism * kSamplesPerPartition) {
+                auto record = randomCursor->next();
+                if (!record) {
+                    break;
+                }
+                samples.push_back(record->id);
+            }
+            std::sort(samples.begin(), samples.end());
+            samples.erase(std::unique(samples.begin(), samples.end()), samples.end());
+
+            if (samples.size() >= parallelism) {
+                for (size_t i = 1; i < parallelism; ++i) {
+                    boundaries.push_back(samples[i * samples.size() / parallelism]);
+                }
+            }
+        }
+    }
+
+    RecordId start;
+    for (size_t i = 0; i <= boundaries.size(); ++i) {
+        auto partition = std::make_unique<Partition>();
+        partition->start = start;
+        partition->end = i < boundaries.size() ? boundaries[i] : RecordId();
+        start = partition->end;
+
+        // The workers only run while this operation holds its locks, so they do not lock anything
+        // themselves.
+        partition->client = opCtx->getServiceContext()->makeClient(
+            str::stream() << "parallelCollectionScan-" << i);
+        partition->opCtx = partition->client->makeOperationContext();
+        partition->opCtx->swapLockState(std::make_unique<LockerNoop>());
+        partition->opCtx->recoveryUnit()->setPrepareConflictBehavior(
+            opCtx->recoveryUnit()->getPrepareConflictBehavior());
+        if (_filter) {
+            partition->filter = _filter->shallowClone();
+        }
+
+        _partitions.push_back(std::move(partition));
+    }
+
+    _workers = getWorkerPool(opCtx->getServiceContext()).get();
+    _specificStats.parallelism = _partitions.size();
+}
+
+void ParallelCollectionScan::runRound(bool positioning) {
+    // The pool is shared with other scans, so wait for this round's partitions rather than for the
+    // pool to become idle.
+    stdx::mutex mutex;
+    stdx::condition_variable roundFinished;
+    size_t running = 0;
+
+    for (auto&& partition : _partitions) {
+        partition->results.clear();
+        if (partition->exhausted || (positioning && partition->positioned)) {
+            continue;
+        }
+
+        {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            ++running;
+        }
+        _workers->schedule([&, partition = partition.get() ](auto scheduleStatus) {
+            if (scheduleStatus.isOK()) {
+                scanPartition(partition);
+            } else {
+                partition->status = scheduleStatus;
+            }
+
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            if (--running == 0) {
+                roundFinished.notify_all();
+            }
+        });
+    }
+
+    {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        roundFinished.wait(lk, [&] { return running == 0; });
+    }
+
+    for (auto&& partition : _partitions) {
+        _specificStats.docsTested += partition->docsTested;
+        partition->docsTested = 0;
+    }
+    ++_specificStats.rounds;
+}
+
+void ParallelCollectionScan::scanPartition(Partition* partition) {
+    AlternativeClientRegion acr(partition->client);
+    OperationContext* opCtx = partition->opCtx.get();
+
+    auto processRecord = [&](const Record& record) {
+        ++partition->docsTested;
+        BSONObj obj = record.data.toBson();
+        if (!partition->filter || partition->filter->matchesBSON(obj)) {
+            partition->results.emplace_back(record.id, obj.getOwned());
+        }
+    };
+
+    try {
+        if (!partition->positioned) {
+            // Every partition is positioned before any of them starts reading, so that a partition
+            // whose starting record is gone can still be merged into the one before it.
+            partition->cursor = collection()->getRecordStore()->getCursor(opCtx, true);
+            if (!partition->start.isNull()) {
+                if (auto record = partition->cursor->seekExact(partition->start)) {
+                    processRecord(*record);
+                } else {
+                    partition->startMissing = true;
+                }
+            }
+            partition->positioned = true;
+        } else {
+            uassert(ErrorCodes::CappedPositionLost,
+                    "ParallelCollectionScan died due to failure to restore its position",
+                    partition->cursor->restore());
+
+            for (size_t i = 0; i < _recordsPerRound; ++i) {
+                auto record = partition->cursor->next();
+                if (!record || (!partition->end.isNull() && record->id >= partition->end)) {
+                    partition->exhausted = true;
+                    break;
+                }
+                processRecord(*record);
+            }
+        }
+    } catch (const WriteConflictException&) {
+        // Treat the conflict like a yield: keep what has been read so far and continue from the
+        // cursor's last position in the next round.
+        if (!partition->positioned) {
+            partition->cursor.reset();
+            partition->results.clear();
+        }
+    } catch (const DBException& ex) {
+        partition->status = ex.toStatus();
+    }
+
+    if (partition->cursor) {
+        partition->cursor->save();
+    }
+    opCtx->recoveryUnit()->abandonSnapshot();
+}
+
+void ParallelCollectionScan::mergeUnpositionedPartitions() {
+    // No partition has read beyond its starting record yet, so extending the range of the partition
+    // before a missing start covers the same records.
+    std::vector<std::unique_ptr<Partition>> merged;
+    for (auto&& partition : _partitions) {
+        if (partition->startMissing && !merged.empty()) {
+            merged.back()->end = partition->end;
+            continue;
+        }
+        merged.push_back(std::move(partition));
+    }
+    _partitions = std::move(merged);
+    _specificStats.parallelism = _partitions.size();
+}
+
+bool ParallelCollectionScan::isEOF() {
+    return _commonStats.isEOF;
+}
+
+std::unique_ptr<PlanStageStats> ParallelCollectionScan::getStats() {
+    // Add a BSON representation of the filter to the stats tree, if there is one.
+    if (nullptr != _filter) {
+        BSONObjBuilder bob;
+        _filter->serialize(&bob);
+        _commonStats.filter = bob.obj();
+    }
+
+    auto ret = std::make_unique<PlanStageStats>(_commonStats, STAGE_PARALLEL_COLLSCAN);
+    ret->specific = std::make_unique<ParallelCollectionScanStats>(_specificStats);
+    return ret;
+}
+
+const SpecificStats* ParallelCollectionScan::getSpecificStats() const {
+    return &_specificStats;
+}
+
+}  // namespace mongo
@@ -0,0 +1,148 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mongo/db/exec/collection_scan_common.h"
+#include "mongo/db/exec/plan_stats.h"
+#include "mongo/db/exec/requires_collection_stage.h"
+#include "mongo/db/record_id.h"
+
+namespace mongo {
+
+class MatchExpression;
+class ThreadPool;
+class WorkingSet;
+
+/**
+ * Scans a collection on several threads. The collection is split into ranges of RecordIds at
+ * boundaries sampled with a random cursor, and each range is read by a worker thread with its own
+ * Client, OperationContext and storage snapshot, taken from a thread pool shared by every scan in
+ * the process. The workers apply their own copies of the filter and hand back owned copies of the
+ * matching documents.
+ *
+ * Results are returned in no particular order, so this stage may only be used when the consumer of
+ * the scan does not depend on natural order (see QueryPlannerParams::PARALLEL_COLLSCAN).
+ *
+ * The workers only run from within work(), while the operation driving the scan holds its locks,
+ * so they read without taking any locks of their own. Each round reads up to
+ * internalQueryParallelCollectionScanRecordsPerRound records from every range; between rounds the
+ * workers' cursors are saved and their snapshots abandoned, exactly as they would be across a
+ * yield.
+ */
+class ParallelCollectionScan final : public RequiresCollectionStage {
+public:
+    static const char* kStageType;
+
+    ParallelCollectionScan(OperationContext* opCtx,
+                           const Collection* collection,
+                           WorkingSet* workingSet,
+                           const MatchExpression* filter);
+
+    ~ParallelCollectionScan();
+
+    /**
+     * Returns true if a scan of 'collection' described by 'params' and 'filter' may be performed
+     * by a ParallelCollectionScan for 'opCtx'. Scans which must observe a single point in time
+     * (multi-document transactions and reads at a timestamp), scans which depend on order (reverse,
+     * tailable and oplog scans, or scans of capped collections) and scans whose filter cannot be
+     * evaluated off the operation's thread ($expr, $where and $text) are not eligible.
+     */
+    static bool canScanInParallel(OperationContext* opCtx,
+                                  const Collection* collection,
+                                  const CollectionScanParams& params,
+                                  const MatchExpression* filter);
+
+    StageState doWork(WorkingSetID* out) final;
+    bool isEOF() final;
+
+    StageType stageType() const final {
+        return STAGE_PARALLEL_COLLSCAN;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final;
+
+    const SpecificStats* getSpecificStats() const final;
+
+protected:
+    // The workers' cursors are saved at the end of every round, so there is nothing to do when the
+    // operation yields.
+    void doSaveStateRequiresCollection() final {}
+    void doRestoreStateRequiresCollection() final {}
+
+private:
+    struct Partition;
+
+    /**
+     * Chooses the boundaries of the ranges to scan and creates the state each worker needs.
+     */
+    void initPartitions();
+
+    /**
+     * Runs one round of every partition which has not reached the end of its range and waits for
+     * all of them to finish. While 'positioning', only the partitions whose cursors have not been
+     * positioned yet are run.
+     */
+    void runRound(bool positioning);
+
+    /**
+     * Runs on a worker thread. The first round opens the partition's cursor and positions it at the
+     * start of its range; later rounds read the next batch of records in the range.
+     */
+    void scanPartition(Partition* partition);
+
+    /**
+     * Called after the positioning round. Merges each partition whose starting record was deleted
+     * before it could be positioned into the partition which precedes it.
+     */
+    void mergeUnpositionedPartitions();
+
+    WorkingSet* _workingSet;
+
+    // Each partition evaluates its own clone of the filter.
+    const MatchExpression* _filter;
+
+    const size_t _maxParallelism;
+    const size_t _recordsPerRound;
+
+    std::vector<std::unique_ptr<Partition>> _partitions;
+    // The process-wide worker pool, set by initPartitions().
+    ThreadPool* _workers = nullptr;
+
+    // Position of the next result to return from the last round.
+    size_t _currentPartition = 0;
+    size_t _currentResult = 0;
+
+    ParallelCollectionScanStats _specificStats;
+};
+
+}  // namespace mongo
@@ -42,21 +42,86 @@ namespace mongo {
 PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     invariant(_opCtx);
     ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
-    ++_commonStats.works;
+
+    if (_hasDeferredState) {
+        // The unit of work which reached this state was counted by the call to workBatch() which
+        // performed it.
+        _hasDeferredState = false;
+        *out = _deferredId;
+        return _deferredState;
+    }
 
     StageState workResult = doWork(out);
+    countUnitOfWork(workResult);
+    return workResult;
+}
+
+PlanStage::StageState PlanStage::workBatch(size_t maxBatchSize, std::vector<WorkingSetID>* out) {
+    invariant(_opCtx);
+    invariant(maxBatchSize > 0);
+    invariant(out->empty());
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+
+    if (_hasDeferredState) {
+        // See work() above.
+        _hasDeferredState = false;
+        if (WorkingSet::INVALID_ID != _deferredId) {
+            out->push_back(_deferredId);
+        }
+        return _deferredState;
+    }
 
+    // The works, advanced, needTime and needYield counters are updated by doWorkBatch() for each
+    // unit of work it performs, so that they match what the same work done by work() would report.
+    const StageState workResult = doWorkBatch(maxBatchSize, out);
     if (StageState::ADVANCED == workResult) {
+        invariant(!out->empty());
+        ++_commonStats.batches;
+        _commonStats.batchedResults += out->size();
+    }
+
+    return workResult;
+}
+
+PlanStage::StageState PlanStage::doWorkBatch(size_t maxBatchSize, std::vector<WorkingSetID>* out) {
+    WorkingSetID id = WorkingSet::INVALID_ID;
+    const StageState state = doWork(&id);
+    countUnitOfWork(state);
+    if (WorkingSet::INVALID_ID != id) {
+        out->push_back(id);
+    }
+    return state;
+}
+
+void PlanStage::countUnitOfWork(StageState state) {
+    ++_commonStats.works;
+    if (StageState::ADVANCED == state) {
         ++_commonStats.advanced;
-    } else if (StageState::NEED_TIME == workResult) {
+    } else if (StageState::NEED_TIME == state) {
         ++_commonStats.needTime;
-    } else if (StageState::NEED_YIELD == workResult) {
+    } else if (StageState::NEED_YIELD == state) {
         ++_commonStats.needYield;
-    } else if (StageState::FAILURE == workResult) {
+    } else if (StageState::FAILURE == state) {
         _commonStats.failed = true;
     }
+}
 
-    return workResult;
+PlanStage::StageState PlanStage::deferStateIfBatched(StageState state,
+                                                     WorkingSetID id,
+                                                     std::vector<WorkingSetID>* out) {
+    invariant(ADVANCED != state && NEED_TIME != state);
+    if (out->empty()) {
+        if (WorkingSet::INVALID_ID != id) {
+            out->push_back(id);
+        }
+        return state;
+    }
+
+    invariant(!_hasDeferredState);
+    _hasDeferredState = true;
+    _deferredState = state;
+    _deferredId = id;
+    return ADVANCED;
 }
 
 void PlanStage::saveState() {
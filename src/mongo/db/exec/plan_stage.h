@@ -193,6 +193,25 @@ public:
      */
     StageState work(WorkingSetID* out);
 
+    /**
+     * Perform up to 'maxBatchSize' units of work on the query in a single call, appending each
+     * result produced to 'out', which must be empty on entry. Returns StageState::ADVANCED if at
+     * least one result was appended. Otherwise returns the same state work() would have returned;
+     * if that state comes with a working set member (e.g. the status member of a FAILURE) it is
+     * the only element of 'out'.
+     *
+     * If a stage reaches a state other than ADVANCED or NEED_TIME after it has already batched
+     * some results, it returns the batch and reports that state on the following call to
+     * work() or workBatch(). Callers therefore see exactly the same sequence of states as they
+     * would from repeated calls to work(), except that consecutive results are grouped.
+     *
+     * Every member in the batch except the last one owns its data. The last member is subject
+     * to the same lifetime rules as a result returned from work().
+     *
+     * Stages which do not override doWorkBatch() produce at most one result per call.
+     */
+    StageState workBatch(size_t maxBatchSize, std::vector<WorkingSetID>* out);
+
     /**
      * Returns true if no more work can be done on the query / out of results.
      */
@@ -341,6 +360,61 @@ protected:
      */
     virtual StageState doWork(WorkingSetID* out) = 0;
 
+    /**
+     * Performs up to 'maxBatchSize' units of work. See the comment at workBatch() above. The
+     * default implementation performs a single unit of work by calling doWork().
+     *
+     * Implementations must call countUnitOfWork() once for each unit of work they perform, with
+     * the state that unit reached, so that the stage's stats are the same as if each unit had been
+     * performed by a call to work().
+     */
+    virtual StageState doWorkBatch(size_t maxBatchSize, std::vector<WorkingSetID>* out);
+
+    /**
+     * Updates the works, advanced, needTime, needYield and failed stats for one unit of work which
+     * reached 'state'.
+     */
+    void countUnitOfWork(StageState state);
+
+    /**
+     * Implements doWorkBatch() for stages which produce results one at a time, by calling
+     * 'workOne' (which has the signature of doWork()) up to 'maxBatchSize' times. Stages should
+     * pass a non-virtual call to their own doWork() so that the per-result cost is a direct call.
+     */
+    template <typename WorkOneFn>
+    StageState fillBatch(WorkingSet* ws,
+                         size_t maxBatchSize,
+                         std::vector<WorkingSetID>* out,
+                         WorkOneFn workOne) {
+        for (size_t i = 0; i < maxBatchSize; ++i) {
+            // The next unit of work may reposition a storage engine cursor, which would
+            // invalidate unowned data in the result we batched last.
+            if (!out->empty()) {
+                ws->get(out->back())->makeObjOwnedIfNeeded();
+            }
+
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            const StageState state = workOne(&id);
+            countUnitOfWork(state);
+            if (ADVANCED == state) {
+                out->push_back(id);
+            } else if (NEED_TIME != state) {
+                return deferStateIfBatched(state, id, out);
+            }
+        }
+        return out->empty() ? NEED_TIME : ADVANCED;
+    }
+
+    /**
+     * Used by implementations of doWorkBatch() when the stage reaches 'state' (which may not be
+     * ADVANCED or NEED_TIME) after having already added results to 'out'. If 'out' is empty,
+     * adds 'id' to it when valid and returns 'state'. Otherwise returns ADVANCED and arranges for
+     * 'state' and 'id' to be reported by the next call to work() or workBatch().
+     */
+    StageState deferStateIfBatched(StageState state,
+                                   WorkingSetID id,
+                                   std::vector<WorkingSetID>* out);
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
@@ -386,6 +460,12 @@ protected:
 
 private:
     OperationContext* _opCtx;
+
+    // Set when a call to doWorkBatch() reached a state other than ADVANCED or NEED_TIME after
+    // already producing results. The state is reported by the next call to work() or workBatch().
+    bool _hasDeferredState = false;
+    StageState _deferredState = NEED_TIME;
+    WorkingSetID _deferredId = WorkingSet::INVALID_ID;
 };
 
 }  // namespace mongo
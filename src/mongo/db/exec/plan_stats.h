@@ -63,6 +63,8 @@ struct CommonStats {
           advanced(0),
           needTime(0),
           needYield(0),
+          batches(0),
+          batchedResults(0),
           executionTimeMillis(0),
           failed(false),
           isEOF(false) {}
@@ -79,6 +81,11 @@ struct CommonStats {
     size_t needTime;
     size_t needYield;
 
+    // How many batches of results were returned from workBatch(...), and how many results they
+    // contained in total. Both are zero if the stage was only ever asked for single results.
+    size_t batches;
+    size_t batchedResults;
+
     // BSON representation of a MatchExpression affixed to this node. If there
     // is no filter affixed, then 'filter' should be an empty BSONObj.
     BSONObj filter;
@@ -206,6 +213,21 @@ struct CollectionScanStats : public SpecificStats {
     boost::optional<Timestamp> maxTs;
 };
 
+struct ParallelCollectionScanStats : public SpecificStats {
+    SpecificStats* clone() const final {
+        return new ParallelCollectionScanStats(*this);
+    }
+
+    // How many documents did the scan threads check against the filter?
+    size_t docsTested = 0;
+
+    // How many ranges of the collection were scanned concurrently.
+    size_t parallelism = 0;
+
+    // How many times the scan threads were run.
+    size_t rounds = 0;
+};
+
 struct CountStats : public SpecificStats {
     CountStats() : nCounted(0), nSkipped(0) {}
 
@@ -343,6 +365,9 @@ struct FetchStats : public SpecificStats {
 
     // The total number of full documents touched by the fetch stage.
     size_t docsExamined = 0u;
+
+    // The number of documents read ahead of time because prefetching was enabled.
+    size_t docsPrefetched = 0u;
 };
 
 struct IDHackStats : public SpecificStats {
@@ -495,6 +520,10 @@ struct SortStats : public SpecificStats {
 
     // The pattern according to which we are sorting.
     BSONObj sortPattern;
+
+    // Whether the sort exceeded its memory limit and wrote sorted runs to disk, and how many.
+    bool usedDisk = false;
+    size_t spills = 0u;
 };
 
 struct MergeSortStats : public SpecificStats {
@@ -181,6 +181,49 @@ PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState ProjectionStage::doWorkBatch(size_t maxBatchSize,
+                                                   std::vector<WorkingSetID>* out) {
+    _childBatch.clear();
+    const CommonStats* childStats = child()->getCommonStats();
+    const size_t childWorks = childStats->works;
+    const size_t childNeedTime = childStats->needTime;
+    const size_t childNeedYield = childStats->needYield;
+    StageState status = child()->workBatch(maxBatchSize, &_childBatch);
+
+    // Each call to doWork() performs one unit of work on the child and reports the state it
+    // reached, so count the child's units of work as this stage's own.
+    _commonStats.works += childStats->works - childWorks;
+    _commonStats.needTime += childStats->needTime - childNeedTime;
+    _commonStats.needYield += childStats->needYield - childNeedYield;
+    if (PlanStage::ADVANCED != status) {
+        if (PlanStage::FAILURE == status) {
+            _commonStats.failed = true;
+        }
+        // Pass along the status member of a FAILURE, if there is one.
+        out->insert(out->end(), _childBatch.begin(), _childBatch.end());
+        return status;
+    }
+
+    for (size_t i = 0; i < _childBatch.size(); ++i) {
+        WorkingSetMember* member = _ws.get(_childBatch[i]);
+        Status projStatus = transform(member);
+        if (!projStatus.isOK()) {
+            warning() << "Couldn't execute projection, status = " << redact(projStatus);
+            for (size_t j = i; j < _childBatch.size(); ++j) {
+                _ws.free(_childBatch[j]);
+            }
+            _commonStats.failed = true;
+            return deferStateIfBatched(PlanStage::FAILURE,
+                                       WorkingSetCommon::allocateStatusMember(&_ws, projStatus),
+                                       out);
+        }
+        out->push_back(_childBatch[i]);
+        ++_commonStats.advanced;
+    }
+
+    return PlanStage::ADVANCED;
+}
+
 std::unique_ptr<PlanStageStats> ProjectionStage::getStats() {
     _commonStats.isEOF = isEOF();
     auto ret = std::make_unique<PlanStageStats>(_commonStats, stageType());
@@ -54,6 +54,7 @@ protected:
 public:
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxBatchSize, std::vector<WorkingSetID>* out) final;
 
     std::unique_ptr<PlanStageStats> getStats() final;
 
@@ -89,6 +90,10 @@ private:
     // Used to retrieve a WorkingSetMember as part of 'doWork()'.
     WorkingSet& _ws;
 
+    // Results requested from the child by 'doWorkBatch()'. Kept as a member so that its storage
+    // is reused from one batch to the next.
+    std::vector<WorkingSetID> _childBatch;
+
     // Populated by 'getStats()'.
     ProjectionStats _specificStats;
 };
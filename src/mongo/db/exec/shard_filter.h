@@ -68,13 +68,17 @@ namespace mongo {
  *
  * Preconditions: Child must be fetched.  TODO: when covering analysis is in just build doc
  * and check that against shard key.  See SERVER-5022.
+ *
+ * If the caller has established that every document the child can return has a shard key within
+ * a range owned by this shard, 'childIsOwned' may be passed to let documents through unchecked.
  */
 class ShardFilterStage final : public PlanStage {
 public:
     ShardFilterStage(OperationContext* opCtx,
                      ScopedCollectionMetadata metadata,
                      WorkingSet* ws,
-                     PlanStage* child);
+                     PlanStage* child,
+                     bool childIsOwned = false);
     ~ShardFilterStage();
 
     bool isEOF() final;
@@ -93,6 +97,9 @@ public:
 private:
     WorkingSet* _ws;
 
+    // Whether all the documents returned by the child are known to belong to this shard
+    const bool _childIsOwned;
+
     // Stats
     ShardingFilterStats _specificStats;
 
@@ -0,0 +1,327 @@
+/**
+ *    Copyright (C) 2018-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/shard_filter.h"
+
+#include <memory>
+#include <vector>
+
+#include "mongo/db/exec/queued_data_stage.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/db/query/stage_builder.h"
+#include "mongo/db/s/scoped_collection_metadata.h"
+#include "mongo/db/service_context_d_test_fixture.h"
+#include "mongo/s/catalog/type_chunk.h"
+#include "mongo/s/chunk_manager.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kNss("test.foo");
+const ShardId kThisShard("thisShard");
+const ShardId kOtherShard("otherShard");
+
+class FixedMetadata : public ScopedCollectionMetadata::Impl {
+public:
+    explicit FixedMetadata(CollectionMetadata metadata) : _metadata(std::move(metadata)) {}
+
+    const CollectionMetadata& get() override {
+        return _metadata;
+    }
+
+private:
+    CollectionMetadata _metadata;
+};
+
+/**
+ * Returns metadata for a collection sharded on 'shardKeyPattern' which is split into 'chunks',
+ * each given as its range and owning shard.
+ */
+CollectionMetadata makeMetadata(const BSONObj& shardKeyPattern,
+                                const std::vector<std::pair<ChunkRange, ShardId>>& chunks) {
+    const OID epoch = OID::gen();
+    ChunkVersion version(1, 0, epoch);
+
+    std::vector<ChunkType> allChunks;
+    for (const auto& chunk : chunks) {
+        allChunks.emplace_back(kNss, chunk.first, version, chunk.second);
+        version.incMajor();
+    }
+
+    auto rt = RoutingTableHistory::makeNew(
+        kNss, UUID::gen(), KeyPattern(shardKeyPattern), nullptr, false, epoch, allChunks);
+    return CollectionMetadata(std::make_shared<ChunkManager>(rt, boost::none), kThisShard);
+}
+
+/**
+ * Sharded on {a: 1}. This shard owns [0, 10) and ["a", "m").
+ */
+CollectionMetadata makeSingleFieldMetadata() {
+    return makeMetadata(BSON("a" << 1),
+                        {{ChunkRange(BSON("a" << MINKEY), BSON("a" << 0)), kOtherShard},
+                         {ChunkRange(BSON("a" << 0), BSON("a" << 10)), kThisShard},
+                         {ChunkRange(BSON("a" << 10), BSON("a"
+                                                           << "a")),
+                          kOtherShard},
+                         {ChunkRange(BSON("a"
+                                          << "a"),
+                                     BSON("a"
+                                          << "m")),
+                          kThisShard},
+                         {ChunkRange(BSON("a"
+                                          << "m"),
+                                     BSON("a" << MAXKEY)),
+                          kOtherShard}});
+}
+
+IndexEntry makeIndexEntry(const BSONObj& keyPattern,
+                          bool multikey = false,
+                          const CollatorInterface* collator = nullptr) {
+    return IndexEntry(keyPattern,
+                      INDEX_BTREE,
+                      multikey,
+                      {},
+                      {},
+                      false,  // sparse
+                      false,  // unique
+                      IndexEntry::Identifier{"indexName"},
+                      nullptr,
+                      BSONObj(),
+                      collator,
+                      nullptr);
+}
+
+OrderedIntervalList makeOil(const std::string& name, std::vector<Interval> intervals) {
+    OrderedIntervalList oil(name);
+    oil.intervals = std::move(intervals);
+    return oil;
+}
+
+/**
+ * Returns an index scan over 'index' with the given bounds, below a FETCH like the ones the shard
+ * filter is built over.
+ */
+std::unique_ptr<FetchNode> makeFetchIndexScan(IndexEntry index,
+                                              std::vector<OrderedIntervalList> bounds) {
+    auto ixn = std::make_unique<IndexScanNode>(std::move(index));
+    ixn->bounds.fields = std::move(bounds);
+
+    auto fetch = std::make_unique<FetchNode>();
+    fetch->children.push_back(ixn.release());
+    return fetch;
+}
+
+class ShardFilterStageTest : public ServiceContextMongoDTest {
+protected:
+    ShardFilterStageTest() : _opCtx(makeOperationContext()) {}
+
+    /**
+     * Runs 'docs' through a ShardFilterStage built over 'node' the way the stage builder builds it,
+     * and returns the documents which it lets through.
+     */
+    std::vector<BSONObj> runShardFilter(const CollectionMetadata& metadata,
+                                        const QuerySolutionNode& node,
+                                        const std::vector<BSONObj>& docs) {
+        WorkingSet ws;
+        auto queued = std::make_unique<QueuedDataStage>(_opCtx.get(), &ws);
+        for (const auto& doc : docs) {
+            WorkingSetID id = ws.allocate();
+            ws.get(id)->obj = Snapshotted<BSONObj>(SnapshotId(), doc);
+            ws.transitionToOwnedObj(id);
+            queued->pushBack(id);
+        }
+
+        ShardFilterStage filter(_opCtx.get(),
+                                ScopedCollectionMetadata(std::make_shared<FixedMetadata>(metadata)),
+                                &ws,
+                                queued.release(),
+                                StageBuilder::indexScanIsOwned(&node, metadata));
+
+        std::vector<BSONObj> results;
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        for (auto state = filter.work(&id); state != PlanStage::IS_EOF; state = filter.work(&id)) {
+            if (state == PlanStage::ADVANCED) {
+                results.push_back(ws.get(id)->obj.value().getOwned());
+            }
+        }
+        return results;
+    }
+
+private:
+    ServiceContext::UniqueOperationContext _opCtx;
+};
+
+void assertDocsEqual(const std::vector<BSONObj>& expected, const std::vector<BSONObj>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_BSONOBJ_EQ(expected[i], actual[i]);
+    }
+}
+
+TEST_F(ShardFilterStageTest, IndexScanWithinOwnedRangeIsNotFiltered) {
+    const auto metadata = makeSingleFieldMetadata();
+    auto node = makeFetchIndexScan(
+        makeIndexEntry(BSON("a" << 1)),
+        {makeOil("a", {Interval(BSON("" << 2 << "" << 8), true, true)})});
+    ASSERT_TRUE(StageBuilder::indexScanIsOwned(node.get(), metadata));
+
+    const std::vector<BSONObj> docs{BSON("a" << 2), BSON("a" << 8)};
+    assertDocsEqual(docs, runShardFilter(metadata, *node, docs));
+}
+
+TEST_F(ShardFilterStageTest, IndexScanTouchingForeignChunkIsFiltered) {
+    const auto metadata = makeSingleFieldMetadata();
+
+    // The chunk boundary at 10 is exclusive, so an inclusive bound of 10 reaches the next chunk.
+    auto node = makeFetchIndexScan(
+        makeIndexEntry(BSON("a" << 1)),
+        {makeOil("a", {Interval(BSON("" << 5 << "" << 10), true, true)})});
+    ASSERT_FALSE(StageBuilder::indexScanIsOwned(node.get(), metadata));
+    assertDocsEqual({BSON("a" << 5)},
+                    runShardFilter(metadata, *node, {BSON("a" << 5), BSON("a" << 10)}));
+
+    // Several intervals, only one of which lies outside the owned ranges.
+    node = makeFetchIndexScan(makeIndexEntry(BSON("a" << 1)),
+                              {makeOil("a",
+                                       {Interval(BSON("" << 1 << "" << 1), true, true),
+                                        Interval(BSON("" << 12 << "" << 12), true, true)})});
+    ASSERT_FALSE(StageBuilder::indexScanIsOwned(node.get(), metadata));
+    assertDocsEqual({BSON("a" << 1)},
+                    runShardFilter(metadata, *node, {BSON("a" << 1), BSON("a" << 12)}));
+}
+
+TEST_F(ShardFilterStageTest, DescendingIndexScan) {
+    const auto metadata = makeSingleFieldMetadata();
+
+    // The intervals of a descending index run from the high bound to the low one.
+    auto node = makeFetchIndexScan(
+        makeIndexEntry(BSON("a" << -1)),
+        {makeOil("a", {Interval(BSON("" << 8 << "" << 2), true, true)})});
+    ASSERT_TRUE(StageBuilder::indexScanIsOwned(node.get(), metadata));
+    assertDocsEqual({BSON("a" << 8), BSON("a" << 2)},
+                    runShardFilter(metadata, *node, {BSON("a" << 8), BSON("a" << 2)}));
+
+    node = makeFetchIndexScan(makeIndexEntry(BSON("a" << -1)),
+                              {makeOil("a", {Interval(BSON("" << 10 << "" << 5), true, true)})});
+    ASSERT_FALSE(StageBuilder::indexScanIsOwned(node.get(), metadata));
+    assertDocsEqual({BSON("a" << 5)},
+                    runShardFilter(metadata, *node, {BSON("a" << 10), BSON("a" << 5)}));
+}
+
+TEST_F(ShardFilterStageTest, CompoundShardKeyWithUnboundedSuffixIsFiltered) {
+    // This shard owns everything below {a: 5, b: 0}.
+    const auto metadata = makeMetadata(
+        BSON("a" << 1 << "b" << 1),
+        {{ChunkRange(BSON("a" << MINKEY << "b" << MINKEY), BSON("a" << 5 << "b" << 0)), kThisShard},
+         {ChunkRange(BSON("a" << 5 << "b" << 0), BSON("a" << MAXKEY << "b" << MAXKEY)),
+          kOtherShard}});
+
+    auto node = makeFetchIndexScan(
+        makeIndexEntry(BSON("a" << 1 << "b" << 1)),
+        {makeOil("a", {Interval(BSON("" << 1 << "" << 5), true, true)}),
+         makeOil("b", {Interval(BSON("" << MINKEY << "" << MAXKEY), true, true)})});
+    ASSERT_FALSE(StageBuilder::indexScanIsOwned(node.get(), metadata));
+    assertDocsEqual({BSON("a" << 1 << "b" << 7), BSON("a" << 5 << "b" << -1)},
+                    runShardFilter(metadata,
+                                   *node,
+                                   {BSON("a" << 1 << "b" << 7),
+                                    BSON("a" << 5 << "b" << -1),
+                                    BSON("a" << 5 << "b" << 3)}));
+
+    // Bounded suffixes which stay below the split point are owned.
+    node = makeFetchIndexScan(makeIndexEntry(BSON("a" << 1 << "b" << 1)),
+                              {makeOil("a", {Interval(BSON("" << 1 << "" << 5), true, true)}),
+                               makeOil("b", {Interval(BSON("" << -5 << "" << -1), true, true)})});
+    ASSERT_TRUE(StageBuilder::indexScanIsOwned(node.get(), metadata));
+}
+
+TEST_F(ShardFilterStageTest, NullAndMinKeyBoundsAreFiltered) {
+    const auto metadata = makeSingleFieldMetadata();
+
+    // Documents missing the shard key are indexed as null, which sorts before every owned range.
+    auto node = makeFetchIndexScan(
+        makeIndexEntry(BSON("a" << 1)),
+        {makeOil("a", {Interval(BSON("" << BSONNULL << "" << BSONNULL), true, true)})});
+    ASSERT_FALSE(StageBuilder::indexScanIsOwned(node.get(), metadata));
+    assertDocsEqual({}, runShardFilter(metadata, *node, {BSON("a" << BSONNULL), BSON("b" << 1)}));
+
+    node = makeFetchIndexScan(
+        makeIndexEntry(BSON("a" << 1)),
+        {makeOil("a", {Interval(BSON("" << MINKEY << "" << 5), true, true)})});
+    ASSERT_FALSE(StageBuilder::indexScanIsOwned(node.get(), metadata));
+    assertDocsEqual({BSON("a" << 5)},
+                    runShardFilter(metadata, *node, {BSON("a" << -5), BSON("a" << 5)}));
+}
+
+TEST_F(ShardFilterStageTest, MultikeyIndexScanIsFiltered) {
+    const auto metadata = makeSingleFieldMetadata();
+
+    // A document with an array in its shard key field has no valid shard key, even though one of
+    // its index keys falls in an owned range.
+    auto node = makeFetchIndexScan(
+        makeIndexEntry(BSON("a" << 1), true /* multikey */),
+        {makeOil("a", {Interval(BSON("" << 2 << "" << 8), true, true)})});
+    ASSERT_FALSE(StageBuilder::indexScanIsOwned(node.get(), metadata));
+    assertDocsEqual(
+        {BSON("a" << 5)},
+        runShardFilter(metadata, *node, {BSON("a" << BSON_ARRAY(5 << 15)), BSON("a" << 5)}));
+}
+
+TEST_F(ShardFilterStageTest, CollatedIndexScanIsFiltered) {
+    const auto metadata = makeSingleFieldMetadata();
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kReverseString);
+
+    // The bounds are on collation keys: "zb" is indexed as "bz", which lies within the bounds,
+    // although the document belongs to the chunk starting at "m".
+    auto node = makeFetchIndexScan(makeIndexEntry(BSON("a" << 1), false, &collator),
+                                   {makeOil("a",
+                                            {Interval(BSON(""
+                                                           << "b"
+                                                           << ""
+                                                           << "c"),
+                                                      true,
+                                                      true)})});
+    ASSERT_FALSE(StageBuilder::indexScanIsOwned(node.get(), metadata));
+    assertDocsEqual({BSON("a"
+                          << "cb")},
+                    runShardFilter(metadata,
+                                   *node,
+                                   {BSON("a"
+                                         << "zb"),
+                                    BSON("a"
+                                         << "cb")}));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -39,6 +39,8 @@ namespace mongo {
 ShardFiltererImpl::ShardFiltererImpl(ScopedCollectionMetadata md) : _metadata(std::move(md)) {
     if (_metadata->isSharded()) {
         _keyPattern = ShardKeyPattern(_metadata->getKeyPattern());
+        _lookupsBeforeOwnedRanges = static_cast<long long>(
+            _metadata->getChunkManager()->numChunks() * kLookupsPerChunkBeforeOwnedRanges);
     }
 }
 
@@ -54,8 +56,13 @@ ShardFilterer::DocumentBelongsResult ShardFiltererImpl::documentBelongsToMe(
         return DocumentBelongsResult::kNoShardKey;
     }
 
-    return _metadata->keyBelongsToMe(shardKey) ? DocumentBelongsResult::kBelongs
-                                               : DocumentBelongsResult::kDoesNotBelong;
+    if (!_ownedRanges && ++_numLookups > _lookupsBeforeOwnedRanges) {
+        _ownedRanges = &_metadata->getOwnedRanges();
+    }
+
+    const bool belongs =
+        _ownedRanges ? _ownedRanges->containsKey(shardKey) : _metadata->keyBelongsToMe(shardKey);
+    return belongs ? DocumentBelongsResult::kBelongs : DocumentBelongsResult::kDoesNotBelong;
 }
 
 }  // namespace mongo
@@ -51,7 +51,17 @@ public:
     }
 
 private:
+    // The owned ranges of the shard take time linear in the number of chunks to build, so they are
+    // only switched to after this many lookups per chunk of the collection
+    static constexpr double kLookupsPerChunkBeforeOwnedRanges = 0.125;
+
     ScopedCollectionMetadata _metadata;
     boost::optional<ShardKeyPattern> _keyPattern;
+
+    // Number of lookups after which '_ownedRanges' are used instead of the routing table
+    long long _lookupsBeforeOwnedRanges = 0;
+
+    mutable long long _numLookups = 0;
+    mutable const ShardOwnedRanges* _ownedRanges = nullptr;
 };
 }  // namespace mongo
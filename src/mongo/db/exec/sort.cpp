@@ -43,6 +43,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -51,9 +52,87 @@ using std::endl;
 using std::unique_ptr;
 using std::vector;
 
+namespace {
+
+/**
+ * Generates a new file name on each call using a static, atomic and monotonically increasing
+ * number.
+ *
+ * Each user of the Sorter must implement this function to ensure that all temporary files that the
+ * Sorter instances produce are uniquely identified using a unique file name extension with separate
+ * atomic variable. This is necessary because the sorter.cpp code is separately included in multiple
+ * places, rather than compiled in one place and linked, and so cannot provide a globally unique ID.
+ */
+std::string nextFileName() {
+    static AtomicWord<unsigned> sortStageFileCounter;
+    return "extsort-sort-stage." + std::to_string(sortStageFileCounter.fetchAndAdd(1));
+}
+
+/**
+ * Orders spilled results the same way as SortStage::WorkingSetComparator orders buffered ones.
+ */
+class SpillComparator {
+public:
+    explicit SpillComparator(BSONObj pattern) : _pattern(std::move(pattern)) {}
+
+    int operator()(const std::pair<BSONObj, SortStage::SpilledMember>& lhs,
+                   const std::pair<BSONObj, SortStage::SpilledMember>& rhs) const {
+        // False means ignore field names.
+        int result = lhs.first.woCompare(rhs.first, _pattern, false);
+        if (0 != result) {
+            return result;
+        }
+        return lhs.second.recordId.compare(rhs.second.recordId);
+    }
+
+private:
+    BSONObj _pattern;
+};
+
+/**
+ * Returns true if 'member' can be rebuilt from its RecordId, document and sort key alone. Members
+ * which carry index keys or computed metadata other than the sort key cannot be spilled.
+ */
+bool canSpill(const WorkingSetMember& member) {
+    if (member.getState() != WorkingSetMember::RID_AND_OBJ &&
+        member.getState() != WorkingSetMember::OWNED_OBJ) {
+        return false;
+    }
+    for (int type = 0; type < WSM_COMPUTED_NUM_TYPES; ++type) {
+        if (type != WSM_SORT_KEY &&
+            member.hasComputed(static_cast<WorkingSetComputedDataType>(type))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
 // static
 const char* SortStage::kStageType = "SORT";
 
+void SortStage::SpilledMember::serializeForSorter(BufBuilder& buf) const {
+    recordId.serializeForSorter(buf);
+    obj.serializeForSorter(buf);
+}
+
+SortStage::SpilledMember SortStage::SpilledMember::deserializeForSorter(
+    BufReader& buf, const SorterDeserializeSettings&) {
+    SpilledMember member;
+    member.recordId = RecordId::deserializeForSorter(buf, {});
+    member.obj = BSONObj::deserializeForSorter(buf, {});
+    return member;
+}
+
+int SortStage::SpilledMember::memUsageForSorter() const {
+    return sizeof(SpilledMember) + obj.objsize();
+}
+
+SortStage::SpilledMember SortStage::SpilledMember::getOwned() const {
+    return {recordId, obj.getOwned()};
+}
+
 SortStage::WorkingSetComparator::WorkingSetComparator(BSONObj p) : pattern(p) {}
 
 bool SortStage::WorkingSetComparator::operator()(const SortableDataItem& lhs,
@@ -97,18 +176,29 @@ SortStage::~SortStage() {}
 bool SortStage::isEOF() {
     // We're done when our child has no more results, we've sorted the child's results, and
     // we've returned all sorted results.
+    if (_sorterIterator) {
+        return child()->isEOF() && _sorted && !_sorterIterator->more();
+    }
     return child()->isEOF() && _sorted && (_data.end() == _resultIterator);
 }
 
 PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes.load());
     if (_memUsage > maxBytes) {
-        str::stream ss;
-        ss << "Sort operation used more than the maximum " << maxBytes
-           << " bytes of RAM. Add an index, or specify a smaller limit.";
-        Status status(ErrorCodes::OperationFailed, ss);
-        *out = WorkingSetCommon::allocateStatusMember(_ws, status);
-        return PlanStage::FAILURE;
+        Status status = Status::OK();
+        if (_allowDiskUse && !storageGlobalParams.readOnly) {
+            status = spillBuffer();
+        } else {
+            str::stream ss;
+            ss << "Sort operation used more than the maximum " << maxBytes
+               << " bytes of RAM. Add an index, or specify a smaller limit.";
+            status = Status(ErrorCodes::OperationFailed, ss);
+        }
+
+        if (!status.isOK()) {
+            *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+            return PlanStage::FAILURE;
+        }
     }
 
     if (isEOF()) {
@@ -137,10 +227,27 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
                 item.recordId = member->recordId;
             }
 
-            addToBuffer(item);
+            if (_sorter) {
+                Status status = addToSorter(item);
+                if (!status.isOK()) {
+                    *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+                    return PlanStage::FAILURE;
+                }
+            } else {
+                addToBuffer(item);
+            }
 
             return PlanStage::NEED_TIME;
         } else if (PlanStage::IS_EOF == code) {
+            if (_sorter) {
+                // The runs spilled to disk are merged lazily as results are returned.
+                _sorterIterator.reset(_sorter->done());
+                _specificStats.usedDisk = _sorter->usedDisk();
+                _specificStats.spills = _sorter->numSpills();
+                _sorted = true;
+                return PlanStage::NEED_TIME;
+            }
+
             // TODO: We don't need the lock for this.  We could ask for a yield and do this work
             // unlocked.  Also, this is performing a lot of work for one call to work(...)
             sortBuffer();
@@ -161,8 +268,34 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     }
 
     // Returning results.
-    verify(_resultIterator != _data.end());
     verify(_sorted);
+    if (_sorterIterator) {
+        verify(_sorterIterator->more());
+        auto next = _sorterIterator->next();
+        const BSONObj& sortKey = next.first;
+        const SpilledMember& spilled = next.second;
+
+        // The document may have changed since it was spilled, so it is not associated with any
+        // snapshot.
+        WorkingSetID id = _ws->allocate();
+        WorkingSetMember* member = _ws->get(id);
+        member->obj = {SnapshotId(), spilled.obj.getOwned()};
+        if (spilled.recordId.isNull()) {
+            _ws->transitionToOwnedObj(id);
+        } else {
+            member->recordId = spilled.recordId;
+            _ws->transitionToRecordIdAndObj(id);
+        }
+
+        // Stages above, such as a $sortKey projection or the merge on mongos, expect the sort key
+        // which the member carried before it was spilled.
+        member->addComputed(new SortKeyComputedData(sortKey));
+
+        *out = id;
+        return PlanStage::ADVANCED;
+    }
+
+    verify(_resultIterator != _data.end());
     *out = _resultIterator->wsid;
     _resultIterator++;
 
@@ -289,4 +422,55 @@ void SortStage::sortBuffer() {
     }
 }
 
+Status SortStage::spillBuffer() {
+    const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes.load());
+    _sorter.reset(SpillingSorter::make(SortOptions()
+                                           .Limit(_limit)
+                                           .MaxMemoryUsageBytes(maxBytes)
+                                           .ExtSortAllowed()
+                                           .TempDir(storageGlobalParams.dbpath + "/_tmp"),
+                                       SpillComparator(_sortKeyComparator->pattern)));
+
+    std::vector<SortableDataItem> buffered;
+    if (_dataSet) {
+        buffered.assign(_dataSet->begin(), _dataSet->end());
+        _dataSet.reset();
+    }
+    buffered.insert(buffered.end(), _data.begin(), _data.end());
+    _data.clear();
+    _resultIterator = _data.end();
+    _memUsage = 0;
+
+    LOG(1) << "Sort operation exceeded " << maxBytes << " bytes of RAM; spilling "
+           << buffered.size() << " buffered results to disk";
+
+    for (auto&& item : buffered) {
+        Status status = addToSorter(item);
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+    return Status::OK();
+}
+
+Status SortStage::addToSorter(const SortableDataItem& item) {
+    WorkingSetMember* member = _ws->get(item.wsid);
+    if (!canSpill(*member)) {
+        const size_t maxBytes = static_cast<size_t>(internalQueryExecMaxBlockingSortBytes.load());
+        return {ErrorCodes::OperationFailed,
+                str::stream() << "Sort operation used more than the maximum " << maxBytes
+                              << " bytes of RAM and its results cannot be written to disk. Add an "
+                                 "index, or specify a smaller limit."};
+    }
+
+    _sorter->add(item.sortKey, {item.recordId, member->obj.value()});
+    _ws->free(item.wsid);
+    _specificStats.usedDisk = _sorter->usedDisk();
+    _specificStats.spills = _sorter->numSpills();
+    return Status::OK();
+}
+
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -38,6 +38,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/index_bounds.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/stdx/unordered_map.h"
 
 namespace mongo {
@@ -62,6 +63,12 @@ public:
 /**
  * Sorts the input received from the child according to the sort pattern provided.
  *
+ * If 'allowDiskUse' is set and the buffered results exceed internalQueryExecMaxBlockingSortBytes,
+ * they are moved into a Sorter, which spills sorted runs to disk (keeping only the top 'limit'
+ * results when there is a limit) and merges them lazily as results are returned. Only results which
+ * consist of a document, and optionally its RecordId, can be spilled. Their sort key is restored
+ * from the Sorter's key when they are returned.
+ *
  * Preconditions:
  *   -- For each field in 'pattern', all inputs in the child must handle a getFieldDotted for that
  *   field.
@@ -88,7 +95,25 @@ public:
 
     static const char* kStageType;
 
+    /**
+     * What is kept of a WorkingSetMember once it has been handed to the Sorter.
+     */
+    struct SpilledMember {
+        struct SorterDeserializeSettings {};
+
+        void serializeForSorter(BufBuilder& buf) const;
+        static SpilledMember deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&);
+        int memUsageForSorter() const;
+        SpilledMember getOwned() const;
+
+        // Null if the member had no RecordId.
+        RecordId recordId;
+        BSONObj obj;
+    };
+
 private:
+    using SpillingSorter = Sorter<BSONObj, SpilledMember>;
+
     //
     // Query Stage
     //
@@ -150,6 +175,17 @@ private:
      */
     void sortBuffer();
 
+    /**
+     * Moves the buffered results into '_sorter', creating it. Fails if any of them cannot be
+     * spilled.
+     */
+    Status spillBuffer();
+
+    /**
+     * Adds 'item' to '_sorter' and frees its working set member.
+     */
+    Status addToSorter(const SortableDataItem& item);
+
     // Comparator for data buffer
     // Initialization follows sort key generator
     std::unique_ptr<WorkingSetComparator> _sortKeyComparator;
@@ -168,6 +204,11 @@ private:
     // Iterates through _data post-sort returning it.
     std::vector<SortableDataItem>::iterator _resultIterator;
 
+    // Once the buffered data has exceeded the memory limit, all data is sorted by '_sorter'
+    // instead, and results are returned from '_sorterIterator'.
+    std::unique_ptr<SpillingSorter> _sorter;
+    std::unique_ptr<SpillingSorter::Iterator> _sorterIterator;
+
     SortStats _specificStats;
 
     // The usage in bytes of all buffered data that we're sorting.
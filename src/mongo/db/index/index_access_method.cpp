@@ -33,6 +33,7 @@
 
 #include "mongo/db/index/btree_access_method.h"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -199,6 +200,104 @@ Status AbstractIndexAccessMethod::insertKeys(OperationContext* opCtx,
     return Status::OK();
 }
 
+Status AbstractIndexAccessMethod::insertBatch(OperationContext* opCtx,
+                                              const std::vector<BsonRecord>& bsonRecords,
+                                              const InsertDeleteOptions& options,
+                                              InsertResult* result) {
+    invariant(options.fromIndexBuilder || !_btreeState->isHybridBuilding());
+
+    std::vector<IndexKeyEntry> entries;
+    entries.reserve(bsonRecords.size());
+    BSONObjSet multikeyMetadataKeys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+    MultikeyPaths batchMultikeyPaths;
+    bool markMultikey = false;
+
+    for (const auto& bsonRecord : bsonRecords) {
+        invariant(bsonRecord.id != RecordId());
+
+        BSONObjSet keys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+        BSONObjSet docMultikeyMetadataKeys = SimpleBSONObjComparator::kInstance.makeBSONObjSet();
+        MultikeyPaths multikeyPaths;
+        getKeys(*bsonRecord.docPtr,
+                options.getKeysMode,
+                &keys,
+                &docMultikeyMetadataKeys,
+                &multikeyPaths);
+
+        if (shouldMarkIndexAsMultikey(
+                {keys.begin(), keys.end()},
+                {docMultikeyMetadataKeys.begin(), docMultikeyMetadataKeys.end()},
+                multikeyPaths)) {
+            markMultikey = true;
+            if (batchMultikeyPaths.empty()) {
+                batchMultikeyPaths = std::move(multikeyPaths);
+            } else if (!multikeyPaths.empty()) {
+                invariant(batchMultikeyPaths.size() == multikeyPaths.size());
+                for (size_t i = 0; i < multikeyPaths.size(); ++i) {
+                    batchMultikeyPaths[i].insert(multikeyPaths[i].begin(), multikeyPaths[i].end());
+                }
+            }
+        }
+        multikeyMetadataKeys.insert(docMultikeyMetadataKeys.begin(),
+                                    docMultikeyMetadataKeys.end());
+        for (const auto& key : keys) {
+            entries.emplace_back(key, bsonRecord.id);
+        }
+    }
+
+    std::sort(entries.begin(),
+              entries.end(),
+              IndexEntryComparison(Ordering::make(_descriptor->keyPattern())));
+
+    // Keys that collide on a unique index get the same treatment as in insertKeys(), after
+    // which the rest of the batch is resumed from the following entry.
+    const bool unique = _descriptor->unique();
+    auto it = entries.cbegin();
+    while (it != entries.cend()) {
+        size_t numInserted = 0;
+        Status status =
+            _newInterface->insertBatch(opCtx, it, entries.cend(), !unique, &numInserted);
+        it += numInserted;
+        if (status.isOK()) {
+            break;
+        }
+
+        if (ErrorCodes::DuplicateKey == status.code() && options.dupsAllowed) {
+            invariant(unique);
+            status = _newInterface->insert(opCtx, it->key, it->loc, true /* dupsAllowed */);
+            if (status.isOK() && result) {
+                result->dupsInserted.push_back(it->key);
+            }
+        }
+        if (isFatalError(opCtx, status, it->key)) {
+            return status;
+        }
+        ++it;
+    }
+
+    if (result) {
+        result->numInserted += entries.size();
+    }
+
+    if (!multikeyMetadataKeys.empty()) {
+        Status status = insertKeys(opCtx,
+                                   {},
+                                   {multikeyMetadataKeys.begin(), multikeyMetadataKeys.end()},
+                                   {},
+                                   kMultikeyMetadataKeyId,
+                                   options,
+                                   result);
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+
+    if (markMultikey) {
+        _btreeState->setMultikey(opCtx, batchMultikeyPaths);
+    }
+    return Status::OK();
+}
+
 void AbstractIndexAccessMethod::removeOneKey(OperationContext* opCtx,
                                              const BSONObj& key,
                                              const RecordId& loc,
@@ -47,6 +47,7 @@ namespace mongo {
 
 class BSONObjBuilder;
 class MatchExpression;
+struct BsonRecord;
 struct UpdateTicket;
 struct InsertResult;
 struct InsertDeleteOptions;
@@ -98,6 +99,18 @@ public:
                               const InsertDeleteOptions& options,
                               InsertResult* result) = 0;
 
+    /**
+     * Equivalent to calling insert() for each document in 'bsonRecords', but generates the keys
+     * of the whole batch first, sorts them in index order and applies them through
+     * SortedDataInterface::insertBatch(). The index is marked multikey at most once per batch.
+     *
+     * Any timestamp shared by the batch must already be set on the recovery unit.
+     */
+    virtual Status insertBatch(OperationContext* opCtx,
+                               const std::vector<BsonRecord>& bsonRecords,
+                               const InsertDeleteOptions& options,
+                               InsertResult* result) = 0;
+
     /**
      * Analogous to insertKeys above, but remove the keys instead of inserting them.
      * 'numDeleted' will be set to the number of keys removed from the index for the provided keys.
@@ -464,6 +477,11 @@ public:
                       const InsertDeleteOptions& options,
                       InsertResult* result) final;
 
+    Status insertBatch(OperationContext* opCtx,
+                       const std::vector<BsonRecord>& bsonRecords,
+                       const InsertDeleteOptions& options,
+                       InsertResult* result) final;
+
     Status removeKeys(OperationContext* opCtx,
                       const std::vector<BSONObj>& keys,
                       const RecordId& loc,
@@ -0,0 +1,342 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_match_expression.h"
+
+#include <cmath>
+
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/matcher/expression_path.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+template <typename T>
+int compareValues(const T& lhs, const T& rhs) {
+    return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+}
+
+bool comparisonHolds(MatchExpression::MatchType comparison, int cmp) {
+    switch (comparison) {
+        case MatchExpression::LT:
+            return cmp < 0;
+        case MatchExpression::LTE:
+            return cmp <= 0;
+        case MatchExpression::EQ:
+            return cmp == 0;
+        case MatchExpression::GT:
+            return cmp > 0;
+        case MatchExpression::GTE:
+            return cmp >= 0;
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+/**
+ * Returns true if 'path' is non-empty and has no empty components.
+ */
+bool isCompilablePath(StringData path) {
+    if (path.empty()) {
+        return false;
+    }
+    size_t start = 0;
+    while (true) {
+        const size_t dot = path.find('.', start);
+        const size_t end = dot == std::string::npos ? path.size() : dot;
+        if (end == start) {
+            return false;
+        }
+        if (dot == std::string::npos) {
+            return true;
+        }
+        start = dot + 1;
+    }
+}
+
+}  // namespace
+
+std::unique_ptr<CompiledMatchExpression> CompiledMatchExpression::compile(
+    const MatchExpression* expr) {
+    invariant(expr);
+
+    std::unique_ptr<CompiledMatchExpression> compiled(new CompiledMatchExpression());
+    compiled->_pathNodes.emplace_back();
+    compiled->compileNode(expr);
+
+    if (compiled->_pathNodes.size() == 1) {
+        // There are no path-based predicates, so every instruction would defer to matchesBSON().
+        return nullptr;
+    }
+    return compiled;
+}
+
+void CompiledMatchExpression::compileNode(const MatchExpression* expr) {
+    const size_t pc = _program.size();
+    _program.emplace_back();
+    _program[pc].expr = expr;
+
+    switch (expr->matchType()) {
+        case MatchExpression::AND:
+            _program[pc].op = Op::kAnd;
+            break;
+        case MatchExpression::OR:
+            _program[pc].op = Op::kOr;
+            break;
+        case MatchExpression::NOR:
+            _program[pc].op = Op::kNor;
+            break;
+        case MatchExpression::NOT:
+            _program[pc].op = Op::kNot;
+            break;
+        default: {
+            auto pathExpr = dynamic_cast<const PathMatchExpression*>(expr);
+            if (!pathExpr || !isCompilablePath(pathExpr->path())) {
+                _program[pc].op = Op::kOpaque;
+                break;
+            }
+
+            const size_t pathNode = addPath(pathExpr->path());
+            Instruction& instruction = _program[pc];
+            instruction.op = Op::kPath;
+            instruction.pathNode = pathNode;
+
+            if (!ComparisonMatchExpression::isComparisonMatchExpression(expr)) {
+                break;
+            }
+
+            auto comparison = static_cast<const ComparisonMatchExpression*>(expr);
+            const BSONElement& rhs = comparison->getData();
+            instruction.comparison = expr->matchType();
+            switch (rhs.type()) {
+                case BSONType::NumberInt:
+                case BSONType::NumberLong:
+                    instruction.op = Op::kCompareIntegral;
+                    instruction.integralOperand = rhs.numberLong();
+                    break;
+                case BSONType::NumberDouble:
+                    // NaN has special equality semantics, so leave it to the general path.
+                    if (!std::isnan(rhs.numberDouble())) {
+                        instruction.op = Op::kCompareDouble;
+                        instruction.doubleOperand = rhs.numberDouble();
+                    }
+                    break;
+                case BSONType::String:
+                    if (!comparison->getCollator()) {
+                        instruction.op = Op::kCompareString;
+                        instruction.stringOperand = rhs.valueStringData();
+                    }
+                    break;
+                default:
+                    break;
+            }
+            break;
+        }
+    }
+
+    if (Op::kAnd == _program[pc].op || Op::kOr == _program[pc].op ||
+        Op::kNor == _program[pc].op || Op::kNot == _program[pc].op) {
+        for (size_t i = 0; i < expr->numChildren(); ++i) {
+            compileNode(expr->getChild(i));
+        }
+    }
+
+    _program[pc].end = _program.size();
+}
+
+size_t CompiledMatchExpression::addPath(StringData path) {
+    size_t node = 0;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t dot = path.find('.', start);
+        if (dot == std::string::npos) {
+            dot = path.size();
+        }
+        // Point into the expression's own copy of the path, which outlives the program.
+        const StringData component = path.substr(start, dot - start);
+
+        size_t next = 0;
+        for (size_t child : _pathNodes[node].children) {
+            if (_pathNodes[child].fieldName == component) {
+                next = child;
+                break;
+            }
+        }
+        if (!next) {
+            next = _pathNodes.size();
+            _pathNodes.emplace_back();
+            _pathNodes[next].fieldName = component;
+            _pathNodes[node].children.push_back(next);
+        }
+
+        node = next;
+        start = dot + 1;
+    }
+    return node;
+}
+
+void CompiledMatchExpression::resolvePaths(size_t node, const BSONObj& obj) {
+    const std::vector<size_t>& children = _pathNodes[node].children;
+    for (size_t child : children) {
+        PathNode& childNode = _pathNodes[child];
+        childNode.element = BSONElement();
+        childNode.found = false;
+        childNode.reachesArray = false;
+    }
+
+    // Like BSONObj::getField(), take the first occurrence of each field name.
+    size_t remaining = children.size();
+    BSONObjIterator it(obj);
+    while (remaining && it.more()) {
+        const BSONElement elem = it.next();
+        const StringData fieldName = elem.fieldNameStringData();
+        for (size_t child : children) {
+            PathNode& childNode = _pathNodes[child];
+            if (!childNode.found && childNode.fieldName == fieldName) {
+                childNode.element = elem;
+                childNode.found = true;
+                --remaining;
+                break;
+            }
+        }
+    }
+
+    for (size_t child : children) {
+        PathNode& childNode = _pathNodes[child];
+        if (childNode.children.empty()) {
+            continue;
+        }
+        switch (childNode.element.type()) {
+            case BSONType::Object:
+                resolvePaths(child, childNode.element.embeddedObject());
+                break;
+            case BSONType::Array:
+                markDescendants(child, true);
+                break;
+            default:
+                // A path through a scalar or a missing field does not exist.
+                markDescendants(child, false);
+                break;
+        }
+    }
+}
+
+void CompiledMatchExpression::markDescendants(size_t node, bool reachesArray) {
+    for (size_t child : _pathNodes[node].children) {
+        PathNode& childNode = _pathNodes[child];
+        childNode.element = BSONElement();
+        childNode.found = false;
+        childNode.reachesArray = reachesArray;
+        markDescendants(child, reachesArray);
+    }
+}
+
+bool CompiledMatchExpression::matchesBSON(const BSONObj& doc) {
+    resolvePaths(0, doc);
+    return evaluate(0, doc);
+}
+
+bool CompiledMatchExpression::evaluate(size_t pc, const BSONObj& doc) const {
+    const Instruction& instruction = _program[pc];
+    switch (instruction.op) {
+        case Op::kAnd:
+            for (size_t child = pc + 1; child < instruction.end; child = _program[child].end) {
+                if (!evaluate(child, doc)) {
+                    return false;
+                }
+            }
+            return true;
+        case Op::kOr:
+            for (size_t child = pc + 1; child < instruction.end; child = _program[child].end) {
+                if (evaluate(child, doc)) {
+                    return true;
+                }
+            }
+            return false;
+        case Op::kNor:
+            for (size_t child = pc + 1; child < instruction.end; child = _program[child].end) {
+                if (evaluate(child, doc)) {
+                    return false;
+                }
+            }
+            return true;
+        case Op::kNot:
+            invariant(pc + 1 < instruction.end);
+            return !evaluate(pc + 1, doc);
+        case Op::kOpaque:
+            return instruction.expr->matchesBSON(doc);
+        default:
+            return evaluatePredicate(instruction, doc);
+    }
+}
+
+bool CompiledMatchExpression::evaluatePredicate(const Instruction& instruction,
+                                                const BSONObj& doc) const {
+    const PathNode& node = _pathNodes[instruction.pathNode];
+    const BSONElement& elem = node.element;
+
+    // Matching against arrays involves implicit traversal, array offsets and matching the array as
+    // a whole, so leave it to the expression itself.
+    if (node.reachesArray || elem.type() == BSONType::Array) {
+        return instruction.expr->matchesBSON(doc);
+    }
+
+    switch (instruction.op) {
+        case Op::kCompareIntegral:
+            if (elem.type() == BSONType::NumberInt || elem.type() == BSONType::NumberLong) {
+                return comparisonHolds(instruction.comparison,
+                                       compareValues(elem.numberLong(),
+                                                     instruction.integralOperand));
+            }
+            break;
+        case Op::kCompareDouble:
+            if (elem.type() == BSONType::NumberDouble && !std::isnan(elem._numberDouble())) {
+                return comparisonHolds(
+                    instruction.comparison,
+                    compareValues(elem._numberDouble(), instruction.doubleOperand));
+            }
+            break;
+        case Op::kCompareString:
+            if (elem.type() == BSONType::String) {
+                return comparisonHolds(instruction.comparison,
+                                       elem.valueStringData().compare(instruction.stringOperand));
+            }
+            break;
+        default:
+            break;
+    }
+
+    return instruction.expr->matchesSingleElement(elem);
+}
+
+}  // namespace mongo
@@ -0,0 +1,176 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mongo/bson/bsonelement.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+/**
+ * A CompiledMatchExpression evaluates a MatchExpression tree against BSON documents without
+ * walking the tree's virtual interface or re-resolving a dotted path for every predicate.
+ *
+ * Compilation flattens the tree into a linear program in which every node records where its
+ * subtree ends, so $and, $or and $nor short-circuit by jumping over their remaining children.
+ * The paths of all path-based predicates are merged into a trie. Before the program runs, the
+ * trie is resolved against the document in a single pass over each object visited, so predicates
+ * sharing a prefix (or a whole path) share its traversal. Comparisons against integral, double and
+ * string constants are specialized for the common case where the document holds a value of the
+ * same type.
+ *
+ * Arrays are where the match language gets its most subtle semantics, so any predicate whose
+ * path reaches an array falls back to the original expression's matchesBSON(). Expressions which
+ * are neither logical nodes nor path-based predicates are always evaluated through matchesBSON().
+ * The compiled program therefore matches exactly the documents the original expression matches.
+ *
+ * The MatchExpression passed to compile() must outlive the CompiledMatchExpression. Evaluation
+ * uses scratch state owned by the CompiledMatchExpression, so an instance must not be used by
+ * multiple threads concurrently.
+ */
+class CompiledMatchExpression {
+    CompiledMatchExpression(const CompiledMatchExpression&) = delete;
+    CompiledMatchExpression& operator=(const CompiledMatchExpression&) = delete;
+
+public:
+    /**
+     * Compiles 'expr'. Returns nullptr if the compiled form would not be any cheaper to evaluate,
+     * which is the case when 'expr' does not contain any path-based predicates.
+     */
+    static std::unique_ptr<CompiledMatchExpression> compile(const MatchExpression* expr);
+
+    /**
+     * Returns true if 'doc' matches the expression this was compiled from.
+     */
+    bool matchesBSON(const BSONObj& doc);
+
+    /**
+     * Returns the number of instructions in the compiled program.
+     */
+    size_t numInstructions() const {
+        return _program.size();
+    }
+
+    /**
+     * Returns the number of distinct path components which are resolved against each document.
+     */
+    size_t numPathComponents() const {
+        return _pathNodes.size() - 1;
+    }
+
+private:
+    enum class Op {
+        kAnd,
+        kOr,
+        kNor,
+        kNot,
+
+        // Any path-based predicate. Evaluated by calling matchesSingleElement() on the resolved
+        // element.
+        kPath,
+
+        // $eq, $lt, $lte, $gt and $gte against a constant of the named type. Evaluated inline when
+        // the resolved element has the same type, and like kPath otherwise.
+        kCompareIntegral,
+        kCompareDouble,
+        kCompareString,
+
+        // Evaluated by calling matchesBSON() on the whole document.
+        kOpaque,
+    };
+
+    struct Instruction {
+        Op op;
+
+        // Index of the first instruction after this instruction's subtree.
+        size_t end = 0;
+
+        const MatchExpression* expr = nullptr;
+
+        // The trie node holding the element at the predicate's path, for path-based predicates.
+        size_t pathNode = 0;
+
+        // The comparison and constant operand for the specialized comparison ops.
+        MatchExpression::MatchType comparison = MatchExpression::EQ;
+        long long integralOperand = 0;
+        double doubleOperand = 0;
+        StringData stringOperand;
+    };
+
+    /**
+     * A node in the trie of predicate paths. Node 0 is the root and represents the document itself.
+     */
+    struct PathNode {
+        StringData fieldName;
+        std::vector<size_t> children;
+
+        // Per-document state, set by resolvePaths(). 'element' is EOO if the path is missing.
+        BSONElement element;
+        bool found = false;
+        bool reachesArray = false;
+    };
+
+    CompiledMatchExpression() = default;
+
+    /**
+     * Appends the instructions for 'expr' and its subtree to the program.
+     */
+    void compileNode(const MatchExpression* expr);
+
+    /**
+     * Returns the index of the trie node for 'path', adding nodes as necessary.
+     */
+    size_t addPath(StringData path);
+
+    /**
+     * Resolves the children of trie node 'node', whose element is the object 'obj', and then
+     * recursively resolves their descendants.
+     */
+    void resolvePaths(size_t node, const BSONObj& obj);
+
+    /**
+     * Marks every descendant of trie node 'node' as unresolvable without array traversal, or as
+     * missing.
+     */
+    void markDescendants(size_t node, bool reachesArray);
+
+    bool evaluate(size_t pc, const BSONObj& doc) const;
+
+    bool evaluatePredicate(const Instruction& instruction, const BSONObj& doc) const;
+
+    std::vector<Instruction> _program;
+    std::vector<PathNode> _pathNodes;
+};
+
+}  // namespace mongo
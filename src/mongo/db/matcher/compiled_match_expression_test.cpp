@@ -0,0 +1,139 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_match_expression.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::unique_ptr<MatchExpression> parse(const BSONObj& filter,
+                                       const CollatorInterface* collator = nullptr) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    expCtx->setCollator(collator);
+    auto swExpr = MatchExpressionParser::parse(filter, expCtx);
+    ASSERT_OK(swExpr.getStatus());
+    return std::move(swExpr.getValue());
+}
+
+const std::vector<BSONObj> kDocuments = {
+    BSONObj(),
+    fromjson("{a: 1}"),
+    fromjson("{a: 5, b: 'x'}"),
+    fromjson("{a: 5.5, b: 'y'}"),
+    fromjson("{a: NumberLong(10), b: 'abc', c: {d: 3, e: 'z'}}"),
+    fromjson("{a: NaN, b: null}"),
+    fromjson("{a: null, c: {d: null}}"),
+    fromjson("{a: '5', b: 7, c: 4}"),
+    fromjson("{a: [1, 5, 10], c: {d: [2, 3]}}"),
+    fromjson("{a: [[5]], c: [{d: 3}, {d: 4}]}"),
+    fromjson("{a: {b: 1}, c: {d: {e: 1}}}"),
+    fromjson("{a: 3, a: 5, c: {d: 1, d: 3}}"),
+    fromjson("{b: 'X', c: {e: 'Z', d: 2.5}}"),
+    fromjson("{a: MinKey, b: MaxKey}"),
+    fromjson("{'': 1, a: {'': 2}}"),
+};
+
+/**
+ * Asserts that the compiled form of 'filter' matches exactly the documents which 'filter' matches.
+ */
+void assertCompiledMatchesInterpreted(const BSONObj& filter,
+                                      const CollatorInterface* collator = nullptr) {
+    auto expr = parse(filter, collator);
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT(compiled) << filter;
+    for (auto&& doc : kDocuments) {
+        ASSERT_EQ(expr->matchesBSON(doc), compiled->matchesBSON(doc))
+            << "filter: " << filter << " document: " << doc;
+    }
+}
+
+TEST(CompiledMatchExpressionTest, ComparisonsMatchInterpretedEvaluation) {
+    for (auto&& op : {"$eq", "$lt", "$lte", "$gt", "$gte"}) {
+        assertCompiledMatchesInterpreted(BSON("a" << BSON(op << 5)));
+        assertCompiledMatchesInterpreted(BSON("a" << BSON(op << 5LL)));
+        assertCompiledMatchesInterpreted(BSON("a" << BSON(op << 5.5)));
+        assertCompiledMatchesInterpreted(BSON("a" << BSON(op << std::nan(""))));
+        assertCompiledMatchesInterpreted(BSON("b" << BSON(op << "x")));
+        assertCompiledMatchesInterpreted(BSON("b" << BSON(op << BSONNULL)));
+        assertCompiledMatchesInterpreted(BSON("c.d" << BSON(op << 3)));
+        assertCompiledMatchesInterpreted(BSON("c.d.e" << BSON(op << 1)));
+        assertCompiledMatchesInterpreted(BSON("c.e" << BSON(op << "z")));
+        assertCompiledMatchesInterpreted(BSON("a" << BSON(op << MAXKEY)));
+        assertCompiledMatchesInterpreted(BSON("a" << BSON(op << BSON("b" << 1))));
+    }
+}
+
+TEST(CompiledMatchExpressionTest, LogicalOperatorsMatchInterpretedEvaluation) {
+    assertCompiledMatchesInterpreted(fromjson("{a: {$gte: 1, $lt: 10}, b: 'x'}"));
+    assertCompiledMatchesInterpreted(fromjson("{$or: [{a: 1}, {'c.d': 3}, {b: {$exists: false}}]}"));
+    assertCompiledMatchesInterpreted(fromjson("{$nor: [{a: 1}, {'c.d': {$gt: 2}}]}"));
+    assertCompiledMatchesInterpreted(fromjson("{a: {$not: {$gt: 4}}, 'c.d': {$ne: 3}}"));
+    assertCompiledMatchesInterpreted(fromjson("{$and: [{$or: [{a: 5}, {a: 1}]}, {b: {$in: ['x', null]}}]}"));
+    assertCompiledMatchesInterpreted(fromjson("{$or: [{a: {$size: 3}}, {c: {$type: 'object'}}]}"));
+    assertCompiledMatchesInterpreted(fromjson("{a: {$elemMatch: {$gt: 4}}, 'c.d': {$exists: true}}"));
+    assertCompiledMatchesInterpreted(fromjson("{'a.0': 1}"));
+    assertCompiledMatchesInterpreted(fromjson("{$expr: {$eq: ['$a', 5]}, b: {$exists: true}}"));
+}
+
+TEST(CompiledMatchExpressionTest, StringComparisonsRespectCollation) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kToLowerString);
+    assertCompiledMatchesInterpreted(fromjson("{b: 'X'}"), &collator);
+    assertCompiledMatchesInterpreted(fromjson("{b: {$gt: 'X'}}"), &collator);
+    assertCompiledMatchesInterpreted(fromjson("{'c.e': {$lte: 'z'}}"), &collator);
+}
+
+TEST(CompiledMatchExpressionTest, SharesPathPrefixes) {
+    auto expr = parse(fromjson("{a: {$gt: 1, $lt: 10}, 'c.d': 1, 'c.e': 2, 'c.d.f': 3}"));
+    auto compiled = CompiledMatchExpression::compile(expr.get());
+    ASSERT(compiled);
+    // a, c, c.d, c.e and c.d.f.
+    ASSERT_EQ(5U, compiled->numPathComponents());
+    // The $and, and one instruction for each predicate.
+    ASSERT_EQ(6U, compiled->numInstructions());
+}
+
+TEST(CompiledMatchExpressionTest, DoesNotCompileExpressionsWithoutPaths) {
+    auto expr = parse(fromjson("{$expr: {$eq: ['$a', 5]}}"));
+    ASSERT_FALSE(CompiledMatchExpression::compile(expr.get()));
+
+    expr = parse(fromjson("{$alwaysFalse: 1}"));
+    ASSERT_FALSE(CompiledMatchExpression::compile(expr.get()));
+}
+
+}  // namespace
+}  // namespace mongo
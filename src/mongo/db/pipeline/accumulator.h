@@ -38,6 +38,7 @@
 
 #include "mongo/base/init.h"
 #include "mongo/bson/bsontypes.h"
+#include "mongo/db/pipeline/column_batch.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
@@ -77,6 +78,18 @@ public:
         processInternal(input, merging);
     }
 
+    /**
+     * Processes the values of 'column' at 'rows', in order, as if process() had been called on
+     * each of them with 'merging' false. Accumulators which can consume unboxed numeric columns
+     * override this to avoid materializing a Value per row.
+     */
+    virtual void processColumn(const ColumnBatch::Column& column,
+                               const std::vector<uint32_t>& rows) {
+        for (auto row : rows) {
+            processInternal(column.getValue(row), false);
+        }
+    }
+
     /** Marks the end of the evaluate() phase and return accumulated result.
      *  toBeMerged should be true when the outputs will be merged by process().
      */
@@ -195,6 +208,8 @@ public:
     explicit AccumulatorSum(const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
     void processInternal(const Value& input, bool merging) final;
+    void processColumn(const ColumnBatch::Column& column,
+                       const std::vector<uint32_t>& rows) final;
     Value getValue(bool toBeMerged) final;
     const char* getOpName() const final;
     void reset() final;
@@ -283,6 +298,8 @@ public:
     explicit AccumulatorAvg(const boost::intrusive_ptr<ExpressionContext>& expCtx);
 
     void processInternal(const Value& input, bool merging) final;
+    void processColumn(const ColumnBatch::Column& column,
+                       const std::vector<uint32_t>& rows) final;
     Value getValue(bool toBeMerged) final;
     const char* getOpName() const final;
     void reset() final;
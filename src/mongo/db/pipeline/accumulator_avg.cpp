@@ -93,6 +93,32 @@ void AccumulatorAvg::processInternal(const Value& input, bool merging) {
     _count++;
 }
 
+void AccumulatorAvg::processColumn(const ColumnBatch::Column& column,
+                                   const std::vector<uint32_t>& rows) {
+    // Each unboxed value is added exactly as processInternal() would add it.
+    switch (column.getType()) {
+        case ColumnBatch::Column::Type::kEmpty:
+            return;
+        case ColumnBatch::Column::Type::kInt:
+            _count += column.forEachValue(
+                column.getInts(), rows, [&](int value) { _nonDecimalTotal.addDouble(value); });
+            return;
+        case ColumnBatch::Column::Type::kLong:
+            _count += column.forEachValue(
+                column.getLongs(), rows, [&](long long value) { _nonDecimalTotal.addLong(value); });
+            return;
+        case ColumnBatch::Column::Type::kDouble:
+            _count += column.forEachValue(column.getDoubles(), rows, [&](double value) {
+                _nonDecimalTotal.addDouble(value);
+            });
+            return;
+        case ColumnBatch::Column::Type::kGeneric:
+            Accumulator::processColumn(column, rows);
+            return;
+    }
+    MONGO_UNREACHABLE;
+}
+
 intrusive_ptr<Accumulator> AccumulatorAvg::create(
     const boost::intrusive_ptr<ExpressionContext>& expCtx) {
     return new AccumulatorAvg(expCtx);
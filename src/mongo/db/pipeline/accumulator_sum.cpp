@@ -85,6 +85,41 @@ void AccumulatorSum::processInternal(const Value& input, bool merging) {
     }
 }
 
+void AccumulatorSum::processColumn(const ColumnBatch::Column& column,
+                                   const std::vector<uint32_t>& rows) {
+    // Each unboxed value is added exactly as processInternal() would add it.
+    size_t numAdded;
+    switch (column.getType()) {
+        case ColumnBatch::Column::Type::kEmpty:
+            return;
+        case ColumnBatch::Column::Type::kInt:
+            numAdded = column.forEachValue(
+                column.getInts(), rows, [&](int value) { nonDecimalTotal.addLong(value); });
+            if (numAdded > 0) {
+                totalType = Value::getWidestNumeric(totalType, NumberInt);
+            }
+            return;
+        case ColumnBatch::Column::Type::kLong:
+            numAdded = column.forEachValue(
+                column.getLongs(), rows, [&](long long value) { nonDecimalTotal.addLong(value); });
+            if (numAdded > 0) {
+                totalType = Value::getWidestNumeric(totalType, NumberLong);
+            }
+            return;
+        case ColumnBatch::Column::Type::kDouble:
+            numAdded = column.forEachValue(
+                column.getDoubles(), rows, [&](double value) { nonDecimalTotal.addDouble(value); });
+            if (numAdded > 0) {
+                totalType = Value::getWidestNumeric(totalType, NumberDouble);
+            }
+            return;
+        case ColumnBatch::Column::Type::kGeneric:
+            Accumulator::processColumn(column, rows);
+            return;
+    }
+    MONGO_UNREACHABLE;
+}
+
 intrusive_ptr<Accumulator> AccumulatorSum::create(
     const boost::intrusive_ptr<ExpressionContext>& expCtx) {
     return new AccumulatorSum(expCtx);
@@ -0,0 +1,190 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/column_batch.h"
+
+namespace mongo {
+
+ColumnBatch::Column::Type ColumnBatch::Column::typeFor(const Value& value) {
+    switch (value.getType()) {
+        case EOO:
+        case jstNULL:
+            return Type::kEmpty;
+        case NumberInt:
+            return Type::kInt;
+        case NumberLong:
+            return Type::kLong;
+        case NumberDouble:
+            return Type::kDouble;
+        default:
+            return Type::kGeneric;
+    }
+}
+
+void ColumnBatch::Column::append(const Value& value) {
+    const Type valueType = typeFor(value);
+
+    if (_type == Type::kGeneric) {
+        _values.push_back(value);
+        ++_size;
+        return;
+    }
+
+    if (valueType == Type::kEmpty) {
+        if (!_hasNullish) {
+            _hasNullish = true;
+            _nullish.assign(_size, false);
+            _missing.assign(_size, false);
+        }
+        _nullish.push_back(true);
+        _missing.push_back(value.missing());
+        switch (_type) {
+            case Type::kInt:
+                _ints.push_back(0);
+                break;
+            case Type::kLong:
+                _longs.push_back(0);
+                break;
+            case Type::kDouble:
+                _doubles.push_back(0);
+                break;
+            default:
+                break;
+        }
+        ++_size;
+        return;
+    }
+
+    if (_type == Type::kEmpty) {
+        setType(valueType);
+    } else if (_type != valueType) {
+        convertToGeneric();
+        _values.push_back(value);
+        ++_size;
+        return;
+    }
+
+    if (_hasNullish) {
+        _nullish.push_back(false);
+        _missing.push_back(false);
+    }
+    switch (_type) {
+        case Type::kInt:
+            _ints.push_back(value.getInt());
+            break;
+        case Type::kLong:
+            _longs.push_back(value.getLong());
+            break;
+        case Type::kDouble:
+            _doubles.push_back(value.getDouble());
+            break;
+        default:
+            MONGO_UNREACHABLE;
+    }
+    ++_size;
+}
+
+void ColumnBatch::Column::setType(Type type) {
+    invariant(_type == Type::kEmpty);
+    _type = type;
+    switch (_type) {
+        case Type::kInt:
+            _ints.assign(_size, 0);
+            break;
+        case Type::kLong:
+            _longs.assign(_size, 0);
+            break;
+        case Type::kDouble:
+            _doubles.assign(_size, 0);
+            break;
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+void ColumnBatch::Column::convertToGeneric() {
+    invariant(_type != Type::kGeneric);
+    _values.clear();
+    _values.reserve(_size);
+    for (size_t row = 0; row < _size; ++row) {
+        _values.push_back(getValue(row));
+    }
+
+    _type = Type::kGeneric;
+    _hasNullish = false;
+    _nullish.clear();
+    _missing.clear();
+    _ints.clear();
+    _longs.clear();
+    _doubles.clear();
+}
+
+Value ColumnBatch::Column::getValue(size_t row) const {
+    dassert(row < _size);
+    if (_type == Type::kGeneric) {
+        return _values[row];
+    }
+
+    if (_hasNullish && _nullish[row]) {
+        return _missing[row] ? Value() : Value(BSONNULL);
+    }
+
+    switch (_type) {
+        case Type::kInt:
+            return Value(_ints[row]);
+        case Type::kLong:
+            return Value(_longs[row]);
+        case Type::kDouble:
+            return Value(_doubles[row]);
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+void ColumnBatch::Column::clear() {
+    _type = Type::kEmpty;
+    _size = 0;
+    _hasNullish = false;
+    _nullish.clear();
+    _missing.clear();
+    _ints.clear();
+    _longs.clear();
+    _doubles.clear();
+    _values.clear();
+}
+
+void ColumnBatch::clear() {
+    for (auto&& column : _columns) {
+        column.clear();
+    }
+}
+
+}  // namespace mongo
@@ -0,0 +1,190 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mongo/db/pipeline/value.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+/**
+ * A batch of rows stored column by column, used by stages which can process many input documents
+ * at once. Each column holds the values of one expression (typically a field path in the
+ * dependency set of the consuming stage) for every row in the batch.
+ *
+ * Converting a batch back to Documents is left to the consuming stage, which knows what each
+ * column represents.
+ */
+class ColumnBatch {
+public:
+    /**
+     * The values of one column. As long as every value appended to the column is either nullish
+     * or of one numeric type, the values are stored unboxed in a vector of that type, with a bitmap
+     * of the nullish rows, so that consumers such as accumulators can run tight loops over them.
+     * Any other mix of types falls back to storing Values.
+     */
+    class Column {
+    public:
+        enum class Type {
+            kEmpty,  // Every row so far is null or missing.
+            kInt,
+            kLong,
+            kDouble,
+            kGeneric,
+        };
+
+        void append(const Value& value);
+
+        void clear();
+
+        Type getType() const {
+            return _type;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        /**
+         * Returns true if the given row is null or missing. Only valid for typed columns, that is
+         * columns whose type is not kGeneric.
+         */
+        bool isNullish(size_t row) const {
+            dassert(_type != Type::kGeneric);
+            return _hasNullish && _nullish[row];
+        }
+
+        /**
+         * The unboxed values of a column of the corresponding type. Entries for nullish rows are
+         * zero.
+         */
+        const std::vector<int>& getInts() const {
+            dassert(_type == Type::kInt);
+            return _ints;
+        }
+        const std::vector<long long>& getLongs() const {
+            dassert(_type == Type::kLong);
+            return _longs;
+        }
+        const std::vector<double>& getDoubles() const {
+            dassert(_type == Type::kDouble);
+            return _doubles;
+        }
+
+        /**
+         * Calls 'fn' on the unboxed value of each of 'rows' which is not nullish, in order.
+         * 'values' must be the vector returned by the accessor matching the column's type. Returns
+         * the number of values visited.
+         */
+        template <typename T, typename Fn>
+        size_t forEachValue(const std::vector<T>& values,
+                            const std::vector<uint32_t>& rows,
+                            Fn&& fn) const {
+            size_t visited = 0;
+            if (!_hasNullish) {
+                for (auto row : rows) {
+                    fn(values[row]);
+                }
+                return rows.size();
+            }
+            for (auto row : rows) {
+                if (!_nullish[row]) {
+                    fn(values[row]);
+                    ++visited;
+                }
+            }
+            return visited;
+        }
+
+        /**
+         * Returns the value of the given row as a Value. This is the boundary back to the
+         * row-oriented representation.
+         */
+        Value getValue(size_t row) const;
+
+    private:
+        /**
+         * Starts storing unboxed values of 'type', back-filling zeros for the nullish rows seen so
+         * far.
+         */
+        void setType(Type type);
+
+        /**
+         * Boxes every value appended so far and switches the column to kGeneric.
+         */
+        void convertToGeneric();
+
+        static Type typeFor(const Value& value);
+
+        Type _type = Type::kEmpty;
+        size_t _size = 0;
+
+        // For typed columns, which rows are nullish and, of those, which are missing rather than
+        // null. Both are only maintained once the column has seen a nullish value.
+        bool _hasNullish = false;
+        std::vector<bool> _nullish;
+        std::vector<bool> _missing;
+
+        std::vector<int> _ints;
+        std::vector<long long> _longs;
+        std::vector<double> _doubles;
+        std::vector<Value> _values;
+    };
+
+    explicit ColumnBatch(size_t numColumns) : _columns(numColumns) {}
+
+    size_t numColumns() const {
+        return _columns.size();
+    }
+
+    size_t numRows() const {
+        return _columns.empty() ? 0 : _columns[0].size();
+    }
+
+    Column& getColumn(size_t i) {
+        return _columns[i];
+    }
+    const Column& getColumn(size_t i) const {
+        return _columns[i];
+    }
+
+    /**
+     * Empties every column, keeping their capacity, so that the batch can be refilled.
+     */
+    void clear();
+
+private:
+    std::vector<Column> _columns;
+};
+
+}  // namespace mongo
@@ -0,0 +1,99 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/column_batch.h"
+
+#include "mongo/db/pipeline/document_value_test_util.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using Column = ColumnBatch::Column;
+
+TEST(ColumnBatchTest, NumericColumnStaysUnboxedAcrossNullishValues) {
+    Column column;
+    column.append(Value(BSONNULL));
+    column.append(Value(1.5));
+    column.append(Value());
+    column.append(Value(2.5));
+
+    ASSERT(column.getType() == Column::Type::kDouble);
+    ASSERT_EQ(column.size(), 4UL);
+    ASSERT_TRUE(column.isNullish(0));
+    ASSERT_FALSE(column.isNullish(1));
+    ASSERT_TRUE(column.isNullish(2));
+
+    ASSERT_VALUE_EQ(column.getValue(0), Value(BSONNULL));
+    ASSERT_VALUE_EQ(column.getValue(1), Value(1.5));
+    ASSERT_TRUE(column.getValue(2).missing());
+    ASSERT_VALUE_EQ(column.getValue(3), Value(2.5));
+
+    double sum = 0;
+    const size_t visited =
+        column.forEachValue(column.getDoubles(), {0, 1, 2, 3}, [&](double value) { sum += value; });
+    ASSERT_EQ(visited, 2UL);
+    ASSERT_EQ(sum, 4.0);
+}
+
+TEST(ColumnBatchTest, MixedTypesFallBackToGenericColumn) {
+    Column column;
+    column.append(Value(1));
+    column.append(Value());
+    column.append(Value(2LL));
+    column.append(Value("str"_sd));
+
+    ASSERT(column.getType() == Column::Type::kGeneric);
+    ASSERT_VALUE_EQ(column.getValue(0), Value(1));
+    ASSERT_EQ(column.getValue(0).getType(), NumberInt);
+    ASSERT_TRUE(column.getValue(1).missing());
+    ASSERT_VALUE_EQ(column.getValue(2), Value(2LL));
+    ASSERT_EQ(column.getValue(2).getType(), NumberLong);
+    ASSERT_VALUE_EQ(column.getValue(3), Value("str"_sd));
+}
+
+TEST(ColumnBatchTest, ClearResetsColumnType) {
+    ColumnBatch batch(2);
+    batch.getColumn(0).append(Value(1));
+    batch.getColumn(1).append(Value("str"_sd));
+    ASSERT_EQ(batch.numRows(), 1UL);
+
+    batch.clear();
+    ASSERT_EQ(batch.numRows(), 0UL);
+    ASSERT(batch.getColumn(0).getType() == Column::Type::kEmpty);
+    ASSERT(batch.getColumn(1).getType() == Column::Type::kEmpty);
+
+    batch.getColumn(1).append(Value(3LL));
+    ASSERT(batch.getColumn(1).getType() == Column::Type::kLong);
+}
+
+}  // namespace
+}  // namespace mongo
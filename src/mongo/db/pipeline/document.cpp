@@ -258,13 +258,20 @@ void DocumentStorage::alloc(unsigned newSize) {
 
     uassert(16490, "Tried to make oversized document", capacity <= size_t(BufferMaxSize));
 
-    std::unique_ptr<char[]> oldBuf(_cache);
-    _cache = new char[capacity];
+    boost::intrusive_ptr<DocumentArena::Block> newArenaBlock;
+    char* const newBuf = allocateCache(capacity, &newArenaBlock);
+
+    // Only heap buffers are freed here; an arena buffer is released together with its block, which
+    // 'oldArenaBlock' keeps alive until the fields have been copied.
+    std::unique_ptr<char[]> oldHeapBuf(_arenaBlock ? nullptr : _cache);
+    const auto oldArenaBlock = std::exchange(_arenaBlock, std::move(newArenaBlock));
+    const char* const oldBuf = _cache;
+    _cache = newBuf;
     _cacheEnd = _cache + capacity - hashTabBytes();
 
     if (!firstAlloc) {
         // This just copies the elements
-        memcpy(_cache, oldBuf.get(), _usedBytes);
+        memcpy(_cache, oldBuf, _usedBytes);
 
         if (_numFields >= HASH_TAB_MIN) {
             // if we were hashing, deal with the hash table
@@ -272,7 +279,7 @@ void DocumentStorage::alloc(unsigned newSize) {
                 rehash();
             } else {
                 // no rehash needed so just slide table down to new position
-                memcpy(_hashTab, oldBuf.get() + oldCapacity, hashTabBytes());
+                memcpy(_hashTab, oldBuf + oldCapacity, hashTabBytes());
             }
         }
     }
@@ -291,10 +298,20 @@ void DocumentStorage::reserveFields(size_t expectedFields) {
 
     uassert(16491, "Tried to make oversized document", newSize <= size_t(BufferMaxSize));
 
-    _cache = new char[newSize + hashTabBytes()];
+    _cache = allocateCache(newSize + hashTabBytes(), &_arenaBlock);
     _cacheEnd = _cache + newSize;
 }
 
+char* DocumentStorage::allocateCache(size_t bytes,
+                                     boost::intrusive_ptr<DocumentArena::Block>* arenaBlock) {
+    if (auto arena = DocumentArena::current()) {
+        if (char* buf = arena->allocate(bytes, arenaBlock)) {
+            return buf;
+        }
+    }
+    return new char[bytes];
+}
+
 intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
     auto out = make_intrusive<DocumentStorage>(_bson, _stripMetadata);
 
@@ -302,7 +319,8 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
         // Make a copy of the buffer with the fields.
         // It is very important that the positions of each field are the same after cloning.
         const size_t bufferBytes = allocatedBytes();
-        out->_cache = new char[bufferBytes];
+        out->_cache = allocateCache(bufferBytes, &out->_arenaBlock);
+        out->_mayHoldArenaValues = _mayHoldArenaValues;
         out->_cacheEnd = out->_cache + (_cacheEnd - _cache);
         memcpy(out->_cache, _cache, bufferBytes);
 
@@ -331,6 +349,17 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
     return out;
 }
 
+intrusive_ptr<DocumentStorage> DocumentStorage::cloneOutOfArena() const {
+    DocumentArena::Scope heapOnly(nullptr);
+
+    auto out = clone();
+    for (auto it = out->iteratorCacheOnly(); !it.atEnd(); it.advance()) {
+        out->getField(it.position()).val = it->val.getOwned();
+    }
+    out->_mayHoldArenaValues = false;
+    return out;
+}
+
 MetadataFields::MetadataFields(const MetadataFields& other) {
     _metaFields = other._metaFields;
     _textScore = other._textScore;
@@ -366,7 +395,8 @@ size_t DocumentStorage::getMetadataApproximateSize() const {
 }
 
 DocumentStorage::~DocumentStorage() {
-    std::unique_ptr<char[]> deleteBufferAtScopeEnd(_cache);
+    // A buffer taken from an arena is released with the block, after the Values below are gone.
+    std::unique_ptr<char[]> deleteBufferAtScopeEnd(_arenaBlock ? nullptr : _cache);
 
     for (auto it = iteratorCacheOnly(); !it.atEnd(); it.advance()) {
         it->val.~Value();  // explicit destructor call
@@ -649,6 +679,13 @@ string Document::toString() const {
     return out.str();
 }
 
+Document Document::getOwned() const {
+    if (!isArenaBacked()) {
+        return *this;
+    }
+    return Document(_storage->cloneOutOfArena().get());
+}
+
 void Document::serializeForSorter(BufBuilder& buf) const {
     const int numElems = size();
     buf.appendNum(numElems);
@@ -318,8 +318,20 @@ public:
     int memUsageForSorter() const {
         return getApproximateSize();
     }
-    Document getOwned() const {
-        return *this;
+
+    /**
+     * Returns a Document which does not reference memory in any DocumentArena, copying this
+     * Document if it does. Call this before holding on to a Document beyond the batch in which it
+     * was produced.
+     */
+    Document getOwned() const;
+
+    /**
+     * Returns true if this Document, or a Value nested in it, may live in a DocumentArena. This is
+     * a constant-time check; see DocumentStorage::isArenaBacked().
+     */
+    bool isArenaBacked() const {
+        return _storage && _storage->isArenaBacked();
     }
 
     /// only for testing
@@ -639,14 +651,18 @@ private:
 
     // This is split into 3 functions to speed up the fast-path
     DocumentStorage& storage() {
-        if (MONGO_unlikely(!_storage))
-            return newStorage();
-
-        if (MONGO_unlikely(_storage->isShared()))
-            return clonedStorage();
-
-        // This function exists to ensure this is safe
-        return const_cast<DocumentStorage&>(*storagePtr());
+        DocumentStorage& out = [&]() -> DocumentStorage& {
+            if (MONGO_unlikely(!_storage))
+                return newStorage();
+
+            if (MONGO_unlikely(_storage->isShared()))
+                return clonedStorage();
+
+            // This function exists to ensure this is safe
+            return const_cast<DocumentStorage&>(*storagePtr());
+        }();
+        out.noteModification();
+        return out;
     }
     DocumentStorage& newStorage() {
         reset(make_intrusive<DocumentStorage>());
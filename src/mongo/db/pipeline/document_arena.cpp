@@ -0,0 +1,77 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_arena.h"
+
+namespace mongo {
+namespace {
+
+thread_local DocumentArena* currentArena = nullptr;
+
+}  // namespace
+
+DocumentArena::Scope::Scope(DocumentArena* arena) : _previous(currentArena) {
+    currentArena = arena;
+}
+
+DocumentArena::Scope::~Scope() {
+    currentArena = _previous;
+}
+
+DocumentArena* DocumentArena::current() {
+    return currentArena;
+}
+
+bool DocumentArena::isActive() {
+    return currentArena && currentArena->_blockBytes > 0;
+}
+
+char* DocumentArena::allocate(size_t bytes, boost::intrusive_ptr<Block>* block) {
+    // Only small buffers are worth packing into a block. Large documents would waste most of the
+    // block they leave behind, and would pin it for as long as they live.
+    if (bytes > _blockBytes / 8) {
+        return nullptr;
+    }
+
+    const size_t alignedBytes = (bytes + kAlignment - 1) & ~(kAlignment - 1);
+
+    char* out = _currentBlock ? _currentBlock->allocate(alignedBytes) : nullptr;
+    if (!out) {
+        // The previous block stays alive for as long as any DocumentStorage still refers to it.
+        _currentBlock = make_intrusive<Block>(_blockBytes);
+        out = _currentBlock->allocate(alignedBytes);
+    }
+
+    *block = _currentBlock;
+    return out;
+}
+
+}  // namespace mongo
@@ -0,0 +1,141 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <cstddef>
+#include <memory>
+
+#include "mongo/util/intrusive_counter.h"
+
+namespace mongo {
+
+/**
+ * A bump allocator for the field buffers of transient DocumentStorage objects.
+ *
+ * Aggregation stages such as $project and $addFields create and destroy a Document for every input
+ * document. Rather than allocating each field buffer from the global heap, buffers created while a
+ * DocumentArena::Scope is active are carved out of large blocks owned by the arena. A block is
+ * released as a whole once the arena has moved on to a newer block and every DocumentStorage which
+ * was allocated from it has been destroyed.
+ *
+ * Because a Document holds a reference to the block backing it, a Document which outlives the batch
+ * it was produced in remains valid, but keeps its whole block alive. Stages which hold Documents or
+ * Values across batches (for example the $group table or the $sort buffer) should therefore call
+ * getOwned() on them, which copies anything arena-backed to the heap.
+ *
+ * An arena is not thread-safe: it must only be installed on the thread executing its pipeline.
+ */
+class DocumentArena {
+    DocumentArena(const DocumentArena&) = delete;
+    DocumentArena& operator=(const DocumentArena&) = delete;
+
+public:
+    /**
+     * A chunk of memory from which buffers are bump-allocated. Each DocumentStorage with a buffer
+     * in the block holds a reference to it.
+     */
+    class Block : public RefCountable {
+    public:
+        explicit Block(size_t capacity) : _buffer(new char[capacity]), _capacity(capacity) {}
+
+        /**
+         * Returns a buffer of 'bytes' bytes, or nullptr if the block does not have enough space
+         * left. 'bytes' must be a multiple of kAlignment.
+         */
+        char* allocate(size_t bytes) {
+            if (bytes > _capacity - _used) {
+                return nullptr;
+            }
+            char* out = _buffer.get() + _used;
+            _used += bytes;
+            return out;
+        }
+
+    private:
+        std::unique_ptr<char[]> _buffer;
+        const size_t _capacity;
+        size_t _used = 0;
+    };
+
+    /**
+     * Makes 'arena' the arena used by DocumentStorage allocations on the current thread for the
+     * lifetime of the Scope, restoring the previous arena afterwards. Passing nullptr forces
+     * allocations onto the heap.
+     */
+    class Scope {
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    public:
+        explicit Scope(DocumentArena* arena);
+        ~Scope();
+
+    private:
+        DocumentArena* const _previous;
+    };
+
+    // Alignment of every buffer handed out by the arena. This matches what operator new[] returns.
+    static constexpr size_t kAlignment = alignof(std::max_align_t);
+
+    /**
+     * Creates an arena which allocates blocks of 'blockBytes' bytes. An arena with a block size of
+     * zero never allocates, so all buffers come from the heap.
+     */
+    explicit DocumentArena(size_t blockBytes) : _blockBytes(blockBytes) {}
+
+    /**
+     * Returns the arena installed on the current thread, or nullptr if there is none.
+     */
+    static DocumentArena* current();
+
+    /**
+     * Returns true if the arena installed on the current thread, if any, hands out buffers. Values
+     * created while this is false never live in an arena.
+     */
+    static bool isActive();
+
+    /**
+     * Returns a buffer of at least 'bytes' bytes and sets '*block' to the block which owns it.
+     * Returns nullptr, leaving '*block' untouched, if the request is too large to be served from
+     * the arena; the caller should then allocate from the heap.
+     */
+    char* allocate(size_t bytes, boost::intrusive_ptr<Block>* block);
+
+    size_t blockBytes() const {
+        return _blockBytes;
+    }
+
+private:
+    const size_t _blockBytes;
+    boost::intrusive_ptr<Block> _currentBlock;
+};
+
+}  // namespace mongo
@@ -35,6 +35,7 @@
 #include <boost/intrusive_ptr.hpp>
 
 #include "mongo/base/static_assert.h"
+#include "mongo/db/pipeline/document_arena.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/util/intrusive_counter.h"
 
@@ -470,6 +471,31 @@ public:
     /// Shallow copy of this. Caller owns memory.
     boost::intrusive_ptr<DocumentStorage> clone() const;
 
+    /**
+     * Returns true if the field buffer of this storage, or a Value stored in one of its cached
+     * fields, may live in a DocumentArena. This does not look at the fields: it is a conservative
+     * flag maintained as the storage is allocated and modified.
+     */
+    bool isArenaBacked() const {
+        return _arenaBlock || _mayHoldArenaValues;
+    }
+
+    /**
+     * Called by MutableDocument before it modifies this storage. Any Value stored while an arena
+     * is active may live in that arena.
+     */
+    void noteModification() {
+        if (!_mayHoldArenaValues && DocumentArena::isActive()) {
+            _mayHoldArenaValues = true;
+        }
+    }
+
+    /**
+     * Deep copy of the parts of this storage which live in a DocumentArena, so that the result
+     * references only heap memory. Caller owns memory.
+     */
+    boost::intrusive_ptr<DocumentStorage> cloneOutOfArena() const;
+
     size_t allocatedBytes() const {
         return !_cache ? 0 : (_cacheEnd - _cache + hashTabBytes());
     }
@@ -637,6 +663,14 @@ private:
     /// Allocates space in _cache. Copies existing data if there is any.
     void alloc(unsigned newSize);
 
+    /**
+     * Returns a new buffer for _cache, taken from the current thread's DocumentArena if there is
+     * one and from the heap otherwise. '*arenaBlock' is set to the owning block only in the former
+     * case, so it must be null on entry.
+     */
+    static char* allocateCache(size_t bytes,
+                               boost::intrusive_ptr<DocumentArena::Block>* arenaBlock);
+
     /// Call after adding field to _cache and increasing _numFields
     void addFieldToHashTable(Position pos);
 
@@ -701,6 +735,15 @@ private:
     unsigned _numFields;    // this includes removed fields
     unsigned _hashTabMask;  // equal to hashTabBuckets()-1 but used more often
 
+    // The arena block which owns _cache, or null if _cache was allocated on the heap (and must be
+    // deleted by this storage).
+    boost::intrusive_ptr<DocumentArena::Block> _arenaBlock;
+
+    // Set if this storage was modified while an arena was active, so that its cached fields may
+    // hold Documents or arrays which live in an arena. Values stored outside of any arena scope are
+    // not tracked; such a Value keeps its block alive but is never left dangling.
+    bool _mayHoldArenaValues = false;
+
     BSONObj _bson;
     mutable BSONObjIterator _bsonIt;
 
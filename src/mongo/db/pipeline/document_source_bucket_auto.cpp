@@ -145,8 +145,8 @@ DocumentSource::GetNextResult DocumentSourceBucketAuto::populateSorter() {
 
     auto next = pSource->getNext();
     for (; next.isAdvanced(); next = pSource->getNext()) {
-        auto nextDoc = next.releaseDocument();
-        _sorter->add(extractKey(nextDoc), nextDoc);
+        auto nextDoc = next.releaseDocument().getOwned();
+        _sorter->add(extractKey(nextDoc).getOwned(), nextDoc);
         _nDocuments++;
     }
     return next;
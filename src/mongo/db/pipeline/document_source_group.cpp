@@ -29,7 +29,9 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <boost/filesystem/operations.hpp>
+#include <limits>
 #include <memory>
 
 #include "mongo/db/jsobj.h"
@@ -42,6 +44,7 @@
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/stdx/unordered_map.h"
 #include "mongo/util/destructor_guard.h"
 
 namespace mongo {
@@ -62,6 +65,24 @@ std::string nextFileName() {
     return "extsort-doc-group." + std::to_string(documentSourceGroupFileCounter.fetchAndAdd(1));
 }
 
+/**
+ * The deepest level to which a spilled partition is recursively partitioned when it does not fit
+ * in memory on its own. Past this point the partition is re-aggregated in memory regardless of the
+ * memory limit, which can only happen with pathological hash collisions.
+ */
+constexpr size_t kMaxSpillPartitionDepth = 8;
+
+/**
+ * Mixes 'hash' with 'depth' (using the SplitMix64 finalizer) so that the groups of one partition
+ * are spread across all partitions of the next level.
+ */
+uint64_t mixPartitionHash(uint64_t hash, size_t depth) {
+    uint64_t x = hash + (depth + 1) * 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
 }  // namespace
 
 using boost::intrusive_ptr;
@@ -149,6 +170,8 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNext() {
 
     if (_spilled) {
         return getNextSpilled();
+    } else if (_numSpilledRuns > 0) {
+        return getNextPartitioned();
     } else {
         return getNextStandard();
     }
@@ -160,22 +183,10 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
         return GetNextResult::makeEOF();
 
     _currentId = _firstPartOfNextGroup.first;
-    const size_t numAccumulators = _accumulatedFields.size();
     while (pExpCtx->getValueComparator().evaluate(_currentId == _firstPartOfNextGroup.first)) {
         // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
         // At loop exit, it is the first value to be processed in the next group.
-        switch (numAccumulators) {  // mirrors switch in spill()
-            case 1:                 // Single accumulators serialize as a single Value.
-                _currentAccumulators[0]->process(_firstPartOfNextGroup.second, true);
-            case 0:  // No accumulators so no Values.
-                break;
-            default: {  // Multiple accumulators serialize as an array of Values.
-                const vector<Value>& accumulatorStates = _firstPartOfNextGroup.second.getArray();
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    _currentAccumulators[i]->process(accumulatorStates[i], true);
-                }
-            }
-        }
+        mergeAccumulators(_firstPartOfNextGroup.second, _currentAccumulators);
 
         if (!_sorterIterator->more()) {
             dispose();
@@ -201,10 +212,34 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
     return std::move(out);
 }
 
+DocumentSource::GetNextResult DocumentSourceGroup::getNextPartitioned() {
+    // Spilled to hash partitions. The groups that never left memory are returned first, then each
+    // spilled partition is re-aggregated and returned in turn.
+    while (groupsIterator == _groups->end()) {
+        if (_pendingPartitions.empty()) {
+            dispose();
+            return GetNextResult::makeEOF();
+        }
+
+        auto partition = std::move(_pendingPartitions.front());
+        _pendingPartitions.pop_front();
+        loadPartition(std::move(partition));
+    }
+
+    Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
+    ++groupsIterator;
+    return std::move(out);
+}
+
 void DocumentSourceGroup::doDispose() {
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
     _sorterIterator.reset();
+    _spillPartitions.clear();
+    _pendingPartitions.clear();
+    _columnarInput.clear();
+    _columnarInputBytes = 0;
+    _columnarBatch.reset();
 
     // Make us look done.
     groupsIterator = _groups->end();
@@ -310,6 +345,13 @@ const std::vector<AccumulationStatement>& DocumentSourceGroup::getAccumulatedFie
     return _accumulatedFields;
 }
 
+bool DocumentSourceGroup::dependsOnInputOrder() const {
+    return std::any_of(
+        _accumulatedFields.begin(), _accumulatedFields.end(), [&](const auto& accumulatedField) {
+            return !accumulatedField.makeAccumulator(pExpCtx)->isCommutative();
+        });
+}
+
 intrusive_ptr<DocumentSourceGroup> DocumentSourceGroup::create(
     const intrusive_ptr<ExpressionContext>& pExpCtx,
     const boost::intrusive_ptr<Expression>& groupByExpression,
@@ -336,7 +378,13 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
       _initialized(false),
       _groups(pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>()),
       _spilled(false),
-      _allowDiskUse(pExpCtx->allowDiskUse && !pExpCtx->inMongos) {
+      _allowDiskUse(pExpCtx->allowDiskUse && !pExpCtx->inMongos),
+      // Partitioning into a single partition cannot split anything up, so treat it as disabled.
+      _numSpillPartitions(internalDocumentSourceGroupSpillPartitions.load() > 1
+                              ? internalDocumentSourceGroupSpillPartitions.load()
+                              : 0),
+      _spillPartitions(_numSpillPartitions),
+      _columnarBatchSize(internalDocumentSourceGroupColumnarBatchSize.load()) {
     if (!pExpCtx->inMongos && (pExpCtx->allowDiskUse || kDebugBuild)) {
         // We spill to disk in debug mode, regardless of allowDiskUse, to stress the system.
         _fileName = pExpCtx->tempDir + "/" + nextFileName();
@@ -470,22 +518,43 @@ private:
 DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     const size_t numAccumulators = _accumulatedFields.size();
 
+    // Merging inputs carry partial accumulator states rather than plain values, so they are always
+    // consumed one document at a time.
+    const bool columnar = _columnarBatchSize > 1 && !_doingMerge;
+
     // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
     GetNextResult input = pSource->getNext();
     for (; input.isAdvanced(); input = pSource->getNext()) {
-        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
-            uassert(16945,
-                    "Exceeded memory limit for $group, but didn't allow external sort."
-                    " Pass allowDiskUse:true to opt in.",
-                    _allowDiskUse);
-            _sortedFiles.push_back(spill());
-            _memoryUsageBytes = 0;
+        if (columnar) {
+            auto doc = input.releaseDocument();
+            const size_t docBytes = doc.getApproximateSize();
+
+            // The buffered documents count against the memory limit. Flush the batch before this
+            // document would take the usage over the limit, so that spilling gets a chance to free
+            // memory first.
+            if (!_columnarInput.empty() &&
+                _memoryUsageBytes + docBytes > _maxMemoryUsageBytes) {
+                processColumnarBatch();
+            }
+
+            _columnarInput.push_back(std::move(doc));
+            _columnarInputBytes += docBytes;
+            _memoryUsageBytes += docBytes;
+            if (_columnarInput.size() >= _columnarBatchSize) {
+                processColumnarBatch();
+            }
+            continue;
         }
 
+        spillIfOverMemoryLimit();
+
         // We release the result document here so that it does not outlive the end of this loop
         // iteration. Not releasing could lead to an array copy when this group follows an unwind.
         auto rootDocument = input.releaseDocument();
-        Value id = computeId(rootDocument);
+
+        // Group keys and accumulator state outlive the batch which produced them, so they are
+        // copied out of the pipeline's arena.
+        Value id = computeId(rootDocument).getOwned();
 
         // Look for the _id value in the map. If it's not there, add a new entry with a blank
         // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
@@ -514,24 +583,24 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
 
         for (size_t i = 0; i < numAccumulators; i++) {
             group[i]->process(
-                _accumulatedFields[i].expression->evaluate(rootDocument, &pExpCtx->variables),
+                _accumulatedFields[i]
+                    .expression->evaluate(rootDocument, &pExpCtx->variables)
+                    .getOwned(),
                 _doingMerge);
 
             _memoryUsageBytes += group[i]->memUsageForSorter();
         }
 
-        if (kDebugBuild && !storageGlobalParams.readOnly) {
-            // In debug mode, spill every time we have a duplicate id to stress merge logic.
-            if (!inserted &&                 // is a dup
-                !pExpCtx->inMongos &&        // can't spill to disk in mongos
-                !_allowDiskUse &&            // don't change behavior when testing external sort
-                _sortedFiles.size() < 20) {  // don't open too many FDs
-
-                _sortedFiles.push_back(spill());
-            }
+        if (!inserted) {
+            stressSpillOnDuplicate();
         }
     }
 
+    // Don't hold a partial batch across a pause, and flush the last one at the end of the input.
+    if (!_columnarInput.empty()) {
+        processColumnarBatch();
+    }
+
     switch (input.getStatus()) {
         case DocumentSource::GetNextResult::ReturnStatus::kAdvanced: {
             MONGO_UNREACHABLE;  // We consumed all advances above.
@@ -541,7 +610,12 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         }
         case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
             // Do any final steps necessary to prepare to output results.
-            if (!_sortedFiles.empty()) {
+            if (_numSpilledRuns > 0) {
+                // Flush the spilled partitions. Whatever is left in '_groups' belongs to resident
+                // partitions and is returned before the spilled partitions are re-aggregated.
+                finishPartitions(&_spillPartitions, 0);
+                groupsIterator = _groups->begin();
+            } else if (!_sortedFiles.empty()) {
                 _spilled = true;
                 if (!_groups->empty()) {
                     _sortedFiles.push_back(spill());
@@ -595,36 +669,320 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
 
     SortedFileWriter<Value, Value> writer(
         SortOptions().TempDir(pExpCtx->tempDir), _fileName, _nextSortedFileWriterOffset);
-    switch (_accumulatedFields.size()) {  // same as ptrs[i]->second.size() for all i.
-        case 0:                           // no values, essentially a distinct
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        writer.addAlreadySorted(ptrs[i]->first, serializeAccumulators(ptrs[i]->second));
+    }
+
+    _groups->clear();
+
+    Sorter<Value, Value>::Iterator* iteratorPtr = writer.done();
+    _nextSortedFileWriterOffset = writer.getFileEndOffset();
+    return shared_ptr<Sorter<Value, Value>::Iterator>(iteratorPtr);
+}
+
+size_t DocumentSourceGroup::partitionFor(const Value& id, size_t depth) const {
+    return mixPartitionHash(pExpCtx->getValueComparator().hash(id), depth) % _numSpillPartitions;
+}
+
+void DocumentSourceGroup::spillPartitions(std::vector<SpillPartition>* partitions,
+                                          size_t depth,
+                                          size_t targetMemoryUsageBytes) {
+    // Bucket the groups by partition, tallying the memory held by each partition.
+    vector<vector<GroupsMap::iterator>> members(partitions->size());
+    vector<size_t> partitionBytes(partitions->size(), 0);
+    for (auto it = _groups->begin(); it != _groups->end(); ++it) {
+        const size_t partition = partitionFor(it->first, depth);
+        members[partition].push_back(it);
+        partitionBytes[partition] += it->first.getApproximateSize();
+        for (auto&& accum : it->second) {
+            partitionBytes[partition] += accum->memUsageForSorter();
+        }
+    }
+
+    auto spillPartition = [&](size_t index) {
+        auto& partition = (*partitions)[index];
+        partition.spilled = true;
+        if (members[index].empty()) {
+            return;
+        }
+
+        // The groups of a partition are re-aggregated through a hash table, so each run is written
+        // in hash table order rather than sorted.
+        SortedFileWriter<Value, Value> writer(
+            SortOptions().TempDir(pExpCtx->tempDir), _fileName, _nextSortedFileWriterOffset);
+        for (auto&& it : members[index]) {
+            writer.addAlreadySorted(it->first, serializeAccumulators(it->second));
+        }
+        partition.runs.emplace_back(writer.done());
+        _nextSortedFileWriterOffset = writer.getFileEndOffset();
+
+        for (auto&& it : members[index]) {
+            _groups->erase(it);
+        }
+        _memoryUsageBytes -= std::min(_memoryUsageBytes, partitionBytes[index]);
+        _usedDisk = true;
+        ++_numSpilledRuns;
+    };
+
+    // Groups which belong to a partition that has already been spilled always go to disk.
+    for (size_t i = 0; i < partitions->size(); ++i) {
+        if ((*partitions)[i].spilled) {
+            spillPartition(i);
+        }
+    }
+
+    // Then evict the largest resident partitions until enough memory has been freed, keeping the
+    // partitions that hold the least data in memory.
+    while (_memoryUsageBytes > targetMemoryUsageBytes) {
+        boost::optional<size_t> largest;
+        for (size_t i = 0; i < partitions->size(); ++i) {
+            if (!(*partitions)[i].spilled &&
+                (!largest || partitionBytes[i] > partitionBytes[*largest])) {
+                largest = i;
             }
+        }
+        if (!largest) {
             break;
+        }
+        spillPartition(*largest);
+    }
+}
+
+void DocumentSourceGroup::finishPartitions(std::vector<SpillPartition>* partitions,
+                                           size_t depth) {
+    // With no memory target, this only writes out the groups of the spilled partitions.
+    spillPartitions(partitions, depth, std::numeric_limits<size_t>::max());
+
+    for (auto&& partition : *partitions) {
+        if (!partition.runs.empty()) {
+            _pendingPartitions.push_back(std::move(partition));
+        }
+    }
+    partitions->clear();
+}
+
+void DocumentSourceGroup::loadPartition(SpillPartition partition) {
+    _groups->clear();
+    _memoryUsageBytes = 0;
+
+    // Created on demand, if this partition turns out to be too large to re-aggregate in memory.
+    const size_t depth = partition.depth + 1;
+    vector<SpillPartition> subPartitions;
+
+    for (auto&& run : partition.runs) {
+        run->openSource();
+        while (run->more()) {
+            pExpCtx->checkForInterrupt();
+
+            if (_memoryUsageBytes > _maxMemoryUsageBytes && depth < kMaxSpillPartitionDepth) {
+                if (subPartitions.empty()) {
+                    subPartitions.resize(_numSpillPartitions);
+                    for (auto&& subPartition : subPartitions) {
+                        subPartition.depth = depth;
+                    }
+                }
+                spillPartitions(&subPartitions, depth, _maxMemoryUsageBytes / 2);
+            }
+
+            auto next = run->next();
+
+            const size_t oldSize = _groups->size();
+            Accumulators& group = (*_groups)[next.first];
+            if (_groups->size() != oldSize) {
+                _memoryUsageBytes += next.first.getApproximateSize();
+                group.reserve(_accumulatedFields.size());
+                for (auto&& accumulatedField : _accumulatedFields) {
+                    group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+                }
+            } else {
+                for (auto&& accum : group) {
+                    _memoryUsageBytes -= accum->memUsageForSorter();
+                }
+            }
+
+            mergeAccumulators(next.second, group);
+            for (auto&& accum : group) {
+                _memoryUsageBytes += accum->memUsageForSorter();
+            }
+        }
+        run->closeSource();
+    }
+
+    if (!subPartitions.empty()) {
+        finishPartitions(&subPartitions, depth);
+    }
+    groupsIterator = _groups->begin();
+}
+
+Value DocumentSourceGroup::serializeAccumulators(const Accumulators& accums) const {
+    switch (accums.size()) {
+        case 0:  // no values, essentially a distinct
+            return Value();
 
         case 1:  // just one value, use optimized serialization as single Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
+            return accums[0]->getValue(/*toBeMerged=*/true);
+
+        default: {  // multiple values, serialize as array-typed Value
+            vector<Value> states;
+            states.reserve(accums.size());
+            for (auto&& accum : accums) {
+                states.push_back(accum->getValue(/*toBeMerged=*/true));
             }
+            return Value(std::move(states));
+        }
+    }
+}
+
+void DocumentSourceGroup::mergeAccumulators(const Value& state, const Accumulators& accums) const {
+    switch (accums.size()) {  // mirrors switch in serializeAccumulators()
+        case 0:               // No accumulators so no Values.
+            break;
+
+        case 1:  // Single accumulators serialize as a single Value.
+            accums[0]->process(state, true);
             break;
 
-        default:  // multiple values, serialize as array-typed Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
+        default: {  // Multiple accumulators serialize as an array of Values.
+            const vector<Value>& accumulatorStates = state.getArray();
+            for (size_t i = 0; i < accums.size(); i++) {
+                accums[i]->process(accumulatorStates[i], true);
+            }
+        }
+    }
+}
+
+void DocumentSourceGroup::spillIfOverMemoryLimit() {
+    if (_memoryUsageBytes <= _maxMemoryUsageBytes) {
+        return;
+    }
+
+    uassert(16945,
+            "Exceeded memory limit for $group, but didn't allow external sort."
+            " Pass allowDiskUse:true to opt in.",
+            _allowDiskUse);
+    if (_numSpillPartitions > 0) {
+        // Leave headroom so that the resident partitions can keep growing for a while.
+        spillPartitions(&_spillPartitions, 0, _maxMemoryUsageBytes / 2);
+    } else {
+        _sortedFiles.push_back(spill());
+        _memoryUsageBytes = 0;
+    }
+}
+
+void DocumentSourceGroup::stressSpillOnDuplicate() {
+    if (kDebugBuild && !storageGlobalParams.readOnly) {
+        // In debug mode, spill every time we have a duplicate id to stress merge logic.
+        if (!pExpCtx->inMongos &&  // can't spill to disk in mongos
+            !_allowDiskUse) {      // don't change behavior when testing external sort
+
+            if (_numSpillPartitions > 0) {
+                if (_numSpilledRuns < 20) {  // bound the number of runs to re-read
+                    spillPartitions(&_spillPartitions, 0, _memoryUsageBytes / 2);
                 }
-                writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
+            } else if (_sortedFiles.size() < 20) {  // don't open too many FDs
+                _sortedFiles.push_back(spill());
             }
-            break;
+        }
     }
+}
 
-    _groups->clear();
+void DocumentSourceGroup::processColumnarBatch() {
+    spillIfOverMemoryLimit();
 
-    Sorter<Value, Value>::Iterator* iteratorPtr = writer.done();
-    _nextSortedFileWriterOffset = writer.getFileEndOffset();
-    return shared_ptr<Sorter<Value, Value>::Iterator>(iteratorPtr);
+    const size_t numIdExpressions = _idExpressions.size();
+    const size_t numAccumulators = _accumulatedFields.size();
+
+    // Transpose the batch: one column per _id expression, followed by one column per accumulator
+    // argument. The values are copied out of the pipeline's arena since they may end up as group
+    // keys or accumulator state.
+    if (!_columnarBatch) {
+        _columnarBatch.emplace(numIdExpressions + numAccumulators);
+    }
+    ColumnBatch& batch = *_columnarBatch;
+    batch.clear();
+    for (auto&& doc : _columnarInput) {
+        for (size_t i = 0; i < numIdExpressions; i++) {
+            batch.getColumn(i).append(
+                _idExpressions[i]->evaluate(doc, &pExpCtx->variables).getOwned());
+        }
+        for (size_t i = 0; i < numAccumulators; i++) {
+            batch.getColumn(numIdExpressions + i)
+                .append(_accumulatedFields[i]
+                            .expression->evaluate(doc, &pExpCtx->variables)
+                            .getOwned());
+        }
+    }
+    const size_t numRows = _columnarInput.size();
+    _columnarInput.clear();
+
+    // Spilling may already have reset the usage, so don't let it wrap around.
+    _memoryUsageBytes -= std::min(_memoryUsageBytes, _columnarInputBytes);
+    _columnarInputBytes = 0;
+
+    // Bucket the rows by group. The rows of each group stay in input order, so that order-sensitive
+    // accumulators such as $first and $push see the same sequence as they would row by row. The
+    // accumulators in '_groups' have stable addresses since no spilling happens during the batch.
+    std::vector<Accumulators*> groups;
+    std::vector<std::vector<uint32_t>> rowsByGroup;
+    std::vector<bool> insertedGroups;
+    stdx::unordered_map<Accumulators*, size_t> groupIndexes;
+    bool sawDuplicate = false;
+    for (size_t row = 0; row < numRows; row++) {
+        // Same as computeId(), but reading the _id expressions' values from the batch.
+        Value id;
+        if (numIdExpressions == 1) {
+            id = batch.getColumn(0).getValue(row);
+            if (id.missing()) {
+                id = Value(BSONNULL);
+            }
+        } else {
+            std::vector<Value> vals;
+            vals.reserve(numIdExpressions);
+            for (size_t i = 0; i < numIdExpressions; i++) {
+                vals.push_back(batch.getColumn(i).getValue(row));
+            }
+            id = Value(std::move(vals));
+        }
+
+        const size_t oldSize = _groups->size();
+        Accumulators& group = (*_groups)[id];
+        const bool inserted = _groups->size() != oldSize;
+        if (inserted) {
+            _memoryUsageBytes += id.getApproximateSize();
+            group.reserve(numAccumulators);
+            for (auto&& accumulatedField : _accumulatedFields) {
+                group.push_back(accumulatedField.makeAccumulator(pExpCtx));
+            }
+        }
+
+        auto indexIt = groupIndexes.find(&group);
+        if (indexIt == groupIndexes.end()) {
+            indexIt = groupIndexes.emplace(&group, groups.size()).first;
+            groups.push_back(&group);
+            rowsByGroup.emplace_back();
+            insertedGroups.push_back(inserted);
+        }
+        rowsByGroup[indexIt->second].push_back(row);
+        sawDuplicate = sawDuplicate || !inserted;
+    }
+
+    // Feed each accumulator all of its group's rows from the column at once.
+    for (size_t g = 0; g < groups.size(); g++) {
+        Accumulators& group = *groups[g];
+        dassert(numAccumulators == group.size());
+        for (size_t i = 0; i < numAccumulators; i++) {
+            if (!insertedGroups[g]) {
+                // subtract old mem usage. New usage added back after processing.
+                _memoryUsageBytes -= group[i]->memUsageForSorter();
+            }
+            group[i]->processColumn(batch.getColumn(numIdExpressions + i), rowsByGroup[g]);
+            _memoryUsageBytes += group[i]->memUsageForSorter();
+        }
+    }
+
+    if (sawDuplicate) {
+        stressSpillOnDuplicate();
+    }
 }
 
 Value DocumentSourceGroup::computeId(const Document& root) {
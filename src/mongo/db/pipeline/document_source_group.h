@@ -29,11 +29,13 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <utility>
 
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/column_batch.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/transformer_interface.h"
 #include "mongo/db/sorter/sorter.h"
@@ -102,6 +104,12 @@ public:
     StringMap<boost::intrusive_ptr<Expression>> getIdFields() const;
     const std::vector<AccumulationStatement>& getAccumulatedFields() const;
 
+    /**
+     * Returns true if the output of this stage can depend on the order of its input, i.e. if any of
+     * its accumulators is not commutative (such as $first or $push).
+     */
+    bool dependsOnInputOrder() const;
+
     /**
      * Convenience method for creating a new $group stage. If maxMemoryUsageBytes is boost::none,
      * then it will actually use the value of internalDocumentSourceGroupMaxMemoryBytes.
@@ -194,6 +202,7 @@ private:
      */
     GetNextResult getNextSpilled();
     GetNextResult getNextStandard();
+    GetNextResult getNextPartitioned();
 
     /**
      * Before returning anything, this source must prepare itself. In a streaming $group,
@@ -207,6 +216,25 @@ private:
      */
     GetNextResult initialize();
 
+    /**
+     * Spills to disk if the groups exceed the memory limit, or throws if spilling is not allowed.
+     */
+    void spillIfOverMemoryLimit();
+
+    /**
+     * In debug builds, spills after a document was added to an existing group, to stress the merge
+     * logic. Does nothing in release builds.
+     */
+    void stressSpillOnDuplicate();
+
+    /**
+     * Adds the documents buffered in '_columnarInput' to the groups. The batch is transposed into a
+     * ColumnBatch holding the values of each _id expression and accumulator argument, and each
+     * accumulator is then fed all of its group's rows from its column in a single call, which lets
+     * numeric accumulators run tight loops over unboxed values.
+     */
+    void processColumnarBatch();
+
     /**
      * Spill groups map to disk and returns an iterator to the file. Note: Since a sorted $group
      * does not exhaust the previous stage before returning, and thus does not maintain as large a
@@ -214,6 +242,53 @@ private:
      */
     std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
+    /**
+     * A hash partition of the groups used when '_numSpillPartitions' is non-zero. Once a partition
+     * has been spilled, every group that hashes to it is periodically written to disk as a run of
+     * unsorted (id, partial accumulator state) pairs, and the partition is re-aggregated on its own
+     * after the input has been exhausted.
+     */
+    struct SpillPartition {
+        std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> runs;
+        size_t depth = 0;
+        bool spilled = false;
+    };
+
+    /**
+     * Returns the partition, out of '_numSpillPartitions', that the group 'id' belongs to at the
+     * given recursion depth. Each depth uses a different mix of the hash so that a partition that
+     * is too large to re-aggregate in memory is split up when it is partitioned again.
+     */
+    size_t partitionFor(const Value& id, size_t depth) const;
+
+    /**
+     * Writes all groups in '_groups' that belong to already spilled members of 'partitions' to
+     * disk, then spills the largest resident partitions until '_memoryUsageBytes' is no more than
+     * 'targetMemoryUsageBytes'. The groups of partitions that are never spilled stay in memory.
+     */
+    void spillPartitions(std::vector<SpillPartition>* partitions,
+                         size_t depth,
+                         size_t targetMemoryUsageBytes);
+
+    /**
+     * Flushes the remaining in-memory groups of spilled members of 'partitions' and queues those
+     * partitions to be re-aggregated by getNextPartitioned().
+     */
+    void finishPartitions(std::vector<SpillPartition>* partitions, size_t depth);
+
+    /**
+     * Rebuilds '_groups' from the spilled runs of 'partition', merging the partial accumulator
+     * states. If the partition does not fit in memory, it is itself partitioned one level deeper.
+     */
+    void loadPartition(SpillPartition partition);
+
+    /**
+     * Serializes the partial state of 'accums' as a single Value and merges such a Value back into
+     * 'accums'. Used by both the sort-based and partitioned spill modes.
+     */
+    Value serializeAccumulators(const Accumulators& accums) const;
+    void mergeAccumulators(const Value& state, const Accumulators& accums) const;
+
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
     /**
@@ -266,6 +341,26 @@ private:
     const bool _allowDiskUse;
 
     std::pair<Value, Value> _firstPartOfNextGroup;
+
+    // The number of hash partitions to spill to. If zero, spilling sorts the whole of '_groups'.
+    const size_t _numSpillPartitions;
+
+    // Only used when '_numSpillPartitions' is non-zero. '_spillPartitions' holds the top-level
+    // partitions while the input is consumed, and '_pendingPartitions' the spilled partitions still
+    // to be re-aggregated and returned once the in-memory groups have been exhausted.
+    std::vector<SpillPartition> _spillPartitions;
+    std::deque<SpillPartition> _pendingPartitions;
+    size_t _numSpilledRuns = 0;
+
+    // The number of input documents to accumulate column by column at a time. If no more than one,
+    // the input is processed one document at a time.
+    const size_t _columnarBatchSize;
+    std::vector<Document> _columnarInput;
+
+    // The approximate size of the documents in '_columnarInput', which is included in
+    // '_memoryUsageBytes' until the batch is processed.
+    size_t _columnarInputBytes = 0;
+    boost::optional<ColumnBatch> _columnarBatch;
 };
 
 }  // namespace mongo
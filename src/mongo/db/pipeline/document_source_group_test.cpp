@@ -49,11 +49,13 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/unordered_set.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -142,6 +144,148 @@ TEST_F(DocumentSourceGroupTest, ShouldBeAbleToPauseLoadingWhileSpilled) {
     ASSERT_EQ(idSet.count(2), 1UL);
 }
 
+TEST_F(DocumentSourceGroupTest, ShouldMergePartialGroupsWhenSpillingToHashPartitions) {
+    auto expCtx = getExpCtx();
+    const int oldNumPartitions = internalDocumentSourceGroupSpillPartitions.load();
+    internalDocumentSourceGroupSpillPartitions.store(4);
+    ON_BLOCK_EXIT([&] { internalDocumentSourceGroupSpillPartitions.store(oldNumPartitions); });
+
+    // Allow the $group stage to spill to disk.
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    const size_t maxMemoryUsageBytes = 1000;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement countStatement{"count",
+                                         ExpressionConstant::create(expCtx, Value(1)),
+                                         AccumulationStatement::getFactory("$sum")};
+    AccumulationStatement pushStatement{"spaceHog",
+                                        ExpressionFieldPath::parse(expCtx, "$largeStr", vps),
+                                        AccumulationStatement::getFactory("$push")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$key", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {countStatement, pushStatement}, maxMemoryUsageBytes);
+
+    // Each group needs more memory than the limit allows, and every key is seen three times, so
+    // the partial groups of spilled partitions must be merged back together.
+    const int numKeys = 20;
+    string largeStr(maxMemoryUsageBytes / 4, 'x');
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int round = 0; round < 3; ++round) {
+        for (int key = 0; key < numKeys; ++key) {
+            inputs.push_back(Document{{"key", key}, {"largeStr", largeStr}});
+        }
+    }
+    auto mock = DocumentSourceMock::createForTest(inputs);
+    group->setSource(mock.get());
+
+    map<int, int> counts;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_EQ(doc["spaceHog"].getArrayLength(), 3UL);
+        ASSERT_TRUE(counts.emplace(doc["_id"].coerceToInt(), doc["count"].coerceToInt()).second);
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+    ASSERT_TRUE(group->usedDisk());
+
+    ASSERT_EQ(counts.size(), static_cast<size_t>(numKeys));
+    for (auto&& count : counts) {
+        ASSERT_EQ(count.second, 3);
+    }
+}
+
+/**
+ * Runs a $group over 'inputs' with the given columnar batch size and returns its results keyed by
+ * the string form of their _id.
+ */
+map<string, Document> runGroupWithColumnarBatchSize(
+    const intrusive_ptr<ExpressionContext>& expCtx,
+    const deque<DocumentSource::GetNextResult>& inputs,
+    int batchSize) {
+    const int oldBatchSize = internalDocumentSourceGroupColumnarBatchSize.load();
+    internalDocumentSourceGroupColumnarBatchSize.store(batchSize);
+    ON_BLOCK_EXIT([&] { internalDocumentSourceGroupColumnarBatchSize.store(oldBatchSize); });
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    auto group = DocumentSourceGroup::create(
+        expCtx,
+        ExpressionFieldPath::parse(expCtx, "$key", vps),
+        {{"count",
+          ExpressionConstant::create(expCtx, Value(1)),
+          AccumulationStatement::getFactory("$sum")},
+         {"sum",
+          ExpressionFieldPath::parse(expCtx, "$n", vps),
+          AccumulationStatement::getFactory("$sum")},
+         {"avg",
+          ExpressionFieldPath::parse(expCtx, "$n", vps),
+          AccumulationStatement::getFactory("$avg")},
+         {"first",
+          ExpressionFieldPath::parse(expCtx, "$s", vps),
+          AccumulationStatement::getFactory("$first")},
+         {"all",
+          ExpressionFieldPath::parse(expCtx, "$n", vps),
+          AccumulationStatement::getFactory("$push")}});
+    auto mock = DocumentSourceMock::createForTest(inputs);
+    group->setSource(mock.get());
+
+    map<string, Document> results;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_TRUE(results.emplace(doc["_id"].toString(), doc).second);
+    }
+    return results;
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldMatchRowByRowResultsWhenProcessingColumnarBatches) {
+    auto expCtx = getExpCtx();
+
+    // Mix typed runs, nulls, missing values and type changes so that batches exercise both the
+    // unboxed and the generic column representations.
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < 50; ++i) {
+        Value n;
+        switch (i % 7) {
+            case 0:
+                n = Value(i);
+                break;
+            case 1:
+                n = Value(static_cast<long long>(i) << 40);
+                break;
+            case 2:
+                n = Value(i + 0.25);
+                break;
+            case 3:
+                n = Value(BSONNULL);
+                break;
+            case 4:
+                break;
+            case 5:
+                n = Value("notANumber"_sd);
+                break;
+            default:
+                n = Value(i);
+        }
+        MutableDocument doc;
+        if (i % 5 != 0) {
+            doc.addField("key", Value(i % 4));
+        }
+        doc.addField("n", n);
+        doc.addField("s", Value(std::to_string(i)));
+        inputs.push_back(doc.freeze());
+    }
+
+    auto rowByRow = runGroupWithColumnarBatchSize(expCtx, inputs, 1);
+    for (int batchSize : {2, 7, 1024}) {
+        auto columnar = runGroupWithColumnarBatchSize(expCtx, inputs, batchSize);
+        ASSERT_EQ(columnar.size(), rowByRow.size());
+        for (auto&& result : rowByRow) {
+            ASSERT_EQ(columnar.count(result.first), 1UL);
+            ASSERT_DOCUMENT_EQ(columnar[result.first], result.second);
+        }
+    }
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldErrorIfNotAllowedToSpillToDiskAndResultSetIsTooLarge) {
     auto expCtx = getExpCtx();
     const size_t maxMemoryUsageBytes = 1000;
@@ -193,6 +337,34 @@ TEST_F(DocumentSourceGroupTest, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
     ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
 }
 
+TEST_F(DocumentSourceGroupTest, ShouldCountBufferedColumnarInputAgainstMemoryLimit) {
+    const int oldBatchSize = internalDocumentSourceGroupColumnarBatchSize.load();
+    internalDocumentSourceGroupColumnarBatchSize.store(1024);
+    ON_BLOCK_EXIT([&] { internalDocumentSourceGroupColumnarBatchSize.store(oldBatchSize); });
+
+    auto expCtx = getExpCtx();
+    const size_t maxMemoryUsageBytes = 1000;
+    expCtx->inMongos = true;  // Disallow external sort.
+                              // This is the only way to do this in a debug build.
+
+    // The groups themselves stay tiny, so only the documents waiting in the batch can take the
+    // stage over its limit.
+    VariablesParseState vps = expCtx->variablesParseState;
+    AccumulationStatement countStatement{"count",
+                                         ExpressionConstant::create(expCtx, Value(1)),
+                                         AccumulationStatement::getFactory("$sum")};
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$_id", vps);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {countStatement}, maxMemoryUsageBytes);
+
+    string largeStr(maxMemoryUsageBytes, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"_id", 0}, {"largeStr", largeStr}},
+                                                   Document{{"_id", 1}, {"largeStr", largeStr}}});
+    group->setSource(mock.get());
+
+    ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldReportSingleFieldGroupKeyAsARename) {
     auto expCtx = getExpCtx();
     VariablesParseState vps = expCtx->variablesParseState;
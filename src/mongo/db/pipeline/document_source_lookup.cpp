@@ -34,8 +34,10 @@
 #include <memory>
 
 #include "mongo/base/init.h"
+#include "mongo/db/field_ref.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_algo.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/expression.h"
@@ -245,20 +247,11 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
-    if (!wasConstructedWithPipelineSyntax()) {
-        auto matchStage =
-            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
-        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-        _resolvedPipeline.back() = matchStage;
-    }
-
-    auto pipeline = buildPipeline(inputDoc);
-
     std::vector<Value> results;
     int objsize = 0;
     const auto maxBytes = internalLookupStageIntermediateDocumentMaxSizeBytes.load();
-    while (auto result = pipeline->getNext()) {
-        objsize += result->getApproximateSize();
+    auto addResult = [&](Document result) {
+        objsize += result.getApproximateSize();
         uassert(4568,
                 str::stream() << "Total size of documents in " << _fromNs.coll()
                               << " matching pipeline's $lookup stage exceeds "
@@ -266,11 +259,29 @@ DocumentSource::GetNextResult DocumentSourceLookUp::getNext() {
                               << " bytes",
 
                 objsize <= maxBytes);
-        results.emplace_back(std::move(*result));
-    }
-    for (auto&& source : pipeline->getSources()) {
-        if (source->usedDisk())
-            _usedDisk = true;
+        results.emplace_back(std::move(result));
+    };
+
+    if (prepareHashJoin()) {
+        for (auto&& result : probeHashTable(inputDoc)) {
+            addResult(std::move(result));
+        }
+    } else {
+        if (!wasConstructedWithPipelineSyntax()) {
+            auto matchStage = makeMatchStageFromInput(
+                inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
+            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
+            _resolvedPipeline.back() = matchStage;
+        }
+
+        auto pipeline = buildPipeline(inputDoc);
+        while (auto result = pipeline->getNext()) {
+            addResult(std::move(*result));
+        }
+        for (auto&& source : pipeline->getSources()) {
+            if (source->usedDisk())
+                _usedDisk = true;
+        }
     }
 
     MutableDocument output(std::move(inputDoc));
@@ -324,6 +335,73 @@ std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
     return pipeline;
 }
 
+bool DocumentSourceLookUp::prepareHashJoin() {
+    if (_hashJoinPrepared) {
+        return _hashTable && _hashTable->isServing();
+    }
+    _hashJoinPrepared = true;
+
+    const auto maxSizeBytes = internalDocumentSourceLookupHashJoinMaxMemoryBytes.load();
+    if (maxSizeBytes <= 0 || wasConstructedWithPipelineSyntax() || pExpCtx->inMongos) {
+        return false;
+    }
+
+    // A numeric path component may refer to an array index, which the keys of the hash table do
+    // not account for.
+    for (size_t i = 0; i < _foreignField->getPathLength(); ++i) {
+        if (FieldRef::isNumericPathComponentLenient(_foreignField->getFieldName(i))) {
+            return false;
+        }
+    }
+
+    // Scan the foreign collection through any view definition, applying the filter of an absorbed
+    // $match, but without the placeholder for the per-document join predicate.
+    std::vector<BSONObj> scanPipeline(_resolvedPipeline.begin(), std::prev(_resolvedPipeline.end()));
+    if (_additionalFilter) {
+        scanPipeline.push_back(BSON("$match" << *_additionalFilter));
+    }
+
+    copyVariablesToExpCtx(_variables, _variablesParseState, _fromExpCtx.get());
+    auto pipeline = pExpCtx->mongoProcessInterface->makePipeline(scanPipeline, _fromExpCtx);
+
+    // Documents which are matched by an equality to null, including those which are missing the
+    // foreign field entirely, are identified with the matcher itself.
+    auto nullMatcher = uassertStatusOK(
+        MatchExpressionParser::parse(BSON(_foreignField->fullPath() << BSONNULL), _fromExpCtx));
+
+    _hashTable.emplace(*_foreignField, _fromExpCtx->getValueComparator(), maxSizeBytes);
+    while (auto foreignDoc = pipeline->getNext()) {
+        const bool matchesNull = nullMatcher->matchesBSON(foreignDoc->toBson());
+        _hashTable->add(std::move(*foreignDoc), matchesNull);
+        if (_hashTable->isAbandoned()) {
+            break;
+        }
+    }
+    _usedDisk = _usedDisk || pipeline->usedDisk();
+
+    if (_hashTable->isAbandoned()) {
+        _hashTable.reset();
+        return false;
+    }
+
+    _hashTable->freeze();
+    return true;
+}
+
+std::vector<Document> DocumentSourceLookUp::probeHashTable(const Document& input) const {
+    // Gather the local values in the same way as makeMatchStageFromInput().
+    std::vector<Value> localValues;
+    document_path_support::visitAllValuesAtPath(
+        input, *_localField, [&](const Value& nextValue) { localValues.push_back(nextValue); });
+
+    if (localValues.empty()) {
+        // Missing values are treated as null.
+        localValues.push_back(Value(BSONNULL));
+    }
+
+    return _hashTable->probe(localValues);
+}
+
 DocumentSource::GetModPathsReturn DocumentSourceLookUp::getModifiedPaths() const {
     std::set<std::string> modifiedPaths{_as.fullPath()};
     if (_unwindSrc) {
@@ -465,6 +543,8 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    _hashTable.reset();
+    _hashJoinMatches.clear();
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
@@ -557,7 +637,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     // Loop until we get a document that has at least one match.
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
-    while (!_pipeline || !_nextValue) {
+    while ((!_pipeline && !_hashTable) || !_nextValue) {
         auto nextInput = pSource->getNext();
         if (!nextInput.isAdvanced()) {
             return nextInput;
@@ -565,28 +645,34 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
         _input = nextInput.releaseDocument();
 
-        if (!wasConstructedWithPipelineSyntax()) {
-            BSONObj filter = _additionalFilter.value_or(BSONObj());
-            auto matchStage =
-                makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
-            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-            _resolvedPipeline.back() = matchStage;
-        }
+        if (prepareHashJoin()) {
+            _hashJoinMatches = probeHashTable(*_input);
+            _hashJoinMatchIndex = 0;
+        } else {
+            if (!wasConstructedWithPipelineSyntax()) {
+                BSONObj filter = _additionalFilter.value_or(BSONObj());
+                auto matchStage = makeMatchStageFromInput(
+                    *_input, *_localField, _foreignField->fullPath(), filter);
+                // We've already allocated space for the trailing $match stage in
+                // '_resolvedPipeline'.
+                _resolvedPipeline.back() = matchStage;
+            }
 
-        if (_pipeline) {
-            _usedDisk = _usedDisk || _pipeline->usedDisk();
-            _pipeline->dispose(pExpCtx->opCtx);
-        }
+            if (_pipeline) {
+                _usedDisk = _usedDisk || _pipeline->usedDisk();
+                _pipeline->dispose(pExpCtx->opCtx);
+            }
 
-        _pipeline = buildPipeline(*_input);
+            _pipeline = buildPipeline(*_input);
 
-        // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
-        // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
-        // outer Pipeline that will propagate dispose() calls before being destroyed.
-        _pipeline.get_deleter().dismissDisposal();
+            // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
+            // potentially be used by multiple OperationContexts, and the $lookup stage is part of
+            // an outer Pipeline that will propagate dispose() calls before being destroyed.
+            _pipeline.get_deleter().dismissDisposal();
+        }
 
         _cursorIndex = 0;
-        _nextValue = _pipeline->getNext();
+        _nextValue = getNextUnwoundForeignDocument();
 
         if (_unwindSrc->preserveNullAndEmptyArrays() && !_nextValue) {
             // There were no results for this cursor, but the $unwind was asked to preserve empty
@@ -604,7 +690,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
     invariant(bool(_input) && bool(_nextValue));
     auto currentValue = *_nextValue;
-    _nextValue = _pipeline->getNext();
+    _nextValue = getNextUnwoundForeignDocument();
 
     // Move input document into output if this is the last or only result, otherwise perform a copy.
     MutableDocument output(_nextValue ? *_input : std::move(*_input));
@@ -618,6 +704,17 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     return output.freeze();
 }
 
+boost::optional<Document> DocumentSourceLookUp::getNextUnwoundForeignDocument() {
+    if (_pipeline) {
+        return _pipeline->getNext();
+    }
+
+    if (_hashJoinMatchIndex < _hashJoinMatches.size()) {
+        return std::move(_hashJoinMatches[_hashJoinMatchIndex++]);
+    }
+    return boost::none;
+}
+
 void DocumentSourceLookUp::copyVariablesToExpCtx(const Variables& vars,
                                                  const VariablesParseState& vps,
                                                  ExpressionContext* expCtx) {
@@ -37,6 +37,7 @@
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
 #include "mongo/db/pipeline/value_comparator.h"
 
@@ -267,6 +268,26 @@ private:
 
     GetNextResult unwindResult();
 
+    /**
+     * Returns the next foreign document joined with '_input' while unwinding, drawing from either
+     * '_pipeline' or '_hashJoinMatches'.
+     */
+    boost::optional<Document> getNextUnwoundForeignDocument();
+
+    /**
+     * Returns true if this $lookup should answer its input documents by probing '_hashTable'. On
+     * the first call, checks whether this $lookup is eligible for the hash join strategy and, if
+     * so, builds '_hashTable' from a single scan of the foreign collection. If the foreign data
+     * turns out not to fit within internalDocumentSourceLookupHashJoinMaxMemoryBytes, the table is
+     * abandoned and this $lookup falls back to running a sub-pipeline per input document.
+     */
+    bool prepareHashJoin();
+
+    /**
+     * Returns the foreign documents which join with 'input', using '_hashTable'.
+     */
+    std::vector<Document> probeHashTable(const Document& input) const;
+
     /**
      * Copies 'vars' and 'vps' to the Variables and VariablesParseState objects in 'expCtx'. These
      * copies provide access to 'let' defined variables in sub-pipeline execution.
@@ -324,6 +345,11 @@ private:
     // from a cursor source.
     boost::optional<SequentialDocumentCache> _cache;
 
+    // Holds the whole foreign collection, keyed on '_foreignField', when the hash join strategy is
+    // in use. See prepareHashJoin().
+    boost::optional<LookupHashTable> _hashTable;
+    bool _hashJoinPrepared = false;
+
     // The ExpressionContext used when performing aggregation pipelines against the '_resolvedNs'
     // namespace.
     boost::intrusive_ptr<ExpressionContext> _fromExpCtx;
@@ -349,6 +375,11 @@ private:
     std::unique_ptr<Pipeline, PipelineDeleter> _pipeline;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
+
+    // Used in place of '_pipeline' to hold the documents joined with '_input' when '_unwindSrc' is
+    // not null and the hash join strategy is in use.
+    std::vector<Document> _hashJoinMatches;
+    size_t _hashJoinMatchIndex = 0;
 };
 
 }  // namespace mongo
@@ -48,6 +48,7 @@
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -649,6 +650,131 @@ TEST_F(DocumentSourceLookUpTest, ShouldPropagatePausesWhileUnwinding) {
     lookup->dispose();
 }
 
+TEST_F(DocumentSourceLookUpTest, ShouldJoinAgainstHashTableWhenHashJoinIsEnabled) {
+    const long long oldMaxMemoryBytes = internalDocumentSourceLookupHashJoinMaxMemoryBytes.load();
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(1024 * 1024);
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(oldMaxMemoryBytes); });
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "x"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource =
+        DocumentSourceMock::createForTest({Document{{"foreignId", 0}},
+                                           DocumentSource::GetNextResult::makePauseExecution(),
+                                           Document{{"foreignId", vector<Value>{Value(1), Value(0)}}},
+                                           Document{{"foreignId", 2}},
+                                           Document()});
+    lookup->setSource(mockLocalSource.get());
+
+    // The mock foreign collection can only be scanned once, so every result below must come from
+    // the hash table.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}, {"x", 0}}, Document{{"_id", 1}, {"x", 1}}, Document{{"_id", 2}}};
+    expCtx->mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", 0},
+                                 {"foreignDocs",
+                                  vector<Value>{Value(Document{{"_id", 0}, {"x", 0}})}}}));
+
+    ASSERT_TRUE(lookup->getNext().isPaused());
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", vector<Value>{Value(1), Value(0)}},
+                                 {"foreignDocs",
+                                  vector<Value>{Value(Document{{"_id", 0}, {"x", 0}}),
+                                                Value(Document{{"_id", 1}, {"x", 1}})}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", 2}, {"foreignDocs", vector<Value>{}}}));
+
+    // A missing local field joins with the foreign documents which are missing the foreign field.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignDocs", vector<Value>{Value(Document{{"_id", 2}})}}}));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldJoinAgainstHashTableWhileUnwinding) {
+    const long long oldMaxMemoryBytes = internalDocumentSourceLookupHashJoinMaxMemoryBytes.load();
+    internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(1024 * 1024);
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceLookupHashJoinMaxMemoryBytes.store(oldMaxMemoryBytes); });
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "x"_sd},
+                                         {"as", "foreignDoc"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    const bool preserveNullAndEmptyArrays = false;
+    const boost::optional<std::string> includeArrayIndex = boost::none;
+    lookup->setUnwindStage(DocumentSourceUnwind::create(
+        expCtx, "foreignDoc", preserveNullAndEmptyArrays, includeArrayIndex));
+
+    auto mockLocalSource = DocumentSourceMock::createForTest(
+        {Document{{"foreignId", 0}}, Document{{"foreignId", 1}}, Document{{"foreignId", 2}}});
+    lookup->setSource(mockLocalSource.get());
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}, {"x", 0}},
+                                                             Document{{"_id", 1}, {"x", 0}},
+                                                             Document{{"_id", 2}, {"x", 2}}};
+    expCtx->mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 0}, {"foreignDoc", Document{{"_id", 0}, {"x", 0}}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 0}, {"foreignDoc", Document{{"_id", 1}, {"x", 0}}}}));
+
+    // The document with no match is dropped by the absorbed $unwind.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 2}, {"foreignDoc", Document{{"_id", 2}, {"x", 2}}}}));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+}
+
 TEST_F(DocumentSourceLookUpTest, LookupReportsAsFieldIsModified) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
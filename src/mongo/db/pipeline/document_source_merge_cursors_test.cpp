@@ -50,6 +50,7 @@
 #include "mongo/executor/thread_pool_task_executor_test_fixture.h"
 #include "mongo/s/catalog/type_shard.h"
 #include "mongo/s/client/shard_registry.h"
+#include "mongo/s/query/async_results_merger_knobs_gen.h"
 #include "mongo/s/sharding_router_test_fixture.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
@@ -107,6 +108,15 @@ public:
         }
 
         setupShards(shards);
+
+        // The tests respond to each getMore in turn, so they must not be sent ahead of time.
+        _originalReadAheadBytes = internalQueryAsyncResultsMergerReadAheadBytes.load();
+        internalQueryAsyncResultsMergerReadAheadBytes.store(0);
+    }
+
+    void tearDown() override {
+        internalQueryAsyncResultsMergerReadAheadBytes.store(_originalReadAheadBytes);
+        ShardingTestFixture::tearDown();
     }
 
     boost::intrusive_ptr<ExpressionContext> getExpCtx() {
@@ -115,6 +125,8 @@ public:
 
 private:
     boost::intrusive_ptr<ExpressionContext> _expCtx;
+
+    long long _originalReadAheadBytes = 0;
 };
 
 TEST_F(DocumentSourceMergeCursorsTest, ShouldRejectNonArray) {
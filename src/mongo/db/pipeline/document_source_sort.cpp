@@ -292,7 +292,10 @@ void DocumentSourceSort::loadDocument(Document&& doc) {
     // already computed the sort key we'd have split the pipeline there, would be merging presorted
     // documents, and wouldn't use this method.
     std::tie(sortKey, docForSorter) = extractSortKey(std::move(doc));
-    _sorter->add(sortKey, docForSorter);
+
+    // The sorter holds on to the document until all input is consumed, so it must not pin the
+    // arena which produced it.
+    _sorter->add(sortKey.getOwned(), docForSorter.getOwned());
 }
 
 void DocumentSourceSort::loadingDone() {
@@ -35,6 +35,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
 #include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/document_arena.h"
 #include "mongo/db/pipeline/document_comparator.h"
 #include "mongo/db/pipeline/document_value_test_util.h"
 #include "mongo/db/pipeline/field_path.h"
@@ -161,6 +162,99 @@ TEST(DocumentSerialization, CannotSerializeDocumentThatExceedsDepthLimit) {
     throwaway.abandon();
 }
 
+TEST(DocumentArena, DocumentOutlivesArenaThatAllocatedIt) {
+    Document doc;
+    {
+        DocumentArena arena(4096);
+        DocumentArena::Scope scope(&arena);
+        MutableDocument md;
+        md.addField("a", Value(1));
+        md.addField("b", Value("string"_sd));
+        doc = md.freeze();
+        ASSERT_TRUE(doc.isArenaBacked());
+    }
+
+    ASSERT_DOCUMENT_EQ(doc, (Document{{"a", 1}, {"b", "string"_sd}}));
+}
+
+TEST(DocumentArena, GetOwnedCopiesNestedDocumentsOutOfArena) {
+    DocumentArena arena(4096);
+    Document doc;
+    {
+        DocumentArena::Scope scope(&arena);
+        MutableDocument inner;
+        inner.addField("c", Value(2));
+        MutableDocument outer;
+        outer.addField("a", Value(1));
+        outer.addField("b", Value(inner.freeze()));
+        outer.addField("arr", Value(std::vector<Value>{Value(outer.peek()["b"])}));
+        doc = outer.freeze();
+    }
+    ASSERT_TRUE(doc.isArenaBacked());
+    ASSERT_TRUE(doc["b"].isArenaBacked());
+    ASSERT_TRUE(doc["arr"].isArenaBacked());
+
+    Document owned = doc.getOwned();
+    ASSERT_FALSE(owned.isArenaBacked());
+    ASSERT_FALSE(owned["b"].isArenaBacked());
+    ASSERT_FALSE(owned["arr"].isArenaBacked());
+    ASSERT_DOCUMENT_EQ(owned, doc);
+}
+
+TEST(DocumentArena, GetOwnedDoesNotCopyHeapDocument) {
+    Document doc{{"a", 1}};
+    ASSERT_FALSE(doc.isArenaBacked());
+    ASSERT_EQUALS(doc.getOwned().getPtr(), doc.getPtr());
+}
+
+TEST(DocumentArena, ArenaWithZeroBlockSizeAllocatesFromHeap) {
+    DocumentArena arena(0);
+    DocumentArena::Scope scope(&arena);
+    MutableDocument md;
+    md.addField("a", Value(1));
+    ASSERT_FALSE(md.freeze().isArenaBacked());
+}
+
+TEST(DocumentArena, LargeDocumentBuiltInArenaIsStillCopiedByGetOwned) {
+    DocumentArena arena(4096);
+    DocumentArena::Scope scope(&arena);
+
+    // The outer buffer is too large for the arena, but the nested Document is not.
+    MutableDocument md;
+    md.addField("nested", Value(Document{{"a", 1}}));
+    for (int i = 0; i < 100; ++i) {
+        md.addField(std::to_string(i), Value(i));
+    }
+    Document doc = md.freeze();
+    ASSERT_TRUE(doc.isArenaBacked());
+
+    Document owned = doc.getOwned();
+    ASSERT_FALSE(owned.isArenaBacked());
+    ASSERT_FALSE(owned["nested"].isArenaBacked());
+    ASSERT_DOCUMENT_EQ(owned, doc);
+}
+
+TEST(DocumentArena, GetOwnedInsideArenaScopeReturnsHeapValues) {
+    DocumentArena arena(4096);
+    DocumentArena::Scope scope(&arena);
+    Value arr(std::vector<Value>{Value(Document{{"a", 1}}), Value(2)});
+    ASSERT_TRUE(arr.isArenaBacked());
+
+    Value owned = arr.getOwned();
+    ASSERT_FALSE(owned.isArenaBacked());
+    ASSERT_FALSE(owned[0].isArenaBacked());
+    ASSERT_VALUE_EQ(owned, arr);
+}
+
+TEST(DocumentArena, DocumentBuiltOutsideArenaIsNotArenaBacked) {
+    MutableDocument md;
+    md.addField("a", Value(1));
+    md.addField("arr", Value(std::vector<Value>{Value(Document{{"b", 2}})}));
+    Document doc = md.freeze();
+    ASSERT_FALSE(doc.isArenaBacked());
+    ASSERT_FALSE(doc["arr"].isArenaBacked());
+}
+
 /** Add Document fields. */
 class AddField {
 public:
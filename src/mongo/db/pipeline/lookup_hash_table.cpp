@@ -0,0 +1,156 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/lookup_hash_table.h"
+
+#include <algorithm>
+
+namespace mongo {
+
+LookupHashTable::LookupHashTable(FieldPath foreignField,
+                                 const ValueComparator& comparator,
+                                 size_t maxSizeBytes)
+    : _foreignField(std::move(foreignField)),
+      _maxSizeBytes(maxSizeBytes),
+      _index(comparator.makeUnorderedValueMap<std::vector<size_t>>()) {}
+
+template <typename Callback>
+void LookupHashTable::visitKeys(const Value& value, size_t index, Callback&& callback) const {
+    if (index == _foreignField.getPathLength()) {
+        callback(value);
+        if (value.isArray()) {
+            for (auto&& element : value.getArray()) {
+                callback(element);
+            }
+        }
+        return;
+    }
+
+    if (value.getType() == BSONType::Object) {
+        visitKeys(value.getDocument()[_foreignField.getFieldName(index)], index + 1, callback);
+    } else if (value.isArray()) {
+        // Arrays along the path are only traversed into their object elements; nested arrays are
+        // not descended into.
+        for (auto&& element : value.getArray()) {
+            if (element.getType() == BSONType::Object) {
+                visitKeys(element, index, callback);
+            }
+        }
+    }
+}
+
+void LookupHashTable::add(Document foreignDoc, bool matchesNull) {
+    invariant(_status == Status::kBuilding);
+
+    // The table lives for the rest of the query, so it must not pin the arena which produced the
+    // document.
+    foreignDoc = foreignDoc.getOwned();
+
+    const size_t position = _documents.size();
+    size_t sizeBytes = foreignDoc.getApproximateSize();
+
+    if (matchesNull) {
+        _nullMatches.push_back(position);
+        sizeBytes += sizeof(size_t);
+    }
+
+    visitKeys(Value(foreignDoc), 0, [&](const Value& key) {
+        if (key.nullish()) {
+            return;
+        }
+
+        auto& positions = _index[key];
+        // The same key may be reached along several paths through the document.
+        if (positions.empty() || positions.back() != position) {
+            if (positions.empty()) {
+                sizeBytes += key.getApproximateSize();
+            }
+            positions.push_back(position);
+            sizeBytes += sizeof(size_t);
+        }
+    });
+
+    _sizeBytes += sizeBytes;
+    if (_sizeBytes > _maxSizeBytes) {
+        abandon();
+        return;
+    }
+
+    _documents.push_back(std::move(foreignDoc));
+}
+
+void LookupHashTable::freeze() {
+    invariant(_status == Status::kBuilding);
+
+    _status = Status::kServing;
+    _documents.shrink_to_fit();
+}
+
+void LookupHashTable::abandon() {
+    _status = Status::kAbandoned;
+
+    _index.clear();
+    std::vector<size_t>().swap(_nullMatches);
+    std::vector<Document>().swap(_documents);
+    _sizeBytes = 0;
+}
+
+std::vector<Document> LookupHashTable::probe(const std::vector<Value>& localValues) const {
+    invariant(_status == Status::kServing);
+
+    std::vector<size_t> positions;
+    for (auto&& localValue : localValues) {
+        if (localValue.nullish()) {
+            positions.insert(positions.end(), _nullMatches.begin(), _nullMatches.end());
+            continue;
+        }
+
+        auto it = _index.find(localValue);
+        if (it != _index.end()) {
+            positions.insert(positions.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    // A foreign document which matches several of the local values is only returned once.
+    if (localValues.size() > 1) {
+        std::sort(positions.begin(), positions.end());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+    }
+
+    std::vector<Document> matches;
+    matches.reserve(positions.size());
+    for (auto position : positions) {
+        matches.push_back(_documents[position]);
+    }
+    return matches;
+}
+
+}  // namespace mongo
@@ -0,0 +1,148 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/field_path.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/db/pipeline/value_comparator.h"
+
+namespace mongo {
+
+/**
+ * Holds the contents of a $lookup's foreign collection in a hash table keyed on the values found at
+ * the 'foreignField' path, so that a localField/foreignField $lookup can be answered for every
+ * input document from a single scan of the foreign collection.
+ *
+ * Like SequentialDocumentCache, the table can be in one of three states: building, serving, or
+ * abandoned. It is abandoned as soon as the approximate size of its contents exceeds the maximum
+ * size it was constructed with.
+ */
+class LookupHashTable {
+    LookupHashTable(const LookupHashTable&) = delete;
+    LookupHashTable& operator=(const LookupHashTable&) = delete;
+
+public:
+    enum class Status {
+        // Foreign documents are being added. A newly instantiated table is in this state.
+        kBuilding,
+
+        // The caller has invoked freeze(). The table is read-only and can be probed.
+        kServing,
+
+        // The maximum permitted size has been exceeded, or the caller has explicitly abandoned the
+        // table. Cannot add more documents or probe.
+        kAbandoned,
+    };
+
+    /**
+     * The table does not own 'comparator', which must outlive it. Keys are compared for equality
+     * using the comparator, and thus respect its collation.
+     */
+    LookupHashTable(FieldPath foreignField, const ValueComparator& comparator, size_t maxSizeBytes);
+
+    /**
+     * Adds a foreign document to the table. 'matchesNull' must be true if the document is matched
+     * by {<foreignField>: null}. Null, missing and undefined values are not indexed by key, since
+     * the query semantics of a null equality cannot be reproduced from the values alone. May only
+     * be called while the table is in 'kBuilding' mode.
+     */
+    void add(Document foreignDoc, bool matchesNull);
+
+    /**
+     * Moves the table into 'kServing' mode. May only be called while in 'kBuilding' mode.
+     */
+    void freeze();
+
+    /**
+     * Marks the table as 'kAbandoned' and frees its memory.
+     */
+    void abandon();
+
+    /**
+     * Returns the foreign documents which have a value equal to any of 'localValues' at the
+     * 'foreignField' path, in the order they were added. A null value in 'localValues' matches the
+     * documents which were added with 'matchesNull' set. May only be called while in 'kServing'
+     * mode.
+     */
+    std::vector<Document> probe(const std::vector<Value>& localValues) const;
+
+    Status status() const {
+        return _status;
+    }
+
+    size_t sizeBytes() const {
+        return _sizeBytes;
+    }
+
+    size_t count() const {
+        return _documents.size();
+    }
+
+    bool isBuilding() const {
+        return _status == Status::kBuilding;
+    }
+
+    bool isServing() const {
+        return _status == Status::kServing;
+    }
+
+    bool isAbandoned() const {
+        return _status == Status::kAbandoned;
+    }
+
+private:
+    /**
+     * Calls 'callback' for every value which an equality predicate on '_foreignField' would compare
+     * against in 'value', starting from path component 'index'. This follows the query system's
+     * path semantics: arrays along the path are traversed into their object elements, and a leaf
+     * array yields both itself and each of its elements.
+     */
+    template <typename Callback>
+    void visitKeys(const Value& value, size_t index, Callback&& callback) const;
+
+    const FieldPath _foreignField;
+    const size_t _maxSizeBytes;
+
+    Status _status = Status::kBuilding;
+    size_t _sizeBytes = 0;
+
+    // Maps each key to the positions in '_documents' of the foreign documents which have it.
+    ValueUnorderedMap<std::vector<size_t>> _index;
+
+    // Positions in '_documents' of the foreign documents which match a null equality.
+    std::vector<size_t> _nullMatches;
+
+    std::vector<Document> _documents;
+};
+
+}  // namespace mongo
@@ -0,0 +1,151 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/db/pipeline/document_value_test_util.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
+#include "mongo/db/pipeline/value_comparator.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/death_test.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const size_t kMaxSizeBytes = 16 * 1024;
+const ValueComparator defaultComparator{nullptr};
+
+std::vector<int> probeIds(const LookupHashTable& table, std::vector<Value> localValues) {
+    std::vector<int> ids;
+    for (auto&& doc : table.probe(localValues)) {
+        ids.push_back(doc["_id"].getInt());
+    }
+    return ids;
+}
+
+TEST(LookupHashTableTest, TableIsInBuildingModeUponInstantiation) {
+    LookupHashTable table(FieldPath("a"), defaultComparator, kMaxSizeBytes);
+    ASSERT(table.isBuilding());
+}
+
+TEST(LookupHashTableTest, ProbeReturnsDocumentsWithEqualKeyInInsertionOrder) {
+    LookupHashTable table(FieldPath("a"), defaultComparator, kMaxSizeBytes);
+    table.add(DOC("_id" << 0 << "a" << 1), false);
+    table.add(DOC("_id" << 1 << "a" << 2), false);
+    table.add(DOC("_id" << 2 << "a" << 1.0), false);
+    table.freeze();
+
+    ASSERT(table.isServing());
+    ASSERT_EQ(table.count(), 3UL);
+    ASSERT(probeIds(table, {Value(1)}) == std::vector<int>({0, 2}));
+    ASSERT(probeIds(table, {Value(2)}) == std::vector<int>({1}));
+    ASSERT(probeIds(table, {Value(3)}).empty());
+}
+
+TEST(LookupHashTableTest, ProbeWithSeveralLocalValuesReturnsEachDocumentOnce) {
+    LookupHashTable table(FieldPath("a"), defaultComparator, kMaxSizeBytes);
+    table.add(DOC("_id" << 0 << "a" << DOC_ARRAY(1 << 2)), false);
+    table.add(DOC("_id" << 1 << "a" << 2), false);
+    table.add(DOC("_id" << 2 << "a" << 3), false);
+    table.freeze();
+
+    ASSERT(probeIds(table, {Value(2), Value(1)}) == std::vector<int>({0, 1}));
+}
+
+TEST(LookupHashTableTest, KeysFollowQueryPathSemantics) {
+    LookupHashTable table(FieldPath("a.b"), defaultComparator, kMaxSizeBytes);
+    table.add(DOC("_id" << 0 << "a" << DOC("b" << 1)), false);
+    table.add(DOC("_id" << 1 << "a" << DOC_ARRAY(DOC("b" << 1) << DOC("b" << 2))), false);
+    table.add(DOC("_id" << 2 << "a" << DOC("b" << DOC_ARRAY(1 << 3))), false);
+    table.add(DOC("_id" << 3 << "a" << DOC_ARRAY(DOC_ARRAY(DOC("b" << 1)))), false);
+    table.freeze();
+
+    // Nested arrays along the path are not traversed.
+    ASSERT(probeIds(table, {Value(1)}) == std::vector<int>({0, 1, 2}));
+
+    // A leaf array is matched both as a whole and by each of its elements.
+    ASSERT(probeIds(table, {Value(std::vector<Value>{Value(1), Value(3)})}) ==
+           std::vector<int>({2}));
+    ASSERT(probeIds(table, {Value(3)}) == std::vector<int>({2}));
+}
+
+TEST(LookupHashTableTest, NullProbeReturnsDocumentsMarkedAsMatchingNull) {
+    LookupHashTable table(FieldPath("a"), defaultComparator, kMaxSizeBytes);
+    table.add(DOC("_id" << 0 << "a" << BSONNULL), true);
+    table.add(DOC("_id" << 1), true);
+    table.add(DOC("_id" << 2 << "a" << 1), false);
+    table.freeze();
+
+    ASSERT(probeIds(table, {Value(BSONNULL)}) == std::vector<int>({0, 1}));
+    ASSERT(probeIds(table, {Value(BSONNULL), Value(1)}) == std::vector<int>({0, 1, 2}));
+}
+
+TEST(LookupHashTableTest, KeysRespectCollation) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kToLowerString);
+    ValueComparator comparator{&collator};
+    LookupHashTable table(FieldPath("a"), comparator, kMaxSizeBytes);
+    table.add(DOC("_id" << 0 << "a"
+                        << "foo"_sd),
+              false);
+    table.add(DOC("_id" << 1 << "a"
+                        << "FOO"_sd),
+              false);
+    table.freeze();
+
+    ASSERT(probeIds(table, {Value("FoO"_sd)}) == std::vector<int>({0, 1}));
+}
+
+TEST(LookupHashTableTest, TableIsAbandonedWhenMaxSizeIsExceeded) {
+    LookupHashTable table(FieldPath("a"), defaultComparator, 1024);
+    table.add(DOC("_id" << 0 << "a" << 1), false);
+    ASSERT(table.isBuilding());
+
+    table.add(DOC("_id" << 1 << "a" << std::string(2048, 'x')), false);
+    ASSERT(table.isAbandoned());
+    ASSERT_EQ(table.count(), 0UL);
+    ASSERT_EQ(table.sizeBytes(), 0UL);
+}
+
+DEATH_TEST(LookupHashTableTest, CannotProbeTableWhileBuilding, "invariant") {
+    LookupHashTable table(FieldPath("a"), defaultComparator, kMaxSizeBytes);
+    table.add(DOC("_id" << 0 << "a" << 1), false);
+    table.probe({Value(1)});
+}
+
+DEATH_TEST(LookupHashTableTest, CannotAddToTableWhileServing, "invariant") {
+    LookupHashTable table(FieldPath("a"), defaultComparator, kMaxSizeBytes);
+    table.freeze();
+    table.add(DOC("_id" << 0 << "a" << 1), false);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -470,6 +470,14 @@ void Pipeline::stitch() {
 
 boost::optional<Document> Pipeline::getNext() {
     invariant(!_sources.empty());
+
+    // Transient Documents are bump-allocated from this pipeline's arena, unless an enclosing
+    // pipeline, such as the one running a $lookup, has already installed its own.
+    boost::optional<DocumentArena::Scope> arenaScope;
+    if (!DocumentArena::current()) {
+        arenaScope.emplace(&_documentArena);
+    }
+
     auto nextResult = _sources.back()->getNext();
     while (nextResult.isPaused()) {
         nextResult = _sources.back()->getNext();
@@ -38,6 +38,7 @@
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/pipeline/dependencies.h"
+#include "mongo/db/pipeline/document_arena.h"
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/query/explain_options.h"
 #include "mongo/db/query/query_knobs_gen.h"
@@ -384,6 +385,10 @@ private:
     SplitState _splitState = SplitState::kUnsplit;
     boost::intrusive_ptr<ExpressionContext> pCtx;
     bool _disposed = false;
+
+    // Backs the field buffers of the Documents created while this pipeline produces results.
+    DocumentArena _documentArena{
+        static_cast<size_t>(internalPipelineDocumentArenaBlockBytes.load())};
 };
 
 /**
@@ -640,6 +640,15 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
         plannerOpts |= QueryPlannerParams::TRACK_LATEST_OPLOG_TS;
     }
 
+    // A $group which does not care about the order of its input lets a collection scan feeding it
+    // run on several threads.
+    if (!sortStage && !oplogReplay) {
+        auto group = dynamic_cast<DocumentSourceGroup*>(pipeline->peekFront());
+        if (group && !group->dependsOnInputOrder()) {
+            plannerOpts |= QueryPlannerParams::PARALLEL_COLLSCAN;
+        }
+    }
+
     if (rewrittenGroupStage) {
         BSONObj emptySort;
 
@@ -877,7 +886,7 @@ void PipelineD::getPlanSummaryStats(const Pipeline* pipeline, PlanSummaryStats*
     }
 
     bool hasSortStage{false};
-    bool usedDisk{false};
+    bool usedDisk{statsOut->usedDisk};
     for (auto&& source : pipeline->_sources) {
         if (dynamic_cast<DocumentSourceSort*>(source.get()))
             hasSortStage = true;
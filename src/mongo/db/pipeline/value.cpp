@@ -1199,6 +1199,36 @@ ostream& operator<<(ostream& out, const Value& val) {
     verify(false);
 }
 
+bool Value::isArenaBacked() const {
+    switch (getType()) {
+        case Object:
+            return getDocument().isArenaBacked();
+        case Array:
+            return static_cast<const RCVector*>(_storage.genericRCPtr)->mayHoldArenaValues;
+        default:
+            return false;
+    }
+}
+
+Value Value::getOwned() const {
+    if (!isArenaBacked()) {
+        return *this;
+    }
+
+    DocumentArena::Scope heapOnly(nullptr);
+    if (getType() == Object) {
+        return Value(getDocument().getOwned());
+    }
+
+    const auto& array = getArray();
+    std::vector<Value> owned;
+    owned.reserve(array.size());
+    for (auto&& elem : array) {
+        owned.push_back(elem.getOwned());
+    }
+    return Value(std::move(owned));
+}
+
 void Value::serializeForSorter(BufBuilder& buf) const {
     buf.appendChar(getType());
     switch (getType()) {
@@ -353,9 +353,18 @@ public:
     int memUsageForSorter() const {
         return getApproximateSize();
     }
-    Value getOwned() const {
-        return *this;
-    }
+
+    /**
+     * Returns a Value which does not reference memory in any DocumentArena, copying any nested
+     * Documents which do. See Document::getOwned().
+     */
+    Value getOwned() const;
+
+    /**
+     * Returns true if a Document nested in this Value may live in a DocumentArena. This is a
+     * constant-time check of the flag kept by the top-level Document or array.
+     */
+    bool isArenaBacked() const;
 
     /// Members to support parsing/deserialization from IDL generated code.
     void serializeForIDL(StringData fieldName, BSONObjBuilder* builder) const;
@@ -38,6 +38,7 @@
 #include "mongo/bson/bsontypes.h"
 #include "mongo/bson/oid.h"
 #include "mongo/bson/timestamp.h"
+#include "mongo/db/pipeline/document_arena.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/intrusive_counter.h"
 
@@ -54,6 +55,10 @@ public:
     RCVector() {}
     RCVector(std::vector<Value> v) : vec(std::move(v)) {}
     std::vector<Value> vec;
+
+    // Set if the array was built while a DocumentArena was active, so that its elements may live
+    // in the arena. See DocumentStorage::isArenaBacked().
+    const bool mayHoldArenaValues = DocumentArena::isActive();
 };
 
 class RCCodeWScope : public RefCountable {
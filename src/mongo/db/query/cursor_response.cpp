@@ -54,15 +54,19 @@ const char kPostBatchResumeTokenField[] = "postBatchResumeToken";
 
 CursorResponseBuilder::CursorResponseBuilder(rpc::ReplyBuilderInterface* replyBuilder,
                                              Options options = Options())
-    : _options(options), _replyBuilder(replyBuilder) {
+    : _options(options),
+      _replyBuilder(replyBuilder),
+      _spliceThresholdBytes(replyBuilder->supportsSplicing() ? options.spliceThresholdBytes : 0) {
     if (_options.useDocumentSequences) {
         _docSeqBuilder.emplace(_replyBuilder->getDocSequenceBuilder(
             _options.isInitialResponse ? kBatchDocSequenceFieldInitial : kBatchDocSequenceField));
     } else {
         _bodyBuilder.emplace(_replyBuilder->getBodyBuilder());
         _cursorObject.emplace(_bodyBuilder->subobjStart(kCursorField));
-        _batch.emplace(_cursorObject->subarrayStart(_options.isInitialResponse ? kBatchFieldInitial
-                                                                               : kBatchField));
+        auto& batchBuf = _cursorObject->subarrayStart(_options.isInitialResponse ? kBatchFieldInitial
+                                                                                : kBatchField);
+        _batchOffset = batchBuf.len();
+        _batch.emplace(batchBuf);
     }
 }
 
@@ -74,6 +78,11 @@ void CursorResponseBuilder::done(CursorId cursorId, StringData cursorNamespace)
         _cursorObject.emplace(_bodyBuilder->subobjStart(kCursorField));
     } else {
         _batch.reset();
+        if (_splicedBytes) {
+            // The batch and cursor objects were sized without the spliced documents.
+            _replyBuilder->growSplicedObject(_batchOffset, _splicedBytes);
+            _replyBuilder->growSplicedObject(_cursorObject->offset(), _splicedBytes);
+        }
     }
     if (!_postBatchResumeToken.isEmpty()) {
         _cursorObject->append(kPostBatchResumeTokenField, _postBatchResumeToken);
@@ -93,6 +102,7 @@ void CursorResponseBuilder::abandon() {
     _bodyBuilder.reset();
     _replyBuilder->reset();
     _numDocs = 0;
+    _splicedBytes = 0;
     _active = false;
 }
 
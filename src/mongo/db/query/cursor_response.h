@@ -54,6 +54,9 @@ public:
     struct Options {
         bool isInitialResponse = false;
         bool useDocumentSequences = false;
+        // Owned documents at least this large are referenced from the reply rather than copied
+        // into it, if the reply builder supports that. 0 disables splicing.
+        size_t spliceThresholdBytes = 0;
     };
 
     /**
@@ -74,13 +77,19 @@ public:
 
     size_t bytesUsed() const {
         invariant(_active);
-        return _options.useDocumentSequences ? _docSeqBuilder->len() : _batch->len();
+        return _options.useDocumentSequences ? _docSeqBuilder->len()
+                                             : _batch->len() + _splicedBytes;
     }
 
     void append(const BSONObj& obj) {
         invariant(_active);
         if (_options.useDocumentSequences) {
             _docSeqBuilder->append(obj);
+        } else if (_shouldSplice(obj)) {
+            // Write the element's type and field name, then let the reply reference the document.
+            _batch->subobjStart();
+            _replyBuilder->spliceIntoBody(obj.sharedBuffer(), obj.objdata(), obj.objsize());
+            _splicedBytes += obj.objsize();
         } else {
             _batch->append(obj);
         }
@@ -109,8 +118,14 @@ public:
     void abandon();
 
 private:
+    bool _shouldSplice(const BSONObj& obj) const {
+        return _spliceThresholdBytes && obj.isOwned() &&
+            static_cast<size_t>(obj.objsize()) >= _spliceThresholdBytes;
+    }
+
     const Options _options;
     rpc::ReplyBuilderInterface* const _replyBuilder;
+    const size_t _spliceThresholdBytes;
     // Order here is important to ensure destruction in the correct order.
     boost::optional<BSONObjBuilder> _bodyBuilder;
     boost::optional<BSONObjBuilder> _cursorObject;
@@ -119,6 +134,9 @@ private:
 
     bool _active = true;
     long long _numDocs = 0;
+    // Offset of the batch array in the reply, and the bytes spliced into it.
+    int _batchOffset = 0;
+    size_t _splicedBytes = 0;
     BSONObj _postBatchResumeToken;
 };
 
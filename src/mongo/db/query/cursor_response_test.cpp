@@ -327,6 +327,51 @@ TEST(CursorResponseTest, cursorReturnDocumentSequences) {
     ASSERT_BSONOBJ_EQ(opMsg.body, expectedBody);
 }
 
+TEST(CursorResponseTest, splicedBatchMatchesCopiedBatch) {
+    const BSONObj smallDoc = BSON("_id" << 1);
+    const BSONObj largeDoc = BSON("_id" << 2 << "payload" << std::string(100, 'x'));
+    const BSONObj container = BSON("embedded" << largeDoc);
+    const BSONObj unownedDoc = container["embedded"].Obj();
+    ASSERT(!unownedDoc.isOwned());
+
+    auto buildReply = [&](size_t spliceThresholdBytes, size_t* bytesUsed) {
+        CursorResponseBuilder::Options options;
+        options.isInitialResponse = true;
+        options.spliceThresholdBytes = spliceThresholdBytes;
+        rpc::OpMsgReplyBuilder builder;
+        CursorResponseBuilder crb(&builder, options);
+        crb.append(smallDoc);
+        crb.append(largeDoc);
+        crb.append(unownedDoc);
+        crb.append(largeDoc);
+        *bytesUsed = crb.bytesUsed();
+        crb.done(CursorId(123), "db.coll");
+        builder.getBodyBuilder().append("ok", 1.0);
+        return builder.done();
+    };
+
+    size_t copiedBytesUsed = 0;
+    size_t splicedBytesUsed = 0;
+    auto copied = buildReply(0, &copiedBytesUsed);
+    auto spliced = buildReply(size_t(largeDoc.objsize()), &splicedBytesUsed);
+    ASSERT_FALSE(copied.isSpliced());
+    ASSERT_TRUE(spliced.isSpliced());
+    ASSERT_EQ(copiedBytesUsed, splicedBytesUsed);
+
+    // Only the two owned large documents are referenced.
+    std::vector<const char*> segments;
+    spliced.forEachSegment([&](const char* data, size_t len) { segments.push_back(data); });
+    ASSERT_EQ(std::count(segments.begin(), segments.end(), largeDoc.objdata()), 2);
+
+    ASSERT_EQ(copied.size(), spliced.size());
+    ASSERT_EQ(memcmp(copied.buf(), spliced.buf(), copied.size()), 0);
+
+    auto response = CursorResponse::parseFromBSON(OpMsg::parse(spliced).body);
+    ASSERT_OK(response.getStatus());
+    ASSERT_EQ(response.getValue().getBatch().size(), 4U);
+    ASSERT_BSONOBJ_EQ(response.getValue().getBatch()[3], largeDoc);
+}
+
 }  // namespace
 
 }  // namespace mongo
@@ -176,6 +176,10 @@ size_t getDocsExamined(StageType type, const SpecificStats* specific) {
     if (STAGE_COLLSCAN == type) {
         const CollectionScanStats* spec = static_cast<const CollectionScanStats*>(specific);
         return spec->docsTested;
+    } else if (STAGE_PARALLEL_COLLSCAN == type) {
+        const ParallelCollectionScanStats* spec =
+            static_cast<const ParallelCollectionScanStats*>(specific);
+        return spec->docsTested;
     } else if (STAGE_FETCH == type) {
         const FetchStats* spec = static_cast<const FetchStats*>(specific);
         return spec->docsExamined;
@@ -332,6 +336,11 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         bob->appendNumber("needYield", stats.common.needYield);
         bob->appendNumber("saveState", stats.common.yields);
         bob->appendNumber("restoreState", stats.common.unyields);
+        if (stats.common.batches > 0) {
+            bob->appendNumber("batches", stats.common.batches);
+            bob->append("avgBatchSize",
+                        static_cast<double>(stats.common.batchedResults) / stats.common.batches);
+        }
         if (stats.common.failed)
             bob->appendBool("failed", stats.common.failed);
         bob->appendNumber("isEOF", stats.common.isEOF);
@@ -367,6 +376,14 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("docsExamined", spec->docsTested);
         }
+    } else if (STAGE_PARALLEL_COLLSCAN == stats.stageType) {
+        ParallelCollectionScanStats* spec =
+            static_cast<ParallelCollectionScanStats*>(stats.specific.get());
+        if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
+            bob->appendNumber("docsExamined", spec->docsTested);
+            bob->appendNumber("parallelism", spec->parallelism);
+            bob->appendNumber("rounds", spec->rounds);
+        }
     } else if (STAGE_COUNT == stats.stageType) {
         CountStats* spec = static_cast<CountStats*>(stats.specific.get());
 
@@ -445,6 +462,7 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("docsExamined", spec->docsExamined);
             bob->appendNumber("alreadyHasObj", spec->alreadyHasObj);
+            bob->appendNumber("docsPrefetched", spec->docsPrefetched);
         }
     } else if (STAGE_GEO_NEAR_2D == stats.stageType || STAGE_GEO_NEAR_2DSPHERE == stats.stageType) {
         NearStats* spec = static_cast<NearStats*>(stats.specific.get());
@@ -541,6 +559,8 @@ void Explain::statsToBSON(const PlanStageStats& stats,
         if (verbosity >= ExplainOptions::Verbosity::kExecStats) {
             bob->appendNumber("memUsage", spec->memUsage);
             bob->appendNumber("memLimit", spec->memLimit);
+            bob->appendBool("usedDisk", spec->usedDisk);
+            bob->appendNumber("spills", static_cast<long long>(spec->spills));
         }
 
         if (spec->limit > 0) {
@@ -976,6 +996,9 @@ void Explain::getSummaryStats(const PlanExecutor& exec, PlanSummaryStats* statsO
 
         if (STAGE_SORT == stages[i]->stageType()) {
             statsOut->hasSortStage = true;
+            const SortStats* sortStats =
+                static_cast<const SortStats*>(stages[i]->getSpecificStats());
+            statsOut->usedDisk = statsOut->usedDisk || sortStats->usedDisk;
         }
 
         if (STAGE_IXSCAN == stages[i]->stageType()) {
@@ -1023,6 +1046,9 @@ void Explain::getSummaryStats(const PlanExecutor& exec, PlanSummaryStats* statsO
                 static_cast<const CollectionScanStats*>(collScan->getSpecificStats());
             if (!collScanStats->tailable)
                 statsOut->collectionScansNonTailable++;
+        } else if (STAGE_PARALLEL_COLLSCAN == stages[i]->stageType()) {
+            statsOut->collectionScans++;
+            statsOut->collectionScansNonTailable++;
         }
     }
 }
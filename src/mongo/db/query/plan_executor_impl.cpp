@@ -54,6 +54,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/service_context.h"
 #include "mongo/util/fail_point_service.h"
@@ -124,6 +125,29 @@ PlanStage* getStageByType(PlanStage* root, StageType type) {
 
     return nullptr;
 }
+
+/**
+ * Returns the largest number of results the executor may request from 'root' in one call.
+ *
+ * Results are not batched for tailable cursors or for plans which report the latest oplog
+ * timestamp. A batched scan reads ahead of the results it has returned, so the timestamp it
+ * reports could cover oplog entries that are still buffered in the executor.
+ */
+size_t getMaxBatchSize(PlanStage* root, const CanonicalQuery* cq) {
+    if (cq && cq->getQueryRequest().isTailable()) {
+        return 1;
+    }
+    if (getStageByType(root, STAGE_CHANGE_STREAM_PROXY)) {
+        return 1;
+    }
+    if (auto collectionScan = getStageByType(root, STAGE_COLLSCAN)) {
+        auto scan = static_cast<CollectionScan*>(collectionScan);
+        if (scan->isTailable() || scan->tracksLatestOplogTimestamp()) {
+            return 1;
+        }
+    }
+    return internalQueryExecBatchSize.load();
+}
 }  // namespace
 
 // static
@@ -231,7 +255,8 @@ PlanExecutorImpl::PlanExecutorImpl(OperationContext* opCtx,
       _root(std::move(rt)),
       _nss(std::move(nss)),
       // There's no point in yielding if the collection doesn't exist.
-      _yieldPolicy(makeYieldPolicy(this, collection ? yieldPolicy : NO_YIELD)) {
+      _yieldPolicy(makeYieldPolicy(this, collection ? yieldPolicy : NO_YIELD)),
+      _maxBatchSize(getMaxBatchSize(_root.get(), _cq.get())) {
     // We may still need to initialize _nss from either collection or _cq.
     if (!_nss.isEmpty()) {
         return;  // We already have an _nss set, so there's nothing more to do.
@@ -328,6 +353,11 @@ void PlanExecutorImpl::saveState() {
     // boundaries.
     WorkingSetCommon::prepareForSnapshotChange(_workingSet.get());
 
+    // Results which are still buffered from the last batch must survive the yield.
+    for (size_t i = _batchPos; i < _batch.size(); ++i) {
+        _workingSet->get(_batch[i])->makeObjOwnedIfNeeded();
+    }
+
     if (!isMarkedAsKilled()) {
         _root->saveState();
     }
@@ -470,6 +500,45 @@ PlanExecutor::ExecState PlanExecutorImpl::_waitForInserts(CappedInsertNotifierDa
     return FAILURE;
 }
 
+bool PlanExecutorImpl::_extractResult(WorkingSetID id,
+                                      Snapshotted<BSONObj>* objOut,
+                                      RecordId* dlOut) {
+    WorkingSetMember* member = _workingSet->get(id);
+    bool hasRequestedData = true;
+
+    if (nullptr != objOut) {
+        if (WorkingSetMember::RID_AND_IDX == member->getState()) {
+            if (1 != member->keyData.size()) {
+                _workingSet->free(id);
+                hasRequestedData = false;
+            } else {
+                // TODO: currently snapshot ids are only associated with documents, and
+                // not with index keys.
+                *objOut = Snapshotted<BSONObj>(SnapshotId(), member->keyData[0].keyData);
+            }
+        } else if (member->hasObj()) {
+            *objOut = member->obj;
+        } else {
+            _workingSet->free(id);
+            hasRequestedData = false;
+        }
+    }
+
+    if (nullptr != dlOut) {
+        if (member->hasRecordId()) {
+            *dlOut = member->recordId;
+        } else {
+            _workingSet->free(id);
+            hasRequestedData = false;
+        }
+    }
+
+    if (hasRequestedData) {
+        _workingSet->free(id);
+    }
+    return hasRequestedData;
+}
+
 PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<BSONObj>* objOut,
                                                        RecordId* dlOut) {
     if (MONGO_FAIL_POINT(planExecutorAlwaysFails)) {
@@ -497,6 +566,13 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<BSONObj>* obj
         return PlanExecutor::ADVANCED;
     }
 
+    // Return the results left over from the last batch before doing any more work.
+    while (_batchPos < _batch.size()) {
+        if (_extractResult(_batch[_batchPos++], objOut, dlOut)) {
+            return PlanExecutor::ADVANCED;
+        }
+    }
+
     // Incremented on every writeConflict, reset to 0 on any successful call to _root->work.
     size_t writeConflictsInARow = 0;
 
@@ -526,46 +602,30 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<BSONObj>* obj
         }
 
         WorkingSetID id = WorkingSet::INVALID_ID;
-        PlanStage::StageState code = _root->work(&id);
+        PlanStage::StageState code;
+        if (_maxBatchSize > 1) {
+            _batch.clear();
+            _batchPos = 0;
+            code = _root->workBatch(_maxBatchSize, &_batch);
+            if (!_batch.empty()) {
+                id = _batch[_batchPos++];
+            }
+        } else {
+            code = _root->work(&id);
+        }
 
         if (code != PlanStage::NEED_YIELD)
             writeConflictsInARow = 0;
 
         if (PlanStage::ADVANCED == code) {
-            WorkingSetMember* member = _workingSet->get(id);
-            bool hasRequestedData = true;
-
-            if (nullptr != objOut) {
-                if (WorkingSetMember::RID_AND_IDX == member->getState()) {
-                    if (1 != member->keyData.size()) {
-                        _workingSet->free(id);
-                        hasRequestedData = false;
-                    } else {
-                        // TODO: currently snapshot ids are only associated with documents, and
-                        // not with index keys.
-                        *objOut = Snapshotted<BSONObj>(SnapshotId(), member->keyData[0].keyData);
-                    }
-                } else if (member->hasObj()) {
-                    *objOut = member->obj;
-                } else {
-                    _workingSet->free(id);
-                    hasRequestedData = false;
-                }
+            if (_extractResult(id, objOut, dlOut)) {
+                return PlanExecutor::ADVANCED;
             }
-
-            if (nullptr != dlOut) {
-                if (member->hasRecordId()) {
-                    *dlOut = member->recordId;
-                } else {
-                    _workingSet->free(id);
-                    hasRequestedData = false;
+            while (_batchPos < _batch.size()) {
+                if (_extractResult(_batch[_batchPos++], objOut, dlOut)) {
+                    return PlanExecutor::ADVANCED;
                 }
             }
-
-            if (hasRequestedData) {
-                _workingSet->free(id);
-                return PlanExecutor::ADVANCED;
-            }
             // This result didn't have the data the caller wanted, try again.
         } else if (PlanStage::NEED_YIELD == code) {
             invariant(id == WorkingSet::INVALID_ID);
@@ -616,7 +676,8 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<BSONObj>* obj
 
 bool PlanExecutorImpl::isEOF() {
     invariant(_currentState == kUsable);
-    return isMarkedAsKilled() || (_stash.empty() && _root->isEOF());
+    return isMarkedAsKilled() ||
+        (_stash.empty() && _batchPos == _batch.size() && _root->isEOF());
 }
 
 void PlanExecutorImpl::markAsKilled(Status killStatus) {
@@ -31,7 +31,9 @@
 
 #include <boost/optional.hpp>
 #include <queue>
+#include <vector>
 
+#include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/plan_executor.h"
 
 namespace mongo {
@@ -147,6 +149,13 @@ private:
      */
     ExecState _getNextImpl(Snapshotted<BSONObj>* objOut, RecordId* dlOut);
 
+    /**
+     * Extracts the data requested by the caller of getNext() from the result 'id' produced by the
+     * root stage, and frees the working set member. Returns false if the member does not have the
+     * requested data, in which case the result should be skipped.
+     */
+    bool _extractResult(WorkingSetID id, Snapshotted<BSONObj>* objOut, RecordId* dlOut);
+
     // The OperationContext that we're executing within. This can be updated if necessary by using
     // detachFromOperationContext() and reattachToOperationContext().
     OperationContext* _opCtx;
@@ -173,6 +182,14 @@ private:
     // stages.
     std::queue<BSONObj> _stash;
 
+    // Upper bound on the number of results requested from '_root' at a time. When greater than
+    // one, results are produced by PlanStage::workBatch() and buffered in '_batch' until they are
+    // returned from getNext(). '_batchPos' is the position of the next result to return.
+    // Always one for tailable cursors and plans which track the latest oplog timestamp.
+    const size_t _maxBatchSize;
+    std::vector<WorkingSetID> _batch;
+    size_t _batchPos = 0;
+
     enum { kUsable, kSaved, kDetached, kDisposed } _currentState = kUsable;
 
     bool _everDetachedFromOperationContext = false;
@@ -98,6 +98,11 @@ struct QueryPlannerParams {
         // return exactly one document per value of the distinct field. See the comments above the
         // declaration of getExecutorDistinct() for more detail.
         STRICT_DISTINCT_ONLY = 1 << 11,
+
+        // Set this if the caller does not depend on the order in which a collection scan returns
+        // its results, so that the scan may be split across several threads. See
+        // ParallelCollectionScan.
+        PARALLEL_COLLSCAN = 1 << 12,
     };
 
     // See Options enum above.
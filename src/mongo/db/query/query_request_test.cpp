@@ -1121,7 +1121,7 @@ TEST(QueryRequestTest, ParseCommandAllowDiskUseFalse) {
     ASSERT_EQ(false, result.getValue()->allowDiskUse());
 }
 
-TEST(QueryRequestTest, ParseCommandAllowDiskUseTestCommandsDisabled) {
+TEST(QueryRequestTest, ParseCommandAllowDiskUseSucceedsWithTestCommandsDisabled) {
     const bool oldTestCommandsEnabledVal = getTestCommandsEnabled();
     ON_BLOCK_EXIT([&] { setTestCommandsEnabled(oldTestCommandsEnabledVal); });
     setTestCommandsEnabled(false);
@@ -1131,10 +1131,8 @@ TEST(QueryRequestTest, ParseCommandAllowDiskUseTestCommandsDisabled) {
     const bool isExplain = false;
     auto result = QueryRequest::makeFromFindCommand(nss, cmdObj, isExplain);
 
-    ASSERT_NOT_OK(result.getStatus());
-    ASSERT_EQ(ErrorCodes::FailedToParse, result.getStatus().code());
-    ASSERT_STRING_CONTAINS(result.getStatus().toString(),
-                           "allowDiskUse is not allowed unless test commands are enabled.");
+    ASSERT_OK(result.getStatus());
+    ASSERT_EQ(true, result.getValue()->allowDiskUse());
 }
 
 //
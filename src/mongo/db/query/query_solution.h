@@ -331,6 +331,10 @@ struct CollectionScanNode : public QuerySolutionNode {
 
     // Whether or not to wait for oplog visibility on oplog collection scans.
     bool shouldWaitForOplogVisibility = false;
+
+    // Whether the scan may return its results out of order by reading the collection on several
+    // threads.
+    bool allowParallel = false;
 };
 
 struct AndHashNode : public QuerySolutionNode {
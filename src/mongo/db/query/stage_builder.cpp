@@ -51,6 +51,7 @@
 #include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/skip.h"
@@ -81,6 +82,11 @@ PlanStage* buildStages(OperationContext* opCtx,
             params.direction = (csn->direction == 1) ? CollectionScanParams::FORWARD
                                                      : CollectionScanParams::BACKWARD;
             params.shouldWaitForOplogVisibility = csn->shouldWaitForOplogVisibility;
+            if (csn->allowParallel &&
+                ParallelCollectionScan::canScanInParallel(
+                    opCtx, collection, params, csn->filter.get())) {
+                return new ParallelCollectionScan(opCtx, collection, ws, csn->filter.get());
+            }
             return new CollectionScan(opCtx, collection, params, ws, csn->filter.get());
         }
         case STAGE_IXSCAN: {
@@ -310,7 +316,10 @@ PlanStage* buildStages(OperationContext* opCtx,
             }
 
             auto css = CollectionShardingState::get(opCtx, collection->ns());
-            return new ShardFilterStage(opCtx, css->getOrphansFilter(opCtx), ws, childStage);
+            auto metadata = css->getOrphansFilter(opCtx);
+            const bool childIsOwned =
+                metadata->isSharded() && StageBuilder::indexScanIsOwned(fn->children[0], *metadata);
+            return new ShardFilterStage(opCtx, std::move(metadata), ws, childStage, childIsOwned);
         }
         case STAGE_DISTINCT_SCAN: {
             const DistinctNode* dn = static_cast<const DistinctNode*>(root);
@@ -379,6 +388,7 @@ PlanStage* buildStages(OperationContext* opCtx,
         case STAGE_IDHACK:
         case STAGE_MULTI_ITERATOR:
         case STAGE_MULTI_PLAN:
+        case STAGE_PARALLEL_COLLSCAN:
         case STAGE_PIPELINE_PROXY:
         case STAGE_QUEUED_DATA:
         case STAGE_RECORD_STORE_FAST_COUNT:
@@ -397,6 +407,70 @@ PlanStage* buildStages(OperationContext* opCtx,
     return nullptr;
 }
 
+// static
+bool StageBuilder::indexScanIsOwned(const QuerySolutionNode* node,
+                                    const CollectionMetadata& metadata) {
+    if (STAGE_FETCH == node->getType() && node->children.size() == 1) {
+        node = node->children[0];
+    }
+
+    if (STAGE_IXSCAN != node->getType()) {
+        return false;
+    }
+
+    const IndexScanNode* ixn = static_cast<const IndexScanNode*>(node);
+    if (INDEX_BTREE != ixn->index.type || ixn->index.collator || ixn->index.multikey ||
+        ixn->bounds.isSimpleRange) {
+        return false;
+    }
+
+    const auto& shardKeyPattern = metadata.getChunkManager()->getShardKeyPattern();
+    if (shardKeyPattern.isHashedPattern()) {
+        return false;
+    }
+
+    BSONObjBuilder minBuilder;
+    BSONObjBuilder maxBuilder;
+
+    BSONObjIterator indexKeyIt(ixn->index.keyPattern);
+    size_t fieldNo = 0;
+    for (const auto& shardKeyElt : shardKeyPattern.toBSON()) {
+        if (!indexKeyIt.more() || fieldNo >= ixn->bounds.fields.size() ||
+            indexKeyIt.next().fieldNameStringData() != shardKeyElt.fieldNameStringData()) {
+            return false;
+        }
+
+        const auto& intervals = ixn->bounds.fields[fieldNo++].intervals;
+        if (intervals.empty()) {
+            return false;
+        }
+
+        // The intervals are in index order, which is descending for descending index fields
+        BSONElement min = intervals.front().start;
+        BSONElement max = intervals.front().start;
+        for (const auto& interval : intervals) {
+            for (const auto& bound : {interval.start, interval.end}) {
+                if (bound.woCompare(min, false) < 0) {
+                    min = bound;
+                }
+                if (bound.woCompare(max, false) > 0) {
+                    max = bound;
+                }
+            }
+        }
+
+        // Documents missing a shard key field are indexed as null and must go through the filter
+        if (min.canonicalType() <= canonicalizeBSONType(jstNULL)) {
+            return false;
+        }
+
+        minBuilder.appendAs(min, shardKeyElt.fieldNameStringData());
+        maxBuilder.appendAs(max, shardKeyElt.fieldNameStringData());
+    }
+
+    return metadata.rangeBelongsToMe(minBuilder.obj(), maxBuilder.obj());
+}
+
 // static (this one is used for Cached and MultiPlanStage)
 bool StageBuilder::build(OperationContext* opCtx,
                          const Collection* collection,
@@ -35,6 +35,7 @@
 
 namespace mongo {
 
+class CollectionMetadata;
 class OperationContext;
 
 /**
@@ -58,6 +59,15 @@ public:
                       const QuerySolution& solution,
                       WorkingSet* wsIn,
                       PlanStage** rootOut);
+
+    /**
+     * Returns true if every document which the index scan under 'node', possibly below a FETCH,
+     * can return has a shard key within a range owned by this shard according to 'metadata', in
+     * which case its results need no orphan filtering. This holds when the index starts with the
+     * fields of the shard key and the bounds on these fields, which must exclude missing and null
+     * values, fall in an owned range.
+     */
+    static bool indexScanIsOwned(const QuerySolutionNode* node, const CollectionMetadata& metadata);
 };
 
 }  // namespace mongo
@@ -105,6 +105,9 @@ enum StageType {
     STAGE_UNKNOWN,
 
     STAGE_UPDATE,
+
+    // A collection scan which reads disjoint ranges of the collection on several threads.
+    STAGE_PARALLEL_COLLSCAN,
 };
 
 }  // namespace mongo
@@ -33,13 +33,16 @@
 
 #include "mongo/db/repl/collection_cloner.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "mongo/base/string_data.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/bson/util/bson_extract.h"
 #include "mongo/client/dbclient_connection.h"
 #include "mongo/client/remote_command_retry_scheduler.h"
 #include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/client.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/cursor_response.h"
 #include "mongo/db/repl/oplogreader.h"
@@ -51,6 +54,7 @@
 #include "mongo/util/destructor_guard.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
@@ -66,6 +70,11 @@ constexpr auto kCountResponseDocumentCountFieldName = "n"_sd;
 const int kProgressMeterSecondsBetween = 60;
 const int kProgressMeterCheckInterval = 128;
 
+// Number of _id values sampled on the sync source for every range a collection is split into.
+const int kSampledIdsPerRange = 32;
+
+const BSONObj kIdIndexKeyPattern = BSON("_id" << 1);
+
 }  // namespace
 
 // Failpoint which causes initial sync to hang before establishing its cursor to clone the
@@ -258,6 +267,9 @@ void CollectionCloner::_cancelRemainingWork_inlock() {
     if (_queryState == QueryState::kRunning) {
         _queryState = QueryState::kCanceling;
         _clientConnection->shutdownAndDisallowReconnect();
+        for (auto& conn : _rangeClientConnections) {
+            conn->shutdownAndDisallowReconnect();
+        }
     } else {
         _queryState = QueryState::kFinished;
     }
@@ -299,6 +311,28 @@ std::vector<BSONObj> CollectionCloner::getDocumentsToInsert_forTest() {
     return _documentsToInsert;
 }
 
+std::vector<BSONObj> CollectionCloner::selectRangeBoundaries(std::vector<BSONObj> sampledIds,
+                                                             size_t numRanges) {
+    const auto& comparator = SimpleBSONObjComparator::kInstance;
+    std::sort(sampledIds.begin(), sampledIds.end(), comparator.makeLessThan());
+    sampledIds.erase(
+        std::unique(sampledIds.begin(), sampledIds.end(), comparator.makeEqualTo()),
+        sampledIds.end());
+
+    std::vector<BSONObj> boundaries;
+    if (numRanges < 2 || sampledIds.empty()) {
+        return boundaries;
+    }
+    numRanges = std::min(numRanges, sampledIds.size());
+    for (size_t i = 1; i < numRanges; ++i) {
+        const auto& boundary = sampledIds[(i * sampledIds.size()) / numRanges];
+        if (boundaries.empty() || comparator.evaluate(boundaries.back() != boundary)) {
+            boundaries.push_back(boundary.getOwned());
+        }
+    }
+    return boundaries;
+}
+
 void CollectionCloner::_countCallback(
     const executor::TaskExecutor::RemoteCommandCallbackArgs& args) {
 
@@ -532,40 +566,27 @@ void CollectionCloner::_runQuery(const executor::TaskExecutor::CallbackArgs& cal
         }
     }
 
-    Status clientConnectionStatus = _clientConnection->connect(_source, StringData());
+    Status clientConnectionStatus = _connectClient(_clientConnection.get());
     if (!clientConnectionStatus.isOK()) {
         stdx::lock_guard<stdx::mutex> lock(_mutex);
         onCompletionGuard->setResultAndCancelRemainingWork_inlock(lock, clientConnectionStatus);
         return;
     }
-    if (!replAuthenticate(_clientConnection.get())) {
-        stdx::lock_guard<stdx::mutex> lock(_mutex);
-        onCompletionGuard->setResultAndCancelRemainingWork_inlock(
-            lock,
-            {ErrorCodes::AuthenticationFailed,
-             str::stream() << "Failed to authenticate to " << _source});
-        return;
-    }
 
     // readOnce is available on 4.2 sync sources only.  Initially we don't know FCV, so
     // we won't use the readOnce feature, but once the admin database is cloned we will use it.
     // The admin database is always cloned first, so all user data should use readOnce.
     const bool readOnceAvailable = serverGlobalParams.featureCompatibility.getVersionUnsafe() ==
         ServerGlobalParams::FeatureCompatibility::Version::kFullyUpgradedTo42;
-    try {
-        _clientConnection->query(
-            [this, onCompletionGuard](DBClientCursorBatchIterator& iter) {
-                _handleNextBatch(onCompletionGuard, iter);
-            },
-            NamespaceStringOrUUID(_sourceNss.db().toString(), *_options.uuid),
-            readOnceAvailable ? QUERY("query" << BSONObj() << "$readOnce" << true) : Query(),
-            nullptr /* fieldsToReturn */,
-            QueryOption_NoCursorTimeout | QueryOption_SlaveOk |
-                (collectionClonerUsesExhaust ? QueryOption_Exhaust : 0),
-            _collectionClonerBatchSize);
-    } catch (const DBException& e) {
-        auto queryStatus = e.toStatus().withContext(str::stream() << "Error querying collection '"
-                                                                  << _sourceNss.ns());
+    const auto boundaries = _sampleRangeBoundaries();
+    auto queryStatus = boundaries.empty()
+        ? _queryRange(_clientConnection.get(),
+                      BSONObj(),
+                      BSONObj(),
+                      readOnceAvailable,
+                      onCompletionGuard)
+        : _runRangeQueries(boundaries, readOnceAvailable, onCompletionGuard);
+    if (!queryStatus.isOK()) {
         stdx::unique_lock<stdx::mutex> lock(_mutex);
         if (queryStatus.code() == ErrorCodes::OperationFailed ||
             queryStatus.code() == ErrorCodes::CursorNotFound ||
@@ -590,11 +611,187 @@ void CollectionCloner::_runQuery(const executor::TaskExecutor::CallbackArgs& cal
     onCompletionGuard->setResultAndCancelRemainingWork_inlock(lock, Status::OK());
 }
 
+Status CollectionCloner::_connectClient(DBClientConnection* conn) {
+    auto status = conn->connect(_source, StringData());
+    if (!status.isOK()) {
+        return status;
+    }
+    if (!replAuthenticate(conn)) {
+        return {ErrorCodes::AuthenticationFailed,
+                str::stream() << "Failed to authenticate to " << _source};
+    }
+    return Status::OK();
+}
+
+std::vector<BSONObj> CollectionCloner::_sampleRangeBoundaries() {
+    const int maxRanges = collectionClonerMaxParallelRanges.load();
+    {
+        stdx::lock_guard<stdx::mutex> lock(_mutex);
+        // Capped collections must be inserted in their natural order, and the _id index of a
+        // collection with a non-simple default collation does not order keys the way the
+        // sampled values compare here, so both are cloned with a single query.
+        if (maxRanges < 2 || _options.capped || !_options.collation.isEmpty() ||
+            _idIndexSpec.isEmpty() ||
+            _stats.documentToCopy <
+                static_cast<size_t>(collectionClonerParallelRangeMinDocuments.load())) {
+            return {};
+        }
+    }
+
+    // The split points only affect how evenly the work is spread: the ranges always cover the
+    // whole _id index, so a failed or unrepresentative sample falls back to a single query.
+    const int sampleSize = maxRanges * kSampledIdsPerRange;
+    BSONObj cmd = BSON("aggregate" << _sourceNss.coll() << "pipeline"
+                                   << BSON_ARRAY(BSON("$sample" << BSON("size" << sampleSize))
+                                                 << BSON("$project" << BSON("_id" << 1)))
+                                   << "cursor"
+                                   << BSON("batchSize" << sampleSize));
+    std::vector<BSONObj> sampledIds;
+    try {
+        BSONObj result;
+        _clientConnection->runCommand(
+            _sourceNss.db().toString(), cmd, result, QueryOption_SlaveOk);
+        auto response = CursorResponse::parseFromBSON(result);
+        if (!response.isOK()) {
+            LOG(1) << "CollectionCloner ns: '" << _sourceNss.ns()
+                   << "' failed to sample _id ranges: " << response.getStatus();
+            return {};
+        }
+        if (response.getValue().getCursorId() != 0) {
+            _clientConnection->killCursor(response.getValue().getNSS(),
+                                          response.getValue().getCursorId());
+        }
+        for (const auto& doc : response.getValue().getBatch()) {
+            auto id = doc["_id"];
+            if (!id.eoo()) {
+                sampledIds.push_back(id.wrap());
+            }
+        }
+    } catch (const DBException& e) {
+        LOG(1) << "CollectionCloner ns: '" << _sourceNss.ns()
+               << "' failed to sample _id ranges: " << e.toStatus();
+        return {};
+    }
+    return selectRangeBoundaries(std::move(sampledIds), maxRanges);
+}
+
+Status CollectionCloner::_queryRange(DBClientConnection* conn,
+                                     const BSONObj& min,
+                                     const BSONObj& max,
+                                     bool readOnceAvailable,
+                                     std::shared_ptr<OnCompletionGuard> onCompletionGuard) {
+    Query query = readOnceAvailable ? QUERY("query" << BSONObj() << "$readOnce" << true) : Query();
+    if (!min.isEmpty() || !max.isEmpty()) {
+        // min and max are index bounds rather than predicates, so documents whose _id values
+        // are of different BSON types are still assigned to exactly one range.
+        query.hint(kIdIndexKeyPattern);
+        if (!min.isEmpty()) {
+            query.minKey(min);
+        }
+        if (!max.isEmpty()) {
+            query.maxKey(max);
+        }
+    }
+    try {
+        conn->query(
+            [this, onCompletionGuard](DBClientCursorBatchIterator& iter) {
+                _handleNextBatch(onCompletionGuard, iter);
+            },
+            NamespaceStringOrUUID(_sourceNss.db().toString(), *_options.uuid),
+            query,
+            nullptr /* fieldsToReturn */,
+            QueryOption_NoCursorTimeout | QueryOption_SlaveOk |
+                (collectionClonerUsesExhaust ? QueryOption_Exhaust : 0),
+            _collectionClonerBatchSize);
+    } catch (const DBException& e) {
+        return e.toStatus().withContext(str::stream() << "Error querying collection '"
+                                                      << _sourceNss.ns());
+    }
+    return Status::OK();
+}
+
+Status CollectionCloner::_runRangeQueries(const std::vector<BSONObj>& boundaries,
+                                          bool readOnceAvailable,
+                                          std::shared_ptr<OnCompletionGuard> onCompletionGuard) {
+    const size_t numRanges = boundaries.size() + 1;
+    log() << "CollectionCloner ns: '" << _sourceNss.ns() << "' cloning " << numRanges
+          << " _id ranges concurrently";
+
+    // (M) The first error reported by any range. Once set, the other ranges are stopped.
+    Status firstError = Status::OK();
+    auto setRangeResult = [&](const Status& status) {
+        if (status.isOK()) {
+            return;
+        }
+        stdx::lock_guard<stdx::mutex> lock(_mutex);
+        if (!firstError.isOK()) {
+            return;
+        }
+        // A range whose connection was shut down by cancellation fails with a network error.
+        firstError = _queryState == QueryState::kCanceling
+            ? Status(ErrorCodes::CallbackCanceled, "Collection cloning cancelled.")
+            : status;
+        _clientConnection->shutdownAndDisallowReconnect();
+        for (auto& conn : _rangeClientConnections) {
+            conn->shutdownAndDisallowReconnect();
+        }
+    };
+
+    auto runRange = [&](size_t rangeIndex) {
+        const BSONObj min = rangeIndex == 0 ? BSONObj() : boundaries[rangeIndex - 1];
+        const BSONObj max = rangeIndex == boundaries.size() ? BSONObj() : boundaries[rangeIndex];
+        if (rangeIndex == 0) {
+            setRangeResult(_queryRange(
+                _clientConnection.get(), min, max, readOnceAvailable, onCompletionGuard));
+            return;
+        }
+
+        DBClientConnection* conn = nullptr;
+        {
+            stdx::lock_guard<stdx::mutex> lock(_mutex);
+            if (_queryState != QueryState::kRunning || !firstError.isOK()) {
+                if (firstError.isOK()) {
+                    firstError = {ErrorCodes::CallbackCanceled, "Collection cloning cancelled."};
+                }
+                return;
+            }
+            _rangeClientConnections.push_back(_createClientFn());
+            conn = _rangeClientConnections.back().get();
+        }
+        auto status = _connectClient(conn);
+        if (status.isOK()) {
+            status = _queryRange(conn, min, max, readOnceAvailable, onCompletionGuard);
+        }
+        setRangeResult(status);
+    };
+
+    std::vector<stdx::thread> rangeThreads;
+    // The threads already started must be joined even if starting another one throws.
+    ON_BLOCK_EXIT([&] {
+        for (auto& thread : rangeThreads) {
+            thread.join();
+        }
+    });
+    for (size_t rangeIndex = 1; rangeIndex < numRanges; ++rangeIndex) {
+        rangeThreads.emplace_back([&, rangeIndex] {
+            Client::initThread(std::string(str::stream() << "CollectionClonerRange-"
+                                                         << rangeIndex));
+            runRange(rangeIndex);
+        });
+    }
+    runRange(0);
+
+    stdx::lock_guard<stdx::mutex> lock(_mutex);
+    _rangeClientConnections.clear();
+    return firstError;
+}
+
 void CollectionCloner::_handleNextBatch(std::shared_ptr<OnCompletionGuard> onCompletionGuard,
                                         DBClientCursorBatchIterator& iter) {
-    _stats.receivedBatches++;
+    bool scheduleInsert = false;
     {
         stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _stats.receivedBatches++;
         uassert(ErrorCodes::CallbackCanceled,
                 "Collection cloning cancelled.",
                 _queryState != QueryState::kCanceling);
@@ -602,18 +799,30 @@ void CollectionCloner::_handleNextBatch(std::shared_ptr<OnCompletionGuard> onCom
             BSONObj o = iter.nextSafe();
             _documentsToInsert.emplace_back(std::move(o));
         }
+
+        // A pending insertion takes all the documents buffered by the time it runs, including
+        // those of batches received from other _id ranges in the meantime.
+        scheduleInsert = !_insertScheduled;
+        _insertScheduled = true;
     }
 
     // Schedule the next document batch insertion.
-    auto&& scheduleResult = _scheduleDbWorkFn([=](const executor::TaskExecutor::CallbackArgs& cbd) {
-        _insertDocumentsCallback(cbd, onCompletionGuard);
-    });
+    if (scheduleInsert) {
+        auto&& scheduleResult =
+            _scheduleDbWorkFn([=](const executor::TaskExecutor::CallbackArgs& cbd) {
+                _insertDocumentsCallback(cbd, onCompletionGuard);
+            });
 
-    if (!scheduleResult.isOK()) {
-        Status newStatus = scheduleResult.getStatus().withContext(
-            str::stream() << "Error cloning collection '" << _sourceNss.ns() << "'");
-        // We must throw an exception to terminate query.
-        uassertStatusOK(newStatus);
+        if (!scheduleResult.isOK()) {
+            {
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                _insertScheduled = false;
+            }
+            Status newStatus = scheduleResult.getStatus().withContext(
+                str::stream() << "Error cloning collection '" << _sourceNss.ns() << "'");
+            // We must throw an exception to terminate query.
+            uassertStatusOK(newStatus);
+        }
     }
 
     MONGO_FAIL_POINT_BLOCK(initialSyncHangCollectionClonerAfterHandlingBatchResponse, nssData) {
@@ -697,11 +906,13 @@ void CollectionCloner::_insertDocumentsCallback(
     std::shared_ptr<OnCompletionGuard> onCompletionGuard) {
     if (!cbd.status.isOK()) {
         stdx::lock_guard<stdx::mutex> lock(_mutex);
+        _insertScheduled = false;
         onCompletionGuard->setResultAndCancelRemainingWork_inlock(lock, cbd.status);
         return;
     }
 
     UniqueLock lk(_mutex);
+    _insertScheduled = false;
     std::vector<BSONObj> docs;
     if (_documentsToInsert.size() == 0) {
         warning() << "_insertDocumentsCallback, but no documents to insert for ns:" << _destNss;
@@ -50,6 +50,7 @@
 #include "mongo/executor/task_executor.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/progress_meter.h"
@@ -177,6 +178,14 @@ public:
      */
     std::vector<BSONObj> getDocumentsToInsert_forTest();
 
+    /**
+     * Chooses at most 'numRanges' - 1 split points from the sampled '{_id: ...}' documents so
+     * that the resulting ranges hold roughly the same number of samples. The split points are
+     * returned in _id index order without duplicates.
+     */
+    static std::vector<BSONObj> selectRangeBoundaries(std::vector<BSONObj> sampledIds,
+                                                      size_t numRanges);
+
 private:
     bool _isActive_inlock() const;
 
@@ -214,11 +223,41 @@ private:
     /**
      * Using a DBClientConnection, executes a query to retrieve all documents in the collection.
      * For each batch returned by the upstream node, _handleNextBatch will be called with the data.
-     * This method will return when the entire query is finished or failed.
+     * Large collections are split into _id ranges which are queried concurrently over separate
+     * connections. This method will return when the entire query is finished or failed.
      */
     void _runQuery(const executor::TaskExecutor::CallbackArgs& callbackData,
                    std::shared_ptr<OnCompletionGuard> onCompletionGuard);
 
+    /**
+     * Connects 'conn' to the sync source and authenticates it.
+     */
+    Status _connectClient(DBClientConnection* conn);
+
+    /**
+     * Samples _id values on the sync source and returns the split points dividing the collection
+     * into ranges, or an empty vector if the collection should be cloned with a single query.
+     */
+    std::vector<BSONObj> _sampleRangeBoundaries();
+
+    /**
+     * Queries the documents whose _id falls in [min, max) on 'conn', handing every batch to
+     * _handleNextBatch. An empty 'min' or 'max' leaves that side of the range unbounded.
+     */
+    Status _queryRange(DBClientConnection* conn,
+                       const BSONObj& min,
+                       const BSONObj& max,
+                       bool readOnceAvailable,
+                       std::shared_ptr<OnCompletionGuard> onCompletionGuard);
+
+    /**
+     * Queries the ranges delimited by 'boundaries' concurrently and returns the first error
+     * encountered by any of them. The first range runs on '_clientConnection'.
+     */
+    Status _runRangeQueries(const std::vector<BSONObj>& boundaries,
+                            bool readOnceAvailable,
+                            std::shared_ptr<OnCompletionGuard> onCompletionGuard);
+
     /**
      * Put all results from a query batch into a buffer to be inserted, and schedule
      * it to be inserted.
@@ -275,6 +314,7 @@ private:
     std::vector<BSONObj> _indexSpecs;             // (M)
     BSONObj _idIndexSpec;                         // (M)
     std::vector<BSONObj> _documentsToInsert;      // (M) Documents read from source to insert.
+    bool _insertScheduled = false;                // (M) An insertion of them is pending.
     TaskRunner _dbWorkTaskRunner;                 // (R)
     ScheduleDbWorkFn
         _scheduleDbWorkFn;  // (RT) Function for scheduling database work using the executor.
@@ -302,6 +342,10 @@ private:
     // allow cancellation, and those other threads may access it only when holding '_mutex'.
     std::unique_ptr<DBClientConnection> _clientConnection;
 
+    // (M) Client connections used for the additional _id ranges of a split collection. Each is
+    // owned by the thread querying its range and follows the same rules as '_clientConnection'.
+    std::vector<std::unique_ptr<DBClientConnection>> _rangeClientConnections;
+
     // State transitions:
     // PreStart --> Running --> ShuttingDown --> Complete
     // It is possible to skip intermediate states. For example,
@@ -28,7 +28,9 @@
  */
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <memory>
+#include <numeric>
 #include <vector>
 
 #include "mongo/db/commands.h"
@@ -36,6 +38,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/repl/base_cloner_test_fixture.h"
 #include "mongo/db/repl/collection_cloner.h"
+#include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/storage_interface.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/dbtests/mock/mock_dbclient_connection.h"
@@ -1464,4 +1467,205 @@ TEST_F(CollectionClonerRenamedBeforeStartTest,
     ASSERT_FALSE(collectionCloner->isActive());
 }
 
+/**
+ * Clones a collection large enough to be split into _id ranges. The sync source holds the documents
+ * {_id: 0} to {_id: 8}, and the sample of their _id values splits them into three ranges. The first
+ * range is queried on '_client', the other two on the connections in '_rangeClients'.
+ */
+class CollectionClonerRangesTest : public CollectionClonerTest {
+protected:
+    static constexpr int kNumDocuments = 9;
+    static constexpr int kNumRanges = 3;
+
+    void setUp() override {
+        CollectionClonerTest::setUp();
+
+        _originalMaxParallelRanges = collectionClonerMaxParallelRanges.load();
+        _originalParallelRangeMinDocuments = collectionClonerParallelRangeMinDocuments.load();
+        collectionClonerMaxParallelRanges.store(kNumRanges);
+        collectionClonerParallelRangeMinDocuments.store(kNumDocuments);
+
+        BSONArrayBuilder sampledIds;
+        for (int i = 0; i < kNumDocuments; ++i) {
+            _server->insert(nss.ns(), BSON("_id" << i));
+            sampledIds.append(BSON("_id" << i));
+        }
+        _server->setCommandReply("aggregate",
+                                 createCursorResponse(0, sampledIds.arr(), "firstBatch"));
+
+        storageInterface->createCollectionForBulkFn =
+            [this](const NamespaceString& nss,
+                   const CollectionOptions& options,
+                   const BSONObj idIndexSpec,
+                   const std::vector<BSONObj>& nonIdIndexSpecs)
+            -> StatusWith<std::unique_ptr<CollectionBulkLoaderMock>> {
+            auto localLoader = std::make_unique<CollectionBulkLoaderMock>(collectionStats);
+            Status result = localLoader->init(nonIdIndexSpecs);
+            if (!result.isOK())
+                return result;
+            localLoader->insertDocsFn = [this](const std::vector<BSONObj>::const_iterator begin,
+                                               const std::vector<BSONObj>::const_iterator end) {
+                stdx::lock_guard<stdx::mutex> lk(_insertedIdsMutex);
+                for (auto it = begin; it != end; ++it) {
+                    _insertedIds.push_back((*it)["_id"].numberInt());
+                }
+                return Status::OK();
+            };
+
+            _loader = localLoader.get();
+
+            return std::move(localLoader);
+        };
+
+        for (int i = 1; i < kNumRanges; ++i) {
+            _rangeClientsToCreate.push_back(
+                std::make_unique<FailableMockDBClientConnection>(_server.get(), getNet()));
+            _rangeClients.push_back(_rangeClientsToCreate.back().get());
+        }
+        collectionCloner->setCreateClientFn_forTest([this] {
+            if (!_clientCreated) {
+                _clientCreated = true;
+                return std::unique_ptr<DBClientConnection>(_client);
+            }
+            invariant(_numRangeClientsCreated < _rangeClientsToCreate.size());
+            return std::unique_ptr<DBClientConnection>(
+                _rangeClientsToCreate[_numRangeClientsCreated++].release());
+        });
+    }
+
+    void tearDown() override {
+        collectionClonerMaxParallelRanges.store(_originalMaxParallelRanges);
+        collectionClonerParallelRangeMinDocuments.store(_originalParallelRangeMinDocuments);
+        _rangeClientsToCreate.clear();
+        CollectionClonerTest::tearDown();
+    }
+
+    /**
+     * Starts cloning and responds to the count and listIndexes commands.
+     */
+    void startCloning() {
+        ASSERT_OK(collectionCloner->startup());
+        executor::NetworkInterfaceMock::InNetworkGuard guard(getNet());
+        processNetworkResponse(createCountResponse(kNumDocuments));
+        processNetworkResponse(createListIndexesResponse(0, BSON_ARRAY(idIndexSpec)));
+    }
+
+    std::vector<int> getInsertedIds() {
+        stdx::lock_guard<stdx::mutex> lk(_insertedIdsMutex);
+        auto insertedIds = _insertedIds;
+        std::sort(insertedIds.begin(), insertedIds.end());
+        return insertedIds;
+    }
+
+    // Connections for the ranges after the first one. They are owned by the CollectionCloner once
+    // created, in order, which happens only for as long as it is cloning.
+    std::vector<FailableMockDBClientConnection*> _rangeClients;
+
+private:
+    int _originalMaxParallelRanges = 0;
+    long long _originalParallelRangeMinDocuments = 0;
+    std::vector<std::unique_ptr<FailableMockDBClientConnection>> _rangeClientsToCreate;
+    size_t _numRangeClientsCreated = 0;
+    stdx::mutex _insertedIdsMutex;
+    std::vector<int> _insertedIds;
+};
+
+TEST_F(CollectionClonerRangesTest, ClonesEachDocumentOnceAcrossConcurrentRanges) {
+    startCloning();
+    collectionCloner->join();
+
+    ASSERT_OK(getStatus());
+    ASSERT_FALSE(collectionCloner->isActive());
+    ASSERT_TRUE(collectionStats->commitCalled);
+
+    // Every range was queried once, on its own connection, and returned only its own documents.
+    ASSERT_EQUALS(static_cast<size_t>(kNumRanges), _server->getQueryCount());
+    ASSERT_EQUALS(static_cast<size_t>(kNumRanges), collectionCloner->getStats().receivedBatches);
+    std::vector<int> expectedIds(kNumDocuments);
+    std::iota(expectedIds.begin(), expectedIds.end(), 0);
+    ASSERT_TRUE(expectedIds == getInsertedIds());
+}
+
+TEST_F(CollectionClonerRangesTest, FailsIfOneRangeFails) {
+    // For this test to work properly, the error cannot be one of the special codes
+    // (OperationFailed or CursorNotFound) which trigger an attempt to see if the collection
+    // was dropped.
+    _rangeClients[0]->setFailureForQuery({ErrorCodes::UnknownError, "range query failed"});
+    startCloning();
+    collectionCloner->join();
+
+    ASSERT_EQUALS(ErrorCodes::UnknownError, getStatus().code());
+    ASSERT_FALSE(collectionCloner->isActive());
+    ASSERT_FALSE(collectionStats->commitCalled);
+}
+
+TEST_F(CollectionClonerRangesTest, ShutdownCancelsAllRanges) {
+    // Pause every range right before it queries its documents.
+    MockClientPauser pauser(_client);
+    MockClientPauser rangePauser1(_rangeClients[0]);
+    MockClientPauser rangePauser2(_rangeClients[1]);
+    startCloning();
+    _client->waitForPausedQuery();
+    _rangeClients[0]->waitForPausedQuery();
+    _rangeClients[1]->waitForPausedQuery();
+
+    // Shutting down the cloner shuts down the connections of all ranges.
+    collectionCloner->shutdown();
+    pauser.resume();
+    rangePauser1.resume();
+    rangePauser2.resume();
+    collectionCloner->join();
+
+    ASSERT_EQUALS(ErrorCodes::CallbackCanceled, getStatus().code());
+    ASSERT_FALSE(collectionCloner->isActive());
+    ASSERT_EQUALS(0, collectionStats->insertCount);
+    ASSERT_FALSE(collectionStats->commitCalled);
+}
+
+TEST(CollectionClonerRangeBoundariesTest, SplitsSampledIdsIntoEvenRanges) {
+    std::vector<BSONObj> sampledIds;
+    for (int i = 99; i >= 0; --i) {
+        sampledIds.push_back(BSON("_id" << i));
+    }
+    auto boundaries = CollectionCloner::selectRangeBoundaries(sampledIds, 4U);
+    ASSERT_EQUALS(3U, boundaries.size());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 25), boundaries[0]);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 50), boundaries[1]);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 75), boundaries[2]);
+}
+
+TEST(CollectionClonerRangeBoundariesTest, OrdersMixedTypesAndDropsDuplicates) {
+    std::vector<BSONObj> sampledIds{BSON("_id"
+                                         << "b"),
+                                    BSON("_id" << 3),
+                                    BSON("_id" << 1),
+                                    BSON("_id"
+                                         << "a"),
+                                    BSON("_id" << 2),
+                                    BSON("_id" << 3.0),
+                                    BSON("_id" << 3)};
+
+    auto boundaries = CollectionCloner::selectRangeBoundaries(sampledIds, 2U);
+    ASSERT_EQUALS(1U, boundaries.size());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 3), boundaries[0]);
+
+    // There can be no more ranges than distinct sampled values.
+    boundaries = CollectionCloner::selectRangeBoundaries(sampledIds, 10U);
+    ASSERT_EQUALS(4U, boundaries.size());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 2), boundaries[0]);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 3), boundaries[1]);
+    ASSERT_BSONOBJ_EQ(BSON("_id"
+                           << "a"),
+                      boundaries[2]);
+    ASSERT_BSONOBJ_EQ(BSON("_id"
+                           << "b"),
+                      boundaries[3]);
+}
+
+TEST(CollectionClonerRangeBoundariesTest, ReturnsNoBoundariesForSingleRangeOrEmptySample) {
+    ASSERT_TRUE(CollectionCloner::selectRangeBoundaries({BSON("_id" << 1), BSON("_id" << 2)}, 1U)
+                    .empty());
+    ASSERT_TRUE(CollectionCloner::selectRangeBoundaries({}, 4U).empty());
+}
+
 }  // namespace
@@ -0,0 +1,370 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kReplication
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_buffer_batch_queue.h"
+
+#include <boost/filesystem/operations.hpp>
+
+#include "mongo/bson/oid.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/destructor_guard.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace repl {
+
+namespace {
+
+std::size_t getDocumentSize(const char* data) {
+    // SERVER-9808 Avoid Fortify complaint about implicit signed->unsigned conversion
+    return static_cast<std::size_t>(ConstDataView(data).read<LittleEndian<int32_t>>());
+}
+
+}  // namespace
+
+OplogBufferBatchQueue::OplogBufferBatchQueue() : OplogBufferBatchQueue(nullptr, {}) {}
+
+OplogBufferBatchQueue::OplogBufferBatchQueue(Counters* counters, Options options)
+    : _counters(counters), _options(std::move(options)) {
+    invariant(_options.maxSpillBytes == 0 || !_options.spillDirectory.empty());
+}
+
+OplogBufferBatchQueue::~OplogBufferBatchQueue() {
+    if (!_spillFileName.empty()) {
+        _spillFile.close();
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_spillFileName));
+    }
+}
+
+void OplogBufferBatchQueue::startup(OperationContext*) {
+    // Update server status metric to reflect the current oplog buffer's max size.
+    if (_counters) {
+        _counters->setMaxSize(getMaxSize());
+    }
+}
+
+void OplogBufferBatchQueue::shutdown(OperationContext* opCtx) {
+    clear(opCtx);
+}
+
+void OplogBufferBatchQueue::pushEvenIfFull(OperationContext*, const Value& value) {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _pushAll_inlock(&value, &value + 1);
+    }
+    if (_counters) {
+        _counters->increment(value);
+    }
+}
+
+void OplogBufferBatchQueue::push(OperationContext*, const Value& value) {
+    {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _waitForSpace_inlock(value.objsize(), lk);
+        _pushAll_inlock(&value, &value + 1);
+    }
+    if (_counters) {
+        _counters->increment(value);
+    }
+}
+
+void OplogBufferBatchQueue::pushAllNonBlocking(OperationContext*,
+                                               Batch::const_iterator begin,
+                                               Batch::const_iterator end) {
+    if (begin == end) {
+        return;
+    }
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _pushAll_inlock(begin, end);
+    }
+    if (_counters) {
+        for (auto i = begin; i != end; ++i) {
+            _counters->increment(*i);
+        }
+    }
+}
+
+template <typename Iterator>
+void OplogBufferBatchQueue::_pushAll_inlock(Iterator begin, Iterator end) {
+    auto it = begin;
+    while (it != end) {
+        Segment segment;
+        if (!it->isOwned()) {
+            auto owned = it->getOwned();
+            segment.owner = owned.sharedBuffer();
+            segment.entries.push_back(owned.objdata());
+            segment.size = owned.objsize();
+            ++it;
+        } else {
+            // Consecutive entries from the same reply share its buffer.
+            segment.owner = it->sharedBuffer();
+            for (; it != end && it->sharedBuffer().get() == segment.owner.get(); ++it) {
+                segment.entries.push_back(it->objdata());
+                segment.size += it->objsize();
+            }
+        }
+        _pushSegment_inlock(std::move(segment));
+    }
+}
+
+void OplogBufferBatchQueue::_pushSegment_inlock(Segment segment) {
+    const bool startedEmpty = _count == 0;
+
+    _lastObjectPushed = BSONObj(segment.entries.back()).shareOwnershipWith(segment.owner);
+    _count += segment.entries.size();
+    _size += segment.size;
+
+    const bool shouldSpill = _options.maxSpillBytes > 0 && !_spillFailed &&
+        _memorySize + segment.size > _options.maxMemoryBytes;
+    if (shouldSpill && _spill_inlock(&segment)) {
+        // Spilling dropped the segment's reference to its buffer. Keep a private copy of the last
+        // entry so that the buffer is not kept alive for as long as that entry is the last one.
+        _lastObjectPushed = _lastObjectPushed.copy();
+        _spilledSize += segment.size;
+    } else {
+        _memorySize += segment.size;
+    }
+    _segments.push_back(std::move(segment));
+
+    if (startedEmpty) {
+        _cvNoLongerEmpty.notify_one();
+    }
+}
+
+bool OplogBufferBatchQueue::_spill_inlock(Segment* segment) {
+    // Spilling only happens while the applier is far behind the fetcher, so doing the file I/O
+    // under the mutex delays the applier by at most one fetcher batch.
+    if (!_spillFile.is_open()) {
+        try {
+            boost::filesystem::create_directories(_options.spillDirectory);
+        } catch (const boost::filesystem::filesystem_error& ex) {
+            warning() << "Unable to create directory for oplog buffer spill file: " << ex.what();
+            _spillFailed = true;
+            return false;
+        }
+        _spillFileName = _options.spillDirectory + "/oplogBuffer." + OID::gen().toString();
+        _spillFile.open(_spillFileName.c_str(),
+                        std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+        if (!_spillFile.good()) {
+            warning() << "Unable to open oplog buffer spill file \"" << _spillFileName
+                      << "\": " << errnoWithDescription();
+            _spillFailed = true;
+            return false;
+        }
+    }
+
+    _spillFile.seekp(_spillWriteOffset);
+    for (auto entry : segment->entries) {
+        _spillFile.write(entry, getDocumentSize(entry));
+    }
+    _spillFile.flush();
+    if (!_spillFile.good()) {
+        warning() << "Unable to write to oplog buffer spill file \"" << _spillFileName
+                  << "\", keeping the remaining oplog entries in memory: "
+                  << errnoWithDescription();
+        _spillFailed = true;
+        return false;
+    }
+
+    segment->spilled = true;
+    segment->spillOffset = _spillWriteOffset;
+    segment->spilledCount = segment->entries.size();
+    segment->entries = {};
+    segment->owner = {};
+    _spillWriteOffset += segment->size;
+    return true;
+}
+
+void OplogBufferBatchQueue::_loadFront_inlock() {
+    auto& segment = _segments.front();
+    if (!segment.spilled) {
+        return;
+    }
+
+    auto buffer = SharedBuffer::allocate(segment.size);
+    _spillFile.seekg(segment.spillOffset);
+    _spillFile.read(buffer.get(), segment.size);
+    if (!_spillFile.good()) {
+        fassertFailedWithStatus(51264,
+                                Status(ErrorCodes::FileStreamFailed,
+                                       str::stream() << "Unable to read from oplog buffer spill "
+                                                        "file \""
+                                                     << _spillFileName
+                                                     << "\": "
+                                                     << errnoWithDescription()));
+    }
+
+    segment.entries.reserve(segment.spilledCount);
+    for (const char* entry = buffer.get(); segment.entries.size() < segment.spilledCount;
+         entry += getDocumentSize(entry)) {
+        segment.entries.push_back(entry);
+    }
+    segment.owner = std::move(buffer);
+    segment.spilled = false;
+
+    _spilledSize -= segment.size;
+    _memorySize += segment.size;
+    if (_spilledSize == 0) {
+        _spillWriteOffset = 0;
+    }
+}
+
+OplogBuffer::Value OplogBufferBatchQueue::_front_inlock() const {
+    const auto& segment = _segments.front();
+    invariant(!segment.spilled);
+    return BSONObj(segment.entries[segment.next]).shareOwnershipWith(segment.owner);
+}
+
+void OplogBufferBatchQueue::waitForSpace(OperationContext*, std::size_t size) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    _waitForSpace_inlock(size, lk);
+}
+
+void OplogBufferBatchQueue::_waitForSpace_inlock(std::size_t size,
+                                                 stdx::unique_lock<stdx::mutex>& lk) {
+    _cvNoLongerFull.wait(lk, [&] { return _size + size <= _getMaxSize_inlock(); });
+}
+
+std::size_t OplogBufferBatchQueue::_getMaxSize_inlock() const {
+    return _options.maxMemoryBytes + (_spillFailed ? 0 : _options.maxSpillBytes);
+}
+
+bool OplogBufferBatchQueue::isEmpty() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _count == 0;
+}
+
+std::size_t OplogBufferBatchQueue::getMaxSize() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _getMaxSize_inlock();
+}
+
+std::size_t OplogBufferBatchQueue::getSize() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _size;
+}
+
+std::size_t OplogBufferBatchQueue::getCount() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _count;
+}
+
+std::size_t OplogBufferBatchQueue::getSegmentCount() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _segments.size();
+}
+
+std::size_t OplogBufferBatchQueue::getSpilledSize() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _spilledSize;
+}
+
+void OplogBufferBatchQueue::clear(OperationContext*) {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _segments.clear();
+        _size = 0;
+        _memorySize = 0;
+        _spilledSize = 0;
+        _count = 0;
+        _lastObjectPushed = {};
+        _spillWriteOffset = 0;
+        _cvNoLongerFull.notify_one();
+    }
+    if (_counters) {
+        _counters->clear();
+    }
+}
+
+bool OplogBufferBatchQueue::tryPop(OperationContext*, Value* value) {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_count == 0) {
+            return false;
+        }
+
+        _loadFront_inlock();
+        *value = _front_inlock();
+
+        auto& segment = _segments.front();
+        const std::size_t size = value->objsize();
+        segment.size -= size;
+        _memorySize -= size;
+        _size -= size;
+        --_count;
+        if (++segment.next == segment.entries.size()) {
+            _segments.pop_front();
+        }
+        if (_count == 0) {
+            _lastObjectPushed = {};
+        }
+        _cvNoLongerFull.notify_one();
+    }
+    if (_counters) {
+        _counters->decrement(*value);
+    }
+    return true;
+}
+
+bool OplogBufferBatchQueue::waitForData(Seconds waitDuration) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    return _cvNoLongerEmpty.wait_for(
+        lk, waitDuration.toSystemDuration(), [&] { return _count > 0; });
+}
+
+bool OplogBufferBatchQueue::peek(OperationContext*, Value* value) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (_count == 0) {
+        return false;
+    }
+
+    _loadFront_inlock();
+    *value = _front_inlock();
+    return true;
+}
+
+boost::optional<OplogBuffer::Value> OplogBufferBatchQueue::lastObjectPushed(
+    OperationContext*) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (_count == 0) {
+        return {};
+    }
+    return _lastObjectPushed;
+}
+
+}  // namespace repl
+}  // namespace mongo
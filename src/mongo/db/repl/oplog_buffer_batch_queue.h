@@ -0,0 +1,168 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "mongo/db/repl/oplog_buffer.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/shared_buffer.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * In memory oplog buffer which keeps the entries pushed together in a single call as one segment.
+ *
+ * The oplog fetcher pushes the documents of a getMore reply, which all share ownership of the
+ * reply's buffer. Instead of holding a reference to that buffer from every entry, a segment holds
+ * one reference and unowned pointers to its entries, and releases the buffer once every entry has
+ * been popped. Entries that do not share a buffer with their neighbours get a segment of their own.
+ *
+ * The buffer is accounted in bytes of oplog entries. When configured with a spill budget, segments
+ * pushed while the in-memory budget is exhausted are written to a file instead, and read back when
+ * they reach the front of the buffer. This allows a lagging secondary to keep fetching without
+ * holding more than the in-memory budget.
+ *
+ * Like OplogBufferBlockingQueue, this buffer supports a single producer and a single consumer.
+ */
+class OplogBufferBatchQueue final : public OplogBuffer {
+public:
+    struct Options {
+        // Number of bytes of oplog entries to hold in memory.
+        std::size_t maxMemoryBytes = 256 * 1024 * 1024;
+
+        // Number of bytes of oplog entries that may be written to the spill file once the
+        // in-memory budget is exhausted. If 0, the buffer never spills.
+        std::size_t maxSpillBytes = 0;
+
+        // Directory in which to create the spill file. Must be set if 'maxSpillBytes' is not 0.
+        std::string spillDirectory;
+    };
+
+    OplogBufferBatchQueue();
+    OplogBufferBatchQueue(Counters* counters, Options options);
+    ~OplogBufferBatchQueue();
+
+    void startup(OperationContext* opCtx) override;
+    void shutdown(OperationContext* opCtx) override;
+    void pushEvenIfFull(OperationContext* opCtx, const Value& value) override;
+    void push(OperationContext* opCtx, const Value& value) override;
+    void pushAllNonBlocking(OperationContext* opCtx,
+                            Batch::const_iterator begin,
+                            Batch::const_iterator end) override;
+    void waitForSpace(OperationContext* opCtx, std::size_t size) override;
+    bool isEmpty() const override;
+    std::size_t getMaxSize() const override;
+    std::size_t getSize() const override;
+    std::size_t getCount() const override;
+    void clear(OperationContext* opCtx) override;
+    bool tryPop(OperationContext* opCtx, Value* value) override;
+    bool waitForData(Seconds waitDuration) override;
+    bool peek(OperationContext* opCtx, Value* value) override;
+    boost::optional<Value> lastObjectPushed(OperationContext* opCtx) const override;
+
+    /**
+     * Returns the number of segments in the buffer.
+     */
+    std::size_t getSegmentCount() const;
+
+    /**
+     * Returns the number of bytes of oplog entries currently held in the spill file.
+     */
+    std::size_t getSpilledSize() const;
+
+private:
+    struct Segment {
+        // Keeps the memory that 'entries' point into alive. Null while the segment is spilled.
+        ConstSharedBuffer owner;
+
+        // Unowned pointers to the entries of the segment, of which those before 'next' have been
+        // popped. Empty while the segment is spilled.
+        std::vector<const char*> entries;
+        std::size_t next = 0;
+
+        // Size in bytes of the entries which have not been popped yet.
+        std::size_t size = 0;
+
+        // Location of the entries in the spill file while the segment is spilled.
+        bool spilled = false;
+        std::streamoff spillOffset = 0;
+        std::size_t spilledCount = 0;
+    };
+
+    template <typename Iterator>
+    void _pushAll_inlock(Iterator begin, Iterator end);
+    void _pushSegment_inlock(Segment segment);
+
+    void _waitForSpace_inlock(std::size_t size, stdx::unique_lock<stdx::mutex>& lk);
+    std::size_t _getMaxSize_inlock() const;
+
+    /**
+     * Writes the entries of 'segment' to the spill file. Returns false, leaving 'segment' in
+     * memory, if the file cannot be written, in which case the buffer stops spilling.
+     */
+    bool _spill_inlock(Segment* segment);
+
+    /**
+     * Reads the front segment back into memory if it is spilled.
+     */
+    void _loadFront_inlock();
+
+    Value _front_inlock() const;
+
+    Counters* const _counters;
+    const Options _options;
+
+    mutable stdx::mutex _mutex;
+    stdx::condition_variable _cvNoLongerFull;
+    stdx::condition_variable _cvNoLongerEmpty;
+
+    std::deque<Segment> _segments;
+    std::size_t _size = 0;
+    std::size_t _memorySize = 0;
+    std::size_t _spilledSize = 0;
+    std::size_t _count = 0;
+    Value _lastObjectPushed;
+
+    // The spill file is created on first use and removed on destruction. It is written from
+    // the start again whenever no spilled segments remain.
+    std::string _spillFileName;
+    std::fstream _spillFile;
+    std::streamoff _spillWriteOffset = 0;
+    bool _spillFailed = false;
+};
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,184 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/repl/oplog_buffer_batch_queue.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+using namespace mongo;
+using namespace mongo::repl;
+
+/**
+ * Returns the documents of a reply to a find or getMore on the oplog, sharing ownership of the
+ * reply's buffer the way the Fetcher returns them.
+ */
+OplogBuffer::Batch makeReplyBatch(int firstTs, int count) {
+    BSONArrayBuilder batchBuilder;
+    for (int i = firstTs; i < firstTs + count; i++) {
+        batchBuilder.append(BSON("ts" << Timestamp(i, 1) << "op"
+                                      << "n"
+                                      << "o"
+                                      << BSONObj()));
+    }
+    auto reply = BSON("cursor" << BSON("nextBatch" << batchBuilder.arr()));
+
+    OplogBuffer::Batch batch;
+    for (auto&& element : reply["cursor"]["nextBatch"].Obj()) {
+        batch.push_back(element.Obj());
+    }
+    for (auto& doc : batch) {
+        doc.shareOwnershipWith(reply.sharedBuffer());
+    }
+    return batch;
+}
+
+std::size_t sizeOf(const OplogBuffer::Batch& batch) {
+    std::size_t size = 0;
+    for (auto&& doc : batch) {
+        size += doc.objsize();
+    }
+    return size;
+}
+
+void assertPopsBatch(OplogBufferBatchQueue* buffer, const OplogBuffer::Batch& batch) {
+    for (auto&& expected : batch) {
+        OplogBuffer::Value value;
+        ASSERT_TRUE(buffer->tryPop(nullptr, &value));
+        ASSERT_TRUE(value.isOwned());
+        ASSERT_BSONOBJ_EQ(expected, value);
+    }
+}
+
+TEST(OplogBufferBatchQueueTest, EntriesOfOneReplyShareOneSegment) {
+    OplogBufferBatchQueue buffer;
+    auto batch = makeReplyBatch(1, 3);
+    buffer.pushAllNonBlocking(nullptr, batch.cbegin(), batch.cend());
+
+    ASSERT_FALSE(buffer.isEmpty());
+    ASSERT_EQUALS(3U, buffer.getCount());
+    ASSERT_EQUALS(1U, buffer.getSegmentCount());
+    ASSERT_EQUALS(sizeOf(batch), buffer.getSize());
+    ASSERT_BSONOBJ_EQ(batch.back(), *buffer.lastObjectPushed(nullptr));
+
+    OplogBuffer::Value value;
+    ASSERT_TRUE(buffer.peek(nullptr, &value));
+    ASSERT_BSONOBJ_EQ(batch.front(), value);
+
+    // The reply's buffer remains alive for as long as an entry popped from it does.
+    OplogBuffer::Value first;
+    ASSERT_TRUE(buffer.tryPop(nullptr, &first));
+    batch.erase(batch.begin());
+    assertPopsBatch(&buffer, batch);
+    ASSERT_EQUALS(Timestamp(1, 1), first["ts"].timestamp());
+
+    ASSERT_TRUE(buffer.isEmpty());
+    ASSERT_EQUALS(0U, buffer.getSegmentCount());
+    ASSERT_EQUALS(0U, buffer.getSize());
+    ASSERT_FALSE(buffer.lastObjectPushed(nullptr));
+    ASSERT_FALSE(buffer.tryPop(nullptr, &value));
+}
+
+TEST(OplogBufferBatchQueueTest, EntriesNotSharingABufferGetSegmentsOfTheirOwn) {
+    OplogBufferBatchQueue buffer;
+    OplogBuffer::Batch batch{BSON("ts" << Timestamp(1, 1)), BSON("ts" << Timestamp(2, 1))};
+    buffer.pushAllNonBlocking(nullptr, batch.cbegin(), batch.cend());
+    buffer.push(nullptr, BSON("ts" << Timestamp(3, 1)));
+    batch.push_back(BSON("ts" << Timestamp(3, 1)));
+
+    ASSERT_EQUALS(3U, buffer.getCount());
+    ASSERT_EQUALS(3U, buffer.getSegmentCount());
+    assertPopsBatch(&buffer, batch);
+    ASSERT_TRUE(buffer.isEmpty());
+}
+
+TEST(OplogBufferBatchQueueTest, ClearDiscardsAllSegments) {
+    OplogBufferBatchQueue buffer;
+    auto batch = makeReplyBatch(1, 3);
+    buffer.pushAllNonBlocking(nullptr, batch.cbegin(), batch.cend());
+    buffer.clear(nullptr);
+
+    ASSERT_TRUE(buffer.isEmpty());
+    ASSERT_EQUALS(0U, buffer.getSize());
+    ASSERT_EQUALS(0U, buffer.getSegmentCount());
+    ASSERT_FALSE(buffer.waitForData(Seconds(0)));
+}
+
+TEST(OplogBufferBatchQueueTest, SpillsRepliesPushedOnceTheMemoryBudgetIsExhausted) {
+    unittest::TempDir tempDir("oplog_buffer_batch_queue_test");
+    auto batch1 = makeReplyBatch(1, 10);
+    auto batch2 = makeReplyBatch(11, 10);
+    auto batch3 = makeReplyBatch(21, 10);
+
+    OplogBufferBatchQueue::Options options;
+    options.maxMemoryBytes = sizeOf(batch1);
+    options.maxSpillBytes = 1024 * 1024;
+    options.spillDirectory = tempDir.path();
+    OplogBufferBatchQueue buffer(nullptr, options);
+    ASSERT_EQUALS(options.maxMemoryBytes + options.maxSpillBytes, buffer.getMaxSize());
+
+    buffer.pushAllNonBlocking(nullptr, batch1.cbegin(), batch1.cend());
+    ASSERT_EQUALS(0U, buffer.getSpilledSize());
+    buffer.pushAllNonBlocking(nullptr, batch2.cbegin(), batch2.cend());
+    buffer.pushAllNonBlocking(nullptr, batch3.cbegin(), batch3.cend());
+    ASSERT_EQUALS(sizeOf(batch2) + sizeOf(batch3), buffer.getSpilledSize());
+    ASSERT_EQUALS(30U, buffer.getCount());
+    ASSERT_BSONOBJ_EQ(batch3.back(), *buffer.lastObjectPushed(nullptr));
+
+    // Spilled replies are read back in order as they reach the front of the buffer.
+    assertPopsBatch(&buffer, batch1);
+    assertPopsBatch(&buffer, batch2);
+    ASSERT_EQUALS(sizeOf(batch3), buffer.getSpilledSize());
+
+    // Once the memory budget is available again, new replies are kept in memory.
+    auto batch4 = makeReplyBatch(31, 10);
+    buffer.pushAllNonBlocking(nullptr, batch4.cbegin(), batch4.cend());
+    ASSERT_EQUALS(sizeOf(batch3), buffer.getSpilledSize());
+
+    assertPopsBatch(&buffer, batch3);
+    ASSERT_EQUALS(0U, buffer.getSpilledSize());
+    assertPopsBatch(&buffer, batch4);
+    ASSERT_TRUE(buffer.isEmpty());
+
+    // The spill file is reused from its start once drained.
+    buffer.pushAllNonBlocking(nullptr, batch1.cbegin(), batch1.cend());
+    buffer.pushAllNonBlocking(nullptr, batch2.cbegin(), batch2.cend());
+    ASSERT_EQUALS(sizeOf(batch2), buffer.getSpilledSize());
+    assertPopsBatch(&buffer, batch1);
+    assertPopsBatch(&buffer, batch2);
+    ASSERT_TRUE(buffer.isEmpty());
+}
+
+}  // namespace
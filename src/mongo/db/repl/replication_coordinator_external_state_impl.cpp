@@ -67,7 +67,7 @@
 #include "mongo/db/repl/noop_writer.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplog_applier_impl.h"
-#include "mongo/db/repl/oplog_buffer_blocking_queue.h"
+#include "mongo/db/repl/oplog_buffer_batch_queue.h"
 #include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/repl_settings.h"
 #include "mongo/db/repl/replication_coordinator.h"
@@ -84,6 +84,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/db/session_catalog_mongod.h"
 #include "mongo/db/storage/storage_engine.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/db/system_index.h"
 #include "mongo/executor/network_connection_hook.h"
 #include "mongo/executor/network_interface.h"
@@ -214,9 +215,12 @@ void ReplicationCoordinatorExternalStateImpl::startSteadyStateReplication(
         return;
 
     invariant(replCoord);
-    _oplogBuffer = std::make_unique<OplogBufferBlockingQueue>(&bufferGauge);
+    OplogBufferBatchQueue::Options bufferOptions;
+    bufferOptions.maxSpillBytes = static_cast<std::size_t>(replOplogBufferMaxSpillBytes);
+    bufferOptions.spillDirectory = storageGlobalParams.dbpath + "/_tmp";
+    _oplogBuffer = std::make_unique<OplogBufferBatchQueue>(&bufferGauge, bufferOptions);
 
-    // No need to log OplogBuffer::startup because the blocking queue implementation
+    // No need to log OplogBuffer::startup because the batch queue implementation
     // does not start any threads or access the storage layer.
     _oplogBuffer->startup(opCtx);
 
@@ -67,6 +67,7 @@
 #include "mongo/db/repl/multiapplier.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/db/repl/repl_client_info.h"
+#include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/repl_set_config.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/repl/transaction_oplog_application.h"
@@ -75,6 +76,7 @@
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/transaction_participant.h"
 #include "mongo/db/transaction_participant_gen.h"
+#include "mongo/stdx/unordered_map.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
@@ -566,6 +568,74 @@ void tryToGoLiveAsASecondary(OperationContext* opCtx,
 
 }  // namespace
 
+/**
+ * Chooses the writer vector for each operation of a batch, given the hash of its conflict key: its
+ * namespace, plus its _id where the documents of the namespace may be written in any order.
+ * Operations with the same key must be applied in order by a single writer.
+ *
+ * When balancing, each key seen for the first time in the batch is assigned to the writer with the
+ * fewest operations so far, instead of to the writer selected by the hash modulo the number of
+ * writers. Otherwise a few hot keys of one collection that happen to collide modulo the number of
+ * writers leave a single writer with a large share of the batch while the others idle at the batch
+ * boundary. Unique secondary index keys need no edges between the operations of a batch, since
+ * secondaries relax unique index constraints while applying them.
+ */
+class SyncTail::WriterAssignment {
+public:
+    WriterAssignment(std::vector<MultiApplier::OperationPtrs>* writerVectors, bool balance)
+        : _writerVectors(writerVectors), _balance(balance) {}
+
+    MultiApplier::OperationPtrs& writerFor(uint32_t conflictKeyHash) {
+        const uint32_t numWriters = _writerVectors->size();
+        if (!_balance) {
+            return (*_writerVectors)[conflictKeyHash % numWriters];
+        }
+
+        auto it = _writerByKey.find(conflictKeyHash);
+        if (it == _writerByKey.end()) {
+            uint32_t leastLoaded = 0;
+            for (uint32_t i = 1; i < numWriters; ++i) {
+                if ((*_writerVectors)[i].size() < (*_writerVectors)[leastLoaded].size()) {
+                    leastLoaded = i;
+                }
+            }
+            it = _writerByKey.emplace(conflictKeyHash, leastLoaded).first;
+        }
+        return (*_writerVectors)[it->second];
+    }
+
+private:
+    std::vector<MultiApplier::OperationPtrs>* const _writerVectors;
+    const bool _balance;
+
+    // Hashes that collide are treated as one key, which is conservative.
+    stdx::unordered_map<uint32_t, uint32_t> _writerByKey;
+};
+
+/**
+ * A batch of operations to apply, together with the state that preparing it produces. Once
+ * prepared, its oplog entries have been scheduled to be written and its operations have been
+ * partitioned into 'writerVectors', which point into 'ops' and 'derivedOps'.
+ */
+struct SyncTail::ApplierBatch {
+    explicit ApplierBatch(MultiApplier::Operations batchOps) : ops(std::move(batchOps)) {}
+
+    MultiApplier::Operations ops;
+
+    // Holds 'pseudo operations' generated by secondaries to aid in replication.
+    // Keep in scope until all operations in 'ops' and 'derivedOps' have been applied.
+    // Pseudo operations include:
+    // - applyOps operations expanded to individual ops.
+    // - ops to update config.transactions. Normal writes to config.transactions in the
+    //   primary don't create an oplog entry, so extract info from writes with transactions
+    //   and create a pseudo oplog.
+    std::vector<MultiApplier::Operations> derivedOps;
+
+    std::vector<MultiApplier::OperationPtrs> writerVectors;
+
+    bool prepared = false;
+};
+
 class SyncTail::OpQueueBatcher {
     OpQueueBatcher(const OpQueueBatcher&) = delete;
     OpQueueBatcher& operator=(const OpQueueBatcher&) = delete;
@@ -601,6 +671,23 @@ public:
         return ops;
     }
 
+    /**
+     * Returns the next batch without waiting if one is ready. Returns an empty batch otherwise,
+     * leaving a request to shut down for getNextBatch() to return.
+     */
+    OpQueue tryGetNextBatch() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_ops.empty()) {
+            return OpQueue(0);
+        }
+
+        OpQueue ops = std::move(_ops);
+        _ops = OpQueue(0);
+        _cv.notify_all();
+
+        return ops;
+    }
+
 private:
     /**
      * If slaveDelay is enabled, this function calculates the most recent timestamp of any oplog
@@ -716,6 +803,9 @@ void SyncTail::_oplogApplication(ReplicationCoordinator* replCoord,
     // Get replication consistency markers.
     OpTime minValid;
 
+    // A batch taken from 'batcher' while the previous batch was being applied.
+    std::unique_ptr<ApplierBatch> nextBatch;
+
     while (true) {  // Exits on message from OpQueueBatcher.
         // Use a new operation context each iteration, as otherwise we may appear to use a single
         // collection name to refer to collections with different UUIDs.
@@ -748,26 +838,30 @@ void SyncTail::_oplogApplication(ReplicationCoordinator* replCoord,
         // Transition to SECONDARY state, if possible.
         tryToGoLiveAsASecondary(&opCtx, replCoord, minValid);
 
-        long long termWhenBufferIsEmpty = replCoord->getTerm();
-        // Blocks up to a second waiting for a batch to be ready to apply. If one doesn't become
-        // ready in time, we'll loop again so we can do the above checks periodically.
-        OpQueue ops = batcher->getNextBatch(Seconds(1));
-        if (ops.empty()) {
-            if (ops.mustShutdown()) {
-                // Shut down and exit oplog application loop.
-                return;
-            }
-            if (MONGO_FAIL_POINT(rsSyncApplyStop)) {
-                continue;
+        std::unique_ptr<ApplierBatch> batch = std::move(nextBatch);
+        if (!batch) {
+            long long termWhenBufferIsEmpty = replCoord->getTerm();
+            // Blocks up to a second waiting for a batch to be ready to apply. If one doesn't
+            // become ready in time, we'll loop again so we can do the above checks periodically.
+            OpQueue ops = batcher->getNextBatch(Seconds(1));
+            if (ops.empty()) {
+                if (ops.mustShutdown()) {
+                    // Shut down and exit oplog application loop.
+                    return;
+                }
+                if (MONGO_FAIL_POINT(rsSyncApplyStop)) {
+                    continue;
+                }
+                // Signal drain complete if we're in Draining state and the buffer is empty.
+                replCoord->signalDrainComplete(&opCtx, termWhenBufferIsEmpty);
+                continue;  // Try again.
             }
-            // Signal drain complete if we're in Draining state and the buffer is empty.
-            replCoord->signalDrainComplete(&opCtx, termWhenBufferIsEmpty);
-            continue;  // Try again.
+            batch = std::make_unique<ApplierBatch>(ops.releaseBatch());
         }
 
-        // Extract some info from ops that we'll need after releasing the batch below.
-        const auto firstOpTimeInBatch = ops.front().getOpTime();
-        const auto lastOpInBatch = ops.back();
+        // Extract some info from ops that we'll need after applying the batch below.
+        const auto firstOpTimeInBatch = batch->ops.front().getOpTime();
+        const auto lastOpInBatch = batch->ops.back();
         const auto lastOpTimeInBatch = lastOpInBatch.getOpTime();
         const auto lastWallTimeInBatch = lastOpInBatch.getWallClockTime();
         const auto lastAppliedOpTimeAtStartOfBatch = replCoord->getMyLastAppliedOpTime();
@@ -786,10 +880,15 @@ void SyncTail::_oplogApplication(ReplicationCoordinator* replCoord,
         // Don't allow the fsync+lock thread to see intermediate states of batch application.
         stdx::lock_guard<SimpleMutex> fsynclk(filesLockedFsync);
 
-        // Apply the operations in this batch. 'multiApply' returns the optime of the last op that
-        // was applied, which should be the last optime in the batch.
-        auto lastOpTimeAppliedInBatch =
-            fassertNoTrace(34437, multiApply(&opCtx, ops.releaseBatch()));
+        // Apply the operations in this batch. '_multiApply' returns the optime of the last op that
+        // was applied, which should be the last optime in the batch. If pipelining is enabled, it
+        // may also hand us the next batch, prepared while this one was applied.
+        auto lastOpTimeAppliedInBatch = fassertNoTrace(
+            34437,
+            _multiApply(&opCtx,
+                        batch.get(),
+                        replPipelineBatchApplication.load() ? batcher : nullptr,
+                        &nextBatch));
         invariant(lastOpTimeAppliedInBatch == lastOpTimeInBatch);
 
         // In order to provide resilience in the event of a crash in the middle of batch
@@ -1110,12 +1209,12 @@ void SyncTail::_fillWriterVectors(OperationContext* opCtx,
                                   MultiApplier::Operations* ops,
                                   std::vector<MultiApplier::OperationPtrs>* writerVectors,
                                   std::vector<MultiApplier::Operations>* derivedOps,
-                                  SessionUpdateTracker* sessionUpdateTracker) {
+                                  SessionUpdateTracker* sessionUpdateTracker,
+                                  WriterAssignment* writerAssignment) {
     const auto serviceContext = opCtx->getServiceContext();
     const auto storageEngine = serviceContext->getStorageEngine();
 
     const bool supportsDocLocking = storageEngine->supportsDocLocking();
-    const uint32_t numWriters = writerVectors->size();
 
     CachedCollectionProperties collPropertiesCache;
     LogicalSessionIdMap<std::vector<OplogEntry*>> partialTxnOps;
@@ -1138,7 +1237,12 @@ void SyncTail::_fillWriterVectors(OperationContext* opCtx,
         if (sessionUpdateTracker) {
             if (auto newOplogWrites = sessionUpdateTracker->updateSession(op)) {
                 derivedOps->emplace_back(std::move(*newOplogWrites));
-                _fillWriterVectors(opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+                _fillWriterVectors(opCtx,
+                                   &derivedOps->back(),
+                                   writerVectors,
+                                   derivedOps,
+                                   nullptr,
+                                   writerAssignment);
             }
         }
 
@@ -1205,16 +1309,24 @@ void SyncTail::_fillWriterVectors(OperationContext* opCtx,
                         partialTxnList.clear();
                     }
                     // Transaction entries cannot have different session updates.
-                    _fillWriterVectors(
-                        opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+                    _fillWriterVectors(opCtx,
+                                       &derivedOps->back(),
+                                       writerVectors,
+                                       derivedOps,
+                                       nullptr,
+                                       writerAssignment);
                 } else {
                     // The applyOps entry was not generated as part of a transaction.
                     invariant(!op.getPrevWriteOpTimeInTransaction());
                     derivedOps->emplace_back(ApplyOps::extractOperations(op));
 
                     // Nested entries cannot have different session updates.
-                    _fillWriterVectors(
-                        opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+                    _fillWriterVectors(opCtx,
+                                       &derivedOps->back(),
+                                       writerVectors,
+                                       derivedOps,
+                                       nullptr,
+                                       writerAssignment);
                 }
             } catch (...) {
                 fassertFailedWithStatusNoTrace(
@@ -1248,11 +1360,12 @@ void SyncTail::_fillWriterVectors(OperationContext* opCtx,
                 partialTxnList.clear();
             }
 
-            _fillWriterVectors(opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+            _fillWriterVectors(
+                opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr, writerAssignment);
             continue;
         }
 
-        auto& writer = (*writerVectors)[hash % numWriters];
+        auto& writer = writerAssignment->writerFor(hash);
         if (writer.empty()) {
             writer.reserve(8);  // Skip a few growth rounds
         }
@@ -1265,12 +1378,15 @@ void SyncTail::fillWriterVectors(OperationContext* opCtx,
                                  std::vector<MultiApplier::OperationPtrs>* writerVectors,
                                  std::vector<MultiApplier::Operations>* derivedOps) {
     SessionUpdateTracker sessionUpdateTracker;
-    _fillWriterVectors(opCtx, ops, writerVectors, derivedOps, &sessionUpdateTracker);
+    WriterAssignment writerAssignment(writerVectors, replBalanceWriterVectors.load());
+    _fillWriterVectors(
+        opCtx, ops, writerVectors, derivedOps, &sessionUpdateTracker, &writerAssignment);
 
     auto newOplogWrites = sessionUpdateTracker.flushAll();
     if (!newOplogWrites.empty()) {
         derivedOps->emplace_back(std::move(newOplogWrites));
-        _fillWriterVectors(opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+        _fillWriterVectors(
+            opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr, &writerAssignment);
     }
 }
 
@@ -1303,6 +1419,29 @@ void SyncTail::_applyOps(std::vector<MultiApplier::OperationPtrs>& writerVectors
 }
 
 StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::Operations ops) {
+    ApplierBatch batch(std::move(ops));
+    return _multiApply(opCtx, &batch, nullptr, nullptr);
+}
+
+void SyncTail::_prepareBatch(OperationContext* opCtx, ApplierBatch* batch) {
+    invariant(!batch->prepared);
+
+    // Write batch of ops into oplog.
+    if (!_options.skipWritesToOplog) {
+        _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, batch->ops.front().getTimestamp());
+        scheduleWritesToOplog(opCtx, _storageInterface, _writerPool, batch->ops);
+    }
+
+    batch->writerVectors.resize(_writerPool->getStats().numThreads);
+    fillWriterVectors(opCtx, &batch->ops, &batch->writerVectors, &batch->derivedOps);
+    batch->prepared = true;
+}
+
+StatusWith<OpTime> SyncTail::_multiApply(OperationContext* opCtx,
+                                         ApplierBatch* batch,
+                                         OpQueueBatcher* batcher,
+                                         std::unique_ptr<ApplierBatch>* nextBatch) {
+    const auto& ops = batch->ops;
     invariant(!ops.empty());
 
     LOG(2) << "replication batch size is " << ops.size();
@@ -1330,26 +1469,12 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
         // because the spawned threads refer to objects on the stack
         ON_BLOCK_EXIT([&] { _writerPool->waitForIdle(); });
 
-        // Write batch of ops into oplog.
-        if (!_options.skipWritesToOplog) {
-            _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, ops.front().getTimestamp());
-            scheduleWritesToOplog(opCtx, _storageInterface, _writerPool, ops);
-        }
-
-        // Holds 'pseudo operations' generated by secondaries to aid in replication.
-        // Keep in scope until all operations in 'ops' and 'derivedOps' have been applied.
-        // Pseudo operations include:
-        // - applyOps operations expanded to individual ops.
-        // - ops to update config.transactions. Normal writes to config.transactions in the
-        //   primary don't create an oplog entry, so extract info from writes with transactions
-        //   and create a pseudo oplog.
-        std::vector<MultiApplier::Operations> derivedOps;
+        if (!batch->prepared) {
+            _prepareBatch(opCtx, batch);
 
-        std::vector<MultiApplier::OperationPtrs> writerVectors(_writerPool->getStats().numThreads);
-        fillWriterVectors(opCtx, &ops, &writerVectors, &derivedOps);
-
-        // Wait for writes to finish before applying ops.
-        _writerPool->waitForIdle();
+            // Wait for writes to finish before applying ops.
+            _writerPool->waitForIdle();
+        }
 
         // Use this fail point to hold the PBWM lock after we have written the oplog entries but
         // before we have applied them.
@@ -1368,7 +1493,33 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
 
         {
             std::vector<Status> statusVector(_writerPool->getStats().numThreads, Status::OK());
-            _applyOps(writerVectors, &statusVector, &multikeyVector);
+            _applyOps(batch->writerVectors, &statusVector, &multikeyVector);
+
+            // While the writer threads apply this batch, take the next one if it is ready. Writer
+            // threads that finish their share of this batch early write the oplog entries of the
+            // next batch, which this thread partitions in the meantime. This is only done when
+            // both batches consist of CRUD operations: commands are batched on their own and may
+            // change the collection properties or session state that partitioning depends on.
+            //
+            // The batch boundary is preserved. The next batch's oplog entries are written only
+            // after the truncate-after point has been reset for this batch, and it sets the point
+            // to its own first timestamp, so a crash before the next batch completes truncates
+            // them again. Its 'minValid' update and its application wait for this batch to
+            // complete.
+            if (batcher && !MONGO_FAIL_POINT(rsSyncApplyStop)) {
+                OpQueue next = batcher->tryGetNextBatch();
+                if (!next.empty()) {
+                    *nextBatch = std::make_unique<ApplierBatch>(next.releaseBatch());
+                    auto isCommand = [](const OplogEntry& op) { return op.isCommand(); };
+                    if (std::none_of(ops.begin(), ops.end(), isCommand) &&
+                        std::none_of(
+                            (*nextBatch)->ops.begin(), (*nextBatch)->ops.end(), isCommand)) {
+                        _prepareBatch(opCtx, nextBatch->get());
+                    }
+                }
+            }
+
+            // Also waits for the oplog writes of the next batch, if any.
             _writerPool->waitForIdle();
 
             // If any of the statuses is not ok, return error.
@@ -232,14 +232,39 @@ public:
 
 private:
     class OpQueueBatcher;
+    class WriterAssignment;
+    struct ApplierBatch;
 
     void _oplogApplication(ReplicationCoordinator* replCoord, OpQueueBatcher* batcher) noexcept;
 
+    /**
+     * Applies 'batch' as described for multiApply(), preparing it first unless that has already
+     * been done while the previous batch was applied.
+     *
+     * If 'batcher' is not null, takes the next batch from it while the writer threads apply
+     * 'batch', if one is ready, and returns it through 'nextBatch'. When both batches consist only
+     * of CRUD operations, the next batch is also prepared, so that its oplog entries are written
+     * by otherwise idle writer threads and its operations are partitioned by this thread. The next
+     * batch is never applied before 'batch' completes.
+     */
+    StatusWith<OpTime> _multiApply(OperationContext* opCtx,
+                                   ApplierBatch* batch,
+                                   OpQueueBatcher* batcher,
+                                   std::unique_ptr<ApplierBatch>* nextBatch);
+
+    /**
+     * Sets the oplog truncate-after point to the start of 'batch', schedules the writes of its
+     * oplog entries on the writer pool and partitions its operations into writer vectors. The
+     * caller must wait for the writer pool to go idle before applying or destroying 'batch'.
+     */
+    void _prepareBatch(OperationContext* opCtx, ApplierBatch* batch);
+
     void _fillWriterVectors(OperationContext* opCtx,
                             MultiApplier::Operations* ops,
                             std::vector<MultiApplier::OperationPtrs>* writerVectors,
                             std::vector<MultiApplier::Operations>* derivedOps,
-                            SessionUpdateTracker* sessionUpdateTracker);
+                            SessionUpdateTracker* sessionUpdateTracker,
+                            WriterAssignment* writerAssignment);
 
     /**
      * Doles out all the work to the writer pool threads. Does not modify writerVectors, but passes
@@ -30,6 +30,7 @@
 #include "mongo/platform/basic.h"
 
 #include <algorithm>
+#include <deque>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -56,6 +57,7 @@
 #include "mongo/db/repl/idempotency_test_fixture.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplog_buffer_blocking_queue.h"
+#include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/replication_process.h"
@@ -67,9 +69,11 @@
 #include "mongo/db/stats/counters.h"
 #include "mongo/db/transaction_participant_gen.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/stdx/unordered_map.h"
 #include "mongo/unittest/death_test.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/clock_source_mock.h"
+#include "mongo/util/fail_point_service.h"
 #include "mongo/util/md5.hpp"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/string_map.h"
@@ -466,6 +470,50 @@ TEST_F(SyncTailTest,
                                                      createOplogCollectionOptions()));
 }
 
+TEST_F(SyncTailTest, FillWriterVectorsBalancesConflictKeysAcrossWriters) {
+    const std::size_t numWriters = 4;
+    const int numCollections = 8;
+
+    MultiApplier::Operations ops;
+    for (int i = 0; i < numCollections; i++) {
+        NamespaceString nss("test.coll" + std::to_string(i));
+        createCollection(_opCtx.get(), nss, {});
+        ops.push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(1), 2 * i + 1), 1LL}, nss, BSON("_id" << 1)));
+    }
+    for (int i = 0; i < numCollections; i++) {
+        NamespaceString nss("test.coll" + std::to_string(i));
+        ops.push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(1), 2 * i + 2), 1LL}, nss, BSON("_id" << 2)));
+    }
+
+    SyncTail syncTail(nullptr,
+                      getConsistencyMarkers(),
+                      getStorageInterface(),
+                      {},
+                      nullptr,
+                      OplogApplier::Options(OplogApplication::Mode::kSecondary));
+    std::vector<MultiApplier::OperationPtrs> writerVectors(numWriters);
+    std::vector<MultiApplier::Operations> derivedOps;
+    syncTail.fillWriterVectors(_opCtx.get(), &ops, &writerVectors, &derivedOps);
+
+    // Every collection was assigned to the least loaded writer when first seen, and kept its
+    // writer for its later operations, which remain in order.
+    stdx::unordered_map<std::string, std::size_t> writerByNs;
+    for (std::size_t i = 0; i < numWriters; i++) {
+        ASSERT_EQUALS(4U, writerVectors[i].size());
+        for (std::size_t j = 0; j < writerVectors[i].size(); j++) {
+            const auto& op = *writerVectors[i][j];
+            auto inserted = writerByNs.emplace(op.getNss().ns(), i);
+            ASSERT_EQUALS(i, inserted.first->second);
+            if (!inserted.second) {
+                ASSERT_BSONOBJ_EQ(BSON("_id" << 2), op.getObject());
+            }
+        }
+    }
+    ASSERT_EQUALS(std::size_t(numCollections), writerByNs.size());
+}
+
 TEST_F(SyncTailTest, MultiSyncApplyUsesSyncApplyToApplyOperation) {
     NamespaceString nss("local." + _agent.getSuiteName() + "_" + _agent.getTestName());
     auto op = makeCreateCollectionOplogEntry({Timestamp(Seconds(1), 0), 1LL}, nss);
@@ -2010,6 +2058,164 @@ DEATH_TEST_F(SyncTailTest,
     syncTail.oplogApplication(oplogBuffer.get(), getNextApplierBatchFn, &replCoord);
 }
 
+TEST_F(SyncTailTest, OplogApplicationAppliesPipelinedBatchesInOrder) {
+    const bool pipelineBatchApplication = replPipelineBatchApplication.load();
+    replPipelineBatchApplication.store(true);
+    ON_BLOCK_EXIT([&] { replPipelineBatchApplication.store(pipelineBatchApplication); });
+
+    NamespaceString nss("test." + _agent.getTestName());
+    createCollectionWithUuid(_opCtx.get(), nss);
+
+    std::deque<OplogApplier::Operations> batches;
+    OpTime lastOpTime;
+    for (int i = 1; i <= 3; i++) {
+        OplogApplier::Operations batch;
+        for (int j = 1; j <= 10; j++) {
+            lastOpTime = {Timestamp(Seconds(i), j), 1LL};
+            batch.push_back(makeInsertDocumentOplogEntry(lastOpTime, nss, BSON("_id" << i * 100 + j)));
+        }
+        batches.push_back(std::move(batch));
+    }
+
+    // Records the batch of every operation applied, which is the seconds of its timestamp.
+    stdx::mutex mutex;
+    std::vector<unsigned> batchesApplied;
+    auto applyOperationFn = [&](OperationContext*,
+                                MultiApplier::OperationPtrs* ops,
+                                SyncTail*,
+                                WorkerMultikeyPathInfo*) {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        for (auto&& op : *ops) {
+            batchesApplied.push_back(op->getTimestamp().getSecs());
+        }
+        return Status::OK();
+    };
+    auto writerPool = OplogApplier::makeWriterPool();
+    SyncTail syncTail(nullptr,  // observer. not required by oplogApplication().
+                      _consistencyMarkers.get(),
+                      getStorageInterface(),
+                      applyOperationFn,
+                      writerPool.get(),
+                      OplogApplier::Options(OplogApplication::Mode::kSecondary));
+
+    auto replCoord = ReplicationCoordinator::get(_opCtx.get());
+    ASSERT_OK(replCoord->setFollowerMode(MemberState::RS_SECONDARY));
+
+    // Hands out the batches as fast as the batcher takes them, so that each batch is ready while
+    // the previous one is applied, and then shuts oplog application down.
+    auto getNextApplierBatchFn = [&](OperationContext*, const OplogApplier::BatchLimits&) {
+        if (batches.empty()) {
+            syncTail.shutdown();
+            return StatusWith<OplogApplier::Operations>(OplogApplier::Operations());
+        }
+        auto batch = std::move(batches.front());
+        batches.pop_front();
+        return StatusWith<OplogApplier::Operations>(std::move(batch));
+    };
+    auto oplogBuffer = std::make_unique<OplogBufferBlockingQueue>();
+
+    // SyncTail::oplogApplication() creates its own OperationContext in the current thread context.
+    auto opCtxHolder = std::move(_opCtx);
+    syncTail.oplogApplication(oplogBuffer.get(), getNextApplierBatchFn, replCoord);
+    _opCtx = std::move(opCtxHolder);
+
+    // No operation of a batch was applied before every operation of the previous batch.
+    ASSERT_EQUALS(30U, batchesApplied.size());
+    ASSERT_TRUE(std::is_sorted(batchesApplied.begin(), batchesApplied.end()));
+
+    ASSERT_EQUALS(lastOpTime, replCoord->getMyLastAppliedOpTime());
+    ASSERT_EQUALS(lastOpTime, getConsistencyMarkers()->getAppliedThrough(_opCtx.get()));
+    ASSERT_EQUALS(Timestamp(), getConsistencyMarkers()->getOplogTruncateAfterPoint(_opCtx.get()));
+}
+
+TEST_F(SyncTailTest, OplogApplicationPreparesNextBatchWhileApplyingCurrentBatch) {
+    const bool pipelineBatchApplication = replPipelineBatchApplication.load();
+    replPipelineBatchApplication.store(true);
+    ON_BLOCK_EXIT([&] { replPipelineBatchApplication.store(pipelineBatchApplication); });
+
+    NamespaceString nss("test." + _agent.getTestName());
+    createCollectionWithUuid(_opCtx.get(), nss);
+
+    // The first batch has a single operation, so that it occupies a single writer thread and
+    // leaves the others free to write the oplog entries of the second batch.
+    std::deque<OplogApplier::Operations> batches;
+    OplogApplier::Operations firstBatch;
+    firstBatch.push_back(
+        makeInsertDocumentOplogEntry({Timestamp(Seconds(1), 1), 1LL}, nss, BSON("_id" << 0)));
+    batches.push_back(std::move(firstBatch));
+    OplogApplier::Operations secondBatch;
+    OpTime lastOpTime;
+    for (int j = 1; j <= 10; j++) {
+        lastOpTime = {Timestamp(Seconds(2), j), 1LL};
+        secondBatch.push_back(makeInsertDocumentOplogEntry(lastOpTime, nss, BSON("_id" << j)));
+    }
+    const auto secondBatchStart = secondBatch.front().getTimestamp();
+    batches.push_back(std::move(secondBatch));
+
+    // Holds the applier thread before it applies the first batch until the batcher has taken the
+    // second one, so that the second batch is ready while the first one is applied.
+    auto failPoint =
+        getGlobalFailPointRegistry()->getFailPoint("pauseBatchApplicationAfterWritingOplogEntries");
+    failPoint->setMode(FailPoint::alwaysOn);
+    ON_BLOCK_EXIT([failPoint] { failPoint->setMode(FailPoint::off); });
+
+    // Blocks the writer thread applying the first batch until the applier thread has started to
+    // prepare the second batch, which begins by setting the oplog truncate-after point to its
+    // first timestamp. Without pipelining, that only happens after the first batch completes.
+    bool secondBatchPreparedDuringFirstBatch = false;
+    auto applyOperationFn = [&](OperationContext* opCtx,
+                                MultiApplier::OperationPtrs* ops,
+                                SyncTail*,
+                                WorkerMultikeyPathInfo*) {
+        if (ops->front()->getTimestamp().getSecs() == 1U) {
+            auto deadline = Date_t::now() + Seconds(30);
+            while (Date_t::now() < deadline) {
+                if (getConsistencyMarkers()->getOplogTruncateAfterPoint(opCtx) ==
+                    secondBatchStart) {
+                    secondBatchPreparedDuringFirstBatch = true;
+                    break;
+                }
+                sleepmillis(1);
+            }
+        }
+        return Status::OK();
+    };
+    auto writerPool = OplogApplier::makeWriterPool();
+    SyncTail syncTail(nullptr,  // observer. not required by oplogApplication().
+                      _consistencyMarkers.get(),
+                      getStorageInterface(),
+                      applyOperationFn,
+                      writerPool.get(),
+                      OplogApplier::Options(OplogApplication::Mode::kSecondary));
+
+    auto replCoord = ReplicationCoordinator::get(_opCtx.get());
+    ASSERT_OK(replCoord->setFollowerMode(MemberState::RS_SECONDARY));
+
+    // The batcher only asks for a batch once it has handed the previous one over, so by the time
+    // it asks for a third batch the second one is waiting for the applier thread.
+    auto getNextApplierBatchFn = [&](OperationContext*, const OplogApplier::BatchLimits&) {
+        if (batches.empty()) {
+            failPoint->setMode(FailPoint::off);
+            syncTail.shutdown();
+            return StatusWith<OplogApplier::Operations>(OplogApplier::Operations());
+        }
+        auto batch = std::move(batches.front());
+        batches.pop_front();
+        return StatusWith<OplogApplier::Operations>(std::move(batch));
+    };
+    auto oplogBuffer = std::make_unique<OplogBufferBlockingQueue>();
+
+    // SyncTail::oplogApplication() creates its own OperationContext in the current thread context.
+    auto opCtxHolder = std::move(_opCtx);
+    syncTail.oplogApplication(oplogBuffer.get(), getNextApplierBatchFn, replCoord);
+    _opCtx = std::move(opCtxHolder);
+
+    ASSERT_TRUE(secondBatchPreparedDuringFirstBatch);
+    ASSERT_EQUALS(lastOpTime, replCoord->getMyLastAppliedOpTime());
+    ASSERT_EQUALS(lastOpTime, getConsistencyMarkers()->getAppliedThrough(_opCtx.get()));
+    ASSERT_EQUALS(Timestamp(), getConsistencyMarkers()->getOplogTruncateAfterPoint(_opCtx.get()));
+}
+
 TEST_F(IdempotencyTest, Geo2dsphereIndexFailedOnUpdate) {
     ASSERT_OK(
         ReplicationCoordinator::get(_opCtx.get())->setFollowerMode(MemberState::RS_RECOVERING));
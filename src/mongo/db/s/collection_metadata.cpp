@@ -33,19 +33,80 @@
 
 #include "mongo/db/s/collection_metadata.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/bson/dotted_path_support.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/s/catalog/type_chunk.h"
 #include "mongo/util/log.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
 
+ShardOwnedRanges::ShardOwnedRanges(const ChunkManager& cm, const ShardId& shardId)
+    : _ordering(Ordering::make(cm.getShardKeyPattern().toBSON())) {
+    // The max bound of the range being coalesced, which is only encoded once the next chunk is
+    // known not to extend it
+    boost::optional<BSONObj> rangeMax;
+
+    for (const auto& chunk : cm.chunks()) {
+        if (chunk.getShardId() != shardId) {
+            continue;
+        }
+
+        if (rangeMax && SimpleBSONObjComparator::kInstance.evaluate(*rangeMax == chunk.getMin())) {
+            rangeMax = chunk.getMax();
+            continue;
+        }
+
+        if (rangeMax) {
+            _bounds.push_back(_toKeyString(*rangeMax));
+        }
+        _bounds.push_back(_toKeyString(chunk.getMin()));
+        rangeMax = chunk.getMax();
+    }
+
+    if (rangeMax) {
+        _bounds.push_back(_toKeyString(*rangeMax));
+    }
+}
+
+bool ShardOwnedRanges::containsKey(const BSONObj& shardKey) const {
+    const auto it = std::upper_bound(_bounds.begin(), _bounds.end(), _toKeyString(shardKey));
+    return (it - _bounds.begin()) % 2 == 1;
+}
+
+std::string ShardOwnedRanges::_toKeyString(const BSONObj& shardKey) const {
+    KeyString ks(KeyString::Version::V1, shardKey, _ordering);
+    return {ks.getBuffer(), ks.getSize()};
+}
+
 CollectionMetadata::CollectionMetadata(std::shared_ptr<ChunkManager> cm, const ShardId& thisShardId)
-    : _cm(std::move(cm)), _thisShardId(thisShardId) {}
+    : _cm(std::move(cm)),
+      _thisShardId(thisShardId),
+      _ownedRangesCache(std::make_shared<OwnedRangesCache>()) {}
+
+const ShardOwnedRanges& CollectionMetadata::getOwnedRanges() const {
+    invariant(isSharded());
+
+    stdx::lock_guard<stdx::mutex> lg(_ownedRangesCache->mutex);
+    if (!_ownedRangesCache->ranges) {
+        _ownedRangesCache->ranges = std::make_unique<ShardOwnedRanges>(*_cm, _thisShardId);
+    }
+
+    return *_ownedRangesCache->ranges;
+}
+
+bool CollectionMetadata::rangeBelongsToMe(const BSONObj& min, const BSONObj& max) const {
+    invariant(isSharded());
+
+    std::set<ShardId> shardIds;
+    _cm->getShardIdsForRange(min, max, &shardIds);
+    return shardIds.size() == 1 && *shardIds.begin() == _thisShardId;
+}
 
 BSONObj CollectionMetadata::extractDocumentKey(const BSONObj& doc) const {
     BSONObj key;
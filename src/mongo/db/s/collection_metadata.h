@@ -31,9 +31,39 @@
 
 #include "mongo/db/range_arithmetic.h"
 #include "mongo/s/chunk_manager.h"
+#include "mongo/stdx/mutex.h"
 
 namespace mongo {
 
+/**
+ * Compact form of the parts of the shard key space owned by a shard, for answering ownership
+ * questions about many keys. Adjacent owned chunks are coalesced into maximal ranges whose bounds
+ * are kept as a sorted vector of KeyStrings, so a lookup is a binary search over the owned ranges
+ * only rather than a search over all the chunks of the collection.
+ */
+class ShardOwnedRanges {
+public:
+    ShardOwnedRanges(const ChunkManager& cm, const ShardId& shardId);
+
+    /**
+     * Returns true if 'shardKey' falls in one of the owned ranges.
+     */
+    bool containsKey(const BSONObj& shardKey) const;
+
+    size_t numRanges() const {
+        return _bounds.size() / 2;
+    }
+
+private:
+    std::string _toKeyString(const BSONObj& shardKey) const;
+
+    const Ordering _ordering;
+
+    // The [min, max) bounds of the owned ranges in ascending order, with each range taking up two
+    // consecutive entries. A key is owned if the number of bounds less than or equal to it is odd.
+    std::vector<std::string> _bounds;
+};
+
 /**
  * The collection metadata has metadata information about a collection, in particular the
  * sharding information. It's main goal in life is to be capable of answering if a certain
@@ -158,6 +188,19 @@ public:
         return _cm->keyBelongsToShard(key, _thisShardId);
     }
 
+    /**
+     * Returns the ranges of the shard key space owned by this shard, for callers which check the
+     * ownership of many keys. They are built on first use, in time linear in the number of chunks,
+     * and are shared by all copies of this metadata object.
+     */
+    const ShardOwnedRanges& getOwnedRanges() const;
+
+    /**
+     * Returns true if all the keys in the range [min, max] belong to this shard. Please note the
+     * inclusive bounds on both sides.
+     */
+    bool rangeBelongsToMe(const BSONObj& min, const BSONObj& max) const;
+
     /**
      * Given a key 'lookupKey' in the shard key range, get the next chunk which overlaps or is
      * greater than this key.  Returns true if a chunk exists, false otherwise.
@@ -217,6 +260,13 @@ private:
     // The identity of this shard, for the purpose of answering "key belongs to me" queries. If the
     // collection is not sharded (_cm is nullptr), then this value will be empty.
     ShardId _thisShardId;
+
+    // Lazily built owned ranges, shared between copies of this metadata object
+    struct OwnedRangesCache {
+        stdx::mutex mutex;
+        std::unique_ptr<ShardOwnedRanges> ranges;
+    };
+    std::shared_ptr<OwnedRangesCache> _ownedRangesCache;
 };
 
 }  // namespace mongo
@@ -299,6 +299,23 @@ TEST_F(TwoChunksWithGapCompoundKeyFixture, ChunkGapOrphanedDataRanges) {
     ASSERT(!makeCollectionMetadata()->getNextOrphanRange(pending, keyRange->getMax()));
 }
 
+TEST_F(TwoChunksWithGapCompoundKeyFixture, OwnedRangesContainKey) {
+    auto metadata(makeCollectionMetadata());
+    const auto& ownedRanges = metadata->getOwnedRanges();
+    ASSERT_EQ(2U, ownedRanges.numRanges());
+
+    ASSERT(ownedRanges.containsKey(BSON("a" << 10 << "b" << 0)));
+    ASSERT(ownedRanges.containsKey(BSON("a" << 15 << "b" << MINKEY)));
+    ASSERT(ownedRanges.containsKey(BSON("a" << 20 << "b" << -1)));
+    ASSERT(ownedRanges.containsKey(BSON("a" << 30 << "b" << 0)));
+
+    ASSERT(!ownedRanges.containsKey(BSON("a" << 10 << "b" << -1)));
+    ASSERT(!ownedRanges.containsKey(BSON("a" << 20 << "b" << 0)));
+    ASSERT(!ownedRanges.containsKey(BSON("a" << 25 << "b" << 0)));
+    ASSERT(!ownedRanges.containsKey(BSON("a" << 40 << "b" << 0)));
+    ASSERT(!ownedRanges.containsKey(BSON("a" << MAXKEY << "b" << MAXKEY)));
+}
+
 /**
  * Fixture with chunk containing:
  * [min->10) , [10->20) , <gap> , [30->max)
@@ -348,6 +365,41 @@ TEST_F(ThreeChunkWithRangeGapFixture, KeyBelongsToMe) {
     ASSERT(!makeCollectionMetadata()->keyBelongsToMe(BSONObj()));
 }
 
+TEST_F(ThreeChunkWithRangeGapFixture, OwnedRangesCoalesceAdjacentChunks) {
+    auto metadata(makeCollectionMetadata());
+    const auto& ownedRanges = metadata->getOwnedRanges();
+    ASSERT_EQ(2U, ownedRanges.numRanges());
+
+    for (const auto& key : {BSON("a" << MINKEY),
+                            BSON("a" << 5),
+                            BSON("a" << 10),
+                            BSON("a" << 19),
+                            BSON("a" << 20),
+                            BSON("a" << 25),
+                            BSON("a" << 30),
+                            BSON("a" << 40),
+                            BSON("a" << MAXKEY)}) {
+        ASSERT_EQ(metadata->keyBelongsToMe(key), ownedRanges.containsKey(key)) << key;
+    }
+}
+
+TEST_F(ThreeChunkWithRangeGapFixture, OwnedRangesAreSharedBetweenCopies) {
+    auto metadata(makeCollectionMetadata());
+    const CollectionMetadata copy(*metadata);
+    ASSERT_EQ(&metadata->getOwnedRanges(), &copy.getOwnedRanges());
+}
+
+TEST_F(ThreeChunkWithRangeGapFixture, RangeBelongsToMe) {
+    auto metadata(makeCollectionMetadata());
+    ASSERT(metadata->rangeBelongsToMe(BSON("a" << MINKEY), BSON("a" << 19)));
+    ASSERT(metadata->rangeBelongsToMe(BSON("a" << 5), BSON("a" << 15)));
+    ASSERT(metadata->rangeBelongsToMe(BSON("a" << 30), BSON("a" << MAXKEY)));
+
+    ASSERT(!metadata->rangeBelongsToMe(BSON("a" << 5), BSON("a" << 20)));
+    ASSERT(!metadata->rangeBelongsToMe(BSON("a" << 20), BSON("a" << 25)));
+    ASSERT(!metadata->rangeBelongsToMe(BSON("a" << 15), BSON("a" << 35)));
+}
+
 TEST_F(ThreeChunkWithRangeGapFixture, GetNextChunkFromBeginning) {
     ChunkType nextChunk;
     ASSERT(
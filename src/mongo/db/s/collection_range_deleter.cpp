@@ -59,6 +59,7 @@
 #include "mongo/db/storage/remove_saver.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/executor/task_executor.h"
+#include "mongo/s/shard_key_pattern.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
@@ -76,6 +77,38 @@ const WriteConcernOptions kMajorityWriteConcern(WriteConcernOptions::kMajority,
 
 MONGO_FAIL_POINT_DEFINE(hangBeforeDoingDeletion);
 
+/**
+ * Paces the range deletions of all collections so that together they delete no more than
+ * rangeDeleterMaxBytesPerSecond bytes of documents per second.
+ */
+class RangeDeletionRateLimiter {
+public:
+    /**
+     * Accounts for a batch which deleted 'bytesDeleted' bytes and returns the earliest time at
+     * which the next batch may start.
+     */
+    Date_t charge(long long bytesDeleted) {
+        const auto now = Date_t::now();
+        const auto maxBytesPerSecond = rangeDeleterMaxBytesPerSecond.load();
+        if (maxBytesPerSecond <= 0) {
+            return now;
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _nextBatchTime = std::max(_nextBatchTime, now) +
+            Microseconds(bytesDeleted * 1000 * 1000 / maxBytesPerSecond);
+        return _nextBatchTime;
+    }
+
+private:
+    stdx::mutex _mutex;
+
+    // Time before which the batches deleted so far exceed the allowed rate
+    Date_t _nextBatchTime;
+};
+
+const auto getRateLimiter = ServiceContext::declareDecoration<RangeDeletionRateLimiter>();
+
 boost::optional<DeleteNotification> checkOverlap(std::list<Deletion> const& deletions,
                                                  ChunkRange const& range) {
     // Start search with newest entries by using reverse iterators
@@ -116,6 +149,8 @@ boost::optional<Date_t> CollectionRangeDeleter::cleanUpNextRange(
 
     auto range = boost::optional<ChunkRange>(boost::none);
     auto notification = DeleteNotification();
+    BSONObj resumeKey;
+    long long bytesDeleted = 0;
 
     {
         UninterruptibleLockGuard noInterrupt(opCtx->lockState());
@@ -162,6 +197,7 @@ boost::optional<Date_t> CollectionRangeDeleter::cleanUpNextRange(
             const auto& frontRange = orphans.front().range;
             range.emplace(frontRange.getMin().getOwned(), frontRange.getMax().getOwned());
             notification = orphans.front().notification;
+            resumeKey = orphans.front().resumeKey;
         }
 
         invariant(range);
@@ -200,15 +236,31 @@ boost::optional<Date_t> CollectionRangeDeleter::cleanUpNextRange(
             metadataManager->getActiveMetadata(metadataManager, boost::none);
         const auto& metadata = *scopedCollectionMetadata;
 
+        BSONObj lastDeletedKey;
         try {
-            swNumDeleted = self->_doDeletion(
-                opCtx, collection, metadata->getKeyPattern(), *range, maxToDelete);
+            swNumDeleted = self->_doDeletion(opCtx,
+                                             collection,
+                                             metadata->getKeyPattern(),
+                                             *range,
+                                             resumeKey,
+                                             maxToDelete,
+                                             &lastDeletedKey,
+                                             &bytesDeleted);
         } catch (const DBException& e) {
             swNumDeleted = e.toStatus();
             warning() << e.what();
         }
+
+        if (!lastDeletedKey.isEmpty()) {
+            stdx::lock_guard<stdx::mutex> scopedLock(csr->_metadataManager->_managerLock);
+            if (!self->_orphans.empty() && self->_orphans.front().notification == notification) {
+                self->_orphans.front().resumeKey = lastDeletedKey;
+            }
+        }
     }  // drop autoColl
 
+    const auto rateLimitedUntil = getRateLimiter(opCtx->getServiceContext()).charge(bytesDeleted);
+
     bool continueDeleting = swNumDeleted.isOK() && swNumDeleted.getValue() > 0;
 
     if (swNumDeleted == ErrorCodes::WriteConflict) {
@@ -287,14 +339,15 @@ boost::optional<Date_t> CollectionRangeDeleter::cleanUpNextRange(
                    << redact(self->_orphans.front().range.toString()) << " next.";
         }
 
-        return Date_t::now() + Milliseconds(rangeDeleterBatchDelayMS.load());
+        return std::max(Date_t::now() + Milliseconds(rangeDeleterBatchDelayMS.load()),
+                        rateLimitedUntil);
     }
 
     invariant(range);
     invariant(continueDeleting);
 
     notification.abandon();
-    return Date_t::now() + Milliseconds(rangeDeleterBatchDelayMS.load());
+    return std::max(Date_t::now() + Milliseconds(rangeDeleterBatchDelayMS.load()), rateLimitedUntil);
 }
 
 bool CollectionRangeDeleter::_checkCollectionMetadataStillValid(
@@ -343,7 +396,10 @@ StatusWith<int> CollectionRangeDeleter::_doDeletion(OperationContext* opCtx,
                                                     Collection* collection,
                                                     BSONObj const& keyPattern,
                                                     ChunkRange const& range,
-                                                    int maxToDelete) {
+                                                    const BSONObj& resumeKey,
+                                                    int maxToDelete,
+                                                    BSONObj* lastDeletedKey,
+                                                    long long* bytesDeleted) {
     invariant(collection != nullptr);
     invariant(!isEmpty());
 
@@ -366,7 +422,9 @@ StatusWith<int> CollectionRangeDeleter::_doDeletion(OperationContext* opCtx,
         return Helpers::toKeyFormat(indexKeyPattern.extendRangeBound(key, false));
     };
 
-    const auto min = extend(range.getMin());
+    // Documents before the resume key were deleted by earlier batches, so there is no need to scan
+    // over the index entries they left behind again
+    const auto min = extend(resumeKey.isEmpty() ? range.getMin() : resumeKey);
     const auto max = extend(range.getMax());
 
     LOG(1) << "begin removal of " << min << " to " << max << " in " << nss.ns();
@@ -408,6 +466,8 @@ StatusWith<int> CollectionRangeDeleter::_doDeletion(OperationContext* opCtx,
 
     PlanYieldPolicy planYieldPolicy(exec.get(), PlanExecutor::YIELD_MANUAL);
 
+    const ShardKeyPattern shardKeyPattern(keyPattern);
+
     int numDeleted = 0;
     do {
         BSONObj deletedObj;
@@ -432,6 +492,13 @@ StatusWith<int> CollectionRangeDeleter::_doDeletion(OperationContext* opCtx,
         invariant(PlanExecutor::ADVANCED == state);
         ShardingStatistics::get(opCtx).countDocsDeletedOnDonor.addAndFetch(1);
 
+        *bytesDeleted += deletedObj.objsize();
+
+        auto deletedKey = shardKeyPattern.extractShardKeyFromDoc(deletedObj);
+        if (!deletedKey.isEmpty()) {
+            *lastDeletedKey = std::move(deletedKey);
+        }
+
     } while (++numDeleted < maxToDelete);
 
     return numDeleted;
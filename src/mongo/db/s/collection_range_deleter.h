@@ -118,6 +118,11 @@ public:
         ChunkRange range;
         Date_t whenToDelete;  // A value of Date_t{} means immediately.
         DeleteNotification notification{};
+
+        // Shard key of the last document deleted from the range, from which the next batch resumes
+        // its scan of the shard key index instead of stepping over the keys deleted before it, or
+        // empty if no documents were deleted yet.
+        BSONObj resumeKey;
     };
 
     CollectionRangeDeleter();
@@ -201,17 +206,21 @@ private:
         std::shared_ptr<MetadataManager> metadataManager);
 
     /**
-     * Performs the deletion of up to maxToDelete entries within the range in progress. Must be
-     * called under the collection lock.
+     * Performs the deletion of up to maxToDelete entries within the range in progress, in shard key
+     * order starting at 'resumeKey' if it is not empty. Must be called under the collection lock.
      *
      * Returns the number of documents deleted, 0 if done with the range, or bad status if deleting
-     * the range failed.
+     * the range failed. Sets 'lastDeletedKey' to the shard key of the last document deleted, if it
+     * had one, and adds the size of the deleted documents to 'bytesDeleted'.
      */
     StatusWith<int> _doDeletion(OperationContext* opCtx,
                                 Collection* collection,
                                 const BSONObj& keyPattern,
                                 ChunkRange const& range,
-                                int maxToDelete);
+                                const BSONObj& resumeKey,
+                                int maxToDelete,
+                                BSONObj* lastDeletedKey,
+                                long long* bytesDeleted);
 
     /**
      * Removes the latest-scheduled range from the ranges to be cleaned up, and notifies any
@@ -40,12 +40,14 @@
 #include "mongo/db/keypattern.h"
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/s/collection_sharding_runtime.h"
+#include "mongo/db/s/sharding_runtime_d_params_gen.h"
 #include "mongo/db/s/sharding_state.h"
 #include "mongo/s/balancer_configuration.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/client/shard_registry.h"
 #include "mongo/s/shard_server_test_fixture.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -67,41 +69,56 @@ protected:
         // Make every test run with a separate epoch
         _epoch = OID::gen();
 
+        shardCollection(kNss, kShardKeyPattern);
+    }
+
+    void tearDown() override {
+        clearFilteringMetadata(kNss);
+
+        ShardServerTestFixture::tearDown();
+    }
+
+    /**
+     * Creates 'nss' with an index on 'shardKeyPattern' and installs filtering metadata under which
+     * this shard owns none of its chunks.
+     */
+    void shardCollection(const NamespaceString& nss, const BSONObj& shardKeyPattern) {
         DBDirectClient client(operationContext());
-        client.createCollection(kNss.ns());
+        client.createCollection(nss.ns());
+        if (!shardKeyPattern.hasField("_id")) {
+            client.createIndex(nss.ns(), shardKeyPattern);
+        }
 
-        const KeyPattern keyPattern(kShardKeyPattern);
+        const KeyPattern keyPattern(shardKeyPattern);
         auto rt = RoutingTableHistory::makeNew(
-            kNss,
+            nss,
             UUID::gen(),
             keyPattern,
             nullptr,
             false,
             epoch(),
-            {ChunkType(kNss,
+            {ChunkType(nss,
                        ChunkRange{keyPattern.globalMin(), keyPattern.globalMax()},
                        ChunkVersion(1, 0, epoch()),
                        ShardId("otherShard"))});
         std::shared_ptr<ChunkManager> cm = std::make_shared<ChunkManager>(rt, Timestamp(100, 0));
 
-        AutoGetCollection autoColl(operationContext(), kNss, MODE_IX);
-        auto* const css = CollectionShardingRuntime::get(operationContext(), kNss);
+        AutoGetCollection autoColl(operationContext(), nss, MODE_IX);
+        auto* const css = CollectionShardingRuntime::get(operationContext(), nss);
         css->setFilteringMetadata(operationContext(), CollectionMetadata(cm, ShardId("thisShard")));
     }
 
-    void tearDown() override {
-        {
-            AutoGetCollection autoColl(operationContext(), kNss, MODE_IX);
-            auto* const css = CollectionShardingRuntime::get(operationContext(), kNss);
-            css->clearFilteringMetadata();
-        }
-
-        ShardServerTestFixture::tearDown();
+    void clearFilteringMetadata(const NamespaceString& nss) {
+        AutoGetCollection autoColl(operationContext(), nss, MODE_IX);
+        auto* const css = CollectionShardingRuntime::get(operationContext(), nss);
+        css->clearFilteringMetadata();
     }
 
-    boost::optional<Date_t> next(CollectionRangeDeleter& rangeDeleter, int maxToDelete) {
+    boost::optional<Date_t> next(CollectionRangeDeleter& rangeDeleter,
+                                 int maxToDelete,
+                                 const NamespaceString& nss = kNss) {
         return CollectionRangeDeleter::cleanUpNextRange(
-            operationContext(), kNss, epoch(), maxToDelete, &rangeDeleter);
+            operationContext(), nss, epoch(), maxToDelete, &rangeDeleter);
     }
 
     std::shared_ptr<RemoteCommandTargeterMock> configTargeter() const {
@@ -414,5 +431,71 @@ TEST_F(CollectionRangeDeleterTest, RetryOnWriteConflictException) {
     ASSERT_EQUALS(2ULL, dbclient.count(kNss.toString(), BSON(kShardKey << LT << 5)));
 }
 
+// Tests that each batch resumes from the shard key of the last document deleted without skipping
+// the remaining documents which share that shard key value.
+TEST_F(CollectionRangeDeleterTest, ResumesBatchesWithinDocumentsSharingAShardKeyValue) {
+    const NamespaceString nss("foo", "baz");
+    const BSONObj shardKeyPattern = BSON("x" << 1);
+    shardCollection(nss, shardKeyPattern);
+    ON_BLOCK_EXIT([&] { clearFilteringMetadata(nss); });
+
+    DBDirectClient dbclient(operationContext());
+    const std::vector<int> shardKeys{3, 5, 5, 5, 5, 5, 7};
+    for (size_t i = 0; i < shardKeys.size(); ++i) {
+        dbclient.insert(nss.ns(), BSON("_id" << static_cast<int>(i) << "x" << shardKeys[i]));
+    }
+    const BSONObj outsideDoc = BSON("_id" << 100 << "x" << 15);
+    dbclient.insert(nss.ns(), outsideDoc);
+
+    CollectionRangeDeleter rangeDeleter;
+    std::list<Deletion> ranges;
+    ranges.emplace_back(Deletion{ChunkRange(BSON("x" << 0), BSON("x" << 10)), Date_t{}});
+    rangeDeleter.add(std::move(ranges));
+
+    // Every batch but the first starts at a shard key value which some of the remaining documents
+    // still have.
+    const auto inRange = BSON("x" << LT << 10);
+    for (unsigned long long remaining = shardKeys.size(); remaining > 0;) {
+        ASSERT_TRUE(next(rangeDeleter, 2, nss));
+        remaining = remaining > 2 ? remaining - 2 : 0;
+        ASSERT_EQUALS(remaining, dbclient.count(nss.ns(), inRange));
+    }
+
+    // The range is now empty, so the next batch retires it.
+    ASSERT_TRUE(next(rangeDeleter, 2, nss));
+    ASSERT_TRUE(rangeDeleter.isEmpty());
+    ASSERT_BSONOBJ_EQ(outsideDoc, dbclient.findOne(nss.ns(), QUERY("_id" << 100)));
+}
+
+// Tests that batches are paced to the configured rate of deletion.
+TEST_F(CollectionRangeDeleterTest, BatchesArePacedToMaxBytesPerSecond) {
+    const auto maxBytesPerSecond = rangeDeleterMaxBytesPerSecond.load();
+    rangeDeleterMaxBytesPerSecond.store(1);
+    ON_BLOCK_EXIT([&] { rangeDeleterMaxBytesPerSecond.store(maxBytesPerSecond); });
+
+    CollectionRangeDeleter rangeDeleter;
+    DBDirectClient dbclient(operationContext());
+    const BSONObj firstDoc = BSON(kShardKey << 1);
+    dbclient.insert(kNss.toString(), firstDoc);
+    dbclient.insert(kNss.toString(), BSON(kShardKey << 2));
+
+    std::list<Deletion> ranges;
+    ranges.emplace_back(
+        Deletion{ChunkRange(BSON(kShardKey << 0), BSON(kShardKey << 10)), Date_t{}});
+    rangeDeleter.add(std::move(ranges));
+
+    const auto before = Date_t::now();
+    auto when = next(rangeDeleter, 1);
+    ASSERT(when);
+    ASSERT_GTE(*when, before + Seconds(firstDoc.objsize()));
+    ASSERT_EQUALS(1ULL, dbclient.count(kNss.toString(), BSON(kShardKey << LT << 5)));
+
+    rangeDeleterMaxBytesPerSecond.store(0);
+    ASSERT_TRUE(next(rangeDeleter, 1));
+    ASSERT_EQUALS(0ULL, dbclient.count(kNss.toString(), BSON(kShardKey << LT << 5)));
+    ASSERT_TRUE(next(rangeDeleter, 1));
+    ASSERT_TRUE(rangeDeleter.isEmpty());
+}
+
 }  // namespace
 }  // namespace mongo
@@ -32,10 +32,11 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/db/s/collection_sharding_runtime.h"
+#include "mongo/db/s/sharding_runtime_d_params_gen.h"
 #include "mongo/db/service_context.h"
 #include "mongo/executor/network_interface_factory.h"
-#include "mongo/executor/network_interface_thread_pool.h"
 #include "mongo/executor/thread_pool_task_executor.h"
+#include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
 namespace {
@@ -62,8 +63,14 @@ private:
         if (!_taskExecutor) {
             const std::string kExecName("CollectionRangeDeleter-TaskExecutor");
 
+            // Range deletions block on majority replication of their deletes, so they run on a pool
+            // of their own threads rather than on the network interface thread
+            ThreadPool::Options options;
+            options.poolName = kExecName;
+            options.maxThreads = rangeDeleterConcurrency;
+
             auto net = executor::makeNetworkInterface(kExecName);
-            auto pool = std::make_unique<executor::NetworkInterfaceThreadPool>(net.get());
+            auto pool = std::make_unique<ThreadPool>(options);
             auto taskExecutor =
                 std::make_unique<executor::ThreadPoolTaskExecutor>(std::move(pool), std::move(net));
             taskExecutor->startup();
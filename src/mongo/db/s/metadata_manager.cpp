@@ -33,6 +33,7 @@
 
 #include "mongo/db/s/metadata_manager.h"
 
+#include <map>
 #include <memory>
 
 #include "mongo/base/string_data.h"
@@ -41,10 +42,12 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/range_arithmetic.h"
 #include "mongo/db/s/collection_sharding_state.h"
+#include "mongo/db/service_context.h"
 #include "mongo/s/grid.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/time_support.h"
 
 // MetadataManager maintains pointers to CollectionMetadata objects in a member list named
@@ -131,6 +134,8 @@ private:
 
 const auto kUnshardedCollection = std::make_shared<UnshardedCollection>();
 
+const auto getActiveCleanups = ServiceContext::declareDecoration<ActiveRangeCleanups>();
+
 /**
  * Deletes ranges, in background, until done, normally using a task executor attached to the
  * ShardingState.
@@ -161,9 +166,28 @@ void scheduleCleanup(executor::TaskExecutor* executor,
 
             MONGO_FAIL_POINT_PAUSE_WHILE_SET(suspendRangeDeletion);
 
-            auto next = CollectionRangeDeleter::cleanUpNextRange(opCtx, nss, epoch);
+            // More than one cleanup may be scheduled for a collection, for example when a range to
+            // delete immediately is added while a delayed one is pending. Whichever finds another
+            // already running leaves the remaining ranges to it, and has it run again once done.
+            auto& activeCleanups = ActiveRangeCleanups::get(opCtx->getServiceContext());
+            if (!activeCleanups.tryStart(nss, epoch)) {
+                LOG(1) << "Range deletions on " << nss.ns() << " are already running";
+                return;
+            }
+
+            boost::optional<Date_t> next;
+            boost::optional<OID> rerunEpoch;
+            {
+                ON_BLOCK_EXIT([&] { rerunEpoch = activeCleanups.finish(nss); });
+                next = CollectionRangeDeleter::cleanUpNextRange(opCtx, nss, epoch);
+            }
+
+            // The rerun was requested against the latest metadata, so its epoch supersedes the one
+            // this cleanup ran with.
+            OID nextEpoch = rerunEpoch ? *rerunEpoch : epoch;
+            next = ActiveRangeCleanups::nextCleanupTime(next, bool(rerunEpoch), Date_t::now());
             if (next) {
-                scheduleCleanup(executor, std::move(nss), std::move(epoch), *next);
+                scheduleCleanup(executor, std::move(nss), std::move(nextEpoch), *next);
             }
         });
 
@@ -175,6 +199,38 @@ void scheduleCleanup(executor::TaskExecutor* executor,
 
 }  // namespace
 
+ActiveRangeCleanups& ActiveRangeCleanups::get(ServiceContext* serviceContext) {
+    return getActiveCleanups(serviceContext);
+}
+
+bool ActiveRangeCleanups::tryStart(const NamespaceString& nss, const OID& epoch) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _active.emplace(nss, boost::none);
+    if (!it.second) {
+        it.first->second = epoch;
+        return false;
+    }
+    return true;
+}
+
+boost::optional<OID> ActiveRangeCleanups::finish(const NamespaceString& nss) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto it = _active.find(nss);
+    invariant(it != _active.end());
+    auto rerunEpoch = std::move(it->second);
+    _active.erase(it);
+    return rerunEpoch;
+}
+
+boost::optional<Date_t> ActiveRangeCleanups::nextCleanupTime(boost::optional<Date_t> next,
+                                                              bool rerunRequested,
+                                                              Date_t now) {
+    if (rerunRequested) {
+        return now;
+    }
+    return next;
+}
+
 class RangePreserver : public ScopedCollectionMetadata::Impl {
 public:
     // Must be called locked with the MetadataManager's _managerLock
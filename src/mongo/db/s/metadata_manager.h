@@ -30,6 +30,7 @@
 #pragma once
 
 #include <list>
+#include <map>
 #include <memory>
 
 #include "mongo/bson/simple_bsonobj_comparator.h"
@@ -48,6 +49,46 @@ namespace mongo {
 
 class RangePreserver;
 
+/**
+ * Tracks the namespaces whose range deletions are running on one of the range deleter's threads.
+ * The ranges of a collection must be deleted one at a time, even though the ranges of different
+ * collections are deleted concurrently.
+ */
+class ActiveRangeCleanups {
+public:
+    static ActiveRangeCleanups& get(ServiceContext* serviceContext);
+
+    /**
+     * Returns true if the caller may start deleting ranges of 'nss'. Otherwise another cleanup of
+     * 'nss' is running, and it is asked to run again for 'epoch' once it is done.
+     */
+    bool tryStart(const NamespaceString& nss, const OID& epoch);
+
+    /**
+     * Ends the cleanup of 'nss' started by tryStart(). Returns the epoch of the latest cleanup of
+     * 'nss' which was requested meanwhile, if any.
+     */
+    boost::optional<OID> finish(const NamespaceString& nss);
+
+    /**
+     * Returns when to run the next cleanup of a namespace whose cleanup has just finished, given
+     * the time 'next' at which that cleanup asked to run again, if any, and whether another
+     * cleanup was requested while it ran. The requested cleanup may be for a range which must be
+     * deleted immediately, so it is not held back until the delayed ranges of the finished one.
+     */
+    static boost::optional<Date_t> nextCleanupTime(boost::optional<Date_t> next,
+                                                   bool rerunRequested,
+                                                   Date_t now);
+
+private:
+    stdx::mutex _mutex;
+
+    // Maps each namespace being cleaned up to the epoch of the cleanup requested for it while it
+    // runs, if any. The collection may have been dropped and recreated in the meantime, so the
+    // rerun must use the epoch it was requested with.
+    std::map<NamespaceString, boost::optional<OID>> _active;
+};
+
 class MetadataManager {
     MetadataManager(const MetadataManager&) = delete;
     MetadataManager& operator=(const MetadataManager&) = delete;
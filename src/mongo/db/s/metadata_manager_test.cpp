@@ -46,6 +46,7 @@
 #include "mongo/s/client/shard_registry.h"
 #include "mongo/s/shard_server_test_fixture.h"
 #include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
 
@@ -482,5 +483,99 @@ TEST_F(MetadataManagerTest, ClearUnneededChunkManagerObjectSnapshotInMiddleOfLis
     ASSERT_EQ(_manager->numberOfEmptyMetadataSnapshots(), 2);
 }
 
+TEST(ActiveRangeCleanupsTest, CleanupOfBusyNamespaceIsHandedToRunningOne) {
+    ActiveRangeCleanups activeCleanups;
+    const NamespaceString otherNss("TestDB", "OtherColl");
+    const OID epoch = OID::gen();
+
+    ASSERT_TRUE(activeCleanups.tryStart(kNss, epoch));
+    ASSERT_FALSE(activeCleanups.tryStart(kNss, epoch));
+
+    // Other namespaces are cleaned up concurrently.
+    ASSERT_TRUE(activeCleanups.tryStart(otherNss, epoch));
+    ASSERT_FALSE(activeCleanups.finish(otherNss));
+
+    // The running cleanup is asked to run again, after which the namespace is free.
+    auto rerunEpoch = activeCleanups.finish(kNss);
+    ASSERT(rerunEpoch);
+    ASSERT_EQ(epoch, *rerunEpoch);
+    ASSERT_TRUE(activeCleanups.tryStart(kNss, epoch));
+    ASSERT_FALSE(activeCleanups.finish(kNss));
+}
+
+TEST(ActiveRangeCleanupsTest, RerunUsesEpochOfLatestRequest) {
+    ActiveRangeCleanups activeCleanups;
+    const OID oldEpoch = OID::gen();
+    const OID newEpoch = OID::gen();
+
+    // The collection is dropped and recreated while its old incarnation is being cleaned up.
+    ASSERT_TRUE(activeCleanups.tryStart(kNss, oldEpoch));
+    ASSERT_FALSE(activeCleanups.tryStart(kNss, oldEpoch));
+    ASSERT_FALSE(activeCleanups.tryStart(kNss, newEpoch));
+
+    auto rerunEpoch = activeCleanups.finish(kNss);
+    ASSERT(rerunEpoch);
+    ASSERT_EQ(newEpoch, *rerunEpoch);
+}
+
+TEST(ActiveRangeCleanupsTest, RerunIsNotDeferredToDelayedRangesOfRunningCleanup) {
+    const Date_t now = Date_t::now();
+    const Date_t delayedUntil = now + Minutes(15);
+
+    // The running cleanup found only ranges whose deletion is delayed, while a range to delete
+    // immediately was queued for the same namespace.
+    ASSERT_EQ(now, *ActiveRangeCleanups::nextCleanupTime(delayedUntil, true, now));
+    ASSERT_EQ(now, *ActiveRangeCleanups::nextCleanupTime(boost::none, true, now));
+
+    // Without a rerun, the cleanup runs again when its delayed ranges are due, if there are any.
+    ASSERT_EQ(delayedUntil, *ActiveRangeCleanups::nextCleanupTime(delayedUntil, false, now));
+    ASSERT_FALSE(ActiveRangeCleanups::nextCleanupTime(boost::none, false, now));
+}
+
+TEST(ActiveRangeCleanupsTest, ConcurrentCleanupsOfOneNamespaceRunOneAtATime) {
+    ActiveRangeCleanups activeCleanups;
+    const OID epoch = OID::gen();
+    const int kThreads = 8;
+    const int kAttemptsPerThread = 1000;
+
+    AtomicWord<int> running{0};
+    AtomicWord<bool> overlapped{false};
+    AtomicWord<int> started{0};
+    AtomicWord<int> rerunsRequested{0};
+
+    std::vector<stdx::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            for (int attempt = 0; attempt < kAttemptsPerThread; ++attempt) {
+                if (!activeCleanups.tryStart(kNss, epoch)) {
+                    continue;
+                }
+                started.fetchAndAdd(1);
+
+                if (running.addAndFetch(1) > 1) {
+                    overlapped.store(true);
+                }
+                stdx::this_thread::yield();
+                running.subtractAndFetch(1);
+
+                if (activeCleanups.finish(kNss)) {
+                    rerunsRequested.fetchAndAdd(1);
+                }
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_FALSE(overlapped.load());
+    ASSERT_GT(started.load(), 0);
+    ASSERT_LTE(rerunsRequested.load(), started.load());
+
+    // Every cleanup finished, so the namespace is free again.
+    ASSERT_TRUE(activeCleanups.tryStart(kNss, epoch));
+    ASSERT_FALSE(activeCleanups.finish(kNss));
+}
+
 }  // namespace
 }  // namespace mongo
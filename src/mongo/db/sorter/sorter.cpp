@@ -573,6 +573,7 @@ private:
         _nextSortedFileWriterOffset = writer.getFileEndOffset();
 
         _iters.push_back(std::shared_ptr<Iterator>(iteratorPtr));
+        ++this->_numSpills;
 
         _memUsed = 0;
     }
@@ -868,6 +869,7 @@ private:
         Iterator* iteratorPtr = writer.done();
         _nextSortedFileWriterOffset = writer.getFileEndOffset();
         _iters.push_back(std::shared_ptr<Iterator>(iteratorPtr));
+        ++this->_numSpills;
 
         _memUsed = 0;
     }
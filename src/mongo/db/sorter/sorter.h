@@ -209,8 +209,13 @@ public:
         return _usedDisk;
     }
 
+    size_t numSpills() const {
+        return _numSpills;
+    }
+
 protected:
     bool _usedDisk{false};  // Keeps track of whether the sorter used disk or not
+    size_t _numSpills{0};   // The number of sorted runs written to disk
     Sorter() {}             // can only be constructed as a base
 };
 
@@ -202,6 +202,13 @@ public:
     virtual void saveUnpositioned() {
         save();
     }
+
+    /**
+     * Hints that the Records with the provided ids are about to be read with seekExact(), so that
+     * the storage engine can start bringing them into memory. This never changes what the cursor
+     * returns, and implementations are free to ignore it.
+     */
+    virtual void prefetch(const std::vector<RecordId>& ids) {}
 };
 
 /**
@@ -90,6 +90,30 @@ public:
                           const RecordId& loc,
                           bool dupsAllowed) = 0;
 
+    /**
+     * Insert the entries in ['begin', 'end'), which must be in ascending index order, as if by
+     * calling insert() for each of them. Storage engines may override this to reuse a single
+     * cursor for the whole batch, so that every insert starts out near the previous one.
+     *
+     * Stops at the first entry that fails and returns its status. '*numInserted' is set to the
+     * number of entries inserted before it, so the failing entry is 'begin + *numInserted'.
+     */
+    virtual Status insertBatch(OperationContext* opCtx,
+                               std::vector<IndexKeyEntry>::const_iterator begin,
+                               std::vector<IndexKeyEntry>::const_iterator end,
+                               bool dupsAllowed,
+                               size_t* numInserted) {
+        *numInserted = 0;
+        for (auto it = begin; it != end; ++it) {
+            Status status = insert(opCtx, it->key, it->loc, dupsAllowed);
+            if (!status.isOK()) {
+                return status;
+            }
+            ++*numInserted;
+        }
+        return Status::OK();
+    }
+
     /**
      * Remove the entry from the index with the specified key and RecordId.
      *
@@ -371,6 +371,66 @@ TEST(SortedDataInterface, InsertMultipleCompoundKeys) {
     }
 }
 
+// Insert a sorted batch of keys and verify that every entry can be found afterwards.
+TEST(SortedDataInterface, InsertBatch) {
+    const auto harnessHelper(newSortedDataInterfaceHarnessHelper());
+    const std::unique_ptr<SortedDataInterface> sorted(
+        harnessHelper->newSortedDataInterface(/*unique=*/false, /*partial=*/false));
+
+    const std::vector<IndexKeyEntry> entries = {
+        {key1, loc1}, {key1, loc2}, {key2, loc3}, {key3, loc4}};
+    {
+        const ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        size_t numInserted = 0;
+        ASSERT_OK(sorted->insertBatch(
+            opCtx.get(), entries.begin(), entries.end(), /*dupsAllowed*/ true, &numInserted));
+        ASSERT_EQUALS(entries.size(), numInserted);
+        uow.commit();
+    }
+
+    {
+        const ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        ASSERT_EQUALS(4, sorted->numEntries(opCtx.get()));
+
+        const std::unique_ptr<SortedDataInterface::Cursor> cursor(sorted->newCursor(opCtx.get()));
+        ASSERT_EQ(cursor->seek(key1, true), IndexKeyEntry(key1, loc1));
+        ASSERT_EQ(cursor->next(), IndexKeyEntry(key1, loc2));
+        ASSERT_EQ(cursor->next(), IndexKeyEntry(key2, loc3));
+        ASSERT_EQ(cursor->next(), IndexKeyEntry(key3, loc4));
+        ASSERT_EQ(cursor->next(), boost::none);
+    }
+}
+
+// Insert a sorted batch containing a duplicate into a unique index and verify that the batch
+// stops at the duplicate and reports how many entries were inserted before it.
+TEST(SortedDataInterface, InsertBatchStopsAtDuplicateKey) {
+    const auto harnessHelper(newSortedDataInterfaceHarnessHelper());
+    const std::unique_ptr<SortedDataInterface> sorted(
+        harnessHelper->newSortedDataInterface(/*unique=*/true, /*partial=*/false));
+
+    const std::vector<IndexKeyEntry> entries = {
+        {key1, loc1}, {key2, loc2}, {key2, loc3}, {key3, loc4}};
+    {
+        const ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        size_t numInserted = 0;
+        ASSERT_EQUALS(ErrorCodes::DuplicateKey,
+                      sorted->insertBatch(opCtx.get(),
+                                          entries.begin(),
+                                          entries.end(),
+                                          /*dupsAllowed*/ false,
+                                          &numInserted));
+        ASSERT_EQUALS(2U, numInserted);
+        uow.commit();
+    }
+
+    {
+        const ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        ASSERT_EQUALS(2, sorted->numEntries(opCtx.get()));
+    }
+}
+
 TEST(SortedDataInterface, InsertReservedRecordId) {
     const auto harnessHelper(newSortedDataInterfaceHarnessHelper());
     const std::unique_ptr<SortedDataInterface> sorted(
@@ -326,6 +326,32 @@ Status WiredTigerIndex::insert(OperationContext* opCtx,
     return _insert(opCtx, c, key, id, dupsAllowed);
 }
 
+Status WiredTigerIndex::insertBatch(OperationContext* opCtx,
+                                    std::vector<IndexKeyEntry>::const_iterator begin,
+                                    std::vector<IndexKeyEntry>::const_iterator end,
+                                    bool dupsAllowed,
+                                    size_t* numInserted) {
+    dassert(opCtx->lockState()->isWriteLocked());
+    *numInserted = 0;
+
+    // A single cursor serves the whole batch. Since the keys arrive in index order, each insert
+    // lands on or next to the page the previous one touched.
+    WiredTigerCursor curwrap(_uri, _tableId, false, opCtx);
+    curwrap.assertInActiveTxn();
+    WT_CURSOR* c = curwrap.get();
+
+    for (auto it = begin; it != end; ++it) {
+        invariant(it->loc.isValid());
+        dassert(!hasFieldNames(it->key));
+        Status status = _insert(opCtx, c, it->key, it->loc, dupsAllowed);
+        if (!status.isOK()) {
+            return status;
+        }
+        ++*numInserted;
+    }
+    return Status::OK();
+}
+
 void WiredTigerIndex::unindex(OperationContext* opCtx,
                               const BSONObj& key,
                               const RecordId& id,
@@ -96,6 +96,12 @@ public:
                           const RecordId& id,
                           bool dupsAllowed);
 
+    virtual Status insertBatch(OperationContext* opCtx,
+                               std::vector<IndexKeyEntry>::const_iterator begin,
+                               std::vector<IndexKeyEntry>::const_iterator end,
+                               bool dupsAllowed,
+                               size_t* numInserted);
+
     virtual void unindex(OperationContext* opCtx,
                          const BSONObj& key,
                          const RecordId& id,
@@ -0,0 +1,172 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/catalog/collection_mock.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/index_entry_comparison.h"
+#include "mongo/db/storage/kv/kv_prefix.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_index.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/util/system_clock_source.h"
+
+namespace mongo {
+namespace {
+
+// Number of index keys inserted per WriteUnitOfWork, matching a 1000 document insert batch on a
+// single field index.
+const int kKeysPerBatch = 1000;
+
+class WiredTigerIndexBenchmarkHelper {
+public:
+    explicit WiredTigerIndexBenchmarkHelper(bool unique) : _dbpath("wt_index_bm") {
+        invariantWTOK(wiredtiger_open(
+            _dbpath.path().c_str(), nullptr, "create,cache_size=1G,", &_conn));
+        _sessionCache = std::make_unique<WiredTigerSessionCache>(_conn, &_clockSource);
+
+        const std::string ns = "test.wt_index_bm";
+        BSONObj spec = BSON("key" << BSON("a" << 1) << "name"
+                                  << "a_1"
+                                  << "v"
+                                  << static_cast<int>(IndexDescriptor::kLatestIndexVersion)
+                                  << "ns"
+                                  << ns
+                                  << "unique"
+                                  << unique);
+        CollectionMock collection{NamespaceString(ns)};
+        IndexDescriptor desc(&collection, "", spec);
+
+        auto opCtx = newOperationContext();
+        KVPrefix prefix = KVPrefix::kNotPrefixed;
+        auto config = WiredTigerIndex::generateCreateString(
+            kWiredTigerEngineName, "", "", desc, prefix.isPrefixed());
+        invariant(config.isOK());
+        const std::string uri = "table:" + ns;
+        invariantWTOK(WiredTigerIndex::Create(opCtx.get(), uri, config.getValue()));
+
+        if (unique) {
+            _index = std::make_unique<WiredTigerIndexUnique>(opCtx.get(), uri, &desc, prefix);
+        } else {
+            _index = std::make_unique<WiredTigerIndexStandard>(opCtx.get(), uri, &desc, prefix);
+        }
+    }
+
+    ~WiredTigerIndexBenchmarkHelper() {
+        _index.reset();
+        _sessionCache.reset();
+        _conn->close(_conn, nullptr);
+    }
+
+    std::unique_ptr<OperationContext> newOperationContext() {
+        return std::make_unique<OperationContextNoop>(
+            new WiredTigerRecoveryUnit(_sessionCache.get(), &_oplogManager));
+    }
+
+    SortedDataInterface* index() const {
+        return _index.get();
+    }
+
+    /**
+     * Returns the next batch of keys in the order their documents would be inserted: random
+     * values pointing to ascending RecordIds.
+     */
+    std::vector<IndexKeyEntry> nextBatch() {
+        std::vector<IndexKeyEntry> entries;
+        entries.reserve(kKeysPerBatch);
+        for (int i = 0; i < kKeysPerBatch; ++i) {
+            entries.emplace_back(BSON("" << _random.nextInt64()), RecordId(++_nextRecordId));
+        }
+        return entries;
+    }
+
+private:
+    unittest::TempDir _dbpath;
+    SystemClockSource _clockSource;
+    WT_CONNECTION* _conn = nullptr;
+    std::unique_ptr<WiredTigerSessionCache> _sessionCache;
+    WiredTigerOplogManager _oplogManager;
+    std::unique_ptr<SortedDataInterface> _index;
+    PseudoRandom _random{1};
+    int64_t _nextRecordId = 0;
+};
+
+// Inserts every key of the batch with its own insert() call, in document order.
+void BM_WiredTigerIndexInsertPerKey(benchmark::State& state) {
+    WiredTigerIndexBenchmarkHelper helper(state.range(0));
+    auto opCtx = helper.newOperationContext();
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto entries = helper.nextBatch();
+        state.ResumeTiming();
+
+        WriteUnitOfWork wuow(opCtx.get());
+        for (const auto& entry : entries) {
+            invariant(helper.index()->insert(opCtx.get(), entry.key, entry.loc, false).isOK());
+        }
+        wuow.commit();
+    }
+    state.SetItemsProcessed(state.iterations() * kKeysPerBatch);
+}
+
+// Sorts the keys of the batch and inserts them with a single insertBatch() call.
+void BM_WiredTigerIndexInsertSortedBatch(benchmark::State& state) {
+    WiredTigerIndexBenchmarkHelper helper(state.range(0));
+    auto opCtx = helper.newOperationContext();
+    const IndexEntryComparison comparison(Ordering::make(BSON("a" << 1)));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto entries = helper.nextBatch();
+        state.ResumeTiming();
+
+        std::sort(entries.begin(), entries.end(), comparison);
+        WriteUnitOfWork wuow(opCtx.get());
+        size_t numInserted = 0;
+        invariant(helper.index()
+                      ->insertBatch(opCtx.get(), entries.begin(), entries.end(), false, &numInserted)
+                      .isOK());
+        wuow.commit();
+    }
+    state.SetItemsProcessed(state.iterations() * kKeysPerBatch);
+}
+
+BENCHMARK(BM_WiredTigerIndexInsertPerKey)->Arg(false)->Arg(true);
+BENCHMARK(BM_WiredTigerIndexInsertSortedBatch)->Arg(false)->Arg(true);
+
+}  // namespace
+}  // namespace mongo
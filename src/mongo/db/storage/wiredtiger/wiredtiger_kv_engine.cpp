@@ -75,6 +75,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_global_options.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_index.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_parameters_gen.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_prefetcher.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
@@ -665,6 +666,12 @@ WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
         _journalFlusher->go();
     }
 
+    // An in-memory engine has nothing to page in.
+    if (!_ephemeral && gWiredTigerPrefetchThreads > 0) {
+        _prefetcher = std::make_unique<WiredTigerPrefetcher>(_sessionCache.get(),
+                                                             gWiredTigerPrefetchThreads);
+    }
+
     // Until the Replication layer installs a real callback, prevent truncating the oplog.
     setOldestActiveTransactionTimestampCallback(
         [](Timestamp) { return StatusWith(boost::make_optional(Timestamp::min())); });
@@ -801,6 +808,11 @@ void WiredTigerKVEngine::cleanShutdown() {
     }
 
     // these must be the last things we do before _conn->close();
+    if (_prefetcher) {
+        log() << "Shutting down prefetcher threads";
+        _prefetcher->shutdown();
+        log() << "Finished shutting down prefetcher threads";
+    }
     if (_sessionSweeper) {
         log() << "Shutting down session sweeper thread";
         _sessionSweeper->shutdown();
@@ -52,6 +52,7 @@ namespace mongo {
 class ClockSource;
 class JournalListener;
 class WiredTigerRecordStore;
+class WiredTigerPrefetcher;
 class WiredTigerSessionCache;
 class WiredTigerSizeStorer;
 
@@ -291,6 +292,13 @@ public:
         return _oplogManager.get();
     }
 
+    /**
+     * Returns the background record reader, or nullptr if prefetching is disabled.
+     */
+    WiredTigerPrefetcher* getPrefetcher() const {
+        return _prefetcher.get();
+    }
+
     static void appendGlobalStats(BSONObjBuilder& b);
 
     Timestamp getStableTimestamp() const override;
@@ -431,6 +439,7 @@ private:
     std::unique_ptr<WiredTigerSessionSweeper> _sessionSweeper;
     std::unique_ptr<WiredTigerJournalFlusher> _journalFlusher;  // Depends on _sizeStorer
     std::unique_ptr<WiredTigerCheckpointThread> _checkpointThread;
+    std::unique_ptr<WiredTigerPrefetcher> _prefetcher;  // Depends on _sessionCache
 
     std::string _rsOptions;
     std::string _indexOptions;
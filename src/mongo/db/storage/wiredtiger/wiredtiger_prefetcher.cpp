@@ -0,0 +1,137 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_prefetcher.h"
+
+#include <algorithm>
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+namespace {
+
+// The number of requests each thread may have queued before new ones are dropped. A request which
+// waits much longer than this is unlikely to complete before the query reaches its records.
+const int kMaxPendingPerThread = 4;
+
+ThreadPool::Options makeThreadPoolOptions(int numThreads) {
+    ThreadPool::Options options;
+    options.poolName = "WTPrefetcher";
+    options.threadNamePrefix = "WTPrefetcher-";
+    options.minThreads = 0;
+    options.maxThreads = static_cast<size_t>(numThreads);
+    return options;
+}
+
+}  // namespace
+
+WiredTigerPrefetcher::WiredTigerPrefetcher(WiredTigerSessionCache* sessionCache, int numThreads)
+    : _sessionCache(sessionCache),
+      _maxPending(numThreads * kMaxPendingPerThread),
+      _pool(makeThreadPoolOptions(numThreads)) {
+    invariant(numThreads > 0);
+    _pool.startup();
+}
+
+WiredTigerPrefetcher::~WiredTigerPrefetcher() {
+    shutdown();
+}
+
+void WiredTigerPrefetcher::prefetch(const std::string& uri,
+                                    KVPrefix prefix,
+                                    std::vector<RecordId> ids) {
+    if (ids.empty() || _shutdown.load()) {
+        return;
+    }
+
+    if (_numPending.fetchAndAdd(1) >= _maxPending) {
+        _numPending.fetchAndSubtract(1);
+        return;
+    }
+
+    _pool.schedule([ this, uri, prefix, ids = std::move(ids) ](auto status) mutable {
+        if (status.isOK() && !_shutdown.load()) {
+            std::sort(ids.begin(), ids.end());
+            _readRecords(uri, prefix, ids);
+        }
+        _numPending.fetchAndSubtract(1);
+    });
+}
+
+void WiredTigerPrefetcher::shutdown() {
+    if (_shutdown.swap(true)) {
+        return;
+    }
+    _pool.shutdown();
+    _pool.join();
+}
+
+void WiredTigerPrefetcher::_readRecords(const std::string& uri,
+                                        KVPrefix prefix,
+                                        const std::vector<RecordId>& ids) {
+    UniqueWiredTigerSession session = _sessionCache->getSession();
+    WT_SESSION* wtSession = session->getSession();
+
+    // The table may be dropped at any time, so the cursor is opened directly rather than through
+    // the session's cursor cache, which treats failing to open one as fatal.
+    WT_CURSOR* cursor = nullptr;
+    int ret = wtSession->open_cursor(wtSession, uri.c_str(), nullptr, nullptr, &cursor);
+    if (ret != 0) {
+        LOG(2) << "Could not open a cursor to prefetch records from " << uri << ": "
+               << wtRCToStatus(ret);
+        return;
+    }
+
+    for (auto&& id : ids) {
+        if (_shutdown.load()) {
+            break;
+        }
+
+        if (prefix.isPrefixed()) {
+            cursor->set_key(cursor, prefix.repr(), id.repr());
+        } else {
+            cursor->set_key(cursor, id.repr());
+        }
+
+        // Positioning the cursor is enough to bring the record's page into the cache. Missing
+        // records and prepare conflicts are expected and ignored.
+        cursor->search(cursor);
+        cursor->reset(cursor);
+    }
+
+    cursor->close(cursor);
+}
+
+}  // namespace mongo
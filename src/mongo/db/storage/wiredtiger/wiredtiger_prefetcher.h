@@ -0,0 +1,81 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/record_id.h"
+#include "mongo/db/storage/kv/kv_prefix.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/thread_pool.h"
+
+namespace mongo {
+
+class WiredTigerSessionCache;
+
+/**
+ * Reads records on a small pool of background threads so that the pages holding them are in the
+ * WiredTiger cache by the time a query seeks to them. Each request reads its records in RecordId
+ * order, from its own session, and does nothing with the values. Prefetching is purely advisory:
+ * requests are dropped when too many are outstanding, and errors are ignored.
+ */
+class WiredTigerPrefetcher {
+    WiredTigerPrefetcher(const WiredTigerPrefetcher&) = delete;
+    WiredTigerPrefetcher& operator=(const WiredTigerPrefetcher&) = delete;
+
+public:
+    WiredTigerPrefetcher(WiredTigerSessionCache* sessionCache, int numThreads);
+    ~WiredTigerPrefetcher();
+
+    /**
+     * Schedules a read of the records 'ids' in the table 'uri', whose keys carry 'prefix' if it is
+     * not KVPrefix::kNotPrefixed.
+     */
+    void prefetch(const std::string& uri, KVPrefix prefix, std::vector<RecordId> ids);
+
+    /**
+     * Waits for the outstanding requests to finish and stops the threads. Must be called before
+     * the session cache shuts down. Later requests are ignored.
+     */
+    void shutdown();
+
+private:
+    void _readRecords(const std::string& uri, KVPrefix prefix, const std::vector<RecordId>& ids);
+
+    WiredTigerSessionCache* const _sessionCache;
+    const int _maxPending;
+    ThreadPool _pool;
+
+    AtomicWord<int> _numPending{0};
+    AtomicWord<bool> _shutdown{false};
+};
+
+}  // namespace mongo
@@ -55,6 +55,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_customization_hooks.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_global_options.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_prefetcher.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_prepare_conflict.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store_oplog_stones.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
@@ -1898,6 +1899,16 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordI
     return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
 }
 
+void WiredTigerRecordStoreCursorBase::prefetch(const std::vector<RecordId>& ids) {
+    if (!_rs._kvEngine) {
+        return;
+    }
+
+    if (auto prefetcher = _rs._kvEngine->getPrefetcher()) {
+        prefetcher->prefetch(_rs.getURI(), _rs.getPrefix(), ids);
+    }
+}
+
 
 void WiredTigerRecordStoreCursorBase::save() {
     try {
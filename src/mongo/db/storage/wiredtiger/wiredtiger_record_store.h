@@ -233,6 +233,13 @@ public:
         return _tableId;
     }
 
+    /**
+     * Returns the prefix of every key in this table, or KVPrefix::kNotPrefixed.
+     */
+    virtual KVPrefix getPrefix() const {
+        return KVPrefix::kNotPrefixed;
+    }
+
     void setSizeStorer(WiredTigerSizeStorer* ss) {
         _sizeStorer = ss;
     }
@@ -395,7 +402,7 @@ public:
     virtual std::unique_ptr<RecordCursor> getRandomCursorWithOptions(
         OperationContext* opCtx, StringData extraConfig) const override;
 
-    virtual KVPrefix getPrefix() const {
+    KVPrefix getPrefix() const override {
         return _prefix;
     }
 
@@ -418,6 +425,8 @@ public:
 
     boost::optional<Record> seekExact(const RecordId& id);
 
+    void prefetch(const std::vector<RecordId>& ids);
+
     void save();
 
     void saveUnpositioned();
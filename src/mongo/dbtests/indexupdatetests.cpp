@@ -34,6 +34,7 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/catalog/multi_index_block.h"
+#include "mongo/db/catalog/multi_index_block_gen.h"
 #include "mongo/db/client.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
@@ -216,6 +217,79 @@ public:
     }
 };
 
+/** Building several indexes on multiple threads indexes every document into each of them. */
+class InsertBuildMultipleIndexesConcurrently : public IndexBuildBase {
+public:
+    void run() {
+        const auto originalThreads = maxIndexBuildThreads.load();
+        ON_BLOCK_EXIT([&] { maxIndexBuildThreads.store(originalThreads); });
+        maxIndexBuildThreads.store(4);
+
+        // Insert enough documents to fill several key generation batches.
+        const int numDocs = 3000;
+        Database* db = _ctx.db();
+        Collection* coll;
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            ASSERT_OK(db->dropCollection(&_opCtx, _nss));
+            coll = db->createCollection(&_opCtx, _nss);
+
+            OpDebug* const nullOpDebug = nullptr;
+            for (int i = 0; i < numDocs; ++i) {
+                BSONObjBuilder bob;
+                bob.append("_id", i);
+                bob.append("a", i);
+                bob.append("b", BSON_ARRAY(i << i + numDocs));
+                if (i % 2 == 0) {
+                    bob.append("c", i);
+                }
+                ASSERT_OK(
+                    coll->insertDocument(&_opCtx, InsertStatement(bob.obj()), nullOpDebug, true));
+            }
+            wunit.commit();
+        }
+
+        auto makeSpec = [&](StringData name, const BSONObj& key) {
+            return BSON("name" << name << "ns" << coll->ns().ns() << "key" << key << "v"
+                               << static_cast<int>(kIndexVersion));
+        };
+        std::vector<BSONObj> specs{
+            makeSpec("a", BSON("a" << 1)),
+            makeSpec("b", BSON("b" << 1)),
+            makeSpec("c", BSON("c" << 1))
+                .addField(BSON("partialFilterExpression" << BSON("c" << BSON("$exists" << true)))
+                              .firstElement())};
+
+        MultiIndexBlock indexer;
+        ON_BLOCK_EXIT([&] { indexer.cleanUpAfterBuild(&_opCtx, coll); });
+
+        ASSERT_OK(indexer.init(&_opCtx, coll, specs, MultiIndexBlock::kNoopOnInitFn).getStatus());
+        ASSERT_OK(indexer.insertAllDocumentsInCollection(&_opCtx, coll));
+        ASSERT_OK(indexer.checkConstraints(&_opCtx));
+        {
+            WriteUnitOfWork wunit(&_opCtx);
+            ASSERT_OK(indexer.commit(&_opCtx,
+                                     coll,
+                                     MultiIndexBlock::kNoopOnCreateEachFn,
+                                     MultiIndexBlock::kNoopOnCommitFn));
+            wunit.commit();
+        }
+
+        auto countKeys = [&](StringData name) {
+            auto desc = coll->getIndexCatalog()->findIndexByName(&_opCtx, name);
+            ASSERT(desc);
+            int64_t numKeys;
+            ValidateResults fullRes;
+            coll->getIndexCatalog()->getEntry(desc)->accessMethod()->validate(
+                &_opCtx, &numKeys, &fullRes);
+            return numKeys;
+        };
+        ASSERT_EQUALS(numDocs, countKeys("a"));
+        ASSERT_EQUALS(2 * numDocs, countKeys("b"));
+        ASSERT_EQUALS(numDocs / 2, countKeys("c"));
+    }
+};
+
 /** Index creation is killed if mayInterrupt is true. */
 class InsertBuildIndexInterrupt : public IndexBuildBase {
 public:
@@ -730,6 +804,7 @@ public:
             add<InsertBuildEnforceUnique<true>>();
             add<InsertBuildEnforceUnique<false>>();
         }
+        add<InsertBuildMultipleIndexesConcurrently>();
         add<InsertBuildIndexInterrupt>();
         add<InsertBuildIdIndexInterrupt>();
         add<SameSpecDifferentOption>();
@@ -47,6 +47,24 @@ using std::vector;
 
 namespace mongo {
 
+namespace {
+
+/**
+ * Returns whether the fields of 'doc' named in the bounds fall in ['min', 'max'). An empty bound
+ * leaves that side of the range open.
+ */
+bool isWithinBounds(const BSONObj& doc, const BSONObj& min, const BSONObj& max) {
+    if (!min.isEmpty() && doc.extractFieldsUnDotted(min).woCompare(min, BSONObj(), false) < 0) {
+        return false;
+    }
+    if (!max.isEmpty() && doc.extractFieldsUnDotted(max).woCompare(max, BSONObj(), false) >= 0) {
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
 MockRemoteDBServer::CircularBSONIterator::CircularBSONIterator(const vector<BSONObj>& replyVector) {
     for (std::vector<mongo::BSONObj>::const_iterator iter = replyVector.begin();
          iter != replyVector.end();
@@ -196,9 +214,13 @@ mongo::BSONArray MockRemoteDBServer::query(MockRemoteDBServer::InstanceID id,
 
     auto ns = nsOrUuid.uuid() ? _uuidToNs[*nsOrUuid.uuid()] : nsOrUuid.nss()->ns();
     const vector<BSONObj>& coll = _dataMgr[ns];
+    const BSONObj min = query.obj.getObjectField("$min");
+    const BSONObj max = query.obj.getObjectField("$max");
     BSONArrayBuilder result;
     for (vector<BSONObj>::const_iterator iter = coll.begin(); iter != coll.end(); ++iter) {
-        result.append(iter->copy());
+        if (isWithinBounds(*iter, min, max)) {
+            result.append(iter->copy());
+        }
     }
 
     return BSONArray(result.obj());
@@ -161,6 +161,11 @@ public:
     //
     rpc::UniqueReply runCommand(InstanceID id, const OpMsgRequest& request);
 
+    /**
+     * Returns all the documents of the collection. The query is ignored, except for the index
+     * bounds set by Query::minKey() and Query::maxKey(), which only return the documents whose
+     * fields named in the bounds fall in [min, max).
+     */
     mongo::BSONArray query(InstanceID id,
                            const NamespaceStringOrUUID& nsOrUuid,
                            mongo::Query query = mongo::Query(),
@@ -33,24 +33,30 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "mongo/client/dbclient_cursor.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/repl/oplog.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/fail_point_service.h"
+#include "mongo/util/scopeguard.h"
 
 namespace query_stage_collection_scan {
 
@@ -144,6 +150,45 @@ public:
         }
     }
 
+    /**
+     * Runs a ParallelCollectionScan with 'filterObj' to completion and returns the values of the
+     * "foo" field of the documents it returned, sorted.
+     */
+    vector<int> getParallelScanResults(const BSONObj& filterObj, size_t* docsExamined) {
+        AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+        auto collection = ctx.getCollection();
+
+        const CollatorInterface* collator = nullptr;
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(filterObj, expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        WorkingSet ws;
+        ParallelCollectionScan scan(&_opCtx, collection, &ws, filterExpr.get());
+
+        vector<int> results;
+        while (!scan.isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = scan.work(&id);
+            ASSERT_NE(PlanStage::FAILURE, state);
+            if (PlanStage::ADVANCED == state) {
+                WorkingSetMember* member = ws.get(id);
+                ASSERT(member->hasRecordId());
+                results.push_back(member->obj.value()["foo"].numberInt());
+                ws.free(id);
+            }
+        }
+
+        auto stats = static_cast<const ParallelCollectionScanStats*>(scan.getSpecificStats());
+        *docsExamined = stats->docsTested;
+
+        std::sort(results.begin(), results.end());
+        return results;
+    }
+
     static int numObj() {
         return 50;
     }
@@ -157,6 +202,32 @@ private:
 };
 
 
+// Scan in parallel and get every matching document exactly once.
+TEST_F(QueryStageCollectionScanTest, QueryStageParallelCollscanReturnsEachMatchOnce) {
+    const auto originalThreads = internalQueryMaxParallelCollectionScanThreads.load();
+    const auto originalRecordsPerRound = internalQueryParallelCollectionScanRecordsPerRound.load();
+    ON_BLOCK_EXIT([&] {
+        internalQueryMaxParallelCollectionScanThreads.store(originalThreads);
+        internalQueryParallelCollectionScanRecordsPerRound.store(originalRecordsPerRound);
+    });
+    internalQueryMaxParallelCollectionScanThreads.store(4);
+    internalQueryParallelCollectionScanRecordsPerRound.store(3);
+
+    size_t docsExamined = 0;
+    vector<int> results = getParallelScanResults(BSON("foo" << BSON("$lt" << 25)), &docsExamined);
+
+    vector<int> expected;
+    for (int i = 0; i < 25; ++i) {
+        expected.push_back(i);
+    }
+    ASSERT(expected == results);
+    ASSERT_EQUALS(static_cast<size_t>(numObj()), docsExamined);
+
+    results = getParallelScanResults(BSONObj(), &docsExamined);
+    ASSERT_EQUALS(static_cast<size_t>(numObj()), results.size());
+    ASSERT_EQUALS(static_cast<size_t>(numObj()), docsExamined);
+}
+
 // Go forwards, get everything.
 TEST_F(QueryStageCollectionScanTest, QueryStageCollscanBasicForward) {
     ASSERT_EQUALS(numObj(), countResults(CollectionScanParams::FORWARD, BSONObj()));
@@ -238,6 +309,183 @@ TEST_F(QueryStageCollectionScanTest, QueryStageCollscanObjectsInOrderBackward) {
     ASSERT_EQUALS(numObj(), count);
 }
 
+// Get the matching objects in order when the scan is asked for batches of results.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanWorkBatchWithMatch) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.tailable = false;
+
+    const CollatorInterface* collator = nullptr;
+    const boost::intrusive_ptr<ExpressionContext> expCtx(new ExpressionContext(&_opCtx, collator));
+    StatusWithMatchExpression statusWithMatcher =
+        MatchExpressionParser::parse(BSON("foo" << BSON("$mod" << BSON_ARRAY(2 << 0))), expCtx);
+    ASSERT_OK(statusWithMatcher.getStatus());
+    unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+    WorkingSet ws;
+    CollectionScan scan(&_opCtx, collection, params, &ws, filterExpr.get());
+
+    int count = 0;
+    std::vector<WorkingSetID> batch;
+    while (!scan.isEOF()) {
+        batch.clear();
+        PlanStage::StageState state = scan.workBatch(8, &batch);
+        if (PlanStage::ADVANCED != state) {
+            ASSERT_TRUE(PlanStage::NEED_TIME == state || PlanStage::IS_EOF == state);
+            ASSERT_TRUE(batch.empty());
+            continue;
+        }
+
+        ASSERT_LTE(batch.size(), 8U);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            WorkingSetMember* member = ws.get(batch[i]);
+            ASSERT_TRUE(member->hasObj());
+            // Only the last result of a batch may still point into the storage engine cursor.
+            if (i + 1 < batch.size()) {
+                ASSERT_TRUE(member->obj.value().isOwned());
+            }
+            ASSERT_EQUALS(2 * count, member->obj.value()["foo"].numberInt());
+            ++count;
+            ws.free(batch[i]);
+        }
+    }
+    ASSERT_EQUALS(numObj() / 2, count);
+
+    // Every record, the creation of the cursor and EOF are each one unit of work. The records
+    // which do not match and the creation of the cursor need time.
+    const CommonStats* stats = scan.getCommonStats();
+    ASSERT_EQUALS(static_cast<size_t>(numObj() + 2), stats->works);
+    ASSERT_EQUALS(static_cast<size_t>(numObj() - count + 1), stats->needTime);
+    ASSERT_EQUALS(static_cast<size_t>(count), stats->advanced);
+    ASSERT_EQUALS(static_cast<size_t>(count), stats->batchedResults);
+    ASSERT_GTE(stats->batches, static_cast<size_t>(count) / 8);
+}
+
+// Get objects in the order we inserted them when the executor requests batches of results.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanObjectsInOrderForwardBatched) {
+    const int oldBatchSize = internalQueryExecBatchSize.load();
+    internalQueryExecBatchSize.store(16);
+    ON_BLOCK_EXIT([&] { internalQueryExecBatchSize.store(oldBatchSize); });
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.tailable = false;
+
+    unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
+    unique_ptr<PlanStage> ps =
+        std::make_unique<CollectionScan>(&_opCtx, collection, params, ws.get(), nullptr);
+
+    auto statusWithPlanExecutor = PlanExecutor::make(
+        &_opCtx, std::move(ws), std::move(ps), collection, PlanExecutor::NO_YIELD);
+    ASSERT_OK(statusWithPlanExecutor.getStatus());
+    auto exec = std::move(statusWithPlanExecutor.getValue());
+
+    int count = 0;
+    PlanExecutor::ExecState state;
+    for (BSONObj obj; PlanExecutor::ADVANCED == (state = exec->getNext(&obj, nullptr));) {
+        ASSERT_EQUALS(count, obj["foo"].numberInt());
+        ++count;
+    }
+    ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+    ASSERT_EQUALS(numObj(), count);
+}
+
+// Results from tailable scans are not batched, even when the executor may request batches.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanTailableIsNotBatched) {
+    const int oldBatchSize = internalQueryExecBatchSize.load();
+    internalQueryExecBatchSize.store(16);
+    ON_BLOCK_EXIT([&] { internalQueryExecBatchSize.store(oldBatchSize); });
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.tailable = true;
+
+    unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
+    unique_ptr<PlanStage> ps =
+        std::make_unique<CollectionScan>(&_opCtx, collection, params, ws.get(), nullptr);
+
+    auto statusWithPlanExecutor = PlanExecutor::make(
+        &_opCtx, std::move(ws), std::move(ps), collection, PlanExecutor::NO_YIELD);
+    ASSERT_OK(statusWithPlanExecutor.getStatus());
+    auto exec = std::move(statusWithPlanExecutor.getValue());
+
+    int count = 0;
+    for (BSONObj obj; PlanExecutor::ADVANCED == exec->getNext(&obj, nullptr);) {
+        ASSERT_EQUALS(count, obj["foo"].numberInt());
+        ++count;
+    }
+    ASSERT_EQUALS(numObj(), count);
+    ASSERT_EQUALS(0U, exec->getRootStage()->getCommonStats()->batches);
+}
+
+// The latest oplog timestamp reported by an oplog scan is that of the last result returned, not
+// that of a result read ahead into a batch.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanTrackLatestOplogTimestampIsNotBatched) {
+    // Skip the test if the storage engine doesn't support capped collections.
+    if (!getGlobalServiceContext()->getStorageEngine()->supportsCappedCollections()) {
+        return;
+    }
+
+    const int oldBatchSize = internalQueryExecBatchSize.load();
+    internalQueryExecBatchSize.store(16);
+    ON_BLOCK_EXIT([&] { internalQueryExecBatchSize.store(oldBatchSize); });
+
+    const NamespaceString oplogNss("local.oplog.rs");
+    {
+        dbtests::WriteContextForTests ctx(&_opCtx, oplogNss.ns());
+        WriteUnitOfWork wuow(&_opCtx);
+        CollectionOptions options;
+        options.capped = true;
+        options.cappedSize = 1024 * 1024;
+        Collection* oplog = ctx.db()->createCollection(&_opCtx, oplogNss, options);
+        OpDebug* const nullOpDebug = nullptr;
+        for (int i = 1; i <= numObj(); ++i) {
+            ASSERT_OK(oplog->insertDocument(
+                &_opCtx, InsertStatement(BSON("ts" << Timestamp(1000, i))), nullOpDebug));
+        }
+        wuow.commit();
+    }
+    ON_BLOCK_EXIT([&] {
+        dbtests::WriteContextForTests ctx(&_opCtx, oplogNss.ns());
+        _client.dropCollection(oplogNss.ns());
+    });
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, oplogNss);
+    auto collection = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.tailable = false;
+    params.shouldTrackLatestOplogTimestamp = true;
+    params.shouldWaitForOplogVisibility = true;
+
+    unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
+    unique_ptr<PlanStage> ps =
+        std::make_unique<CollectionScan>(&_opCtx, collection, params, ws.get(), nullptr);
+
+    auto statusWithPlanExecutor = PlanExecutor::make(
+        &_opCtx, std::move(ws), std::move(ps), collection, PlanExecutor::NO_YIELD);
+    ASSERT_OK(statusWithPlanExecutor.getStatus());
+    auto exec = std::move(statusWithPlanExecutor.getValue());
+
+    int count = 0;
+    for (BSONObj obj; PlanExecutor::ADVANCED == exec->getNext(&obj, nullptr);) {
+        ++count;
+        ASSERT_EQUALS(Timestamp(1000, count), obj["ts"].timestamp());
+        ASSERT_EQUALS(Timestamp(1000, count), exec->getLatestOplogTimestamp());
+    }
+    ASSERT_EQUALS(numObj(), count);
+}
+
 // Scan through half the objects, delete the one we're about to fetch, then expect to get the "next"
 // object we would have gotten after that.
 TEST_F(QueryStageCollectionScanTest, QueryStageCollscanDeleteUpcomingObject) {
@@ -34,6 +34,7 @@
 #include "mongo/platform/basic.h"
 
 #include <memory>
+#include <vector>
 
 #include "mongo/client/dbclient_cursor.h"
 #include "mongo/db/catalog/collection.h"
@@ -46,7 +47,9 @@
 #include "mongo/db/exec/queued_data_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/dbtests/dbtests.h"
+#include "mongo/util/scopeguard.h"
 
 namespace QueryStageFetch {
 
@@ -223,6 +226,151 @@ public:
     }
 };
 
+//
+// Test that reading ahead for prefetching returns every result, in the child's order, and still
+// stops to yield when the child asks it to.
+//
+class FetchStageReadAhead : public QueryStageFetchBase {
+public:
+    void run() {
+        const int oldBatchSize = internalQueryFetchPrefetchBatchSize.load();
+        ON_BLOCK_EXIT([&] { internalQueryFetchPrefetchBatchSize.store(oldBatchSize); });
+        internalQueryFetchPrefetchBatchSize.store(4);
+
+        dbtests::WriteContextForTests ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, nss());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, nss());
+            wuow.commit();
+        }
+
+        const int numDocs = 10;
+        for (int i = 0; i < numDocs; ++i) {
+            insert(BSON("foo" << i));
+        }
+        set<RecordId> recordIds;
+        getRecordIds(&recordIds, coll);
+        ASSERT_EQUALS(size_t(numDocs), recordIds.size());
+
+        // Queue the records in reverse order, with a yield request in the middle.
+        WorkingSet ws;
+        auto mockStage = std::make_unique<QueuedDataStage>(&_opCtx, &ws);
+        int queued = 0;
+        for (auto it = recordIds.rbegin(); it != recordIds.rend(); ++it) {
+            WorkingSetID id = ws.allocate();
+            WorkingSetMember* mockMember = ws.get(id);
+            mockMember->recordId = *it;
+            ws.transitionToRecordIdAndIdx(id);
+            mockStage->pushBack(id);
+            if (++queued == 6) {
+                mockStage->pushBack(PlanStage::NEED_YIELD);
+            }
+        }
+
+        auto fetchStage =
+            std::make_unique<FetchStage>(&_opCtx, &ws, mockStage.release(), nullptr, coll);
+
+        int expected = numDocs - 1;
+        int yields = 0;
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        PlanStage::StageState state;
+        while ((state = fetchStage->work(&id)) != PlanStage::IS_EOF) {
+            if (PlanStage::NEED_YIELD == state) {
+                ++yields;
+                continue;
+            }
+            if (PlanStage::ADVANCED == state) {
+                ASSERT_EQUALS(expected, ws.get(id)->obj.value()["foo"].numberInt());
+                --expected;
+            }
+        }
+
+        ASSERT_EQUALS(-1, expected);
+        ASSERT_EQUALS(1, yields);
+        auto stats = static_cast<const FetchStats*>(fetchStage->getSpecificStats());
+        ASSERT_EQUALS(size_t(numDocs), stats->docsPrefetched);
+    }
+};
+
+//
+// Test that results which were read ahead from the child no longer point into storage when the
+// child asks to yield before they are returned.
+//
+class FetchStageReadAheadOwnsBufferedObjects : public QueryStageFetchBase {
+public:
+    void run() {
+        const int oldBatchSize = internalQueryFetchPrefetchBatchSize.load();
+        ON_BLOCK_EXIT([&] { internalQueryFetchPrefetchBatchSize.store(oldBatchSize); });
+        internalQueryFetchPrefetchBatchSize.store(4);
+
+        dbtests::WriteContextForTests ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, nss());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, nss());
+            wuow.commit();
+        }
+
+        // Stands in for the storage which the unowned objects returned by the child point into.
+        std::vector<BSONObj> storage;
+        for (int i = 0; i < 2; ++i) {
+            storage.push_back(BSON("foo" << i));
+        }
+
+        // Queue two unowned objects, as an OR over fetched branches would return, followed by a
+        // yield request and one more result.
+        WorkingSet ws;
+        auto mockStage = std::make_unique<QueuedDataStage>(&_opCtx, &ws);
+        std::vector<WorkingSetID> bufferedIds;
+        for (int i = 0; i < 2; ++i) {
+            WorkingSetID id = ws.allocate();
+            WorkingSetMember* mockMember = ws.get(id);
+            mockMember->recordId = RecordId(i + 1);
+            mockMember->obj = Snapshotted<BSONObj>(SnapshotId(), BSONObj(storage[i].objdata()));
+            ws.transitionToRecordIdAndObj(id);
+            ASSERT_FALSE(mockMember->obj.value().isOwned());
+            mockStage->pushBack(id);
+            bufferedIds.push_back(id);
+        }
+        mockStage->pushBack(PlanStage::NEED_YIELD);
+        {
+            WorkingSetID id = ws.allocate();
+            WorkingSetMember* mockMember = ws.get(id);
+            mockMember->recordId = RecordId(3);
+            mockMember->obj = Snapshotted<BSONObj>(SnapshotId(), BSON("foo" << 2));
+            mockMember->transitionToOwnedObj();
+            mockStage->pushBack(id);
+        }
+
+        auto fetchStage =
+            std::make_unique<FetchStage>(&_opCtx, &ws, mockStage.release(), nullptr, coll);
+
+        // The first call reads ahead the first two results and then stops for the yield.
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        ASSERT_EQUALS(PlanStage::NEED_YIELD, fetchStage->work(&id));
+        for (auto bufferedId : bufferedIds) {
+            ASSERT_TRUE(ws.get(bufferedId)->obj.value().isOwned());
+        }
+
+        // Whatever the unowned objects pointed into is gone after the yield.
+        storage.clear();
+
+        int expected = 0;
+        PlanStage::StageState state;
+        while ((state = fetchStage->work(&id)) != PlanStage::IS_EOF) {
+            ASSERT_NOT_EQUALS(PlanStage::NEED_YIELD, state);
+            if (PlanStage::ADVANCED == state) {
+                ASSERT_EQUALS(expected, ws.get(id)->obj.value()["foo"].numberInt());
+                ++expected;
+            }
+        }
+        ASSERT_EQUALS(3, expected);
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_fetch") {}
@@ -230,6 +378,8 @@ public:
     void setupTests() {
         add<FetchStageAlreadyFetched>();
         add<FetchStageFilter>();
+        add<FetchStageReadAhead>();
+        add<FetchStageReadAheadOwnsBufferedObjects>();
     }
 };
 
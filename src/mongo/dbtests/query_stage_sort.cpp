@@ -40,11 +40,15 @@
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/queued_data_stage.h"
 #include "mongo/db/exec/sort.h"
 #include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_always_boolean.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/dbtests/dbtests.h"
+#include "mongo/util/scopeguard.h"
 
 /**
  * This file tests db/exec/sort.cpp
@@ -576,6 +580,177 @@ public:
     }
 };
 
+// A sort which exceeds its memory limit with allowDiskUse set should spill sorted runs to disk and
+// still return every result in order.
+template <int LIMIT>
+class QueryStageSortSpillsToDisk : public QueryStageSortTestBase {
+public:
+    virtual int numObj() {
+        return 2000;
+    }
+
+    virtual int limit() const {
+        return LIMIT;
+    }
+
+    void run() {
+        const int oldMaxBlockingSortBytes = internalQueryExecMaxBlockingSortBytes.load();
+        ON_BLOCK_EXIT(
+            [&] { internalQueryExecMaxBlockingSortBytes.store(oldMaxBlockingSortBytes); });
+        internalQueryExecMaxBlockingSortBytes.store(16 * 1024);
+
+        dbtests::WriteContextForTests ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, nss());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, nss());
+            wuow.commit();
+        }
+
+        const std::string padding(100, 'x');
+        for (int i = 0; i < numObj(); ++i) {
+            insert(BSON("foo" << (i * 7919) % numObj() << "padding" << padding));
+        }
+
+        auto ws = std::make_unique<WorkingSet>();
+        auto queuedDataStage = std::make_unique<QueuedDataStage>(&_opCtx, ws.get());
+        insertVarietyOfObjects(ws.get(), queuedDataStage.get(), coll);
+
+        SortStageParams params;
+        params.pattern = BSON("foo" << 1);
+        params.limit = limit();
+        params.allowDiskUse = true;
+
+        auto keyGenStage = std::make_unique<SortKeyGeneratorStage>(
+            &_opCtx, queuedDataStage.release(), ws.get(), params.pattern, nullptr);
+        auto sortStage =
+            std::make_unique<SortStage>(&_opCtx, params, ws.get(), keyGenStage.release());
+        SortStage* sort = sortStage.get();
+        auto fetchStage =
+            std::make_unique<FetchStage>(&_opCtx, ws.get(), sortStage.release(), nullptr, coll);
+
+        auto statusWithPlanExecutor = PlanExecutor::make(
+            &_opCtx, std::move(ws), std::move(fetchStage), coll, PlanExecutor::NO_YIELD);
+        ASSERT_OK(statusWithPlanExecutor.getStatus());
+        auto exec = std::move(statusWithPlanExecutor.getValue());
+
+        int count = 0;
+        BSONObj obj;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, nullptr))) {
+            ASSERT_EQUALS(count, obj["foo"].numberInt());
+            ++count;
+        }
+        ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+        checkCount(count);
+
+        auto stats = static_cast<const SortStats*>(sort->getSpecificStats());
+        ASSERT_TRUE(stats->usedDisk);
+        ASSERT_GT(stats->spills, 0u);
+    }
+};
+
+// Results returned from disk should still carry their sort key, for a $sortKey projection above.
+class QueryStageSortSpilledResultsKeepSortKey : public QueryStageSortTestBase {
+public:
+    virtual int numObj() {
+        return 2000;
+    }
+
+    void run() {
+        const int oldMaxBlockingSortBytes = internalQueryExecMaxBlockingSortBytes.load();
+        ON_BLOCK_EXIT(
+            [&] { internalQueryExecMaxBlockingSortBytes.store(oldMaxBlockingSortBytes); });
+        internalQueryExecMaxBlockingSortBytes.store(16 * 1024);
+
+        dbtests::WriteContextForTests ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, nss());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, nss());
+            wuow.commit();
+        }
+
+        const std::string padding(100, 'x');
+        for (int i = 0; i < numObj(); ++i) {
+            insert(BSON("foo" << (i * 7919) % numObj() << "padding" << padding));
+        }
+
+        auto ws = std::make_unique<WorkingSet>();
+        auto queuedDataStage = std::make_unique<QueuedDataStage>(&_opCtx, ws.get());
+        insertVarietyOfObjects(ws.get(), queuedDataStage.get(), coll);
+
+        SortStageParams params;
+        params.pattern = BSON("foo" << 1);
+        params.allowDiskUse = true;
+
+        auto keyGenStage = std::make_unique<SortKeyGeneratorStage>(
+            &_opCtx, queuedDataStage.release(), ws.get(), params.pattern, nullptr);
+        auto sortStage =
+            std::make_unique<SortStage>(&_opCtx, params, ws.get(), keyGenStage.release());
+        SortStage* sort = sortStage.get();
+
+        AlwaysTrueMatchExpression matchAll;
+        auto projectionStage = std::make_unique<ProjectionStageDefault>(
+            &_opCtx,
+            fromjson("{_id: 0, foo: 1, key: {$meta: 'sortKey'}}"),
+            ws.get(),
+            std::move(sortStage),
+            matchAll,
+            nullptr);
+
+        auto statusWithPlanExecutor = PlanExecutor::make(
+            &_opCtx, std::move(ws), std::move(projectionStage), coll, PlanExecutor::NO_YIELD);
+        ASSERT_OK(statusWithPlanExecutor.getStatus());
+        auto exec = std::move(statusWithPlanExecutor.getValue());
+
+        int count = 0;
+        BSONObj obj;
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, nullptr))) {
+            ASSERT_BSONOBJ_EQ(BSON("foo" << count << "key" << BSON("" << count)), obj);
+            ++count;
+        }
+        ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+        ASSERT_EQUALS(numObj(), count);
+
+        auto stats = static_cast<const SortStats*>(sort->getSpecificStats());
+        ASSERT_TRUE(stats->usedDisk);
+    }
+};
+
+// A sort which exceeds its memory limit without allowDiskUse should fail.
+class QueryStageSortFailsWithoutAllowDiskUse : public QueryStageSortTestBase {
+public:
+    virtual int numObj() {
+        return 2000;
+    }
+
+    void run() {
+        const int oldMaxBlockingSortBytes = internalQueryExecMaxBlockingSortBytes.load();
+        ON_BLOCK_EXIT(
+            [&] { internalQueryExecMaxBlockingSortBytes.store(oldMaxBlockingSortBytes); });
+        internalQueryExecMaxBlockingSortBytes.store(16 * 1024);
+
+        dbtests::WriteContextForTests ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll = db->getCollection(&_opCtx, nss());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, nss());
+            wuow.commit();
+        }
+
+        fillData();
+        auto exec = makePlanExecutorWithSortStage(coll);
+
+        BSONObj obj;
+        ASSERT_EQUALS(PlanExecutor::FAILURE, exec->getNext(&obj, nullptr));
+    }
+};
+
 class All : public Suite {
 public:
     All() : Suite("query_stage_sort") {}
@@ -593,6 +768,10 @@ public:
         add<QueryStageSortDeletionInvalidationWithLimit<10>>();
         add<QueryStageSortDeletionInvalidationWithLimit<1>>();
         add<QueryStageSortParallelArrays>();
+        add<QueryStageSortSpillsToDisk<0>>();
+        add<QueryStageSortSpillsToDisk<500>>();
+        add<QueryStageSortSpilledResultsKeepSortKey>();
+        add<QueryStageSortFailsWithoutAllowDiskUse>();
     }
 };
 
@@ -30,11 +30,15 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
 
 #include "mongo/base/data_type_endian.h"
 #include "mongo/base/data_view.h"
 #include "mongo/base/encoded_value_storage.h"
 #include "mongo/base/static_assert.h"
+#include "mongo/util/shared_buffer.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
@@ -392,9 +396,33 @@ inline int ConstView::dataLen() const {
 
 class Message {
 public:
+    /**
+     * A range of bytes that belongs to the message but lives in a buffer owned by someone else,
+     * such as the documents of a query result batch. It is logically inserted into the message
+     * at 'offset' bytes into the head buffer.
+     */
+    struct Splice {
+        size_t offset;
+        ConstSharedBuffer owner;
+        const char* data;
+        size_t len;
+    };
+
     Message() = default;
     explicit Message(SharedBuffer data) : _buf(std::move(data)) {}
 
+    /**
+     * Builds a message whose bytes are 'head' with 'splices' inserted into it, so that they can be
+     * written to the network with a gather write instead of being copied together first. The
+     * header in 'head' must already account for the spliced bytes, and 'splices' must be ordered
+     * by offset.
+     */
+    Message(SharedBuffer head, std::vector<Splice> splices) : _buf(std::move(head)) {
+        if (!splices.empty()) {
+            _splices = std::make_shared<const std::vector<Splice>>(std::move(splices));
+        }
+    }
+
     MsgData::View header() const {
         verify(!empty());
         return _buf.get();
@@ -406,9 +434,44 @@ public:
 
     MsgData::View singleData() const {
         massert(13273, "single data buffer expected", _buf);
+        _flatten();
         return header();
     }
 
+    /**
+     * Returns whether some of this message's bytes live outside its head buffer. Accessing the
+     * message as a single buffer (buf(), singleData(), sharedBuffer()) copies them into one.
+     */
+    bool isSpliced() const {
+        return bool(_splices);
+    }
+
+    /**
+     * Calls 'cb(const char* data, size_t len)' for each contiguous piece of the message, in wire
+     * order, without copying spliced bytes.
+     */
+    template <typename Callback>
+    void forEachSegment(Callback&& cb) const {
+        if (!_splices) {
+            cb(_buf.get(), size_t(size()));
+            return;
+        }
+
+        size_t headOffset = 0;
+        for (const auto& splice : *_splices) {
+            if (splice.offset > headOffset) {
+                cb(_buf.get() + headOffset, splice.offset - headOffset);
+                headOffset = splice.offset;
+            }
+            cb(splice.data, splice.len);
+        }
+
+        const auto headLen = size_t(size()) - _splicedBytes();
+        if (headLen > headOffset) {
+            cb(_buf.get() + headOffset, headLen - headOffset);
+        }
+    }
+
     bool empty() const {
         return !_buf;
     }
@@ -429,11 +492,13 @@ public:
     }
 
     void realloc(size_t size) {
+        _flatten();
         _buf.reallocOrCopy(size);
     }
 
     void reset() {
         _buf = {};
+        _splices.reset();
     }
 
     // use to set first buffer if empty
@@ -456,23 +521,58 @@ public:
     }
 
     char* buf() {
+        _flatten();
         return _buf.get();
     }
 
     const char* buf() const {
+        _flatten();
         return _buf.get();
     }
 
     SharedBuffer sharedBuffer() {
+        _flatten();
         return _buf;
     }
 
     ConstSharedBuffer sharedBuffer() const {
+        _flatten();
         return _buf;
     }
 
 private:
-    SharedBuffer _buf;
+    size_t _splicedBytes() const {
+        size_t total = 0;
+        for (const auto& splice : *_splices) {
+            total += splice.len;
+        }
+        return total;
+    }
+
+    /**
+     * Copies any spliced bytes into a single buffer. This changes how the message is stored but
+     * not its contents, so it is allowed on const messages.
+     */
+    void _flatten() const {
+        if (!_splices) {
+            return;
+        }
+
+        const auto total = size_t(size());
+        auto flat = SharedBuffer::allocate(total);
+        size_t pos = 0;
+        forEachSegment([&](const char* data, size_t len) {
+            memcpy(flat.get() + pos, data, len);
+            pos += len;
+        });
+        invariant(pos == total);
+
+        _buf = std::move(flat);
+        _splices.reset();
+    }
+
+    mutable SharedBuffer _buf;
+    mutable std::shared_ptr<const std::vector<Splice>> _splices;
 };
 
 /**
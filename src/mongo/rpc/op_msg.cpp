@@ -83,8 +83,8 @@ uint32_t OpMsg::flags(const Message& message) {
     if (message.operation() != dbMsg)
         return 0;  // Other command protocols are the same as no flags set.
 
-    return BufReader(message.singleData().data(), message.dataSize())
-        .read<LittleEndian<uint32_t>>();
+    // The flags always live in the head buffer, so reading them never flattens a spliced reply.
+    return BufReader(message.header().data(), message.dataSize()).read<LittleEndian<uint32_t>>();
 }
 
 void OpMsg::replaceFlags(Message* message, uint32_t flags) {
@@ -92,7 +92,7 @@ void OpMsg::replaceFlags(Message* message, uint32_t flags) {
     invariant(message->operation() == dbMsg);
     invariant(message->dataSize() >= static_cast<int>(sizeof(uint32_t)));
 
-    DataView(message->singleData().data()).write<LittleEndian<uint32_t>>(flags);
+    DataView(message->header().data()).write<LittleEndian<uint32_t>>(flags);
 }
 
 uint32_t OpMsg::getChecksum(const Message& message) {
@@ -292,13 +292,42 @@ Message OpMsgBuilder::finish() {
     invariant(!_openBuilder);
     _state = kDone;
 
-    const auto size = _buf.len();
+    const auto size = _buf.len() + _splicedBytes;
     MSGHEADER::View header(_buf.buf());
     header.setMessageLength(size);
     // header.setRequestMsgId(...); // These are currently filled in by the networking layer.
     // header.setResponseToMsgId(...);
     header.setOpCode(dbMsg);
-    return Message(_buf.release());
+
+    if (_splices.empty()) {
+        return Message(_buf.release());
+    }
+
+    // Every splice is inside the body, so its size grows by all of them.
+    _growObjectSize(_bodyStart, _splicedBytes);
+    for (const auto& fixup : _splicedObjectFixups) {
+        _growObjectSize(fixup.first, fixup.second);
+    }
+    return Message(_buf.release(), std::move(_splices));
+}
+
+void OpMsgBuilder::spliceIntoBody(ConstSharedBuffer owner, const char* data, size_t len) {
+    invariant(_state == kBody);
+    invariant(_splices.empty() || _splices.back().offset <= size_t(_buf.len()));
+    _splices.push_back({size_t(_buf.len()), std::move(owner), data, len});
+    _splicedBytes += len;
+}
+
+void OpMsgBuilder::growSplicedObject(int offset, int bytes) {
+    invariant(_state == kBody);
+    invariant(offset > _bodyStart);
+    _splicedObjectFixups.emplace_back(offset, bytes);
+}
+
+void OpMsgBuilder::_growObjectSize(int offset, int bytes) {
+    DataView view(_buf.buf());
+    const auto size = view.read<LittleEndian<int32_t>>(offset);
+    view.write<LittleEndian<int32_t>>(size + bytes, offset);
 }
 
 BSONObj OpMsgBuilder::releaseBody() {
@@ -306,8 +335,17 @@ BSONObj OpMsgBuilder::releaseBody() {
     invariant(_bodyStart);
     invariant(_bodyStart == sizeof(MSGHEADER::Layout) + 4 /*flags*/ + 1 /*body kind byte*/);
     invariant(!_openBuilder);
-    _state = kDone;
 
+    if (!_splices.empty()) {
+        // The body is returned as a single object, so the spliced bytes must be copied into it.
+        // Nothing precedes the body, so it starts at the same offset in the flattened message.
+        const auto bodyStart = _bodyStart;
+        auto message = finish();
+        auto flat = message.sharedBuffer();
+        return BSONObj(flat.get() + bodyStart).shareOwnershipWith(std::move(flat));
+    }
+
+    _state = kDone;
     auto bson = BSONObj(_buf.buf() + _bodyStart);
     return bson.shareOwnershipWith(_buf.release());
 }
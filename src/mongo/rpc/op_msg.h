@@ -238,6 +238,30 @@ public:
      */
     Message finish();
 
+    /**
+     * Makes the 'len' bytes at 'data', kept alive by 'owner', appear at the current end of the
+     * body without copying them. The returned Message carries them as splices.
+     *
+     * The bytes are not visible in the builder's buffer: until finish(), the sizes of the body and
+     * of any object containing spliced bytes only count the bytes that were actually appended.
+     * Callers must register each such nested object with growSplicedObject(), and must not read
+     * spliced parts of the body back out before finish() or releaseBody(), which copies them in.
+     */
+    void spliceIntoBody(ConstSharedBuffer owner, const char* data, size_t len);
+
+    /**
+     * Adds 'bytes' to the size of the BSON object or array starting at 'offset' in the body when
+     * the message is finished. Used for nested objects that contain spliced bytes.
+     */
+    void growSplicedObject(int offset, int bytes);
+
+    /**
+     * Returns the number of bytes spliced into the body so far.
+     */
+    size_t splicedBytes() const {
+        return _splicedBytes;
+    }
+
     /**
      * Reset this object to its initial empty state. All previously appended data is lost.
      */
@@ -249,6 +273,9 @@ public:
         _bodyStart = 0;
         _state = kEmpty;
         _openBuilder = false;
+        _splices.clear();
+        _splicedObjectFixups.clear();
+        _splicedBytes = 0;
     }
 
     /**
@@ -295,11 +322,16 @@ private:
         _buf.appendNum(uint32_t(0));           // flags (currently always 0).
     }
 
+    void _growObjectSize(int offset, int bytes);
+
     // When adding members, remember to update reset().
     BufBuilder _buf;
     int _bodyStart = 0;
     State _state = kEmpty;
     bool _openBuilder = false;
+    std::vector<Message::Splice> _splices;
+    std::vector<std::pair<int, int>> _splicedObjectFixups;  // (offset, bytes) of nested objects.
+    size_t _splicedBytes = 0;
 };
 
 /**
@@ -66,6 +66,15 @@ public:
     OpMsgBuilder::DocSequenceBuilder getDocSequenceBuilder(StringData name) override {
         return _builder.beginDocSequence(name);
     }
+    bool supportsSplicing() const override {
+        return true;
+    }
+    void spliceIntoBody(ConstSharedBuffer owner, const char* data, size_t len) override {
+        _builder.spliceIntoBody(std::move(owner), data, len);
+    }
+    void growSplicedObject(int offset, int bytes) override {
+        _builder.growSplicedObject(offset, bytes);
+    }
     rpc::Protocol getProtocol() const override {
         return rpc::Protocol::kOpMsg;
     }
@@ -805,6 +805,95 @@ TEST(OpMsgSerializer, BodyAndInPlaceSequenceInPlaceWithReset) {
                    });
 }
 
+TEST(OpMsgSerializer, BodyWithSplicedDocuments) {
+    const auto doc = fromjson("{a: 1, b: 'spliced'}");
+    OpMsgBuilder builder;
+
+    {
+        auto body = builder.beginBody();
+        body.append("ping", 1);
+        auto& arrayBuf = body.subarrayStart("docs");
+        const int arrayOffset = arrayBuf.len();
+        BSONArrayBuilder docs(arrayBuf);
+        for (int i = 0; i < 2; i++) {
+            docs.subobjStart();
+            builder.spliceIntoBody(doc.sharedBuffer(), doc.objdata(), doc.objsize());
+        }
+        docs.done();
+        builder.growSplicedObject(arrayOffset, 2 * doc.objsize());
+    }
+    builder.resumeBody().append("$db", "foo");
+    ASSERT_EQ(builder.splicedBytes(), size_t(2 * doc.objsize()));
+
+    auto msg = builder.finish();
+    ASSERT(msg.isSpliced());
+
+    // The head buffer is split around both documents, which are referenced rather than copied.
+    std::vector<const char*> segments;
+    size_t total = 0;
+    msg.forEachSegment([&](const char* data, size_t len) {
+        segments.push_back(data);
+        total += len;
+    });
+    ASSERT_EQ(segments.size(), 5u);
+    ASSERT_EQ(segments[1], doc.objdata());
+    ASSERT_EQ(segments[3], doc.objdata());
+    ASSERT_EQ(total, size_t(msg.size()));
+
+    // Reading the flags only needs the head buffer.
+    ASSERT_EQ(OpMsg::flags(msg), kNoFlags);
+    ASSERT(msg.isSpliced());
+
+    testSerializer(msg,
+                   OpMsgBytes{
+                       kNoFlags,  //
+                       kBodySection,
+                       BSON("ping" << 1 << "docs" << BSON_ARRAY(doc << doc) << "$db"
+                                   << "foo"),
+                   });
+    ASSERT(!msg.isSpliced());
+}
+
+TEST(OpMsgSerializer, ReleaseBodyCopiesSplicedDocuments) {
+    const auto doc = fromjson("{a: 1, b: 'spliced'}");
+    OpMsgBuilder builder;
+    {
+        auto body = builder.beginBody();
+        body.append("ping", 1);
+        body.bb().appendNum(char(Object));
+        body.bb().appendStr("doc");
+        builder.spliceIntoBody(doc.sharedBuffer(), doc.objdata(), doc.objsize());
+    }
+    builder.resumeBody().append("$db", "foo");
+
+    ASSERT_BSONOBJ_EQ(builder.releaseBody(),
+                      BSON("ping" << 1 << "doc" << doc << "$db"
+                                  << "foo"));
+}
+
+TEST(OpMsgSerializer, ResetDropsSplicedDocuments) {
+    const auto doc = fromjson("{a: 1}");
+    OpMsgBuilder builder;
+    {
+        auto body = builder.beginBody();
+        body.append("first", 1);
+        body.bb().appendNum(char(Object));
+        body.bb().appendStr("doc");
+        builder.spliceIntoBody(doc.sharedBuffer(), doc.objdata(), doc.objsize());
+    }
+    builder.reset();
+
+    builder.beginBody().append("ping", 1);
+    auto msg = builder.finish();
+    ASSERT(!msg.isSpliced());
+    testSerializer(msg,
+                   OpMsgBytes{
+                       kNoFlags,  //
+                       kBodySection,
+                       fromjson("{ping: 1}"),
+                   });
+}
+
 TEST(OpMsgSerializer, ReplaceFlagsWorks) {
     {
         auto msg = OpMsgBytes{~0u}.done();
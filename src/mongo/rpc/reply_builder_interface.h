@@ -35,6 +35,8 @@
 #include "mongo/bson/util/builder.h"
 #include "mongo/rpc/op_msg.h"
 #include "mongo/rpc/protocol.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/shared_buffer.h"
 
 namespace mongo {
 class BSONObj;
@@ -76,6 +78,28 @@ public:
         uasserted(50875, "Only OpMsg may use document sequences");
     }
 
+    /**
+     * Returns true if this builder can reference externally owned bytes from its body rather than
+     * copying them, via spliceIntoBody() and growSplicedObject().
+     */
+    virtual bool supportsSplicing() const {
+        return false;
+    }
+
+    /**
+     * See OpMsgBuilder::spliceIntoBody(). Only legal if supportsSplicing() returns true.
+     */
+    virtual void spliceIntoBody(ConstSharedBuffer owner, const char* data, size_t len) {
+        MONGO_UNREACHABLE;
+    }
+
+    /**
+     * See OpMsgBuilder::growSplicedObject(). Only legal if supportsSplicing() returns true.
+     */
+    virtual void growSplicedObject(int offset, int bytes) {
+        MONGO_UNREACHABLE;
+    }
+
     /**
      * Sets the reply for this command. If an engaged StatusWith<BSONObj> is passed, the command
      * reply will be set to the contained BSONObj, augmented with the element {ok, 1.0} if it
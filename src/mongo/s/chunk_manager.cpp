@@ -33,6 +33,8 @@
 
 #include "mongo/s/chunk_manager.h"
 
+#include <numeric>
+
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/db/matcher/extensions_callback_noop.h"
@@ -50,6 +52,13 @@ namespace {
 // Used to generate sequence numbers to assign to each newly created RoutingTableHistory
 AtomicWord<unsigned> nextCMSequenceNumber(0);
 
+// Maximum number of entries in a ChunkInfoMap segment. Larger segments are split in half.
+const size_t kMaxChunkInfoMapSegmentSize = 256;
+
+// Number of chunks a batched lookup steps over to reach the chunk of its next sorted key before it
+// falls back to a search of the chunk map.
+const int kMaxBatchedLookupLinearSteps = 8;
+
 void checkAllElementsAreOfType(BSONType type, const BSONObj& o) {
     for (auto&& element : o) {
         uassert(ErrorCodes::ConflictingOperationInProgress,
@@ -68,15 +77,199 @@ std::string extractKeyStringInternal(const BSONObj& shardKeyValue, Ordering orde
     return {ks.getBuffer(), ks.getSize()};
 }
 
+void checkChunksAreAdjacent(const ChunkInfo& left, const ChunkInfo& right) {
+    if (SimpleBSONObjComparator::kInstance.evaluate(left.getMax() == right.getMin()))
+        return;
+
+    if (SimpleBSONObjComparator::kInstance.evaluate(left.getMax() < right.getMin()))
+        uasserted(ErrorCodes::ConflictingOperationInProgress,
+                  str::stream() << "Gap exists in the routing table between chunks "
+                                << left.getRange().toString()
+                                << " and "
+                                << right.getRange().toString());
+    else
+        uasserted(ErrorCodes::ConflictingOperationInProgress,
+                  str::stream() << "Overlap exists in the routing table between chunks "
+                                << left.getRange().toString()
+                                << " and "
+                                << right.getRange().toString());
+}
+
+/**
+ * Checks the continuity of the chunks map on both sides of the chunk at 'it'.
+ */
+void checkContinuity(const ChunkInfoMap& chunkMap, ChunkInfoMap::const_iterator it) {
+    if (it != chunkMap.begin()) {
+        checkChunksAreAdjacent(*std::prev(it)->second, *it->second);
+    }
+    const auto next = std::next(it);
+    if (next != chunkMap.end()) {
+        checkChunksAreAdjacent(*it->second, *next->second);
+    }
+}
+
 }  // namespace
 
+ChunkInfoMap::const_iterator& ChunkInfoMap::const_iterator::operator++() {
+    if (++_pos == _map->_segments[_segment]->size()) {
+        ++_segment;
+        _pos = 0;
+    }
+    return *this;
+}
+
+ChunkInfoMap::const_iterator& ChunkInfoMap::const_iterator::operator--() {
+    if (_pos == 0) {
+        --_segment;
+        _pos = _map->_segments[_segment]->size();
+    }
+    --_pos;
+    return *this;
+}
+
+ChunkInfoMap::const_iterator ChunkInfoMap::upper_bound(const key_type& key) const {
+    const auto segmentIt =
+        std::upper_bound(_segments.begin(),
+                         _segments.end(),
+                         key,
+                         [](const key_type& key, const std::shared_ptr<Segment>& segment) {
+                             return key < segment->back().first;
+                         });
+    if (segmentIt == _segments.end()) {
+        return end();
+    }
+
+    const auto& segment = **segmentIt;
+    const auto pos = std::upper_bound(
+        segment.begin(), segment.end(), key, [](const key_type& key, const value_type& entry) {
+            return key < entry.first;
+        });
+    return {this,
+            static_cast<size_t>(segmentIt - _segments.begin()),
+            static_cast<size_t>(pos - segment.begin())};
+}
+
+ChunkInfoMap::const_iterator ChunkInfoMap::lower_bound(const key_type& key) const {
+    const auto segmentIt =
+        std::lower_bound(_segments.begin(),
+                         _segments.end(),
+                         key,
+                         [](const std::shared_ptr<Segment>& segment, const key_type& key) {
+                             return segment->back().first < key;
+                         });
+    if (segmentIt == _segments.end()) {
+        return end();
+    }
+
+    const auto& segment = **segmentIt;
+    const auto pos = std::lower_bound(
+        segment.begin(), segment.end(), key, [](const value_type& entry, const key_type& key) {
+            return entry.first < key;
+        });
+    return {this,
+            static_cast<size_t>(segmentIt - _segments.begin()),
+            static_cast<size_t>(pos - segment.begin())};
+}
+
+void ChunkInfoMap::insert(value_type value) {
+    if (_segments.empty()) {
+        _segments.push_back(std::make_shared<Segment>(1, std::move(value)));
+        _size = 1;
+        return;
+    }
+
+    // The entry belongs to the first segment whose last key is not less than its key, or at the
+    // end of the last segment if there is no such segment.
+    auto it = lower_bound(value.first);
+    if (it != end() && it->first == value.first) {
+        return;
+    }
+    if (it == end()) {
+        it = {this, _segments.size() - 1, _segments.back()->size()};
+    }
+
+    auto& segment = _mutableSegment(it._segment);
+    segment.insert(segment.begin() + it._pos, std::move(value));
+    ++_size;
+
+    if (segment.size() > kMaxChunkInfoMapSegmentSize) {
+        const auto middle = segment.begin() + segment.size() / 2;
+        auto upperHalf = std::make_shared<Segment>(std::make_move_iterator(middle),
+                                                   std::make_move_iterator(segment.end()));
+        segment.erase(middle, segment.end());
+        _segments.insert(_segments.begin() + it._segment + 1, std::move(upperHalf));
+    }
+}
+
+void ChunkInfoMap::erase(const_iterator first, const_iterator last) {
+    if (first == last) {
+        return;
+    }
+
+    const size_t firstSegment = first._segment;
+    const size_t lastSegment = last._segment;
+    if (firstSegment == lastSegment) {
+        auto& segment = _mutableSegment(firstSegment);
+        segment.erase(segment.begin() + first._pos, segment.begin() + last._pos);
+        _size -= last._pos - first._pos;
+    } else {
+        // Trim the tail of the first segment and the head of the last one, and drop every
+        // segment in between without touching its entries.
+        auto& head = _mutableSegment(firstSegment);
+        _size -= head.size() - first._pos;
+        head.erase(head.begin() + first._pos, head.end());
+
+        if (lastSegment < _segments.size() && last._pos > 0) {
+            auto& tail = _mutableSegment(lastSegment);
+            tail.erase(tail.begin(), tail.begin() + last._pos);
+            _size -= last._pos;
+        }
+
+        for (size_t i = firstSegment + 1; i < lastSegment; ++i) {
+            _size -= _segments[i]->size();
+        }
+        _segments.erase(_segments.begin() + firstSegment + 1, _segments.begin() + lastSegment);
+    }
+
+    if (_segments[firstSegment]->empty()) {
+        _segments.erase(_segments.begin() + firstSegment);
+    } else {
+        _mergeWithNext(firstSegment);
+    }
+    if (firstSegment > 0) {
+        _mergeWithNext(firstSegment - 1);
+    }
+}
+
+ChunkInfoMap::Segment& ChunkInfoMap::_mutableSegment(size_t index) {
+    auto& segment = _segments[index];
+    if (segment.use_count() > 1) {
+        segment = std::make_shared<Segment>(*segment);
+    }
+    return *segment;
+}
+
+void ChunkInfoMap::_mergeWithNext(size_t index) {
+    if (index + 1 >= _segments.size() ||
+        _segments[index]->size() + _segments[index + 1]->size() > kMaxChunkInfoMapSegmentSize / 2) {
+        return;
+    }
+
+    auto& segment = _mutableSegment(index);
+    const auto& next = *_segments[index + 1];
+    segment.insert(segment.end(), next.begin(), next.end());
+    _segments.erase(_segments.begin() + index + 1);
+}
+
 RoutingTableHistory::RoutingTableHistory(NamespaceString nss,
                                          boost::optional<UUID> uuid,
                                          KeyPattern shardKeyPattern,
                                          std::unique_ptr<CollatorInterface> defaultCollator,
                                          bool unique,
                                          ChunkInfoMap chunkMap,
-                                         ChunkVersion collectionVersion)
+                                         ChunkVersion collectionVersion,
+                                         ShardVersionMap shardVersions,
+                                         ShardChunksInfoMap shardChunksInfo)
     : _sequenceNumber(nextCMSequenceNumber.addAndFetch(1)),
       _nss(std::move(nss)),
       _uuid(uuid),
@@ -86,7 +279,8 @@ RoutingTableHistory::RoutingTableHistory(NamespaceString nss,
       _unique(unique),
       _chunkMap(std::move(chunkMap)),
       _collectionVersion(collectionVersion),
-      _shardVersions(_constructShardVersionMap()) {}
+      _shardVersions(std::move(shardVersions)),
+      _shardChunksInfo(std::move(shardChunksInfo)) {}
 
 Chunk ChunkManager::findIntersectingChunk(const BSONObj& shardKey, const BSONObj& collation) const {
     const bool hasSimpleCollation = (collation.isEmpty() && !_rt->getDefaultCollator()) ||
@@ -108,6 +302,46 @@ Chunk ChunkManager::findIntersectingChunk(const BSONObj& shardKey, const BSONObj
     return Chunk(*(it->second), _clusterTime);
 }
 
+std::vector<boost::optional<Chunk>> ChunkManager::findIntersectingChunksWithSimpleCollation(
+    const std::vector<BSONObj>& shardKeys) const {
+    const auto& chunkMap = _rt->getChunkMap();
+
+    std::vector<std::string> keyStrings;
+    keyStrings.reserve(shardKeys.size());
+    for (const auto& shardKey : shardKeys) {
+        keyStrings.push_back(_rt->_extractKeyString(shardKey));
+    }
+
+    std::vector<size_t> order(shardKeys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&keyStrings](size_t lhs, size_t rhs) {
+        return keyStrings[lhs] < keyStrings[rhs];
+    });
+
+    std::vector<boost::optional<Chunk>> chunks(shardKeys.size());
+
+    // The sorted keys only move forward through the chunk map and most of them fall into the chunk
+    // of the previous key or one shortly after it, so step towards it before resorting to a search.
+    auto it = chunkMap.begin();
+    for (const auto index : order) {
+        const auto& keyString = keyStrings[index];
+
+        for (int steps = 0; it != chunkMap.end() && it->first <= keyString; ++steps) {
+            if (steps == kMaxBatchedLookupLinearSteps) {
+                it = chunkMap.upper_bound(keyString);
+                break;
+            }
+            ++it;
+        }
+
+        if (it != chunkMap.end() && it->second->containsKey(shardKeys[index])) {
+            chunks[index].emplace(*(it->second), _clusterTime);
+        }
+    }
+
+    return chunks;
+}
+
 bool ChunkManager::keyBelongsToShard(const BSONObj& shardKey, const ShardId& shardId) const {
     if (shardKey.isEmpty())
         return false;
@@ -404,87 +638,34 @@ std::string RoutingTableHistory::toString() const {
     return sb.str();
 }
 
-ShardVersionMap RoutingTableHistory::_constructShardVersionMap() const {
-    const OID& epoch = _collectionVersion.epoch();
-
-    ShardVersionMap shardVersions;
-    ChunkInfoMap::const_iterator current = _chunkMap.cbegin();
-
-    boost::optional<BSONObj> firstMin = boost::none;
-    boost::optional<BSONObj> lastMax = boost::none;
-
-    while (current != _chunkMap.cend()) {
-        const auto& firstChunkInRange = current->second;
-        const auto& currentRangeShardId = firstChunkInRange->getShardIdAt(boost::none);
-
-        // Tracks the max shard version for the shard on which the current range will reside
-        auto shardVersionIt = shardVersions.find(currentRangeShardId);
-        if (shardVersionIt == shardVersions.end()) {
-            shardVersionIt =
-                shardVersions.emplace(currentRangeShardId, ChunkVersion(0, 0, epoch)).first;
-        }
-
-        auto& maxShardVersion = shardVersionIt->second;
-
-        current =
-            std::find_if(current,
-                         _chunkMap.cend(),
-                         [&currentRangeShardId,
-                          &maxShardVersion](const ChunkInfoMap::value_type& chunkMapEntry) {
-                             const auto& currentChunk = chunkMapEntry.second;
-
-                             if (currentChunk->getShardIdAt(boost::none) != currentRangeShardId)
-                                 return true;
-
-                             if (currentChunk->getLastmod() > maxShardVersion)
-                                 maxShardVersion = currentChunk->getLastmod();
-
-                             return false;
-                         });
-
-        const auto rangeLast = std::prev(current);
-
-        const auto& rangeMin = firstChunkInRange->getMin();
-        const auto& rangeMax = rangeLast->second->getMax();
-
-        // Check the continuity of the chunks map
-        if (lastMax && !SimpleBSONObjComparator::kInstance.evaluate(*lastMax == rangeMin)) {
-            if (SimpleBSONObjComparator::kInstance.evaluate(*lastMax < rangeMin))
-                uasserted(ErrorCodes::ConflictingOperationInProgress,
-                          str::stream()
-                              << "Gap exists in the routing table between chunks "
-                              << _chunkMap.at(_extractKeyString(*lastMax))->getRange().toString()
-                              << " and "
-                              << rangeLast->second->getRange().toString());
-            else
-                uasserted(ErrorCodes::ConflictingOperationInProgress,
-                          str::stream()
-                              << "Overlap exists in the routing table between chunks "
-                              << _chunkMap.at(_extractKeyString(*lastMax))->getRange().toString()
-                              << " and "
-                              << rangeLast->second->getRange().toString());
+void RoutingTableHistory::_constructShardVersionMap(const ChunkInfoMap& chunkMap,
+                                                    const OID& epoch,
+                                                    ShardVersionMap* shardVersions,
+                                                    ShardChunksInfoMap* shardChunksInfo) {
+    shardVersions->clear();
+    shardChunksInfo->clear();
+
+    for (const auto& chunkMapEntry : chunkMap) {
+        const auto& chunk = chunkMapEntry.second;
+        const auto& shardId = chunk->getShardIdAt(boost::none);
+
+        auto& info = (*shardChunksInfo)[shardId];
+        ++info.numChunks;
+
+        // Tracks the max shard version for the shard on which the chunk resides
+        auto& maxShardVersion =
+            shardVersions->emplace(shardId, ChunkVersion(0, 0, epoch)).first->second;
+        if (chunk->getLastmod() > maxShardVersion) {
+            maxShardVersion = chunk->getLastmod();
+            info.maxVersionChunk = chunk;
         }
+    }
 
-        if (!firstMin)
-            firstMin = rangeMin;
-
-        lastMax = rangeMax;
-
+    for (const auto& entry : *shardVersions) {
         // If a shard has chunks it must have a shard version, otherwise we have an invalid chunk
         // somewhere, which should have been caught at chunk load time
-        invariant(maxShardVersion.isSet());
+        invariant(entry.second.isSet());
     }
-
-    if (!_chunkMap.empty()) {
-        invariant(!shardVersions.empty());
-        invariant(firstMin.is_initialized());
-        invariant(lastMax.is_initialized());
-
-        checkAllElementsAreOfType(MinKey, firstMin.get());
-        checkAllElementsAreOfType(MaxKey, lastMax.get());
-    }
-
-    return shardVersions;
 }
 
 std::string RoutingTableHistory::_extractKeyString(const BSONObj& shardKeyValue) const {
@@ -505,7 +686,9 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeNew(
                                std::move(defaultCollator),
                                std::move(unique),
                                {},
-                               {0, 0, epoch})
+                               {0, 0, epoch},
+                               {},
+                               {})
         .makeUpdated(chunks);
 }
 
@@ -513,7 +696,19 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
     const std::vector<ChunkType>& changedChunks) {
 
     const auto startingCollectionVersion = getVersion();
+
+    // Copying the chunk map only shares its segments. The changes below clone just the segments
+    // they modify, and the shard versions are adjusted for the changed chunks alone.
     auto chunkMap = _chunkMap;
+    auto shardVersions = _shardVersions;
+    auto shardChunksInfo = _shardChunksInfo;
+
+    // Shards whose version was carried by a chunk which was replaced, without the shard receiving
+    // a newer chunk afterwards. Their version must be recomputed from their remaining chunks.
+    std::set<ShardId> shardsToRecompute;
+
+    std::vector<ChunkInfoMap::value_type> insertedChunks;
+    insertedChunks.reserve(changedChunks.size());
 
     ChunkVersion collectionVersion = startingCollectionVersion;
     for (const auto& chunk : changedChunks) {
@@ -562,11 +757,32 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
             newChunk->getWritesTracker()->addBytesWritten(bytesInReplacedChunk);
         }
 
+        for (auto it = low; it != high; ++it) {
+            const auto& replacedChunk = it->second;
+            const auto& replacedShardId = replacedChunk->getShardIdAt(boost::none);
+            auto& info = shardChunksInfo[replacedShardId];
+            --info.numChunks;
+            if (info.maxVersionChunk == replacedChunk) {
+                shardsToRecompute.insert(replacedShardId);
+            }
+        }
+
         // Erase all chunks from the map, which overlap the chunk we got from the persistent store
         chunkMap.erase(low, high);
 
         // Insert only the chunk itself
         chunkMap.insert(std::make_pair(chunkMaxKeyString, newChunk));
+
+        // A changed chunk is at least as new as every chunk already in the map, so its version
+        // becomes the version of the shard it resides on.
+        const auto& shardId = newChunk->getShardIdAt(boost::none);
+        auto& info = shardChunksInfo[shardId];
+        ++info.numChunks;
+        info.maxVersionChunk = newChunk;
+        shardVersions.insert_or_assign(shardId, chunkVersion);
+        shardsToRecompute.erase(shardId);
+
+        insertedChunks.emplace_back(chunkMaxKeyString, std::move(newChunk));
     }
 
     // If at least one diff was applied, the metadata is correct, but it might not have changed so
@@ -580,6 +796,37 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
         return shared_from_this();
     }
 
+    for (auto it = shardChunksInfo.begin(); it != shardChunksInfo.end();) {
+        if (it->second.numChunks == 0) {
+            shardVersions.erase(it->first);
+            shardsToRecompute.erase(it->first);
+            it = shardChunksInfo.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (!shardsToRecompute.empty()) {
+        _constructShardVersionMap(
+            chunkMap, collectionVersion.epoch(), &shardVersions, &shardChunksInfo);
+    }
+
+    // The previous routing table was continuous, so only the boundaries of the chunks inserted
+    // above can have introduced a gap or an overlap.
+    for (const auto& inserted : insertedChunks) {
+        const auto it = chunkMap.lower_bound(inserted.first);
+        if (it != chunkMap.end() && it->second == inserted.second) {
+            checkContinuity(chunkMap, it);
+        }
+    }
+
+    if (!chunkMap.empty()) {
+        invariant(!shardVersions.empty());
+
+        checkAllElementsAreOfType(MinKey, chunkMap.begin()->second->getMin());
+        checkAllElementsAreOfType(MaxKey, std::prev(chunkMap.end())->second->getMax());
+    }
+
     return std::shared_ptr<RoutingTableHistory>(
         new RoutingTableHistory(_nss,
                                 _uuid,
@@ -587,7 +834,9 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
                                 CollatorInterface::cloneCollator(getDefaultCollator()),
                                 isUnique(),
                                 std::move(chunkMap),
-                                collectionVersion));
+                                collectionVersion,
+                                std::move(shardVersions),
+                                std::move(shardChunksInfo)));
 }
 
 }  // namespace mongo
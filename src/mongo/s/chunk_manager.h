@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <iterator>
 #include <map>
 #include <set>
 #include <string>
@@ -49,8 +50,128 @@ struct QuerySolutionNode;
 class OperationContext;
 class ChunkManager;
 
-// Ordered map from the max for each chunk to an entry describing the chunk
-using ChunkInfoMap = std::map<std::string, std::shared_ptr<ChunkInfo>>;
+/**
+ * Ordered map from the max for each chunk to an entry describing the chunk.
+ *
+ * The entries are kept in a sequence of sorted segments of bounded size, which copies of the map
+ * share until one of them modifies a segment. Copying the map therefore only copies one pointer
+ * per segment, and each insert or erase afterwards only clones the segments it touches. This
+ * lets a routing table refresh apply a few changed chunks without copying every chunk of the
+ * collection, while readers of the previous routing table keep using its segments unchanged.
+ */
+class ChunkInfoMap {
+public:
+    using key_type = std::string;
+    using mapped_type = std::shared_ptr<ChunkInfo>;
+    using value_type = std::pair<key_type, mapped_type>;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = ChunkInfoMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        const_iterator() = default;
+
+        reference operator*() const {
+            return (*_map->_segments[_segment])[_pos];
+        }
+        pointer operator->() const {
+            return &**this;
+        }
+
+        const_iterator& operator++();
+        const_iterator operator++(int) {
+            auto old = *this;
+            ++*this;
+            return old;
+        }
+        const_iterator& operator--();
+        const_iterator operator--(int) {
+            auto old = *this;
+            --*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return _segment == other._segment && _pos == other._pos;
+        }
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        friend class ChunkInfoMap;
+
+        const_iterator(const ChunkInfoMap* map, size_t segment, size_t pos)
+            : _map(map), _segment(segment), _pos(pos) {}
+
+        const ChunkInfoMap* _map{nullptr};
+        size_t _segment{0};
+        size_t _pos{0};
+    };
+    using iterator = const_iterator;
+
+    const_iterator begin() const {
+        return {this, 0, 0};
+    }
+    const_iterator end() const {
+        return {this, _segments.size(), 0};
+    }
+    const_iterator cbegin() const {
+        return begin();
+    }
+    const_iterator cend() const {
+        return end();
+    }
+
+    size_t size() const {
+        return _size;
+    }
+    bool empty() const {
+        return _size == 0;
+    }
+
+    /**
+     * Returns the first entry whose key is greater than 'key'.
+     */
+    const_iterator upper_bound(const key_type& key) const;
+
+    /**
+     * Returns the first entry whose key is not less than 'key'.
+     */
+    const_iterator lower_bound(const key_type& key) const;
+
+    /**
+     * Inserts 'value' unless an entry with the same key already exists.
+     */
+    void insert(value_type value);
+
+    /**
+     * Removes the entries in ['first', 'last'). Invalidates all iterators into this map.
+     */
+    void erase(const_iterator first, const_iterator last);
+
+private:
+    using Segment = std::vector<value_type>;
+
+    /**
+     * Returns segment 'index' for modification, cloning it first if other maps share it.
+     */
+    Segment& _mutableSegment(size_t index);
+
+    /**
+     * Folds segment 'index' into its successor if together they fit in a single segment.
+     */
+    void _mergeWithNext(size_t index);
+
+    // Non-empty sorted segments, each holding keys less than those of the next one.
+    std::vector<std::shared_ptr<Segment>> _segments;
+
+    size_t _size{0};
+};
 
 // Map from a shard is to the max chunk version on that shard
 using ShardVersionMap = std::map<ShardId, ChunkVersion>;
@@ -151,18 +272,36 @@ public:
 
 
 private:
+    /**
+     * Bookkeeping for a shard that owns chunks, which lets makeUpdated() maintain the shard
+     * versions without scanning the whole chunk map.
+     */
+    struct ShardChunksInfo {
+        size_t numChunks{0};
+
+        // The chunk whose version is the shard's version.
+        std::shared_ptr<ChunkInfo> maxVersionChunk;
+    };
+    using ShardChunksInfoMap = std::map<ShardId, ShardChunksInfo>;
+
     RoutingTableHistory(NamespaceString nss,
                         boost::optional<UUID> uuid,
                         KeyPattern shardKeyPattern,
                         std::unique_ptr<CollatorInterface> defaultCollator,
                         bool unique,
                         ChunkInfoMap chunkMap,
-                        ChunkVersion collectionVersion);
+                        ChunkVersion collectionVersion,
+                        ShardVersionMap shardVersions,
+                        ShardChunksInfoMap shardChunksInfo);
 
     /**
-     * Does a single pass over the chunkMap and constructs the ShardVersionMap object.
+     * Does a single pass over 'chunkMap' and constructs the shard versions and the per-shard
+     * bookkeeping from scratch.
      */
-    ShardVersionMap _constructShardVersionMap() const;
+    static void _constructShardVersionMap(const ChunkInfoMap& chunkMap,
+                                          const OID& epoch,
+                                          ShardVersionMap* shardVersions,
+                                          ShardChunksInfoMap* shardChunksInfo);
 
     std::string _extractKeyString(const BSONObj& shardKeyValue) const;
 
@@ -198,6 +337,9 @@ private:
     // chunks, it won't be present in this map.
     const ShardVersionMap _shardVersions;
 
+    // Number of chunks and the chunk carrying the version of every shard in '_shardVersions'.
+    const ShardChunksInfoMap _shardChunksInfo;
+
     friend class ChunkManager;
 };
 
@@ -337,6 +479,16 @@ public:
         return findIntersectingChunk(shardKey, CollationSpec::kSimpleSpec);
     }
 
+    /**
+     * Batched form of findIntersectingChunkWithSimpleCollation. Returns the chunk containing each
+     * of 'shardKeys', in the same order, or boost::none for keys which no chunk contains.
+     *
+     * The keys are sorted and resolved in a single forward pass over the chunk map, which is
+     * cheaper than searching the map separately for every key of a large batch.
+     */
+    std::vector<boost::optional<Chunk>> findIntersectingChunksWithSimpleCollation(
+        const std::vector<BSONObj>& shardKeys) const;
+
     /**
      * Finds the shard IDs for a given filter and collation. If collation is empty, we use the
      * collection default collation for targeting.
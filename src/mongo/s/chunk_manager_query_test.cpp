@@ -488,5 +488,61 @@ TEST_F(ChunkManagerQueryTest, SimpleCollationNumbersMultiShard) {
         {ShardId("0")});
 }
 
+TEST_F(ChunkManagerQueryTest, BatchedLookupMatchesSingleKeyLookups) {
+    std::vector<BSONObj> splitPoints;
+    for (int i = 0; i < 200; i += 2) {
+        splitPoints.push_back(BSON("a" << i));
+    }
+
+    const ShardKeyPattern shardKeyPattern(BSON("a" << 1));
+    auto chunkManager = makeChunkManager(kNss, shardKeyPattern, nullptr, false, splitPoints);
+
+    // Unsorted keys with repeats, keys sharing a chunk and jumps far enough apart that the lookup
+    // has to search the chunk map rather than step to the next chunk.
+    std::vector<BSONObj> shardKeys;
+    for (int key : {150, -5, 3, 2, 150, 199, 0, 1, 57, 250, 3, 120, -1000, 198}) {
+        shardKeys.push_back(BSON("a" << key));
+    }
+
+    const auto chunks = chunkManager->findIntersectingChunksWithSimpleCollation(shardKeys);
+    ASSERT_EQ(chunks.size(), shardKeys.size());
+
+    for (size_t i = 0; i < shardKeys.size(); ++i) {
+        ASSERT(chunks[i]);
+        const auto expected = chunkManager->findIntersectingChunkWithSimpleCollation(shardKeys[i]);
+        ASSERT_BSONOBJ_EQ(chunks[i]->getMin(), expected.getMin());
+        ASSERT_EQ(chunks[i]->getShardId(), expected.getShardId());
+    }
+}
+
+TEST_F(ChunkManagerQueryTest, BatchedLookupOfHashedShardKeys) {
+    const ShardKeyPattern shardKeyPattern(BSON("a"
+                                               << "hashed"));
+    auto chunkManager = makeChunkManager(kNss,
+                                         shardKeyPattern,
+                                         nullptr,
+                                         false,
+                                         {BSON("a" << -4611686018427387902LL),
+                                          BSON("a" << 0LL),
+                                          BSON("a" << 4611686018427387902LL)});
+
+    std::vector<BSONObj> shardKeys;
+    for (int i = 0; i < 100; ++i) {
+        shardKeys.push_back(shardKeyPattern.extractShardKeyFromDoc(BSON("a" << i)));
+    }
+
+    const auto chunks = chunkManager->findIntersectingChunksWithSimpleCollation(shardKeys);
+    ASSERT_EQ(chunks.size(), shardKeys.size());
+
+    std::set<ShardId> shardIds;
+    for (size_t i = 0; i < shardKeys.size(); ++i) {
+        ASSERT(chunks[i]);
+        const auto expected = chunkManager->findIntersectingChunkWithSimpleCollation(shardKeys[i]);
+        ASSERT_EQ(chunks[i]->getShardId(), expected.getShardId());
+        shardIds.insert(chunks[i]->getShardId());
+    }
+    ASSERT_EQ(shardIds.size(), 4UL);
+}
+
 }  // namespace
 }  // namespace mongo
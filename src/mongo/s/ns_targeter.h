@@ -98,6 +98,23 @@ public:
     virtual StatusWith<ShardEndpoint> targetInsert(OperationContext* opCtx,
                                                    const BSONObj& doc) const = 0;
 
+    /**
+     * Returns the result of targetInsert for each of the documents of a batched insert, in the
+     * same order as 'docs'.
+     *
+     * Implementations may resolve the whole batch at once. By default, every document is targeted
+     * separately.
+     */
+    virtual std::vector<StatusWith<ShardEndpoint>> targetInserts(
+        OperationContext* opCtx, const std::vector<BSONObj>& docs) const {
+        std::vector<StatusWith<ShardEndpoint>> endpoints;
+        endpoints.reserve(docs.size());
+        for (const auto& doc : docs) {
+            endpoints.push_back(targetInsert(opCtx, doc));
+        }
+        return endpoints;
+    }
+
     /**
      * Returns a vector of ShardEndpoints for a potentially multi-shard update.
      *
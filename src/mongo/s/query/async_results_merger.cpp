@@ -41,6 +41,7 @@
 #include "mongo/db/query/killcursors_request.h"
 #include "mongo/executor/remote_command_request.h"
 #include "mongo/executor/remote_command_response.h"
+#include "mongo/s/query/async_results_merger_knobs_gen.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 
@@ -91,8 +92,7 @@ AsyncResultsMerger::AsyncResultsMerger(OperationContext* opCtx,
       // since that is not supported we treat boost::none (unspecified) to mean 'kNormal'.
       _tailableMode(params.getTailableMode().value_or(TailableModeEnum::kNormal)),
       _params(std::move(params)),
-      _mergeQueue(MergingComparator(
-          _remotes, _params.getSort().value_or(BSONObj()), _params.getCompareWholeSortKey())),
+      _mergeTree(MergingComparator(_remotes, _params.getSort().value_or(BSONObj()))),
       _promisedMinSortKeys(PromisedMinSortKeyComparator(_params.getSort().value_or(BSONObj()))) {
     if (params.getTxnNumber()) {
         invariant(params.getSessionId());
@@ -242,14 +242,11 @@ bool AsyncResultsMerger::_readySorted(WithLock lk) {
 }
 
 bool AsyncResultsMerger::_readySortedTailable(WithLock lk) {
-    if (_mergeQueue.empty()) {
+    if (_mergeTree.empty()) {
         return false;
     }
 
-    auto smallestRemote = _mergeQueue.top();
-    auto smallestResult = _remotes[smallestRemote].docBuffer.front();
-    auto keyWeWantToReturn =
-        extractSortKey(*smallestResult.getResult(), _params.getCompareWholeSortKey());
+    const auto& keyWeWantToReturn = _remotes[_mergeTree.top()].frontSortKey;
     // We should always have a minPromisedSortKey from every shard in the sorted tailable case.
     auto minPromisedSortKey = _getMinPromisedSortKey(lk);
     invariant(!minPromisedSortKey.isEmpty());
@@ -290,28 +287,25 @@ StatusWith<ClusterQueryResult> AsyncResultsMerger::nextReady() {
     return _params.getSort() ? _nextReadySorted(lk) : _nextReadyUnsorted(lk);
 }
 
-ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
+ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock lk) {
     // Tailable non-awaitData cursors cannot have a sort.
     invariant(_tailableMode != TailableModeEnum::kTailable);
 
-    if (_mergeQueue.empty()) {
+    if (_mergeTree.empty()) {
         return {};
     }
 
-    size_t smallestRemote = _mergeQueue.top();
-    _mergeQueue.pop();
+    size_t smallestRemote = _mergeTree.top();
 
     invariant(!_remotes[smallestRemote].docBuffer.empty());
     invariant(_remotes[smallestRemote].status.isOK());
 
-    ClusterQueryResult front = _remotes[smallestRemote].docBuffer.front();
-    _remotes[smallestRemote].docBuffer.pop();
+    ClusterQueryResult front = _popFront(lk, smallestRemote);
 
-    // Re-populate the merging queue with the next result from 'smallestRemote', if it has a
-    // next result.
-    if (!_remotes[smallestRemote].docBuffer.empty()) {
-        _mergeQueue.push(smallestRemote);
-    }
+    // Replay the merge with the next result from 'smallestRemote', or withdraw it from the merge
+    // if it has no next result.
+    _updateMergeTree(lk, smallestRemote);
+    _readAhead(lk, smallestRemote);
 
     // For sorted tailable awaitData cursors, update the high water mark to the document's sort key.
     if (_tailableMode == TailableModeEnum::kTailableAndAwaitData) {
@@ -322,15 +316,15 @@ ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
     return front;
 }
 
-ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
+ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock lk) {
     size_t remotesAttempted = 0;
     while (remotesAttempted < _remotes.size()) {
         // It is illegal to call this method if there is an error received from any shard.
         invariant(_remotes[_gettingFromRemote].status.isOK());
 
         if (_remotes[_gettingFromRemote].hasNext()) {
-            ClusterQueryResult front = _remotes[_gettingFromRemote].docBuffer.front();
-            _remotes[_gettingFromRemote].docBuffer.pop();
+            ClusterQueryResult front = _popFront(lk, _gettingFromRemote);
+            _readAhead(lk, _gettingFromRemote);
 
             if (_tailableMode == TailableModeEnum::kTailable &&
                 !_remotes[_gettingFromRemote].hasNext()) {
@@ -353,6 +347,60 @@ ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
     return {};
 }
 
+ClusterQueryResult AsyncResultsMerger::_popFront(WithLock, size_t remoteIndex) {
+    auto& remote = _remotes[remoteIndex];
+
+    ClusterQueryResult front = remote.docBuffer.front();
+    remote.docBuffer.pop();
+
+    const auto size = front.getResult() ? front.getResult()->objsize() : 0;
+    _bufferedBytes -= size;
+
+    return front;
+}
+
+void AsyncResultsMerger::_updateMergeTree(WithLock, size_t remoteIndex) {
+    if (_mergeTree.size() < _remotes.size()) {
+        _mergeTree.resize(_remotes.size());
+    }
+
+    auto& remote = _remotes[remoteIndex];
+    remote.frontSortKey = remote.hasNext()
+        ? extractSortKey(*remote.docBuffer.front().getResult(), _params.getCompareWholeSortKey())
+        : BSONObj();
+    _mergeTree.update(remoteIndex, remote.hasNext());
+}
+
+void AsyncResultsMerger::_readAhead(WithLock lk, size_t remoteIndex) {
+    // Batches from tailable cursors are passed through to the client as they are received, so
+    // they are never requested early.
+    if (_tailableMode != TailableModeEnum::kNormal || _lifecycleState != kAlive || !_opCtx) {
+        return;
+    }
+
+    const auto& remote = _remotes[remoteIndex];
+    if (!remote.status.isOK() || remote.exhausted() || remote.cbHandle.isValid()) {
+        return;
+    }
+
+    // A remote with no results left is asked for its next batch by nextEvent() in any case. Reading
+    // further ahead reserves the size of the remote's previous batch for the getMore, on top of the
+    // results already buffered and of the reservations of the getMores still in flight. The initial
+    // batch says little about the size of the getMore batches, which may be as large as 16MB, so
+    // remotes are not read ahead from until they have answered a getMore.
+    const auto readAheadBytes = internalQueryAsyncResultsMergerReadAheadBytes.load();
+    if (readAheadBytes == 0 ||
+        (remote.hasNext() &&
+         (!remote.receivedGetMoreBatch ||
+          _bufferedBytes + _reservedBytes + remote.lastBatchBytes > readAheadBytes))) {
+        return;
+    }
+
+    // Reading ahead is only an optimization. If the getMore can't be scheduled now, it is scheduled
+    // again once the remote has no results left, which then reports the error.
+    _askForNextBatch(lk, remoteIndex).ignore();
+}
+
 Status AsyncResultsMerger::_askForNextBatch(WithLock, size_t remoteIndex) {
     invariant(_opCtx, "Cannot schedule a getMore without an OperationContext");
     auto& remote = _remotes[remoteIndex];
@@ -409,6 +457,10 @@ Status AsyncResultsMerger::_askForNextBatch(WithLock, size_t remoteIndex) {
     }
 
     remote.cbHandle = callbackStatus.getValue();
+
+    // Until the batch arrives, assume that it is as large as the previous one.
+    remote.reservedBytes = remote.lastBatchBytes;
+    _reservedBytes += remote.reservedBytes;
     return Status::OK();
 }
 
@@ -433,6 +485,8 @@ Status AsyncResultsMerger::_scheduleGetMores(WithLock lk) {
             if (!nextBatchStatus.isOK()) {
                 return nextBatchStatus;
             }
+        } else {
+            _readAhead(lk, i);
         }
     }
     return Status::OK();
@@ -535,7 +589,10 @@ void AsyncResultsMerger::_handleBatchResponse(WithLock lk,
                                               CbData const& cbData,
                                               size_t remoteIndex) {
     // Got a response from remote, so indicate we are no longer waiting for one.
-    _remotes[remoteIndex].cbHandle = executor::TaskExecutor::CallbackHandle();
+    auto& remote = _remotes[remoteIndex];
+    remote.cbHandle = executor::TaskExecutor::CallbackHandle();
+    _reservedBytes -= remote.reservedBytes;
+    remote.reservedBytes = 0;
 
     //  On shutdown, there is no need to process the response.
     if (_lifecycleState != kAlive) {
@@ -579,9 +636,8 @@ void AsyncResultsMerger::_cleanUpFailedBatch(WithLock lk, Status status, size_t
     if (_params.getAllowPartialResults() || remote.status == ErrorCodes::ExchangePassthrough) {
         remote.status = Status::OK();
 
-        // Clear the results buffer and cursor id.
-        std::queue<ClusterQueryResult> emptyBuffer;
-        std::swap(remote.docBuffer, emptyBuffer);
+        // Clear the cursor id. Any results which were read ahead from this remote before the
+        // failure are still returned.
         remote.cursorId = 0;
     }
 }
@@ -609,6 +665,7 @@ void AsyncResultsMerger::_processBatchResults(WithLock lk,
     remote.cursorId = cursorResponse.getCursorId();
 
     // Save the batch in the remote's buffer.
+    remote.receivedGetMoreBatch = true;
     if (!_addBatchToBuffer(lk, remoteIndex, cursorResponse)) {
         return;
     }
@@ -628,6 +685,8 @@ void AsyncResultsMerger::_processBatchResults(WithLock lk,
         // Be careful only to do this when '_opCtx' is non-null, since it is illegal to schedule a
         // remote command on a user's behalf without a non-null OperationContext.
         remote.status = _askForNextBatch(lk, remoteIndex);
+    } else {
+        _readAhead(lk, remoteIndex);
     }
 }
 
@@ -636,6 +695,7 @@ bool AsyncResultsMerger::_addBatchToBuffer(WithLock lk,
                                            const CursorResponse& response) {
     auto& remote = _remotes[remoteIndex];
     _updateRemoteMetadata(lk, remoteIndex, response);
+    remote.lastBatchBytes = 0;
     for (const auto& obj : response.getBatch()) {
         // If there's a sort, we're expecting the remote node to have given us back a sort key.
         if (_params.getSort()) {
@@ -659,13 +719,14 @@ bool AsyncResultsMerger::_addBatchToBuffer(WithLock lk,
 
         ClusterQueryResult result(obj);
         remote.docBuffer.push(result);
+        remote.lastBatchBytes += obj.objsize();
+        _bufferedBytes += obj.objsize();
         ++remote.fetchedCount;
     }
 
-    // If we're doing a sorted merge, then we have to make sure to put this remote onto the merge
-    // queue.
+    // If we're doing a sorted merge, then we have to make sure this remote takes part in the merge.
     if (_params.getSort() && !response.getBatch().empty()) {
-        _mergeQueue.push(remoteIndex);
+        _updateMergeTree(lk, remoteIndex);
     }
     return true;
 }
@@ -776,13 +837,8 @@ bool AsyncResultsMerger::RemoteCursorData::exhausted() const {
 // AsyncResultsMerger::MergingComparator
 //
 
-bool AsyncResultsMerger::MergingComparator::operator()(const size_t& lhs, const size_t& rhs) {
-    const ClusterQueryResult& leftDoc = _remotes[lhs].docBuffer.front();
-    const ClusterQueryResult& rightDoc = _remotes[rhs].docBuffer.front();
-
-    return compareSortKeys(extractSortKey(*leftDoc.getResult(), _compareWholeSortKey),
-                           extractSortKey(*rightDoc.getResult(), _compareWholeSortKey),
-                           _sort) > 0;
+bool AsyncResultsMerger::MergingComparator::operator()(size_t lhs, size_t rhs) const {
+    return compareSortKeys(_remotes[lhs].frontSortKey, _remotes[rhs].frontSortKey, _sort) < 0;
 }
 
 bool AsyncResultsMerger::PromisedMinSortKeyComparator::operator()(
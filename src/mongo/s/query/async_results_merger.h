@@ -43,6 +43,7 @@
 #include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/time_support.h"
+#include "mongo/util/tournament_tree.h"
 
 namespace mongo {
 
@@ -67,6 +68,12 @@ class CursorResponse;
  * This requires waiting until we have a response from every remote before returning results.
  * Without a sort, we are ready to return results as soon as we have *any* response from a remote.
  *
+ * Outside of tailable cursors, the ARM also reads ahead: once a remote has answered a getMore, the
+ * ARM keeps a getMore in flight to it while it is not exhausted, so that merging does not stall on
+ * a round trip each time the remote's batch runs out. internalQueryAsyncResultsMergerReadAheadBytes
+ * is a soft target for the results buffered plus the size of the previous batch of each remote
+ * with a getMore in flight: a batch larger than the previous one from its remote can exceed it.
+ *
  * On any error, the caller is responsible for shutting down the ARM using the kill() method.
  *
  * Does not throw exceptions.
@@ -292,6 +299,22 @@ private:
         // The buffer of results that have been retrieved but not yet returned to the caller.
         std::queue<ClusterQueryResult> docBuffer;
 
+        // Total size in bytes of the last batch received from this remote, which is the estimated
+        // size of its next batch.
+        long long lastBatchBytes = 0;
+
+        // Whether a batch has been received in response to a getMore. Until then 'lastBatchBytes'
+        // is the size of the initial batch, which is usually limited to a much smaller number of
+        // results than a getMore batch and therefore no estimate of it.
+        bool receivedGetMoreBatch = false;
+
+        // The bytes counted in '_reservedBytes' for the pending request to this remote, if any.
+        long long reservedBytes = 0;
+
+        // The sort key of the first result in 'docBuffer', extracted once for all the comparisons
+        // of the merge. Used only if there is a sort.
+        BSONObj frontSortKey;
+
         // Is valid if there is currently a pending request to this remote.
         executor::TaskExecutor::CallbackHandle cbHandle;
 
@@ -304,24 +327,20 @@ private:
         long long fetchedCount = 0;
     };
 
+    /**
+     * Orders remotes by the sort key of their first buffered result.
+     */
     class MergingComparator {
     public:
-        MergingComparator(const std::vector<RemoteCursorData>& remotes,
-                          const BSONObj& sort,
-                          bool compareWholeSortKey)
-            : _remotes(remotes), _sort(sort), _compareWholeSortKey(compareWholeSortKey) {}
+        MergingComparator(const std::vector<RemoteCursorData>& remotes, const BSONObj& sort)
+            : _remotes(remotes), _sort(sort) {}
 
-        bool operator()(const size_t& lhs, const size_t& rhs);
+        bool operator()(size_t lhs, size_t rhs) const;
 
     private:
         const std::vector<RemoteCursorData>& _remotes;
 
         const BSONObj _sort;
-
-        // When '_compareWholeSortKey' is true, $sortKey is a scalar value, rather than an object.
-        // We extract the sort key {$sortKey: <value>}. The sort key pattern '_sort' is verified to
-        // be {$sortKey: 1}.
-        const bool _compareWholeSortKey;
     };
 
     using MinSortKeyRemoteIdPair = std::pair<BSONObj, size_t>;
@@ -377,6 +396,26 @@ private:
     ClusterQueryResult _nextReadySorted(WithLock);
     ClusterQueryResult _nextReadyUnsorted(WithLock);
 
+    /**
+     * Removes and returns the first buffered result of the given remote.
+     */
+    ClusterQueryResult _popFront(WithLock, size_t remoteIndex);
+
+    /**
+     * Replays the merge for the given remote after its first buffered result changed. Used only if
+     * there is a sort.
+     */
+    void _updateMergeTree(WithLock, size_t remoteIndex);
+
+    /**
+     * Asks the given remote for its next batch ahead of time, while it still has results buffered,
+     * if it has no request outstanding, has already answered a getMore, and the
+     * internalQueryAsyncResultsMergerReadAheadBytes budget holds the results buffered across all
+     * remotes, the bytes reserved for the requests in flight and the size of this remote's previous
+     * batch.
+     */
+    void _readAhead(WithLock, size_t remoteIndex);
+
     using CbData = executor::TaskExecutor::RemoteCommandCallbackArgs;
     using CbResponse = executor::TaskExecutor::ResponseStatus;
 
@@ -456,9 +495,16 @@ private:
     // Data tracking the state of our communication with each of the remote nodes.
     std::vector<RemoteCursorData> _remotes;
 
-    // The top of this priority queue is the index into '_remotes' for the remote host that has the
-    // next document to return, according to the sort order. Used only if there is a sort.
-    std::priority_queue<size_t, std::vector<size_t>, MergingComparator> _mergeQueue;
+    // Tournament among the remotes which have buffered results, whose winner is the index into
+    // '_remotes' for the remote host that has the next document to return, according to the sort
+    // order. Used only if there is a sort.
+    TournamentTree<MergingComparator> _mergeTree;
+
+    // Total size in bytes of the results buffered across all remotes.
+    long long _bufferedBytes = 0;
+
+    // Total size in bytes reserved for the batches of the requests outstanding to all remotes.
+    long long _reservedBytes = 0;
 
     // The index into '_remotes' for the remote from which we are currently retrieving results.
     // Used only if there is *not* a sort.
@@ -41,6 +41,7 @@
 #include "mongo/db/query/query_request.h"
 #include "mongo/executor/task_executor.h"
 #include "mongo/s/client/shard_registry.h"
+#include "mongo/s/query/async_results_merger_knobs_gen.h"
 #include "mongo/s/query/results_merger_test_fixture.h"
 #include "mongo/unittest/death_test.h"
 #include "mongo/unittest/death_test.h"
@@ -1914,5 +1915,253 @@ TEST_F(AsyncResultsMergerTest, ShouldNotScheduleGetMoresWithoutAnOperationContex
     executor()->waitForEvent(killedEvent);
 }
 
+TEST_F(AsyncResultsMergerTest, NoReadAheadBeforeFirstGetMoreBatch) {
+    restoreReadAhead();
+
+    std::vector<RemoteCursor> cursors;
+    std::vector<BSONObj> batch = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, std::move(batch))));
+    auto arm = makeARMFromExistingCursors(std::move(cursors));
+
+    // The size of the initial batch is no estimate of the size of the next one, so the shard is
+    // not asked for its next batch while results of the initial batch are left.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 2}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(arm->ready());
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    scheduleNetworkResponse({kTestNss, CursorId(5), {fromjson("{_id: 3}"), fromjson("{_id: 4}")}});
+    executor()->waitForEvent(readyEvent);
+
+    // Once the shard has answered a getMore, it is read ahead from.
+    ASSERT_TRUE(networkHasReadyRequests());
+    ASSERT_EQ(getNthPendingRequest(0).cmdObj["getMore"].numberLong(), 5);
+    scheduleNetworkResponse({kTestNss, CursorId(0), {fromjson("{_id: 5}")}});
+
+    for (int id = 3; id <= 5; ++id) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_BSONOBJ_EQ(BSON("_id" << id), *unittest::assertGet(arm->nextReady()).getResult());
+    }
+    ASSERT_FALSE(networkHasReadyRequests());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
+TEST_F(AsyncResultsMergerTest, ReadAheadWhileResultsAreBuffered) {
+    restoreReadAhead();
+
+    BSONObj findCmd = fromjson("{find: 'testcoll', sort: {_id: 1}}");
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(
+        makeRemoteCursor(kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, {})));
+    cursors.push_back(
+        makeRemoteCursor(kTestShardIds[1], kTestShardHosts[1], CursorResponse(kTestNss, 6, {})));
+    auto arm = makeARMFromExistingCursors(std::move(cursors), findCmd);
+
+    ASSERT_FALSE(arm->ready());
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    std::vector<CursorResponse> responses;
+    std::vector<BSONObj> batch1 = {fromjson("{$sortKey: {'': 1}}"),
+                                   fromjson("{$sortKey: {'': 4}}")};
+    responses.emplace_back(kTestNss, CursorId(5), batch1);
+    std::vector<BSONObj> batch2 = {fromjson("{$sortKey: {'': 2}}"),
+                                   fromjson("{$sortKey: {'': 3}}")};
+    responses.emplace_back(kTestNss, CursorId(6), batch2);
+    scheduleNetworkResponses(std::move(responses));
+    executor()->waitForEvent(readyEvent);
+
+    // Each shard is asked for its next batch as soon as its previous one arrives, even though it
+    // still has results buffered.
+    ASSERT_EQ(getNthPendingRequest(0).cmdObj["getMore"].numberLong(), 5);
+    ASSERT_EQ(getNthPendingRequest(1).cmdObj["getMore"].numberLong(), 6);
+    responses.clear();
+    std::vector<BSONObj> batch3 = {fromjson("{$sortKey: {'': 5}}")};
+    responses.emplace_back(kTestNss, CursorId(0), batch3);
+    std::vector<BSONObj> batch4 = {fromjson("{$sortKey: {'': 6}}")};
+    responses.emplace_back(kTestNss, CursorId(0), batch4);
+    scheduleNetworkResponses(std::move(responses));
+
+    // Both shards are now exhausted and the remaining results are merged without further requests.
+    ASSERT_TRUE(arm->remotesExhausted());
+    for (int sortKey = 1; sortKey <= 6; ++sortKey) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_BSONOBJ_EQ(BSON("$sortKey" << BSON("" << sortKey)),
+                          *unittest::assertGet(arm->nextReady()).getResult());
+    }
+    ASSERT_FALSE(networkHasReadyRequests());
+
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
+TEST_F(AsyncResultsMergerTest, ReadAheadStopsAtByteBudget) {
+    std::vector<BSONObj> batch = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    internalQueryAsyncResultsMergerReadAheadBytes.store(batch[0].objsize());
+
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(
+        makeRemoteCursor(kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, {})));
+    auto arm = makeARMFromExistingCursors(std::move(cursors));
+
+    ASSERT_FALSE(arm->ready());
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    scheduleNetworkResponse({kTestNss, CursorId(5), batch});
+    executor()->waitForEvent(readyEvent);
+
+    // The results left in the buffer use up the whole budget, so no getMore is sent yet.
+    ASSERT_FALSE(networkHasReadyRequests());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+
+    // Once the buffer is drained, the next batch is requested right away.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 2}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(networkHasReadyRequests());
+    ASSERT_FALSE(arm->ready());
+
+    readyEvent = unittest::assertGet(arm->nextEvent());
+    scheduleNetworkResponse({kTestNss, CursorId(0), {fromjson("{_id: 3}")}});
+    executor()->waitForEvent(readyEvent);
+
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 3}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
+TEST_F(AsyncResultsMergerTest, ReadAheadReservesPreviousBatchSizeForGetMoresInFlight) {
+    BSONObj findCmd = fromjson("{find: 'testcoll', sort: {_id: 1}}");
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(
+        makeRemoteCursor(kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, {})));
+    cursors.push_back(
+        makeRemoteCursor(kTestShardIds[1], kTestShardHosts[1], CursorResponse(kTestNss, 6, {})));
+
+    // All results have the same size. The budget holds five of them.
+    const auto resultBytes = fromjson("{$sortKey: {'': 1}}").objsize();
+    internalQueryAsyncResultsMergerReadAheadBytes.store(5 * resultBytes);
+    auto arm = makeARMFromExistingCursors(std::move(cursors), findCmd);
+
+    ASSERT_FALSE(arm->ready());
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    std::vector<CursorResponse> responses;
+    std::vector<BSONObj> batch1 = {fromjson("{$sortKey: {'': 1}}"),
+                                   fromjson("{$sortKey: {'': 4}}")};
+    responses.emplace_back(kTestNss, CursorId(5), batch1);
+    std::vector<BSONObj> batch2 = {fromjson("{$sortKey: {'': 2}}"),
+                                   fromjson("{$sortKey: {'': 3}}")};
+    responses.emplace_back(kTestNss, CursorId(6), batch2);
+    scheduleNetworkResponses(std::move(responses));
+    executor()->waitForEvent(readyEvent);
+
+    // The first shard's batch arrived first, and the budget holds its two results and the two
+    // expected from its next batch. Once the second shard's batch arrives, four results are
+    // buffered and two more are expected from the first shard, so the second shard is not asked
+    // to read ahead.
+    ASSERT_EQ(getNthPendingRequest(0).cmdObj["getMore"].numberLong(), 5);
+    scheduleNetworkResponse({kTestNss, CursorId(0), {fromjson("{$sortKey: {'': 5}}")}});
+    ASSERT_FALSE(networkHasReadyRequests());
+
+    // Taking a result from the first shard, which is exhausted, requests nothing.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{$sortKey: {'': 1}}"),
+                      *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+
+    // Taking a result from the second shard leaves three results buffered, so the budget now holds
+    // the batch expected from it.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{$sortKey: {'': 2}}"),
+                      *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(networkHasReadyRequests());
+    ASSERT_EQ(getNthPendingRequest(0).cmdObj["getMore"].numberLong(), 6);
+    scheduleNetworkResponse({kTestNss, CursorId(0), {fromjson("{$sortKey: {'': 6}}")}});
+
+    for (int sortKey = 3; sortKey <= 6; ++sortKey) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_BSONOBJ_EQ(BSON("$sortKey" << BSON("" << sortKey)),
+                          *unittest::assertGet(arm->nextReady()).getResult());
+    }
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
+TEST_F(AsyncResultsMergerTest, AllowPartialResultsKeepsResultsReadAheadFromFailedShard) {
+    restoreReadAhead();
+
+    BSONObj findCmd = fromjson("{find: 'testcoll', allowPartialResults: true}");
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(
+        makeRemoteCursor(kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, {})));
+    cursors.push_back(
+        makeRemoteCursor(kTestShardIds[1], kTestShardHosts[1], CursorResponse(kTestNss, 6, {})));
+    auto arm = makeARMFromExistingCursors(std::move(cursors), findCmd);
+
+    ASSERT_FALSE(arm->ready());
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    std::vector<CursorResponse> responses;
+    std::vector<BSONObj> batch1 = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    responses.emplace_back(kTestNss, CursorId(5), batch1);
+    std::vector<BSONObj> batch2 = {fromjson("{_id: 3}")};
+    responses.emplace_back(kTestNss, CursorId(6), batch2);
+    scheduleNetworkResponses(std::move(responses));
+    executor()->waitForEvent(readyEvent);
+
+    // Both shards are read ahead from, and the first one then fails.
+    ASSERT_EQ(getNthPendingRequest(0).cmdObj["getMore"].numberLong(), 5);
+    ASSERT_EQ(getNthPendingRequest(1).cmdObj["getMore"].numberLong(), 6);
+    scheduleErrorResponse({ErrorCodes::AuthenticationFailed, "authentication failed"});
+
+    // The results buffered from the failed shard are still returned, followed by the results of
+    // the other shard.
+    for (int id = 1; id <= 3; ++id) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_BSONOBJ_EQ(BSON("_id" << id), *unittest::assertGet(arm->nextReady()).getResult());
+    }
+
+    ASSERT_FALSE(arm->ready());
+    readyEvent = unittest::assertGet(arm->nextEvent());
+    ASSERT_EQ(getNthPendingRequest(0).cmdObj["getMore"].numberLong(), 6);
+    scheduleNetworkResponse({kTestNss, CursorId(0), {fromjson("{_id: 4}")}});
+    executor()->waitForEvent(readyEvent);
+
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 4}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
+TEST_F(AsyncResultsMergerTest, KillWithReadAheadOutstanding) {
+    restoreReadAhead();
+
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(
+        makeRemoteCursor(kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, {})));
+    auto arm = makeARMFromExistingCursors(std::move(cursors));
+
+    ASSERT_FALSE(arm->ready());
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    scheduleNetworkResponse({kTestNss, CursorId(5), {fromjson("{_id: 1}"), fromjson("{_id: 2}")}});
+    executor()->waitForEvent(readyEvent);
+
+    // The next getMore is sent while both results are still buffered.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_EQ(getNthPendingRequest(0).cmdObj["getMore"].numberLong(), 5);
+
+    // Killing the ARM cancels the getMore and kills the remote cursor without waiting for it.
+    auto killEvent = arm->kill(operationContext());
+    assertKillCusorsCmdHasCursorId(getNthPendingRequest(0u).cmdObj, 5);
+
+    // The kill completes once the canceled getMore's callback has run.
+    runReadyCallbacks();
+    executor()->waitForEvent(killEvent);
+}
+
 }  // namespace
 }  // namespace mongo
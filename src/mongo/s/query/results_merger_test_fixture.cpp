@@ -34,6 +34,7 @@
 #include "mongo/executor/network_interface_mock.h"
 #include "mongo/executor/thread_pool_task_executor_test_fixture.h"
 #include "mongo/s/catalog/type_shard.h"
+#include "mongo/s/query/async_results_merger_knobs_gen.h"
 #include "mongo/s/query/results_merger_test_fixture.h"
 
 namespace mongo {
@@ -72,6 +73,20 @@ void ResultsMergerTestFixture::setUp() {
     }
 
     setupShards(shards);
+
+    // Disable read-ahead so that getMores are only sent once the tests have consumed a remote's
+    // buffered results. Tests of read-ahead enable it explicitly.
+    _originalReadAheadBytes = internalQueryAsyncResultsMergerReadAheadBytes.load();
+    internalQueryAsyncResultsMergerReadAheadBytes.store(0);
+}
+
+void ResultsMergerTestFixture::restoreReadAhead() {
+    internalQueryAsyncResultsMergerReadAheadBytes.store(_originalReadAheadBytes);
+}
+
+void ResultsMergerTestFixture::tearDown() {
+    internalQueryAsyncResultsMergerReadAheadBytes.store(_originalReadAheadBytes);
+    ShardingTestFixture::tearDown();
 }
 
 }  // namespace mongo
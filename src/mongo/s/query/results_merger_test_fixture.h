@@ -50,6 +50,8 @@ public:
 
     void setUp() override;
 
+    void tearDown() override;
+
 protected:
     /**
      * Constructs an AsyncResultsMergerParams object with the given vector of existing cursors.
@@ -247,6 +249,15 @@ protected:
         invariant(mockClock);
         return mockClock;
     }
+
+    /**
+     * Restores the read-ahead budget which setUp() found, normally the default value of
+     * internalQueryAsyncResultsMergerReadAheadBytes.
+     */
+    void restoreReadAhead();
+
+private:
+    long long _originalReadAheadBytes = 0;
 };
 
 }  // namespace mongo
@@ -318,5 +318,174 @@ TEST_F(RoutingTableHistoryTestThreeInitialChunks,
                               expectedBytesInChunksNotSplit);
 }
 
+/**
+ * Test fixture for tests that start with a routing table large enough to span many segments of
+ * the chunk map, with chunks [10 * i, 10 * (i + 1)) spread round-robin over three shards.
+ */
+class RoutingTableHistoryManyChunksTest : public unittest::Test {
+public:
+    static constexpr int kNumChunks = 1000;
+
+    void setUp() override {
+        std::vector<ChunkType> chunks;
+        ChunkVersion version{1, 0, _epoch};
+        for (int i = 0; i < kNumChunks; ++i) {
+            chunks.emplace_back(kNss, chunkRange(i, i + 1), version, shardFor(i));
+            version.incMinor();
+        }
+
+        _rt = RoutingTableHistory::makeNew(
+            kNss, UUID::gen(), _shardKeyPattern, nullptr, false, _epoch, chunks);
+        ASSERT_EQ(_rt->getChunkMap().size(), static_cast<size_t>(kNumChunks));
+    }
+
+    ChunkRange chunkRange(int first, int last) const {
+        return {first == 0 ? _shardKeyPattern.globalMin() : BSON("a" << first * 10),
+                last == kNumChunks ? _shardKeyPattern.globalMax() : BSON("a" << last * 10)};
+    }
+
+    const ShardId& shardFor(int chunk) const {
+        return _shards[chunk % _shards.size()];
+    }
+
+    const ShardId& shard(int index) const {
+        return _shards[index];
+    }
+
+    ChunkVersion nextVersion(const std::shared_ptr<RoutingTableHistory>& rt, bool major) const {
+        auto version = rt->getVersion();
+        if (major) {
+            version.incMajor();
+        } else {
+            version.incMinor();
+        }
+        return version;
+    }
+
+    const std::shared_ptr<RoutingTableHistory>& getInitialRoutingTable() const {
+        return _rt;
+    }
+
+    /**
+     * Checks that the chunks of 'rt' are contiguous, and that its shard versions match those of
+     * a routing table built from scratch out of the same chunks.
+     */
+    void assertMatchesRebuiltRoutingTable(const std::shared_ptr<RoutingTableHistory>& rt) const {
+        std::vector<ChunkType> chunks;
+        boost::optional<BSONObj> lastMax;
+        for (const auto& entry : rt->getChunkMap()) {
+            const auto& chunk = *entry.second;
+            if (lastMax) {
+                ASSERT_BSONOBJ_EQ(*lastMax, chunk.getMin());
+            }
+            lastMax = chunk.getMax();
+            chunks.emplace_back(
+                kNss, chunk.getRange(), chunk.getLastmod(), chunk.getShardIdAt(boost::none));
+        }
+        std::sort(chunks.begin(), chunks.end(), [](const ChunkType& lhs, const ChunkType& rhs) {
+            return lhs.getVersion() < rhs.getVersion();
+        });
+
+        auto rebuilt = RoutingTableHistory::makeNew(
+            kNss, UUID::gen(), _shardKeyPattern, nullptr, false, _epoch, chunks);
+        ASSERT_EQ(rebuilt->getChunkMap().size(), rt->getChunkMap().size());
+        ASSERT_EQ(rebuilt->getVersion(), rt->getVersion());
+
+        std::set<ShardId> shardIds, rebuiltShardIds;
+        rt->getAllShardIds(&shardIds);
+        rebuilt->getAllShardIds(&rebuiltShardIds);
+        ASSERT(shardIds == rebuiltShardIds);
+        for (const auto& shardId : _shards) {
+            ASSERT_EQ(rebuilt->getVersion(shardId), rt->getVersion(shardId));
+        }
+    }
+
+private:
+    const OID _epoch{OID::gen()};
+    const KeyPattern _shardKeyPattern{BSON("a" << 1)};
+    const std::vector<ShardId> _shards{ShardId("shard0"), ShardId("shard1"), ShardId("shard2")};
+    std::shared_ptr<RoutingTableHistory> _rt;
+};
+
+TEST_F(RoutingTableHistoryManyChunksTest, MigrationUpdatesOnlyTheNewRoutingTable) {
+    const auto& rt = getInitialRoutingTable();
+    ASSERT_EQ(shardFor(500), shard(2));
+    ASSERT_EQ(shardFor(503), shard(2));
+
+    // Move chunk 500 to shard0, bumping the donor's chunk 503.
+    const auto migratedVersion = nextVersion(rt, true);
+    auto controlVersion = migratedVersion;
+    controlVersion.incMinor();
+    auto newRt = rt->makeUpdated({ChunkType{kNss, chunkRange(500, 501), migratedVersion, shard(0)},
+                                  ChunkType{kNss, chunkRange(503, 504), controlVersion, shard(2)}});
+
+    ASSERT_EQ(newRt->getChunkMap().size(), static_cast<size_t>(kNumChunks));
+    ASSERT_EQ(newRt->getVersion(shard(0)), migratedVersion);
+    ASSERT_EQ(newRt->getVersion(shard(1)), rt->getVersion(shard(1)));
+    ASSERT_EQ(newRt->getVersion(shard(2)), controlVersion);
+    assertMatchesRebuiltRoutingTable(newRt);
+
+    // The previous routing table still routes the migrated chunk to its donor.
+    const auto key = BSON("a" << 5005);
+    ASSERT_EQ(rt->overlappingRanges(key, key, true).first->second->getShardIdAt(boost::none),
+              shard(2));
+    ASSERT_EQ(newRt->overlappingRanges(key, key, true).first->second->getShardIdAt(boost::none),
+              shard(0));
+    assertMatchesRebuiltRoutingTable(rt);
+}
+
+TEST_F(RoutingTableHistoryManyChunksTest, MergeAcrossManyChunks) {
+    const auto& rt = getInitialRoutingTable();
+
+    auto newRt = rt->makeUpdated(
+        {ChunkType{kNss, chunkRange(100, 400), nextVersion(rt, false), shard(1)}});
+
+    ASSERT_EQ(newRt->getChunkMap().size(), static_cast<size_t>(kNumChunks - 299));
+    assertMatchesRebuiltRoutingTable(newRt);
+    ASSERT_EQ(rt->getChunkMap().size(), static_cast<size_t>(kNumChunks));
+    assertMatchesRebuiltRoutingTable(rt);
+}
+
+TEST_F(RoutingTableHistoryManyChunksTest, ReplacedMaxVersionChunkRecomputesShardVersion) {
+    const auto& rt = getInitialRoutingTable();
+
+    // Chunk 998 carries shard2's version. Moving it to shard0 without bumping another chunk of
+    // shard2 leaves shard2 with the version of its next newest chunk, 995.
+    ASSERT_EQ(shardFor(998), shard(2));
+    auto newRt = rt->makeUpdated(
+        {ChunkType{kNss, chunkRange(998, 999), nextVersion(rt, true), shard(0)}});
+
+    ChunkVersion expectedShard2Version{1, 995, rt->getVersion().epoch()};
+    ASSERT_EQ(newRt->getVersion(shard(2)), expectedShard2Version);
+    assertMatchesRebuiltRoutingTable(newRt);
+}
+
+TEST_F(RoutingTableHistoryManyChunksTest, ShardWithoutChunksLosesItsVersion) {
+    const auto& rt = getInitialRoutingTable();
+
+    auto newRt = rt->makeUpdated(
+        {ChunkType{kNss, chunkRange(0, kNumChunks), nextVersion(rt, true), shard(0)}});
+
+    ASSERT_EQ(newRt->getChunkMap().size(), 1ull);
+    std::set<ShardId> shardIds;
+    newRt->getAllShardIds(&shardIds);
+    ASSERT_EQ(shardIds.size(), 1ull);
+    ASSERT_EQ(*shardIds.begin(), shard(0));
+    ASSERT_EQ(newRt->getVersion(shard(1)), ChunkVersion(0, 0, rt->getVersion().epoch()));
+    ASSERT_EQ(rt->getChunkMap().size(), static_cast<size_t>(kNumChunks));
+}
+
+TEST_F(RoutingTableHistoryManyChunksTest, GapInChangedChunksIsDetected) {
+    const auto& rt = getInitialRoutingTable();
+
+    ASSERT_THROWS_CODE(
+        rt->makeUpdated({ChunkType{kNss,
+                                   ChunkRange{BSON("a" << 5000), BSON("a" << 5005)},
+                                   nextVersion(rt, true),
+                                   shard(0)}}),
+        DBException,
+        ErrorCodes::ConflictingOperationInProgress);
+}
+
 }  // namespace
 }  // namespace mongo
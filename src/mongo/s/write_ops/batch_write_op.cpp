@@ -301,6 +301,39 @@ Status BatchWriteOp::targetBatch(const NSTargeter& targeter,
 
     const size_t numWriteOps = _clientRequest.sizeWriteOps();
 
+    // Inserts are targeted through NSTargeter::targetInserts in windows of doubling size, so that
+    // the documents of a large batch are resolved together, while a pass which stops early (for
+    // example an ordered batch moving on to another shard) targets at most twice as many documents
+    // as it consumed.
+    const bool isInsert = _clientRequest.getBatchType() == BatchedCommandRequest::BatchType_Insert;
+    std::vector<size_t> insertWindowOps;
+    std::vector<StatusWith<ShardEndpoint>> insertWindowEndpoints;
+    size_t insertWindowPos = 0;
+    size_t insertWindowSize = 1;
+
+    auto nextInsertEndpoint = [&](size_t opIndex) -> StatusWith<ShardEndpoint> {
+        if (insertWindowPos == insertWindowOps.size()) {
+            insertWindowOps.clear();
+            insertWindowPos = 0;
+
+            std::vector<BSONObj> docs;
+            for (size_t j = opIndex; j < numWriteOps && docs.size() < insertWindowSize; ++j) {
+                if (_writeOps[j].getWriteState() != WriteOpState_Ready)
+                    continue;
+
+                insertWindowOps.push_back(j);
+                docs.push_back(_writeOps[j].getWriteItem().getDocument());
+            }
+
+            insertWindowEndpoints = targeter.targetInserts(_opCtx, docs);
+            invariant(insertWindowEndpoints.size() == docs.size());
+            insertWindowSize *= 2;
+        }
+
+        invariant(insertWindowOps[insertWindowPos] == opIndex);
+        return std::move(insertWindowEndpoints[insertWindowPos++]);
+    };
+
     for (size_t i = 0; i < numWriteOps; ++i) {
         WriteOp& writeOp = _writeOps[i];
 
@@ -316,7 +349,9 @@ Status BatchWriteOp::targetBatch(const NSTargeter& targeter,
         OwnedPointerVector<TargetedWrite> writesOwned;
         vector<TargetedWrite*>& writes = writesOwned.mutableVector();
 
-        Status targetStatus = writeOp.targetWrites(_opCtx, targeter, &writes);
+        Status targetStatus = isInsert
+            ? writeOp.targetWrites(_opCtx, targeter, nextInsertEndpoint(i), &writes)
+            : writeOp.targetWrites(_opCtx, targeter, &writes);
 
         if (!targetStatus.isOK()) {
             WriteErrorDetail targetError;
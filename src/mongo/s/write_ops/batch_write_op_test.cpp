@@ -1229,6 +1229,140 @@ TEST_F(BatchWriteOpTest, MultiOpFailedTargetUnordered) {
     ASSERT_EQUALS(clientResponse.getErrDetailsAt(0)->getIndex(), 1);
 }
 
+/**
+ * Records the number of documents in each window of inserts targeted together.
+ */
+class InsertWindowRecordingTargeter : public MockNSTargeter {
+public:
+    std::vector<StatusWith<ShardEndpoint>> targetInserts(
+        OperationContext* opCtx, const std::vector<BSONObj>& docs) const override {
+        windowSizes.push_back(docs.size());
+        return MockNSTargeter::targetInserts(opCtx, docs);
+    }
+
+    mutable std::vector<size_t> windowSizes;
+};
+
+// Ordered insert batch whose shard changes in the middle of a targeting window. The documents of
+// the window past the shard change are targeted again, starting from a new window, in the next
+// round.
+TEST_F(BatchWriteOpTest, MultiOpInsertShardChangeWithinTargetingWindowOrdered) {
+    NamespaceString nss("foo.bar");
+    ShardEndpoint endpointA(ShardId("shardA"), ChunkVersion::IGNORED());
+    ShardEndpoint endpointB(ShardId("shardB"), ChunkVersion::IGNORED());
+    InsertWindowRecordingTargeter targeter;
+    initTargeterSplitRange(nss, endpointA, endpointB, &targeter);
+
+    BatchedCommandRequest request([&] {
+        write_ops::Insert insertOp(nss);
+        insertOp.setDocuments({BSON("x" << -1),
+                               BSON("x" << -2),
+                               BSON("x" << -3),
+                               BSON("x" << -4),
+                               BSON("x" << 1),
+                               BSON("x" << 2),
+                               BSON("x" << 3)});
+        return insertOp;
+    }());
+
+    BatchWriteOp batchOp(operationContext(), request);
+
+    OwnedPointerMap<ShardId, TargetedWriteBatch> targetedOwned;
+    std::map<ShardId, TargetedWriteBatch*>& targeted = targetedOwned.mutableMap();
+    ASSERT_OK(batchOp.targetBatch(targeter, false, &targeted));
+    ASSERT(!batchOp.isFinished());
+    ASSERT_EQUALS(targeted.size(), 1u);
+    ASSERT_EQUALS(targeted.begin()->second->getWrites().size(), 4u);
+    assertEndpointsEqual(targeted.begin()->second->getEndpoint(), endpointA);
+
+    // The shard changes at the second document of the third window.
+    ASSERT(targeter.windowSizes == std::vector<size_t>({1u, 2u, 4u}));
+
+    BatchedCommandResponse response;
+    buildResponse(4, &response);
+    batchOp.noteBatchResponse(*targeted.begin()->second, response, nullptr);
+    ASSERT(!batchOp.isFinished());
+
+    targetedOwned.clear();
+    targeter.windowSizes.clear();
+
+    ASSERT_OK(batchOp.targetBatch(targeter, false, &targeted));
+    ASSERT(!batchOp.isFinished());
+    ASSERT_EQUALS(targeted.size(), 1u);
+    ASSERT_EQUALS(targeted.begin()->second->getWrites().size(), 3u);
+    assertEndpointsEqual(targeted.begin()->second->getEndpoint(), endpointB);
+    ASSERT(targeter.windowSizes == std::vector<size_t>({1u, 2u}));
+
+    buildResponse(3, &response);
+    batchOp.noteBatchResponse(*targeted.begin()->second, response, nullptr);
+    ASSERT(batchOp.isFinished());
+
+    BatchedCommandResponse clientResponse;
+    batchOp.buildClientResponse(&clientResponse);
+    ASSERT(clientResponse.getOk());
+    ASSERT_EQUALS(clientResponse.getN(), 7);
+}
+
+// Unordered insert batch with targeting errors in the middle of a targeting window. The documents
+// after each error are still targeted from the same window.
+TEST_F(BatchWriteOpTest, MultiOpInsertTargetErrorsWithinTargetingWindowUnordered) {
+    NamespaceString nss("foo.bar");
+    ShardEndpoint endpoint(ShardId("shard"), ChunkVersion::IGNORED());
+    InsertWindowRecordingTargeter targeter;
+    initTargeterHalfRange(nss, endpoint, &targeter);
+
+    BatchedCommandRequest request([&] {
+        write_ops::Insert insertOp(nss);
+        insertOp.setWriteCommandBase([] {
+            write_ops::WriteCommandBase wcb;
+            wcb.setOrdered(false);
+            return wcb;
+        }());
+        insertOp.setDocuments({BSON("x" << -1),
+                               BSON("x" << -2),
+                               BSON("x" << 3),
+                               BSON("x" << -4),
+                               BSON("x" << 5),
+                               BSON("x" << -6),
+                               BSON("x" << -7)});
+        return insertOp;
+    }());
+
+    BatchWriteOp batchOp(operationContext(), request);
+
+    OwnedPointerMap<ShardId, TargetedWriteBatch> targetedOwned;
+    std::map<ShardId, TargetedWriteBatch*>& targeted = targetedOwned.mutableMap();
+    ASSERT_NOT_OK(batchOp.targetBatch(targeter, false, &targeted));
+
+    // First targeting round stops at the first error, at the end of the second window.
+    ASSERT(!batchOp.isFinished());
+    ASSERT(targeter.windowSizes == std::vector<size_t>({1u, 2u}));
+
+    targetedOwned.clear();
+    targeter.windowSizes.clear();
+    ASSERT_OK(batchOp.targetBatch(targeter, true, &targeted));
+
+    // Second targeting round records both errors and targets every other document.
+    ASSERT(!batchOp.isFinished());
+    ASSERT(targeter.windowSizes == std::vector<size_t>({1u, 2u, 4u}));
+    ASSERT_EQUALS(targeted.size(), 1u);
+    ASSERT_EQUALS(targeted.begin()->second->getWrites().size(), 5u);
+
+    BatchedCommandResponse response;
+    buildResponse(5, &response);
+    batchOp.noteBatchResponse(*targeted.begin()->second, response, nullptr);
+    ASSERT(batchOp.isFinished());
+
+    BatchedCommandResponse clientResponse;
+    batchOp.buildClientResponse(&clientResponse);
+    ASSERT(clientResponse.getOk());
+    ASSERT_EQUALS(clientResponse.getN(), 5);
+    ASSERT(clientResponse.isErrDetailsSet());
+    ASSERT_EQUALS(clientResponse.sizeErrDetails(), 2u);
+    ASSERT_EQUALS(clientResponse.getErrDetailsAt(0)->getIndex(), 2);
+    ASSERT_EQUALS(clientResponse.getErrDetailsAt(1)->getIndex(), 4);
+}
+
 // Batch failure (ok : 0) reported in a multi-op batch (ordered). Expect this gets translated down
 // into write errors for first affected write.
 TEST_F(BatchWriteOpTest, MultiOpFailedBatchOrdered) {
@@ -340,6 +340,30 @@ bool wasMetadataRefreshed(const std::shared_ptr<ChunkManager>& managerA,
     return false;
 }
 
+/**
+ * Sharded collections have the following requirements for targeting:
+ *
+ * Inserts must contain the exact shard key.
+ */
+StatusWith<BSONObj> extractInsertShardKey(const ShardKeyPattern& shardKeyPattern,
+                                          const BSONObj& doc) {
+    BSONObj shardKey = shardKeyPattern.extractShardKeyFromDoc(doc);
+
+    // Check shard key exists
+    if (shardKey.isEmpty()) {
+        return {ErrorCodes::ShardKeyNotFound,
+                str::stream() << "document " << doc << " does not contain shard key for pattern "
+                              << shardKeyPattern.toString()};
+    }
+
+    // Check shard key size on insert
+    Status status = ShardKeyPattern::checkShardKeySize(shardKey);
+    if (!status.isOK())
+        return status;
+
+    return shardKey;
+}
+
 }  // namespace
 
 ChunkManagerTargeter::ChunkManagerTargeter(const NamespaceString& nss,
@@ -371,6 +395,52 @@ Status ChunkManagerTargeter::init(OperationContext* opCtx) {
     return Status::OK();
 }
 
+std::vector<StatusWith<ShardEndpoint>> ChunkManagerTargeter::targetInserts(
+    OperationContext* opCtx, const std::vector<BSONObj>& docs) const {
+    const auto cm = _routingInfo->cm();
+    if (!cm) {
+        return NSTargeter::targetInserts(opCtx, docs);
+    }
+
+    // Extract (and for hashed shard keys, hash) all the shard keys first, so that the routing table
+    // only needs to be walked once for the entire batch.
+    std::vector<StatusWith<BSONObj>> swShardKeys;
+    swShardKeys.reserve(docs.size());
+    std::vector<BSONObj> shardKeys;
+    shardKeys.reserve(docs.size());
+    for (const auto& doc : docs) {
+        swShardKeys.push_back(extractInsertShardKey(cm->getShardKeyPattern(), doc));
+        if (swShardKeys.back().isOK()) {
+            shardKeys.push_back(swShardKeys.back().getValue());
+        }
+    }
+
+    const auto chunks = cm->findIntersectingChunksWithSimpleCollation(shardKeys);
+
+    std::vector<StatusWith<ShardEndpoint>> endpoints;
+    endpoints.reserve(docs.size());
+    size_t keyIndex = 0;
+    for (const auto& swShardKey : swShardKeys) {
+        if (!swShardKey.isOK()) {
+            endpoints.push_back(swShardKey.getStatus());
+            continue;
+        }
+
+        const auto& chunk = chunks[keyIndex++];
+        if (!chunk) {
+            endpoints.push_back({ErrorCodes::ShardKeyNotFound,
+                                 str::stream() << "Cannot target single shard using key "
+                                               << swShardKey.getValue()});
+            continue;
+        }
+
+        const auto& shardId = chunk->getShardId();
+        endpoints.push_back(ShardEndpoint(shardId, cm->getVersion(shardId)));
+    }
+
+    return endpoints;
+}
+
 const NamespaceString& ChunkManagerTargeter::getNS() const {
     return _nss;
 }
@@ -380,26 +450,11 @@ StatusWith<ShardEndpoint> ChunkManagerTargeter::targetInsert(OperationContext* o
     BSONObj shardKey;
 
     if (_routingInfo->cm()) {
-        //
-        // Sharded collections have the following requirements for targeting:
-        //
-        // Inserts must contain the exact shard key.
-        //
-
-        shardKey = _routingInfo->cm()->getShardKeyPattern().extractShardKeyFromDoc(doc);
+        auto swShardKey = extractInsertShardKey(_routingInfo->cm()->getShardKeyPattern(), doc);
+        if (!swShardKey.isOK())
+            return swShardKey.getStatus();
 
-        // Check shard key exists
-        if (shardKey.isEmpty()) {
-            return {ErrorCodes::ShardKeyNotFound,
-                    str::stream() << "document " << doc
-                                  << " does not contain shard key for pattern "
-                                  << _routingInfo->cm()->getShardKeyPattern().toString()};
-        }
-
-        // Check shard key size on insert
-        Status status = ShardKeyPattern::checkShardKeySize(shardKey);
-        if (!status.isOK())
-            return status;
+        shardKey = std::move(swShardKey.getValue());
     }
 
     // Target the shard key or database primary
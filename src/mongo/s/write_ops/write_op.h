@@ -122,6 +122,15 @@ public:
                         const NSTargeter& targeter,
                         std::vector<TargetedWrite*>* targetedWrites);
 
+    /**
+     * Same as above, but for an insert whose endpoint was already resolved by
+     * NSTargeter::targetInserts as part of its batch.
+     */
+    Status targetWrites(OperationContext* opCtx,
+                        const NSTargeter& targeter,
+                        StatusWith<ShardEndpoint> swInsertEndpoint,
+                        std::vector<TargetedWrite*>* targetedWrites);
+
     /**
      * Returns the number of child writes that were last targeted.
      */
@@ -160,6 +169,14 @@ public:
     void setOpError(const WriteErrorDetail& error);
 
 private:
+    /**
+     * Creates the TargetedWrites for the endpoints this write op was targeted to.
+     */
+    Status _addChildOps(OperationContext* opCtx,
+                        const NSTargeter& targeter,
+                        StatusWith<std::vector<ShardEndpoint>> swEndpoints,
+                        std::vector<TargetedWrite*>* targetedWrites);
+
     /**
      * Updates the op state after new information is received.
      */
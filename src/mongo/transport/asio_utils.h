@@ -29,9 +29,12 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/base/status.h"
 #include "mongo/base/system_error.h"
 #include "mongo/config.h"
+#include "mongo/util/assert_util.h"
 #include "mongo/util/errno_util.h"
 #include "mongo/util/future.h"
 #include "mongo/util/net/hostandport.h"
@@ -323,6 +326,65 @@ boost::optional<std::array<std::uint8_t, 7>> checkTLSRequest(const Buffer& buffe
 }
 #endif
 
+/**
+ * A ConstBufferSequence made of several buffers, so that a Message whose bytes live in more than
+ * one place can be written with a single gather write.
+ *
+ * Besides iteration, it supports the parts of the asio::const_buffer interface that the
+ * opportunistic write path uses: size() is the total number of bytes, operator+= consumes bytes
+ * from the front, and data() and the conversion to asio::const_buffer refer to the first buffer.
+ */
+class ConstBufferVector {
+public:
+    using value_type = asio::const_buffer;
+    using const_iterator = std::vector<asio::const_buffer>::const_iterator;
+
+    ConstBufferVector() = default;
+
+    explicit ConstBufferVector(std::vector<asio::const_buffer> buffers)
+        : _buffers(std::move(buffers)), _size(asio::buffer_size(_buffers)) {}
+
+    const_iterator begin() const {
+        return _buffers.begin() + _first;
+    }
+
+    const_iterator end() const {
+        return _buffers.end();
+    }
+
+    std::size_t size() const {
+        return _size;
+    }
+
+    const void* data() const {
+        return _first < _buffers.size() ? _buffers[_first].data() : nullptr;
+    }
+
+    operator asio::const_buffer() const {
+        return _first < _buffers.size() ? _buffers[_first] : asio::const_buffer();
+    }
+
+    ConstBufferVector& operator+=(std::size_t bytes) {
+        invariant(bytes <= _size);
+        _size -= bytes;
+        while (bytes && _first < _buffers.size()) {
+            auto& front = _buffers[_first];
+            if (bytes < front.size()) {
+                front += bytes;
+                break;
+            }
+            bytes -= front.size();
+            ++_first;
+        }
+        return *this;
+    }
+
+private:
+    std::vector<asio::const_buffer> _buffers;
+    std::size_t _first = 0;
+    std::size_t _size = 0;
+};
+
 /**
  * Pass this to asio functions in place of a callback to have them return a Future<T>. This behaves
  * similarly to asio::use_future_t, however it returns a mongo::Future<T> rather than a
@@ -0,0 +1,266 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/io_uring.h"
+
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+int sysIoUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sysIoUringEnter(
+    int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize) {
+    return static_cast<int>(
+        ::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize));
+}
+
+int sysIoUringRegister(int fd, unsigned opcode, void* arg, unsigned nrArgs) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+void* mapRing(int fd, size_t size, off_t offset) {
+    auto ptr =
+        ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+void* mapAnonymous(size_t size) {
+    auto ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+Status errnoStatus(StringData what, int err) {
+    return Status(ErrorCodes::OperationFailed,
+                  str::stream() << what << " failed: " << errnoWithDescription(err));
+}
+
+}  // namespace
+
+StatusWith<std::unique_ptr<IoUring>> IoUring::make(unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CLAMP;
+
+    const int fd = sysIoUringSetup(entries, &params);
+    if (fd < 0) {
+        return errnoStatus("io_uring_setup", errno);
+    }
+
+    std::unique_ptr<IoUring> ring(new IoUring());
+    ring->_fd = fd;
+
+    const auto kRequiredFeatures = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & kRequiredFeatures) != kRequiredFeatures) {
+        return Status(ErrorCodes::OperationFailed,
+                      "The running kernel's io_uring lacks the NODROP and EXT_ARG features");
+    }
+
+    ring->_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        ring->_sqRingSize = ring->_cqRingSize = std::max(ring->_sqRingSize, ring->_cqRingSize);
+    }
+
+    ring->_sqRing = mapRing(fd, ring->_sqRingSize, IORING_OFF_SQ_RING);
+    if (!ring->_sqRing) {
+        return errnoStatus("mmap of the io_uring submission queue", errno);
+    }
+
+    if (singleMmap) {
+        ring->_cqRing = ring->_sqRing;
+    } else {
+        ring->_cqRing = mapRing(fd, ring->_cqRingSize, IORING_OFF_CQ_RING);
+        if (!ring->_cqRing) {
+            return errnoStatus("mmap of the io_uring completion queue", errno);
+        }
+    }
+
+    ring->_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    ring->_sqes = static_cast<io_uring_sqe*>(mapRing(fd, ring->_sqesSize, IORING_OFF_SQES));
+    if (!ring->_sqes) {
+        return errnoStatus("mmap of the io_uring submission entries", errno);
+    }
+
+    auto sq = static_cast<char*>(ring->_sqRing);
+    ring->_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    ring->_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    ring->_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    ring->_sqEntries = params.sq_entries;
+    ring->_sqLocalTail = *ring->_sqTail;
+
+    // SQEs are always filled in ring order, so the indirection array is the identity mapping.
+    auto array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < params.sq_entries; ++i) {
+        array[i] = i;
+    }
+
+    auto cq = static_cast<char*>(ring->_cqRing);
+    ring->_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    ring->_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    ring->_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    ring->_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    return {std::move(ring)};
+}
+
+IoUring::~IoUring() {
+    if (_bufferBase) {
+        ::munmap(_bufferBase, _bufferSize * _bufCount);
+    }
+    if (_bufRing) {
+        ::munmap(_bufRing, _bufRingSize);
+    }
+    if (_sqes) {
+        ::munmap(_sqes, _sqesSize);
+    }
+    if (_cqRing && _cqRing != _sqRing) {
+        ::munmap(_cqRing, _cqRingSize);
+    }
+    if (_sqRing) {
+        ::munmap(_sqRing, _sqRingSize);
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+}
+
+io_uring_sqe* IoUring::getSqe() {
+    const auto head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+    if (_sqLocalTail - head >= _sqEntries) {
+        return nullptr;
+    }
+
+    auto sqe = &_sqes[_sqLocalTail & _sqMask];
+    ++_sqLocalTail;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+unsigned IoUring::publishSqes() {
+    __atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+    return _sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+}
+
+int IoUring::submit() {
+    const auto toSubmit = publishSqes();
+    if (toSubmit == 0) {
+        return 0;
+    }
+
+    int ret;
+    do {
+        ret = sysIoUringEnter(_fd, toSubmit, 0, 0, nullptr, 0);
+    } while (ret < 0 && errno == EINTR);
+
+    return ret < 0 ? -errno : ret;
+}
+
+int IoUring::submitAndWait(unsigned toSubmit, Milliseconds timeout) {
+    const auto millis = std::max<int64_t>(timeout.count(), 0);
+    __kernel_timespec ts;
+    ts.tv_sec = millis / 1000;
+    ts.tv_nsec = (millis % 1000) * 1000 * 1000;
+
+    io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+
+    const int ret = sysIoUringEnter(
+        _fd, toSubmit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if (ret < 0 && (errno == ETIME || errno == EINTR)) {
+        return 0;
+    }
+
+    return ret < 0 ? -errno : ret;
+}
+
+Status IoUring::registerBufferRing(uint16_t bgid, uint16_t count, size_t size) {
+    invariant(!_bufRing);
+    invariant(count > 0 && (count & (count - 1)) == 0);
+
+    _bufRingSize = count * sizeof(io_uring_buf);
+    _bufRing = static_cast<io_uring_buf_ring*>(mapAnonymous(_bufRingSize));
+    if (!_bufRing) {
+        return errnoStatus("mmap of the io_uring provided buffer ring", errno);
+    }
+
+    _bufferBase = static_cast<char*>(mapAnonymous(size * count));
+    if (!_bufferBase) {
+        return errnoStatus("mmap of the io_uring provided buffers", errno);
+    }
+    _bufferSize = size;
+    _bufCount = count;
+    _bgid = bgid;
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(_bufRing);
+    reg.ring_entries = count;
+    reg.bgid = bgid;
+    if (sysIoUringRegister(_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        return errnoStatus("io_uring_register(IORING_REGISTER_PBUF_RING)", errno);
+    }
+
+    for (uint16_t bid = 0; bid < count; ++bid) {
+        auto& buf = _bufRing->bufs[bid];
+        buf.addr = reinterpret_cast<uint64_t>(providedBuffer(bid));
+        buf.len = static_cast<uint32_t>(size);
+        buf.bid = bid;
+    }
+    __atomic_store_n(&_bufRing->tail, count, __ATOMIC_RELEASE);
+
+    return Status::OK();
+}
+
+void IoUring::recycleBuffer(uint16_t bid) {
+    const uint16_t tail = _bufRing->tail;
+    auto& buf = _bufRing->bufs[tail & (_bufCount - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(providedBuffer(bid));
+    buf.len = static_cast<uint32_t>(_bufferSize);
+    buf.bid = bid;
+    __atomic_store_n(&_bufRing->tail, static_cast<uint16_t>(tail + 1), __ATOMIC_RELEASE);
+}
+
+}  // namespace transport
+}  // namespace mongo
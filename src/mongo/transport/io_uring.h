@@ -0,0 +1,158 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <memory>
+
+#include "mongo/base/status_with.h"
+#include "mongo/util/duration.h"
+
+namespace mongo {
+namespace transport {
+
+/**
+ * A thin wrapper around a Linux io_uring instance that talks to the kernel through the raw
+ * io_uring_setup/io_uring_enter/io_uring_register system calls.
+ *
+ * The rings are not internally synchronized. Callers must serialize getSqe(), publishSqes() and
+ * submit() against each other, and reapCompletions() and recycleBuffer() against themselves.
+ * submitAndWait() only enters the kernel and may run concurrently with the submission side.
+ */
+class IoUring {
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+public:
+    /**
+     * Creates a ring with room for at least 'entries' submissions. Fails if the kernel does not
+     * support io_uring or lacks the features (EXT_ARG, NODROP) this wrapper depends on.
+     */
+    static StatusWith<std::unique_ptr<IoUring>> make(unsigned entries);
+
+    ~IoUring();
+
+    /**
+     * Returns a zeroed SQE at the tail of the submission queue, or nullptr if the queue is full.
+     * The entry becomes visible to the kernel on the next submit().
+     */
+    io_uring_sqe* getSqe();
+
+    /**
+     * Makes all prepared SQEs visible to the kernel and returns how many it has yet to consume.
+     */
+    unsigned publishSqes();
+
+    /**
+     * Hands all prepared SQEs to the kernel with a single io_uring_enter() call. Returns the
+     * number submitted, or a negative errno.
+     */
+    int submit();
+
+    /**
+     * Submits 'toSubmit' published SQEs and waits up to 'timeout' for at least one completion.
+     * Returns the number submitted, or a negative errno. Timing out is not an error.
+     */
+    int submitAndWait(unsigned toSubmit, Milliseconds timeout);
+
+    /**
+     * Invokes 'cb(const io_uring_cqe&)' for every completion currently in the CQ ring, then
+     * releases them back to the kernel. Returns the number reaped.
+     */
+    template <typename Callback>
+    size_t reapCompletions(Callback&& cb) {
+        auto head = *_cqHead;
+        const auto tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+        size_t reaped = 0;
+        for (; head != tail; ++head, ++reaped) {
+            cb(_cqes[head & _cqMask]);
+        }
+        __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+        return reaped;
+    }
+
+    /**
+     * Registers a ring of 'count' provided buffers of 'size' bytes each under buffer group 'bgid'
+     * (IORING_REGISTER_PBUF_RING). Receives issued with IOSQE_BUFFER_SELECT and this group pick a
+     * buffer from the ring and report its id in the CQE. Only one group may be registered.
+     */
+    Status registerBufferRing(uint16_t bgid, uint16_t count, size_t size);
+
+    /**
+     * Returns the start of provided buffer 'bid'.
+     */
+    char* providedBuffer(uint16_t bid) const {
+        return _bufferBase + static_cast<size_t>(bid) * _bufferSize;
+    }
+
+    /**
+     * Gives provided buffer 'bid' back to the kernel once its contents have been consumed.
+     */
+    void recycleBuffer(uint16_t bid);
+
+    int fd() const {
+        return _fd;
+    }
+
+private:
+    IoUring() = default;
+
+    int _fd = -1;
+
+    void* _sqRing = nullptr;
+    size_t _sqRingSize = 0;
+    void* _cqRing = nullptr;
+    size_t _cqRingSize = 0;
+    io_uring_sqe* _sqes = nullptr;
+    size_t _sqesSize = 0;
+
+    unsigned* _sqHead = nullptr;
+    unsigned* _sqTail = nullptr;
+    unsigned _sqMask = 0;
+    unsigned _sqEntries = 0;
+    unsigned _sqLocalTail = 0;
+
+    unsigned* _cqHead = nullptr;
+    unsigned* _cqTail = nullptr;
+    unsigned _cqMask = 0;
+    io_uring_cqe* _cqes = nullptr;
+
+    io_uring_buf_ring* _bufRing = nullptr;
+    size_t _bufRingSize = 0;
+    char* _bufferBase = nullptr;
+    size_t _bufferSize = 0;
+    uint16_t _bufCount = 0;
+    uint16_t _bgid = 0;
+};
+
+}  // namespace transport
+}  // namespace mongo
@@ -36,6 +36,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/transport/service_executor_adaptive.h"
 #include "mongo/transport/service_executor_synchronous.h"
+#include "mongo/transport/service_executor_work_stealing.h"
 #include "mongo/transport/service_executor_task_names.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
@@ -93,7 +94,14 @@ public:
     ASIOReactor() : _ioContext() {}
 
     void run() noexcept final {
-        MONGO_UNREACHABLE;
+        asio::io_context::work work(_ioContext);
+
+        try {
+            _ioContext.run();
+        } catch (...) {
+            severe() << "Uncaught exception in reactor: " << exceptionToStatus();
+            fassertFailed(51263);
+        }
     }
 
     void runFor(Milliseconds time) noexcept final {
@@ -164,6 +172,45 @@ protected:
     std::shared_ptr<asio::io_context> asioIOCtx;
 };
 
+struct WorkStealingTestOptions : public ServiceExecutorWorkStealing::Options {
+    int workerThreads() const final {
+        return 2;
+    }
+
+    bool pinWorkerThreads() const final {
+        return false;
+    }
+
+    int recursionLimit() const final {
+        return 8;
+    }
+
+    Milliseconds stuckThreadTimeout() const final {
+        return Milliseconds{100};
+    }
+};
+
+class ServiceExecutorWorkStealingFixture : public unittest::Test {
+protected:
+    void setUp() override {
+        auto scOwned = ServiceContext::make();
+        setGlobalServiceContext(std::move(scOwned));
+
+        executor = std::make_unique<ServiceExecutorWorkStealing>(
+            getGlobalServiceContext(),
+            std::make_shared<ASIOReactor>(),
+            std::make_unique<WorkStealingTestOptions>());
+    }
+
+    BSONObj stats() const {
+        BSONObjBuilder bob;
+        executor->appendStats(&bob);
+        return bob.obj();
+    }
+
+    std::unique_ptr<ServiceExecutorWorkStealing> executor;
+};
+
 class ServiceExecutorSynchronousFixture : public unittest::Test {
 protected:
     void setUp() override {
@@ -206,6 +253,107 @@ TEST_F(ServiceExecutorAdaptiveFixture, ScheduleFailsBeforeStartup) {
     scheduleBasicTask(executor.get(), false);
 }
 
+TEST_F(ServiceExecutorWorkStealingFixture, BasicTaskRuns) {
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    scheduleBasicTask(executor.get(), true);
+}
+
+TEST_F(ServiceExecutorWorkStealingFixture, ScheduleFailsBeforeStartup) {
+    scheduleBasicTask(executor.get(), false);
+}
+
+TEST_F(ServiceExecutorWorkStealingFixture, IdleWorkerStealsQueuedTasks) {
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    constexpr int kNumTasks = 10;
+    stdx::mutex mutex;
+    stdx::condition_variable cond;
+    int tasksRun = 0;
+    bool allRan = false;
+
+    // The first task queues more tasks on its own worker and then blocks until they have all run,
+    // which can only happen if the other worker steals them.
+    auto status = executor->schedule(
+        [&] {
+            for (int i = 0; i < kNumTasks; i++) {
+                invariant(executor->schedule(
+                    [&] {
+                        stdx::lock_guard<stdx::mutex> lk(mutex);
+                        if (++tasksRun == kNumTasks) {
+                            cond.notify_all();
+                        }
+                    },
+                    ServiceExecutor::kEmptyFlags,
+                    ServiceExecutorTaskName::kSSMProcessMessage));
+            }
+
+            stdx::unique_lock<stdx::mutex> lk(mutex);
+            allRan = cond.wait_for(
+                lk, stdx::chrono::seconds(10), [&] { return tasksRun == kNumTasks; });
+            cond.notify_all();
+        },
+        ServiceExecutor::kEmptyFlags,
+        ServiceExecutorTaskName::kSSMStartSession);
+    ASSERT_OK(status);
+
+    {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        cond.wait_for(lk, stdx::chrono::seconds(10), [&] { return allRan; });
+    }
+    ASSERT_TRUE(allRan);
+
+    auto executorStats = stats();
+    ASSERT_GT(executorStats["steals"].numberLong(), 0);
+    ASSERT_GTE(executorStats["tasksStolen"].numberLong(), kNumTasks);
+    ASSERT_EQ(executorStats["workers"].Array().size(), 2U);
+}
+
+TEST_F(ServiceExecutorWorkStealingFixture, OverflowThreadRunsTasksBehindBlockedWorkers) {
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    stdx::mutex mutex;
+    stdx::condition_variable cond;
+    int blocked = 0;
+    bool released = false;
+
+    // Block both workers on a task that only the last task can release.
+    for (int i = 0; i < 2; i++) {
+        ASSERT_OK(executor->schedule(
+            [&] {
+                stdx::unique_lock<stdx::mutex> lk(mutex);
+                ++blocked;
+                cond.notify_all();
+                cond.wait_for(lk, stdx::chrono::seconds(10), [&] { return released; });
+            },
+            ServiceExecutor::kEmptyFlags,
+            ServiceExecutorTaskName::kSSMProcessMessage));
+    }
+
+    {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        ASSERT_TRUE(cond.wait_for(lk, stdx::chrono::seconds(10), [&] { return blocked == 2; }));
+    }
+
+    ASSERT_OK(executor->schedule(
+        [&] {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            released = true;
+            cond.notify_all();
+        },
+        ServiceExecutor::kEmptyFlags,
+        ServiceExecutorTaskName::kSSMProcessMessage));
+
+    {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        ASSERT_TRUE(cond.wait_for(lk, stdx::chrono::seconds(10), [&] { return released; }));
+    }
+    ASSERT_GTE(stats()["overflowThreadsStarted"].numberLong(), 1);
+}
+
 TEST_F(ServiceExecutorSynchronousFixture, BasicTaskRuns) {
     ASSERT_OK(executor->start());
     auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
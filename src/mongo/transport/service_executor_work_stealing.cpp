@@ -0,0 +1,566 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kExecutor;
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/service_executor_work_stealing.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "mongo/transport/service_entry_point_utils.h"
+#include "mongo/transport/service_executor_gen.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace transport {
+
+namespace {
+constexpr auto kTotalQueued = "totalQueued"_sd;
+constexpr auto kTotalExecuted = "totalExecuted"_sd;
+constexpr auto kThreadsInUse = "threadsInUse"_sd;
+constexpr auto kThreadsRunning = "threadsRunning"_sd;
+constexpr auto kExecutorLabel = "executor"_sd;
+constexpr auto kExecutorName = "workStealing"_sd;
+constexpr auto kQueueDepth = "queueDepth"_sd;
+constexpr auto kSteals = "steals"_sd;
+constexpr auto kTasksStolen = "tasksStolen"_sd;
+constexpr auto kYields = "yields"_sd;
+constexpr auto kOverflowThreadsStarted = "overflowThreadsStarted"_sd;
+constexpr auto kWorkers = "workers"_sd;
+constexpr auto kExecuted = "executed"_sd;
+
+// Idle workers wake up this often to look for work to steal, in case a busy worker's queue grew
+// without it asking for help.
+constexpr Milliseconds kIdleStealInterval{20};
+
+struct ServerParameterOptions : public ServiceExecutorWorkStealing::Options {
+    int workerThreads() const final {
+        int value = workStealingServiceExecutorWorkerThreads.load();
+        if (value == -1) {
+            value = std::max(static_cast<int>(ProcessInfo::getNumAvailableCores()), 2);
+            workStealingServiceExecutorWorkerThreads.store(value);
+            log() << "No worker thread count configured for executor. Using number of cores: "
+                  << value;
+        }
+        return value;
+    }
+
+    bool pinWorkerThreads() const final {
+        return workStealingServiceExecutorPinWorkerThreads.load();
+    }
+
+    int recursionLimit() const final {
+        return workStealingServiceExecutorRecursionLimit.load();
+    }
+
+    Milliseconds stuckThreadTimeout() const final {
+        return Milliseconds{workStealingServiceExecutorStuckThreadTimeoutMillis.load()};
+    }
+};
+
+}  // namespace
+
+thread_local ServiceExecutorWorkStealing* ServiceExecutorWorkStealing::_localExecutor = nullptr;
+thread_local ServiceExecutorWorkStealing::Worker* ServiceExecutorWorkStealing::_localWorker =
+    nullptr;
+thread_local int ServiceExecutorWorkStealing::_localRecursionDepth = 0;
+
+ServiceExecutorWorkStealing::ServiceExecutorWorkStealing(ServiceContext* ctx,
+                                                         ReactorHandle reactor)
+    : ServiceExecutorWorkStealing(
+          ctx, std::move(reactor), std::make_unique<ServerParameterOptions>()) {}
+
+ServiceExecutorWorkStealing::ServiceExecutorWorkStealing(ServiceContext* ctx,
+                                                         ReactorHandle reactor,
+                                                         std::unique_ptr<Options> config)
+    : _reactorHandle(std::move(reactor)), _config(std::move(config)) {}
+
+ServiceExecutorWorkStealing::~ServiceExecutorWorkStealing() {
+    invariant(!_isRunning.load());
+}
+
+Status ServiceExecutorWorkStealing::start() {
+    invariant(!_isRunning.load());
+
+    const auto numWorkers = std::max(_config->workerThreads(), 1);
+    _workers.clear();
+    for (auto i = 0; i < numWorkers; i++) {
+        _workers.push_back(std::make_unique<Worker>());
+    }
+
+#ifndef __linux__
+    if (_config->pinWorkerThreads()) {
+        warning() << "Pinning service executor worker threads is only supported on Linux";
+    }
+#endif
+
+    _isRunning.store(true);
+
+    // Network completions run on a thread of their own, which only turns them into tasks for the
+    // workers. Workers issue I/O themselves and only wait for the reactor if it would block.
+    _reactorThread = stdx::thread([this] {
+        setThreadName("worker-reactor"_sd);
+        _reactorHandle->run();
+    });
+    _controllerThread = stdx::thread(&ServiceExecutorWorkStealing::_controllerThreadRoutine, this);
+
+    for (size_t i = 0; i < _workers.size(); i++) {
+        _threadsRunning.addAndFetch(1);
+        const auto launchResult =
+            launchServiceWorkerThread([this, i] { _workerThreadRoutine(i); });
+        if (!launchResult.isOK()) {
+            // Tasks handed to a worker that never started would only run when stolen, so give up.
+            warning() << "Failed to launch new worker thread: " << launchResult;
+            _threadExited();
+            shutdown(_config->stuckThreadTimeout()).ignore();
+            return launchResult;
+        }
+    }
+
+    return Status::OK();
+}
+
+Status ServiceExecutorWorkStealing::shutdown(Milliseconds timeout) {
+    if (!_isRunning.load())
+        return Status::OK();
+
+    _isRunning.store(false);
+
+    for (auto& worker : _workers) {
+        stdx::lock_guard<stdx::mutex> lk(worker->mutex);
+        worker->wakeup.notify_one();
+    }
+    {
+        stdx::lock_guard<stdx::mutex> lk(_threadsMutex);
+        _controllerWakeup.notify_one();
+    }
+    _controllerThread.join();
+
+    _reactorHandle->stop();
+    _reactorThread.join();
+
+    stdx::unique_lock<stdx::mutex> lk(_threadsMutex);
+    bool result = _deathCondition.wait_for(
+        lk, timeout.toSystemDuration(), [&] { return _threadsRunning.load() == 0; });
+
+    return result
+        ? Status::OK()
+        : Status(ErrorCodes::Error::ExceededTimeLimit,
+                 "work-stealing executor couldn't shutdown all worker threads within time limit.");
+}
+
+Status ServiceExecutorWorkStealing::schedule(Task task,
+                                             ScheduleFlags flags,
+                                             ServiceExecutorTaskName taskName) {
+    if (!_isRunning.load()) {
+        return {ErrorCodes::ShutdownInProgress, "Executor is not running"};
+    }
+
+    _totalQueued.addAndFetch(1);
+    const bool onExecutorThread = _localExecutor == this;
+
+    // Recursing is only allowed while running one of our tasks. The reactor thread must never run
+    // tasks itself, or it would stop delivering network completions.
+    if (onExecutorThread && (flags & kMayRecurse) && _localRecursionDepth > 0 &&
+        _localRecursionDepth < _config->recursionLimit()) {
+        ++_localRecursionDepth;
+        const auto guard = makeGuard([this] {
+            --_localRecursionDepth;
+            _totalExecuted.addAndFetch(1);
+        });
+        task();
+        return Status::OK();
+    }
+
+    if (onExecutorThread && _localWorker) {
+        // A task scheduled between two requests yields to whatever else is queued on this worker.
+        // Any other task continues the work in progress and runs next, while its data is still
+        // in this core's caches.
+        const bool yield = flags & kMayYieldBeforeSchedule;
+        if (yield && _localWorker->queueDepth.load() > 0) {
+            _yields.addAndFetch(1);
+        }
+        _push(_localWorker, std::move(task), !yield);
+
+        // The task after the next one would wait for the current task to finish, so let an idle
+        // worker steal it instead.
+        if (_localWorker->queueDepth.load() > 1) {
+            _wakeSleeper();
+        }
+        return Status::OK();
+    }
+
+    _push(_pickWorker(), std::move(task), false);
+    return Status::OK();
+}
+
+void ServiceExecutorWorkStealing::_push(Worker* worker, Task task, bool front) {
+    stdx::lock_guard<stdx::mutex> lk(worker->mutex);
+    if (front) {
+        worker->queue.push_front(std::move(task));
+    } else {
+        worker->queue.push_back(std::move(task));
+    }
+    worker->queueDepth.store(worker->queue.size());
+
+    if (worker->sleeping.load()) {
+        worker->wakeup.notify_one();
+    }
+}
+
+ServiceExecutorWorkStealing::Worker* ServiceExecutorWorkStealing::_pickWorker() {
+    const auto numWorkers = _workers.size();
+    const auto start = _nextWorker.fetchAndAdd(1);
+
+    if (_sleepingWorkers.load() > 0) {
+        for (size_t i = 0; i < numWorkers; i++) {
+            auto worker = _workers[(start + i) % numWorkers].get();
+            if (worker->sleeping.load()) {
+                return worker;
+            }
+        }
+    }
+
+    // Everyone is busy, so pick the shorter of two queues.
+    auto first = _workers[start % numWorkers].get();
+    auto second = _workers[(start + numWorkers / 2) % numWorkers].get();
+    return first->queueDepth.load() <= second->queueDepth.load() ? first : second;
+}
+
+void ServiceExecutorWorkStealing::_wakeSleeper() {
+    if (_sleepingWorkers.load() == 0) {
+        return;
+    }
+
+    const auto numWorkers = _workers.size();
+    const auto start = _nextWorker.fetchAndAdd(1);
+    for (size_t i = 0; i < numWorkers; i++) {
+        auto worker = _workers[(start + i) % numWorkers].get();
+        if (worker == _localWorker || !worker->sleeping.load()) {
+            continue;
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(worker->mutex);
+        if (worker->sleeping.load()) {
+            worker->stealRequested = true;
+            worker->wakeup.notify_one();
+            return;
+        }
+    }
+}
+
+bool ServiceExecutorWorkStealing::_popLocal(Worker* worker, Task* task) {
+    stdx::lock_guard<stdx::mutex> lk(worker->mutex);
+    if (worker->queue.empty()) {
+        return false;
+    }
+
+    *task = std::move(worker->queue.front());
+    worker->queue.pop_front();
+    worker->queueDepth.store(worker->queue.size());
+    return true;
+}
+
+bool ServiceExecutorWorkStealing::_steal(Worker* thief, Task* task) {
+    const auto numWorkers = _workers.size();
+    const auto start = _nextWorker.fetchAndAdd(1);
+
+    for (size_t i = 0; i < numWorkers; i++) {
+        auto victim = _workers[(start + i) % numWorkers].get();
+        if (victim == thief || victim->queueDepth.load() == 0) {
+            continue;
+        }
+
+        // Take half of the victim's queue from the back, which is the work it would get to last.
+        // Overflow threads have no queue to keep the rest in, so they take one task at a time.
+        std::vector<Task> loot;
+        {
+            stdx::lock_guard<stdx::mutex> lk(victim->mutex);
+            const auto count = thief ? (victim->queue.size() + 1) / 2 : std::size_t(1);
+            for (size_t j = 0; j < count && !victim->queue.empty(); j++) {
+                loot.push_back(std::move(victim->queue.back()));
+                victim->queue.pop_back();
+            }
+            victim->queueDepth.store(victim->queue.size());
+        }
+
+        if (loot.empty()) {
+            continue;
+        }
+
+        const auto stolen = static_cast<int64_t>(loot.size());
+        _steals.addAndFetch(1);
+        _tasksStolen.addAndFetch(stolen);
+        if (thief) {
+            thief->tasksStolen.addAndFetch(stolen);
+        }
+
+        // The loot is newest first. Run the oldest task now and queue the rest in their order.
+        *task = std::move(loot.back());
+        loot.pop_back();
+        if (!loot.empty()) {
+            stdx::lock_guard<stdx::mutex> lk(thief->mutex);
+            for (auto it = loot.rbegin(); it != loot.rend(); ++it) {
+                thief->queue.push_back(std::move(*it));
+            }
+            thief->queueDepth.store(thief->queue.size());
+        }
+        return true;
+    }
+
+    return false;
+}
+
+bool ServiceExecutorWorkStealing::_hasQueuedTasks() const {
+    for (const auto& worker : _workers) {
+        if (worker->queueDepth.load() > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ServiceExecutorWorkStealing::_runTask(Worker* worker, Task& task) {
+    _threadsInUse.addAndFetch(1);
+    _tasksStarted.addAndFetch(1);
+    _localRecursionDepth = 1;
+    const auto guard = makeGuard([this, worker, &task] {
+        // Release whatever the task holds on to before counting it as done.
+        task = nullptr;
+        _localRecursionDepth = 0;
+        _threadsInUse.subtractAndFetch(1);
+        _totalExecuted.addAndFetch(1);
+        if (worker) {
+            worker->executed.addAndFetch(1);
+        }
+    });
+
+    task();
+}
+
+void ServiceExecutorWorkStealing::_workerThreadRoutine(size_t index) {
+    auto worker = _workers[index].get();
+    _localExecutor = this;
+    _localWorker = worker;
+    {
+        std::string threadName = str::stream() << "worker-" << index;
+        setThreadName(threadName);
+    }
+
+    if (_config->pinWorkerThreads()) {
+        _pinToCpu(index);
+    }
+
+    log() << "Started new database worker thread " << index;
+
+    const auto guard = makeGuard([this] {
+        _localExecutor = nullptr;
+        _localWorker = nullptr;
+        _threadExited();
+    });
+
+    while (_isRunning.load()) {
+        Task task;
+        if (_popLocal(worker, &task) || _steal(worker, &task)) {
+            _runTask(worker, task);
+            continue;
+        }
+
+        stdx::unique_lock<stdx::mutex> lk(worker->mutex);
+        if (!worker->queue.empty()) {
+            continue;
+        }
+
+        worker->sleeping.store(true);
+        _sleepingWorkers.addAndFetch(1);
+        worker->wakeup.wait_for(lk, kIdleStealInterval.toSystemDuration(), [&] {
+            return !worker->queue.empty() || worker->stealRequested || !_isRunning.load();
+        });
+        worker->stealRequested = false;
+        worker->sleeping.store(false);
+        _sleepingWorkers.subtractAndFetch(1);
+    }
+}
+
+void ServiceExecutorWorkStealing::_pinToCpu(size_t index) {
+#ifdef __linux__
+    // Spread the workers over the CPUs this process is allowed to run on.
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        warning() << "Failed to get the CPU affinity of worker thread " << index << ": "
+                  << errnoWithDescription();
+        return;
+    }
+
+    const auto numCpus = CPU_COUNT(&allowed);
+    if (numCpus == 0) {
+        return;
+    }
+
+    auto remaining = static_cast<int>(index % numCpus);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed) || remaining-- > 0) {
+            continue;
+        }
+
+        cpu_set_t pinned;
+        CPU_ZERO(&pinned);
+        CPU_SET(cpu, &pinned);
+        if (int err = pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned)) {
+            warning() << "Failed to pin worker thread " << index << " to CPU " << cpu << ": "
+                      << errnoWithDescription(err);
+        } else {
+            LOG(1) << "Pinned worker thread " << index << " to CPU " << cpu;
+        }
+        return;
+    }
+#endif
+}
+
+void ServiceExecutorWorkStealing::_controllerThreadRoutine() {
+    setThreadName("worker-controller"_sd);
+
+    auto lastStarted = _tasksStarted.load();
+    stdx::unique_lock<stdx::mutex> lk(_threadsMutex);
+    while (_isRunning.load()) {
+        _controllerWakeup.wait_for(lk, _config->stuckThreadTimeout().toSystemDuration(), [this] {
+            return !_isRunning.load();
+        });
+        if (!_isRunning.load()) {
+            break;
+        }
+
+        // If every thread is busy, tasks are queued, and not a single task has started since the
+        // last check, the tasks being run are blocked and need another thread to make progress.
+        const auto started = _tasksStarted.load();
+        const bool madeProgress = started != lastStarted;
+        lastStarted = started;
+        if (madeProgress || _threadsInUse.load() < _threadsRunning.load() || !_hasQueuedTasks()) {
+            continue;
+        }
+
+        lk.unlock();
+        log() << "Detected blocked worker threads, starting overflow thread to run queued tasks.";
+        _startOverflowThread();
+        lk.lock();
+    }
+}
+
+void ServiceExecutorWorkStealing::_startOverflowThread() {
+    const auto id = _overflowThreadsStarted.addAndFetch(1);
+    _threadsRunning.addAndFetch(1);
+
+    const auto launchResult = launchServiceWorkerThread([this, id] { _overflowThreadRoutine(id); });
+    if (!launchResult.isOK()) {
+        warning() << "Failed to launch new overflow worker thread: " << launchResult;
+        _overflowThreadsStarted.subtractAndFetch(1);
+        _threadExited();
+    }
+}
+
+void ServiceExecutorWorkStealing::_overflowThreadRoutine(int64_t id) {
+    _localExecutor = this;
+    {
+        std::string threadName = str::stream() << "worker-overflow-" << id;
+        setThreadName(threadName);
+    }
+
+    const auto guard = makeGuard([this] {
+        _localExecutor = nullptr;
+        _threadExited();
+    });
+
+    // Once it has found nothing to steal for as long as it took to detect that the workers were
+    // blocked, the overflow thread is no longer needed.
+    auto lastTaskTime = stdx::chrono::steady_clock::now();
+    while (_isRunning.load()) {
+        Task task;
+        if (_steal(nullptr, &task)) {
+            _runTask(nullptr, task);
+            lastTaskTime = stdx::chrono::steady_clock::now();
+            continue;
+        }
+
+        if (stdx::chrono::steady_clock::now() - lastTaskTime >=
+            _config->stuckThreadTimeout().toSystemDuration()) {
+            break;
+        }
+        stdx::this_thread::sleep_for(Milliseconds{1}.toSystemDuration());
+    }
+
+    log() << "Overflow worker thread " << id << " ran out of work. Exiting thread.";
+}
+
+void ServiceExecutorWorkStealing::_threadExited() {
+    stdx::lock_guard<stdx::mutex> lk(_threadsMutex);
+    _threadsRunning.subtractAndFetch(1);
+    _deathCondition.notify_one();
+}
+
+void ServiceExecutorWorkStealing::appendStats(BSONObjBuilder* bob) const {
+    int64_t queueDepth = 0;
+    for (const auto& worker : _workers) {
+        queueDepth += worker->queueDepth.load();
+    }
+
+    *bob << kExecutorLabel << kExecutorName                            //
+         << kTotalQueued << _totalQueued.load()                        //
+         << kTotalExecuted << _totalExecuted.load()                    //
+         << kThreadsInUse << _threadsInUse.load()                      //
+         << kThreadsRunning << _threadsRunning.load()                  //
+         << kQueueDepth << queueDepth                                  //
+         << kSteals << _steals.load()                                  //
+         << kTasksStolen << _tasksStolen.load()                        //
+         << kYields << _yields.load()                                  //
+         << kOverflowThreadsStarted << _overflowThreadsStarted.load();
+
+    BSONArrayBuilder workers(bob->subarrayStart(kWorkers));
+    for (const auto& worker : _workers) {
+        BSONObjBuilder workerStats(workers.subobjStart());
+        workerStats << kQueueDepth << worker->queueDepth.load()  //
+                    << kExecuted << worker->executed.load()      //
+                    << kTasksStolen << worker->tasksStolen.load();
+        workerStats.doneFast();
+    }
+    workers.doneFast();
+}
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,165 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "mongo/db/service_context.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/service_executor.h"
+#include "mongo/transport/service_executor_task_names.h"
+#include "mongo/transport/transport_layer.h"
+
+namespace mongo {
+namespace transport {
+
+/**
+ * An asynchronous ServiceExecutor with a fixed pool of worker threads, each with its own run
+ * queue.
+ *
+ * A task scheduled from a worker goes to that worker's queue: at the front if it continues the
+ * work the worker is doing, or at the back if it was scheduled with kMayYieldBeforeSchedule,
+ * which lets the other sessions queued on the worker run first. Tasks scheduled from other
+ * threads, such as the network completions run by the executor's reactor thread, are handed to
+ * an idle worker. A worker that runs out of work steals half of another worker's queue before
+ * going to sleep.
+ *
+ * The pool does not grow with load. To guarantee forward progress when every worker is blocked
+ * in a task, a controller thread starts a temporary overflow thread whenever tasks are queued and
+ * none has started for stuckThreadTimeout(). Overflow threads only steal, and exit once they run
+ * out of work.
+ */
+class ServiceExecutorWorkStealing final : public ServiceExecutor {
+public:
+    struct Options {
+        virtual ~Options() = default;
+        // The number of worker threads.
+        virtual int workerThreads() const = 0;
+
+        // Whether each worker thread is bound to a single CPU.
+        virtual bool pinWorkerThreads() const = 0;
+
+        // The maximum allowable depth of recursion for tasks scheduled with the MayRecurse flag
+        // before stack unwinding is forced.
+        virtual int recursionLimit() const = 0;
+
+        // How long queued tasks may wait with no task starting before an overflow thread is
+        // started.
+        virtual Milliseconds stuckThreadTimeout() const = 0;
+    };
+
+    ServiceExecutorWorkStealing(ServiceContext* ctx, ReactorHandle reactor);
+    ServiceExecutorWorkStealing(ServiceContext* ctx,
+                                ReactorHandle reactor,
+                                std::unique_ptr<Options> config);
+
+    ~ServiceExecutorWorkStealing();
+
+    Status start() final;
+    Status shutdown(Milliseconds timeout) final;
+    Status schedule(Task task, ScheduleFlags flags, ServiceExecutorTaskName taskName) final;
+
+    Mode transportMode() const final {
+        return Mode::kAsynchronous;
+    }
+
+    void appendStats(BSONObjBuilder* bob) const final;
+
+private:
+    struct Worker {
+        stdx::mutex mutex;
+        stdx::condition_variable wakeup;
+        // The front of the queue runs next; thieves take from the back.
+        std::deque<Task> queue;
+        bool stealRequested = false;
+
+        // These mirror state protected by the mutex so that other threads can check it cheaply.
+        AtomicWord<bool> sleeping{false};
+        AtomicWord<int64_t> queueDepth{0};
+        AtomicWord<int64_t> executed{0};
+        AtomicWord<int64_t> tasksStolen{0};
+    };
+
+    void _workerThreadRoutine(size_t index);
+    void _overflowThreadRoutine(int64_t id);
+    void _controllerThreadRoutine();
+    void _startOverflowThread();
+    void _threadExited();
+    void _pinToCpu(size_t index);
+
+    bool _popLocal(Worker* worker, Task* task);
+    bool _steal(Worker* thief, Task* task);
+    void _push(Worker* worker, Task task, bool front);
+    Worker* _pickWorker();
+    void _wakeSleeper();
+    void _runTask(Worker* worker, Task& task);
+    bool _hasQueuedTasks() const;
+
+    ReactorHandle _reactorHandle;
+    std::unique_ptr<Options> _config;
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    stdx::thread _reactorThread;
+    stdx::thread _controllerThread;
+
+    AtomicWord<bool> _isRunning{false};
+    AtomicWord<uint64_t> _nextWorker{0};
+    AtomicWord<int> _sleepingWorkers{0};
+
+    // Worker and overflow threads signal this condition variable when they exit so we can
+    // gracefully shut down the executor.
+    stdx::mutex _threadsMutex;
+    stdx::condition_variable _deathCondition;
+    stdx::condition_variable _controllerWakeup;
+
+    AtomicWord<int> _threadsRunning{0};
+    AtomicWord<int> _threadsInUse{0};
+    AtomicWord<int64_t> _tasksStarted{0};
+
+    // These counters are only used for reporting in serverStatus.
+    AtomicWord<int64_t> _totalQueued{0};
+    AtomicWord<int64_t> _totalExecuted{0};
+    AtomicWord<int64_t> _steals{0};
+    AtomicWord<int64_t> _tasksStolen{0};
+    AtomicWord<int64_t> _yields{0};
+    AtomicWord<int64_t> _overflowThreadsStarted{0};
+
+    static thread_local ServiceExecutorWorkStealing* _localExecutor;
+    static thread_local Worker* _localWorker;
+    static thread_local int _localRecursionDepth;
+};
+
+}  // namespace transport
+}  // namespace mongo
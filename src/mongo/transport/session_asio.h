@@ -150,6 +150,16 @@ public:
     Status sinkMessage(Message message) override {
         ensureSync();
 
+        if (canGatherWrite(message)) {
+            return write(gatherBuffers(message))
+                .then([this, &message] {
+                    if (_isIngressSession) {
+                        networkCounter.hitPhysicalOut(message.size());
+                    }
+                })
+                .getNoThrow();
+        }
+
         return write(asio::buffer(message.buf(), message.size()))
             .then([this, &message] {
                 if (_isIngressSession) {
@@ -161,6 +171,15 @@ public:
 
     Future<void> asyncSinkMessage(Message message, const BatonHandle& baton = nullptr) override {
         ensureAsync();
+        if (canGatherWrite(message)) {
+            return write(gatherBuffers(message), baton)
+                .then([this, message /*keep the buffers alive*/]() {
+                    if (_isIngressSession) {
+                        networkCounter.hitPhysicalOut(message.size());
+                    }
+                });
+        }
+
         return write(asio::buffer(message.buf(), message.size()), baton)
             .then([this, message /*keep the buffer alive*/]() {
                 if (_isIngressSession) {
@@ -417,6 +436,26 @@ private:
         return opportunisticRead(_socket, buffers, baton);
     }
 
+    /**
+     * Spliced messages are written straight from the buffers that hold their pieces, unless the
+     * bytes have to be encrypted, which copies them anyway.
+     */
+    bool canGatherWrite(const Message& message) const {
+#ifdef MONGO_CONFIG_SSL
+        if (_sslSocket) {
+            return false;
+        }
+#endif
+        return message.isSpliced();
+    }
+
+    static ConstBufferVector gatherBuffers(const Message& message) {
+        std::vector<asio::const_buffer> buffers;
+        message.forEachSegment(
+            [&](const char* data, size_t len) { buffers.emplace_back(data, len); });
+        return ConstBufferVector(std::move(buffers));
+    }
+
     template <typename ConstBufferSequence>
     Future<void> write(const ConstBufferSequence& buffers, const BatonHandle& baton = nullptr) {
 #ifdef MONGO_CONFIG_SSL
@@ -36,15 +36,23 @@
 #include <memory>
 
 #include "mongo/base/status.h"
+#include "mongo/config.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/transport/service_executor_adaptive.h"
 #include "mongo/transport/service_executor_synchronous.h"
+#include "mongo/transport/service_executor_work_stealing.h"
 #include "mongo/transport/session.h"
 #include "mongo/transport/transport_layer_asio.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/net/ssl_options.h"
 #include "mongo/util/net/ssl_types.h"
 #include "mongo/util/time_support.h"
 
+#ifdef MONGO_CONFIG_HAVE_LINUX_IO_URING
+#include "mongo/transport/transport_layer_uring.h"
+#endif
+
 namespace mongo {
 namespace transport {
 
@@ -128,27 +136,70 @@ std::unique_ptr<TransportLayer> TransportLayerManager::makeAndStartDefaultEgress
     return std::unique_ptr<TransportLayer>(std::move(ret));
 }
 
+namespace {
+/**
+ * Makes the asynchronous ServiceExecutor selected by --serviceExecutor, driven by 'reactor'.
+ */
+std::unique_ptr<ServiceExecutor> makeAsyncServiceExecutor(const ServerGlobalParams* config,
+                                                          ServiceContext* ctx,
+                                                          ReactorHandle reactor) {
+    if (config->serviceExecutor == "adaptive") {
+        return std::make_unique<ServiceExecutorAdaptive>(ctx, std::move(reactor));
+    } else if (config->serviceExecutor == "workStealing") {
+        return std::make_unique<ServiceExecutorWorkStealing>(ctx, std::move(reactor));
+    }
+    MONGO_UNREACHABLE;
+}
+}  // namespace
+
 std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
     const ServerGlobalParams* config, ServiceContext* ctx) {
     std::unique_ptr<TransportLayer> transportLayer;
     auto sep = ctx->getServiceEntryPoint();
 
+    if (config->transportLayer == "io_uring") {
+#ifdef MONGO_CONFIG_HAVE_LINUX_IO_URING
+        // io_uring only handles ingress, so outbound connections and batons are served by an
+        // egress-only ASIO transport layer kept at the front of the list.
+        invariant(config->serviceExecutor != "synchronous");
+#ifdef MONGO_CONFIG_SSL
+        uassert(ErrorCodes::InvalidOptions,
+                "The io_uring transport layer does not support TLS",
+                getSSLGlobalParams().sslMode.load() == SSLParams::SSLMode_disabled);
+#endif
+        transport::TransportLayerASIO::Options egressOpts(config);
+        egressOpts.mode = transport::TransportLayerASIO::Options::kEgress;
+        egressOpts.ipList.clear();
+
+        auto transportLayerUring = std::make_unique<transport::TransportLayerUring>(
+            transport::TransportLayerUring::Options(config), sep);
+        auto reactor = transportLayerUring->getReactor(TransportLayer::kIngress);
+        ctx->setServiceExecutor(makeAsyncServiceExecutor(config, ctx, std::move(reactor)));
+
+        std::vector<std::unique_ptr<TransportLayer>> retVector;
+        retVector.emplace_back(std::make_unique<transport::TransportLayerASIO>(egressOpts, sep));
+        retVector.emplace_back(std::move(transportLayerUring));
+        return std::make_unique<TransportLayerManager>(std::move(retVector));
+#else
+        uasserted(ErrorCodes::IllegalOperation,
+                  "This build of the server does not support the io_uring transport layer");
+#endif
+    }
+
     transport::TransportLayerASIO::Options opts(config);
-    if (config->serviceExecutor == "adaptive") {
-        opts.transportMode = transport::Mode::kAsynchronous;
-    } else if (config->serviceExecutor == "synchronous") {
+    if (config->serviceExecutor == "synchronous") {
         opts.transportMode = transport::Mode::kSynchronous;
     } else {
-        MONGO_UNREACHABLE;
+        opts.transportMode = transport::Mode::kAsynchronous;
     }
 
     auto transportLayerASIO = std::make_unique<transport::TransportLayerASIO>(opts, sep);
 
-    if (config->serviceExecutor == "adaptive") {
-        auto reactor = transportLayerASIO->getReactor(TransportLayer::kIngress);
-        ctx->setServiceExecutor(std::make_unique<ServiceExecutorAdaptive>(ctx, std::move(reactor)));
-    } else if (config->serviceExecutor == "synchronous") {
+    if (config->serviceExecutor == "synchronous") {
         ctx->setServiceExecutor(std::make_unique<ServiceExecutorSynchronous>(ctx));
+    } else {
+        auto reactor = transportLayerASIO->getReactor(TransportLayer::kIngress);
+        ctx->setServiceExecutor(makeAsyncServiceExecutor(config, ctx, std::move(reactor)));
     }
     transportLayer = std::move(transportLayerASIO);
 
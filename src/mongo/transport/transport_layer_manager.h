@@ -92,9 +92,9 @@ public:
 
     BatonHandle makeBaton(OperationContext* opCtx) const override {
         stdx::lock_guard<stdx::mutex> lk(_tlsMutex);
-        // TODO: figure out what to do about managers with more than one transport layer.
-        invariant(_tls.size() == 1);
-        return _tls[0]->makeBaton(opCtx);
+        // Batons poll egress networking, which is always handled by the first transport layer.
+        invariant(!_tls.empty());
+        return _tls.front()->makeBaton(opCtx);
     }
 
 private:
@@ -0,0 +1,1358 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_uring.h"
+
+#include <deque>
+#include <map>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <set>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "mongo/db/stats/counters.h"
+#include "mongo/rpc/message.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/transport/io_uring.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/transport/transport_layer_uring_gen.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/socket_utils.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+constexpr uint16_t kBufferGroup = 0;
+constexpr size_t kHeaderSize = sizeof(MSGHEADER::Value);
+
+// Receives stop being re-armed for a session that has this many bytes of complete messages that
+// nobody has asked for yet, and an armed multishot receive is canceled once the session gets there.
+constexpr size_t kMaxBufferedBytes = 16 * 1024 * 1024;
+
+// How long a receive that ran out of provided buffers waits for one to be recycled before it is
+// re-armed anyway.
+constexpr Milliseconds kBufferWaitRetryInterval{10};
+
+// Upper bound on how long the polling thread sleeps in the kernel before re-checking for
+// expired timers and stop requests.
+constexpr Milliseconds kMaxPollInterval{1000};
+
+// How many ready tasks a reactor thread runs before submitting the SQEs they prepared.
+constexpr size_t kMaxTaskBatch = 64;
+
+// Kernels older than 6.0 reject IORING_RECV_MULTISHOT and IORING_ACCEPT_MULTISHOT with EINVAL.
+// The first such rejection flips these and everything falls back to single-shot operations.
+AtomicWord<bool> multishotRecvSupported{true};
+AtomicWord<bool> multishotAcceptSupported{true};
+
+Status errnoToStatus(int err) {
+    if (err == 0) {
+        return {ErrorCodes::HostUnreachable, "Connection closed by peer"};
+    }
+    return {ErrorCodes::HostUnreachable, errnoWithDescription(err)};
+}
+
+uint16_t roundUpToPowerOfTwo(int value) {
+    uint32_t result = 1;
+    while (result < static_cast<uint32_t>(value)) {
+        result <<= 1;
+    }
+    return static_cast<uint16_t>(std::min<uint32_t>(result, 32768));
+}
+
+/**
+ * An in-flight io_uring request. The address of the operation is the SQE's user_data, and the
+ * reactor deletes the operation once complete() reports that no more CQEs will arrive for it.
+ */
+class UringOperation {
+public:
+    virtual ~UringOperation() = default;
+
+    /**
+     * Called on the reactor's polling thread for every CQE posted for this operation. Returns true
+     * if the operation is finished and may be destroyed.
+     */
+    virtual bool complete(int res, uint32_t flags) = 0;
+};
+
+/**
+ * Cancels the operation whose user_data is the address it is submitted with. Whether the target
+ * was still in flight does not matter: either way its own final CQE follows or has been posted.
+ */
+class CancelOperation final : public UringOperation {
+public:
+    bool complete(int res, uint32_t flags) override {
+        return true;
+    }
+};
+
+}  // namespace
+
+class TransportLayerUring::UringReactor final : public Reactor {
+public:
+    UringReactor() {
+        auto swRing = IoUring::make(gIoUringTransportQueueDepth);
+        uassertStatusOKWithContext(swRing.getStatus(), "Failed to create an io_uring instance");
+        _ring = std::move(swRing.getValue());
+
+        uassertStatusOKWithContext(
+            _ring->registerBufferRing(kBufferGroup,
+                                      roundUpToPowerOfTwo(gIoUringTransportProvidedBuffers),
+                                      gIoUringTransportProvidedBufferSizeBytes),
+            "Failed to register io_uring receive buffers");
+
+        _wakeFd = ::eventfd(0, EFD_CLOEXEC);
+        uassert(ErrorCodes::OperationFailed,
+                str::stream() << "Failed to create an eventfd: " << errnoWithDescription(),
+                _wakeFd >= 0);
+        _armWakeup();
+    }
+
+    ~UringReactor() {
+        // Closing the ring cancels anything still in flight.
+        _ring.reset();
+        ::close(_wakeFd);
+    }
+
+    void run() noexcept override {
+        _runUntil(Date_t::max());
+    }
+
+    void runFor(Milliseconds time) noexcept override {
+        _runUntil(now() + time);
+    }
+
+    void stop() override {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_tasksMutex);
+            _stopped = true;
+        }
+        _tasksCv.notify_all();
+        _wake();
+    }
+
+    void drain() override {
+        ThreadIdGuard threadIdGuard(this);
+        for (;;) {
+            std::deque<Task> tasks;
+            {
+                stdx::lock_guard<stdx::mutex> lk(_tasksMutex);
+                tasks.swap(_tasks);
+            }
+            if (tasks.empty()) {
+                break;
+            }
+
+            LOG(2) << "Draining remaining work in reactor.";
+            for (auto& task : tasks) {
+                task(Status::OK());
+            }
+            _flushSubmissions();
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_tasksMutex);
+        _stopped = true;
+    }
+
+    std::unique_ptr<ReactorTimer> makeTimer() override;
+
+    Date_t now() override {
+        return Date_t::now();
+    }
+
+    void schedule(Task task) override {
+        bool wakePoller;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_tasksMutex);
+            _tasks.emplace_back(std::move(task));
+            wakePoller = _pollerSleeping;
+        }
+        _tasksCv.notify_one();
+        if (wakePoller) {
+            _wake();
+        }
+    }
+
+    void dispatch(Task task) override {
+        if (onReactorThread()) {
+            task(Status::OK());
+        } else {
+            schedule(std::move(task));
+        }
+    }
+
+    bool onReactorThread() const override {
+        return this == _reactorForThread;
+    }
+
+    /**
+     * Prepares an SQE with 'prep' and queues it for submission on behalf of 'op'. Reactor threads
+     * leave the SQE to be submitted with the rest of their batch. Other threads submit right away
+     * since nothing else would notice the new entry until the polling thread next wakes up.
+     *
+     * If the submission queue is full, the SQE is kept aside and moved into the ring by the polling
+     * thread once the kernel has consumed enough entries.
+     */
+    template <typename Prep>
+    void submit(UringOperation* op, Prep&& prep) {
+        bool wakePoller = false;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_sqMutex);
+            auto sqe = _sqOverflow.empty() ? _ring->getSqe() : nullptr;
+            if (sqe) {
+                prep(sqe);
+                sqe->user_data = reinterpret_cast<uint64_t>(op);
+            } else {
+                io_uring_sqe entry{};
+                prep(&entry);
+                entry.user_data = reinterpret_cast<uint64_t>(op);
+                _sqOverflow.push_back(entry);
+            }
+
+            if (onReactorThread()) {
+                _sqPending.store(true);
+            } else {
+                wakePoller = !_submitLocked(lk);
+            }
+        }
+
+        if (wakePoller) {
+            _wake();
+        }
+    }
+
+    /**
+     * Returns the received bytes for a CQE that consumed provided buffer 'bid'. Must be called on
+     * the polling thread, and the buffer must be handed back with recycleBuffer() once consumed.
+     */
+    const char* providedBuffer(uint16_t bid) const {
+        return _ring->providedBuffer(bid);
+    }
+
+    void recycleBuffer(uint16_t bid) {
+        _ring->recycleBuffer(bid);
+        _bufferRecycled = true;
+    }
+
+    /**
+     * Schedules 'task' once the receives that ran out of provided buffers may succeed again: at the
+     * end of the first pass over the completion queue that recycles a buffer, or after
+     * kBufferWaitRetryInterval if none does. Must be called on the polling thread.
+     */
+    void waitForBuffer(Task task) {
+        if (_bufferWaiters.empty()) {
+            _bufferWaitStart = now();
+        }
+        _bufferWaiters.emplace_back(std::move(task));
+    }
+
+    void addTimer(const UringTimer* timer, Date_t deadline, Promise<void> promise);
+    void cancelTimer(const UringTimer* timer);
+
+private:
+    class ThreadIdGuard {
+    public:
+        ThreadIdGuard(UringReactor* reactor) {
+            _reactorForThread = reactor;
+        }
+
+        ~ThreadIdGuard() {
+            _reactorForThread = nullptr;
+        }
+    };
+
+    class WakeupOperation final : public UringOperation {
+    public:
+        explicit WakeupOperation(UringReactor* reactor) : _reactor(reactor) {}
+
+        bool complete(int res, uint32_t flags) override {
+            _reactor->_armWakeup();
+            return false;
+        }
+
+        uint64_t value = 0;
+
+    private:
+        UringReactor* const _reactor;
+    };
+
+    struct PendingTimer {
+        const UringTimer* timer;
+        Promise<void> promise;
+    };
+
+    void _runUntil(Date_t deadline) noexcept;
+    void _poll(Date_t deadline);
+    void _fireExpiredTimers();
+    void _resumeBufferWaiters();
+    void _flushSubmissions();
+    void _drainOverflowLocked(WithLock);
+    bool _submitLocked(WithLock);
+    void _armWakeup();
+    void _wake();
+
+    static thread_local UringReactor* _reactorForThread;
+
+    std::unique_ptr<IoUring> _ring;
+
+    // Guards the submission side of _ring.
+    stdx::mutex _sqMutex;
+    AtomicWord<bool> _sqPending{false};
+
+    // SQEs prepared while the submission queue was full, in submission order.
+    std::deque<io_uring_sqe> _sqOverflow;
+
+    stdx::mutex _tasksMutex;
+    stdx::condition_variable _tasksCv;
+    std::deque<Task> _tasks;
+    bool _polling = false;        // whether some thread owns the completion side of _ring
+    bool _pollerSleeping = false;  // whether that thread may be blocked in io_uring_enter()
+    bool _stopped = false;
+
+    int _wakeFd = -1;
+    WakeupOperation _wakeOp{this};
+
+    stdx::mutex _timersMutex;
+    std::multimap<Date_t, PendingTimer> _timers;
+
+    // Only accessed by the polling thread. Whether a provided buffer was recycled during the
+    // current pass over the completion queue, and the tasks waiting for one since
+    // '_bufferWaitStart'.
+    bool _bufferRecycled = false;
+    std::vector<Task> _bufferWaiters;
+    Date_t _bufferWaitStart;
+};
+
+thread_local TransportLayerUring::UringReactor*
+    TransportLayerUring::UringReactor::_reactorForThread = nullptr;
+
+void TransportLayerUring::UringReactor::_runUntil(Date_t deadline) noexcept {
+    ThreadIdGuard threadIdGuard(this);
+    try {
+        stdx::unique_lock<stdx::mutex> lk(_tasksMutex);
+        while (!_stopped && now() < deadline) {
+            if (!_tasks.empty()) {
+                std::vector<Task> batch;
+                while (!_tasks.empty() && batch.size() < kMaxTaskBatch) {
+                    batch.emplace_back(std::move(_tasks.front()));
+                    _tasks.pop_front();
+                }
+
+                lk.unlock();
+                for (auto& task : batch) {
+                    task(Status::OK());
+                }
+                batch.clear();
+                _flushSubmissions();
+                lk.lock();
+                continue;
+            }
+
+            if (!_polling) {
+                _polling = true;
+                _pollerSleeping = true;
+                lk.unlock();
+
+                _poll(deadline);
+
+                lk.lock();
+                _polling = false;
+                _pollerSleeping = false;
+                // Let a waiting thread take over polling if this one is about to leave.
+                _tasksCv.notify_all();
+                continue;
+            }
+
+            MONGO_IDLE_THREAD_BLOCK;
+            _tasksCv.wait_until(lk, deadline.toSystemTimePoint(), [&] {
+                return _stopped || !_tasks.empty() || !_polling;
+            });
+        }
+    } catch (...) {
+        severe() << "Uncaught exception in reactor: " << exceptionToStatus();
+        fassertFailed(51260);
+    }
+}
+
+void TransportLayerUring::UringReactor::_poll(Date_t deadline) {
+    auto pollUntil = std::min(deadline, now() + kMaxPollInterval);
+    {
+        stdx::lock_guard<stdx::mutex> lk(_timersMutex);
+        if (!_timers.empty()) {
+            pollUntil = std::min(pollUntil, _timers.begin()->first);
+        }
+    }
+    if (!_bufferWaiters.empty()) {
+        pollUntil = std::min(pollUntil, _bufferWaitStart + kBufferWaitRetryInterval);
+    }
+
+    unsigned toSubmit;
+    bool overflowed;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_sqMutex);
+        _drainOverflowLocked(lk);
+        toSubmit = _ring->publishSqes();
+        overflowed = !_sqOverflow.empty();
+        _sqPending.store(overflowed);
+    }
+
+    // Entries still waiting for room in the submission queue get it as soon as the kernel consumes
+    // what was just published, so don't sleep on them.
+    const auto timeout =
+        overflowed ? Milliseconds(0) : std::max(pollUntil - now(), Milliseconds(0));
+    const auto ret = _ring->submitAndWait(toSubmit, timeout);
+    if (ret < 0 && ret != -EBUSY && ret != -EAGAIN) {
+        severe() << "io_uring_enter failed: " << errnoWithDescription(-ret);
+        fassertFailed(51261);
+    }
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_tasksMutex);
+        _pollerSleeping = false;
+    }
+
+    _ring->reapCompletions([](const io_uring_cqe& cqe) {
+        auto op = reinterpret_cast<UringOperation*>(cqe.user_data);
+        if (op->complete(cqe.res, cqe.flags)) {
+            delete op;
+        }
+    });
+
+    _resumeBufferWaiters();
+    _fireExpiredTimers();
+}
+
+void TransportLayerUring::UringReactor::_resumeBufferWaiters() {
+    // The completions reaped in this pass were posted before any buffer recycled while reaping
+    // them, so such a buffer is available to the receives which ran out during the pass.
+    const bool recycled = std::exchange(_bufferRecycled, false);
+    if (_bufferWaiters.empty() ||
+        (!recycled && now() < _bufferWaitStart + kBufferWaitRetryInterval)) {
+        return;
+    }
+
+    auto waiters = std::move(_bufferWaiters);
+    _bufferWaiters.clear();
+    for (auto& task : waiters) {
+        schedule(std::move(task));
+    }
+}
+
+void TransportLayerUring::UringReactor::_fireExpiredTimers() {
+    std::vector<Promise<void>> expired;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_timersMutex);
+        const auto end = _timers.upper_bound(now());
+        for (auto it = _timers.begin(); it != end; ++it) {
+            expired.emplace_back(std::move(it->second.promise));
+        }
+        _timers.erase(_timers.begin(), end);
+    }
+
+    for (auto& promise : expired) {
+        schedule([promise = std::move(promise)](Status) mutable { promise.emplaceValue(); });
+    }
+}
+
+void TransportLayerUring::UringReactor::_flushSubmissions() {
+    if (!_sqPending.load()) {
+        return;
+    }
+
+    bool wakePoller;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_sqMutex);
+        wakePoller = !_submitLocked(lk);
+    }
+
+    if (wakePoller) {
+        _wake();
+    }
+}
+
+void TransportLayerUring::UringReactor::_drainOverflowLocked(WithLock) {
+    while (!_sqOverflow.empty()) {
+        auto sqe = _ring->getSqe();
+        if (!sqe) {
+            return;
+        }
+        *sqe = _sqOverflow.front();
+        _sqOverflow.pop_front();
+    }
+}
+
+/**
+ * Submits every prepared SQE. Returns false if some were left for the polling thread, either
+ * because the submission queue is full or because the kernel refused them for now: with
+ * IORING_FEAT_NODROP, io_uring_enter() fails with EBUSY or EAGAIN until overflowed completions
+ * have been reaped, which only the polling thread does.
+ */
+bool TransportLayerUring::UringReactor::_submitLocked(WithLock lk) {
+    _drainOverflowLocked(lk);
+    const auto ret = _ring->submit();
+    if (ret < 0 && ret != -EBUSY && ret != -EAGAIN) {
+        warning() << "Failed to submit io_uring requests: " << errnoWithDescription(-ret);
+    }
+
+    const bool submitted = ret >= 0 && _sqOverflow.empty();
+    _sqPending.store(!submitted);
+    return submitted;
+}
+
+void TransportLayerUring::UringReactor::_armWakeup() {
+    submit(&_wakeOp, [&](io_uring_sqe* sqe) {
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = _wakeFd;
+        sqe->addr = reinterpret_cast<uint64_t>(&_wakeOp.value);
+        sqe->len = sizeof(_wakeOp.value);
+    });
+}
+
+void TransportLayerUring::UringReactor::_wake() {
+    const uint64_t one = 1;
+    if (::write(_wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        warning() << "Failed to wake io_uring reactor: " << errnoWithDescription();
+    }
+}
+
+class TransportLayerUring::UringTimer final : public ReactorTimer {
+public:
+    explicit UringTimer(UringReactor* reactor) : _reactor(reactor) {}
+
+    ~UringTimer() {
+        cancel();
+    }
+
+    void cancel(const BatonHandle& baton = nullptr) override {
+        _reactor->cancelTimer(this);
+    }
+
+    Future<void> waitUntil(Date_t deadline, const BatonHandle& baton = nullptr) override {
+        cancel();
+
+        auto pf = makePromiseFuture<void>();
+        _reactor->addTimer(this, deadline, std::move(pf.promise));
+        return std::move(pf.future);
+    }
+
+private:
+    UringReactor* const _reactor;
+};
+
+std::unique_ptr<ReactorTimer> TransportLayerUring::UringReactor::makeTimer() {
+    return std::make_unique<UringTimer>(this);
+}
+
+void TransportLayerUring::UringReactor::addTimer(const UringTimer* timer,
+                                                 Date_t deadline,
+                                                 Promise<void> promise) {
+    bool earliest;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_timersMutex);
+        auto it = _timers.emplace(deadline, PendingTimer{timer, std::move(promise)});
+        earliest = it == _timers.begin();
+    }
+
+    // The polling thread may be sleeping past the new deadline.
+    if (earliest) {
+        _wake();
+    }
+}
+
+void TransportLayerUring::UringReactor::cancelTimer(const UringTimer* timer) {
+    std::vector<Promise<void>> canceled;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_timersMutex);
+        for (auto it = _timers.begin(); it != _timers.end();) {
+            if (it->second.timer == timer) {
+                canceled.emplace_back(std::move(it->second.promise));
+                it = _timers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (auto& promise : canceled) {
+        schedule([promise = std::move(promise)](Status) mutable {
+            promise.setError({ErrorCodes::CallbackCanceled, "Timer was canceled"});
+        });
+    }
+}
+
+class TransportLayerUring::UringSession final : public Session {
+    UringSession(const UringSession&) = delete;
+    UringSession& operator=(const UringSession&) = delete;
+
+public:
+    UringSession(TransportLayerUring* tl,
+                 std::shared_ptr<UringReactor> reactor,
+                 int fd,
+                 SockAddr localAddr,
+                 SockAddr remoteAddr)
+        : _tl(tl),
+          _reactor(std::move(reactor)),
+          _fd(fd),
+          _localAddr(std::move(localAddr)),
+          _remoteAddr(std::move(remoteAddr)),
+          _local(HostAndPort(_localAddr.toString(true))),
+          _remote(HostAndPort(_remoteAddr.toString(true))) {}
+
+    ~UringSession() {
+        end();
+        ::close(_fd);
+    }
+
+    TransportLayer* getTransportLayer() const override {
+        return _tl;
+    }
+
+    const HostAndPort& remote() const override {
+        return _remote;
+    }
+
+    const HostAndPort& local() const override {
+        return _local;
+    }
+
+    const SockAddr& remoteAddr() const override {
+        return _remoteAddr;
+    }
+
+    const SockAddr& localAddr() const override {
+        return _localAddr;
+    }
+
+    void end() override {
+        if (_ended.swap(true)) {
+            return;
+        }
+
+        // Shutting the socket down completes the outstanding receive; the descriptor itself is
+        // only closed once nothing in the ring can refer to this session any longer.
+        ::shutdown(_fd, SHUT_RDWR);
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _fail(lk, Session::ClosedStatus);
+    }
+
+    StatusWith<Message> sourceMessage() override {
+        return asyncSourceMessage().getNoThrow();
+    }
+
+    Future<Message> asyncSourceMessage(const BatonHandle& baton = nullptr) override {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (!_ready.empty()) {
+            auto message = std::move(_ready.front());
+            _ready.pop_front();
+            _readyBytes -= message.size();
+            _armRecv(lk);
+            return Future<Message>::makeReady(std::move(message));
+        }
+
+        if (!_status.isOK()) {
+            return Future<Message>::makeReady(_status);
+        }
+
+        invariant(!_pendingSource);
+        auto pf = makePromiseFuture<Message>();
+        _pendingSource.emplace(std::move(pf.promise));
+        _armRecv(lk);
+        return std::move(pf.future);
+    }
+
+    Status sinkMessage(Message message) override {
+        return asyncSinkMessage(std::move(message)).getNoThrow();
+    }
+
+    Future<void> asyncSinkMessage(Message message, const BatonHandle& baton = nullptr) override {
+        if (_ended.load()) {
+            return Future<void>::makeReady(Session::ClosedStatus);
+        }
+
+        auto pf = makePromiseFuture<void>();
+        auto op = new SendOperation(_self(), std::move(message), std::move(pf.promise));
+        op->submit();
+        return std::move(pf.future);
+    }
+
+    void cancelAsyncOperations(const BatonHandle& baton = nullptr) override {
+        LOG(3) << "Cancelling outstanding I/O operations on connection to " << _remote;
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_pendingSource) {
+            _resolve<Message>(std::move(*_pendingSource),
+                              Status(ErrorCodes::CallbackCanceled, "Operation was canceled"));
+            _pendingSource = boost::none;
+        }
+    }
+
+    void setTimeout(boost::optional<Milliseconds> timeout) override {
+        // Ingress sessions are never given timeouts; those only apply to egress connections.
+        invariant(!timeout || timeout->count() > 0);
+    }
+
+    bool isConnected() override {
+        if (_ended.load()) {
+            return false;
+        }
+
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (!_status.isOK()) {
+                return false;
+            }
+        }
+
+        pollfd pfd;
+        pfd.fd = _fd;
+        pfd.events = POLLRDHUP;
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, 0) < 0) {
+            warning() << "Failed to poll socket for connectivity check: " << errnoWithDescription();
+            return false;
+        }
+
+        return !(pfd.revents & (POLLRDHUP | POLLHUP | POLLERR));
+    }
+
+private:
+    /**
+     * A multishot receive that copies whatever arrives into the owning session. It only holds a
+     * weak reference so that an idle connection does not keep its session alive.
+     */
+    class RecvOperation final : public UringOperation {
+    public:
+        RecvOperation(std::weak_ptr<UringSession> session, UringReactor* reactor)
+            : _session(std::move(session)), _reactor(reactor) {}
+
+        bool complete(int res, uint32_t flags) override {
+            const bool more = flags & IORING_CQE_F_MORE;
+            auto session = _session.lock();
+            if (session) {
+                session->_onRecv(res, flags);
+            } else if (flags & IORING_CQE_F_BUFFER) {
+                // The session is gone, but the buffer still has to go back to the kernel. The
+                // socket shutdown in end() guarantees the final CQE is not far behind.
+                _reactor->recycleBuffer(flags >> IORING_CQE_BUFFER_SHIFT);
+            }
+            return !more;
+        }
+
+    private:
+        std::weak_ptr<UringSession> _session;
+        UringReactor* const _reactor;
+    };
+
+    /**
+     * Sends one message, resubmitting the remainder after a short send.
+     */
+    class SendOperation final : public UringOperation {
+    public:
+        SendOperation(std::shared_ptr<UringSession> session, Message message, Promise<void> promise)
+            : _session(std::move(session)),
+              _message(std::move(message)),
+              _promise(std::move(promise)) {}
+
+        void submit() {
+            _session->_reactor->submit(this, [&](io_uring_sqe* sqe) {
+                sqe->opcode = IORING_OP_SEND;
+                sqe->fd = _session->_fd;
+                sqe->addr = reinterpret_cast<uint64_t>(_message.buf() + _sent);
+                sqe->len = static_cast<uint32_t>(_message.size() - _sent);
+                sqe->msg_flags = MSG_NOSIGNAL;
+            });
+        }
+
+        bool complete(int res, uint32_t flags) override {
+            if (res <= 0) {
+                _session->_resolve<void>(std::move(_promise), errnoToStatus(-res));
+                return true;
+            }
+
+            _sent += res;
+            if (_sent < static_cast<size_t>(_message.size())) {
+                submit();
+                return false;
+            }
+
+            networkCounter.hitPhysicalOut(_message.size());
+            _session->_resolve<void>(std::move(_promise), Status::OK());
+            return true;
+        }
+
+    private:
+        std::shared_ptr<UringSession> _session;
+        Message _message;
+        Promise<void> _promise;
+        size_t _sent = 0;
+    };
+
+    std::shared_ptr<UringSession> _self() {
+        return std::static_pointer_cast<UringSession>(shared_from_this());
+    }
+
+    void _armRecv(WithLock) {
+        if (_recvArmed || _waitingForBuffer || !_status.isOK() ||
+            _readyBytes >= kMaxBufferedBytes) {
+            return;
+        }
+
+        _recvArmed = true;
+        const bool multishot = multishotRecvSupported.load();
+        _recvOp = new RecvOperation(_self(), _reactor.get());
+        _reactor->submit(_recvOp, [&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = _fd;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = kBufferGroup;
+            if (multishot) {
+                sqe->ioprio = IORING_RECV_MULTISHOT;
+            }
+        });
+    }
+
+    void _onRecv(int res, uint32_t flags) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (flags & IORING_CQE_F_BUFFER) {
+            const uint16_t bid = flags >> IORING_CQE_BUFFER_SHIFT;
+            if (res > 0 && _status.isOK()) {
+                _consume(lk, _reactor->providedBuffer(bid), res);
+            }
+            _reactor->recycleBuffer(bid);
+        }
+
+        if (res == -EINVAL && multishotRecvSupported.load()) {
+            LOG(1) << "Kernel does not support multishot receives, falling back to single-shot";
+            multishotRecvSupported.store(false);
+        } else if (res == 0) {
+            _fail(lk, errnoToStatus(0));
+        } else if (res < 0 && res != -ENOBUFS && res != -ECANCELED) {
+            _fail(lk, errnoToStatus(-res));
+        }
+
+        if (!(flags & IORING_CQE_F_MORE)) {
+            _recvArmed = false;
+            _recvOp = nullptr;
+            _recvCancelRequested = false;
+            if (res == -ENOBUFS) {
+                // Every provided buffer is in use, so a receive armed right away would fail the
+                // same way until one is recycled.
+                _waitingForBuffer = true;
+                std::weak_ptr<UringSession> weakSession = _self();
+                _reactor->waitForBuffer([weakSession](Status) {
+                    if (auto session = weakSession.lock()) {
+                        stdx::lock_guard<stdx::mutex> lk(session->_mutex);
+                        session->_waitingForBuffer = false;
+                        session->_armRecv(lk);
+                    }
+                });
+            } else if (_pendingSource || _readyBytes < kMaxBufferedBytes) {
+                _armRecv(lk);
+            }
+        } else if (_readyBytes >= kMaxBufferedBytes && !_recvCancelRequested) {
+            // A multishot receive keeps posting completions regardless of how much is buffered, so
+            // stop it until the session has caught up. asyncSourceMessage() re-arms it.
+            _recvCancelRequested = true;
+            auto target = _recvOp;
+            _reactor->submit(new CancelOperation(), [&](io_uring_sqe* sqe) {
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->fd = -1;
+                sqe->addr = reinterpret_cast<uint64_t>(target);
+            });
+        }
+    }
+
+    /**
+     * Splits received bytes into messages.
+     */
+    void _consume(WithLock lk, const char* data, size_t len) {
+        while (len > 0 && _status.isOK()) {
+            if (!_partial) {
+                const auto n = std::min(len, kHeaderSize - _headerBytes);
+                memcpy(_header + _headerBytes, data, n);
+                _headerBytes += n;
+                data += n;
+                len -= n;
+                if (_headerBytes < kHeaderSize) {
+                    return;
+                }
+
+                if (StringData(_header, 4) == "GET "_sd) {
+                    _fail(lk,
+                          {ErrorCodes::ProtocolError,
+                           "Client sent an HTTP request over a native MongoDB connection"});
+                    return;
+                }
+
+                const auto msgLen = size_t(MSGHEADER::ConstView(_header).getMessageLength());
+                if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
+                    StringBuilder sb;
+                    sb << "recv(): message msgLen " << msgLen << " is invalid. "
+                       << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
+                    const auto str = sb.str();
+                    LOG(0) << str;
+                    _fail(lk, {ErrorCodes::ProtocolError, str});
+                    return;
+                }
+
+                _partial = SharedBuffer::allocate(msgLen);
+                memcpy(_partial.get(), _header, kHeaderSize);
+                _partialBytes = kHeaderSize;
+                _partialLen = msgLen;
+                _headerBytes = 0;
+            }
+
+            const auto n = std::min(len, _partialLen - _partialBytes);
+            memcpy(_partial.get() + _partialBytes, data, n);
+            _partialBytes += n;
+            data += n;
+            len -= n;
+
+            if (_partialBytes == _partialLen) {
+                networkCounter.hitPhysicalIn(_partialLen);
+                _deliver(lk, Message(std::move(_partial)));
+                _partial = {};
+            }
+        }
+    }
+
+    void _deliver(WithLock, Message message) {
+        if (_pendingSource) {
+            _resolve<Message>(std::move(*_pendingSource), std::move(message));
+            _pendingSource = boost::none;
+            return;
+        }
+
+        _readyBytes += message.size();
+        _ready.emplace_back(std::move(message));
+    }
+
+    void _fail(WithLock, Status status) {
+        if (_status.isOK()) {
+            _status = std::move(status);
+        }
+
+        if (_pendingSource) {
+            _resolve<Message>(std::move(*_pendingSource), _status);
+            _pendingSource = boost::none;
+        }
+    }
+
+    /**
+     * Completes 'promise' from a reactor task so that continuations never run on the polling
+     * thread or under the session mutex.
+     */
+    template <typename T>
+    void _resolve(Promise<T> promise, StatusOrStatusWith<T> result) {
+        _reactor->schedule(
+            [promise = std::move(promise), result = std::move(result)](Status) mutable {
+                promise.setFrom(Future<T>::makeReady(std::move(result)));
+            });
+    }
+
+    TransportLayerUring* const _tl;
+    const std::shared_ptr<UringReactor> _reactor;
+    const int _fd;
+
+    const SockAddr _localAddr;
+    const SockAddr _remoteAddr;
+    const HostAndPort _local;
+    const HostAndPort _remote;
+
+    AtomicWord<bool> _ended{false};
+
+    stdx::mutex _mutex;
+    Status _status = Status::OK();
+    bool _recvArmed = false;
+    boost::optional<Promise<Message>> _pendingSource;
+
+    // The armed receive, if any, whether it has been asked to stop because too much is buffered,
+    // and whether the next one waits for the reactor to have provided buffers again.
+    UringOperation* _recvOp = nullptr;
+    bool _recvCancelRequested = false;
+    bool _waitingForBuffer = false;
+
+    // Complete messages nobody has asked for yet.
+    std::deque<Message> _ready;
+    size_t _readyBytes = 0;
+
+    // The message currently being received.
+    char _header[kHeaderSize];
+    size_t _headerBytes = 0;
+    SharedBuffer _partial;
+    size_t _partialBytes = 0;
+    size_t _partialLen = 0;
+};
+
+TransportLayerUring::Options::Options(const ServerGlobalParams* params)
+    : port(params->port),
+      ipList(params->bind_ips),
+      useUnixSockets(!params->noUnixSocket),
+      enableIPv6(params->enableIPv6) {}
+
+TransportLayerUring::TransportLayerUring(const Options& opts, ServiceEntryPoint* sep)
+    : _reactor(std::make_shared<UringReactor>()), _sep(sep), _listenerOptions(opts) {}
+
+TransportLayerUring::~TransportLayerUring() {
+    shutdown();
+}
+
+StatusWith<SessionHandle> TransportLayerUring::connect(HostAndPort peer,
+                                                       ConnectSSLMode sslMode,
+                                                       Milliseconds timeout) {
+    return Status(ErrorCodes::IllegalOperation,
+                  "The io_uring transport layer only accepts incoming connections");
+}
+
+Future<SessionHandle> TransportLayerUring::asyncConnect(HostAndPort peer,
+                                                        ConnectSSLMode sslMode,
+                                                        const ReactorHandle& reactor,
+                                                        Milliseconds timeout) {
+    return Future<SessionHandle>::makeReady(
+        Status(ErrorCodes::IllegalOperation,
+               "The io_uring transport layer only accepts incoming connections"));
+}
+
+ReactorHandle TransportLayerUring::getReactor(WhichReactor which) {
+    if (which == TransportLayer::kNewReactor) {
+        return std::make_shared<UringReactor>();
+    }
+    return _reactor;
+}
+
+Status TransportLayerUring::setup() {
+    std::vector<std::string> listenAddrs;
+    if (_listenerOptions.ipList.empty()) {
+        listenAddrs = {"127.0.0.1"};
+        if (_listenerOptions.enableIPv6) {
+            listenAddrs.emplace_back("::1");
+        }
+    } else {
+        listenAddrs = _listenerOptions.ipList;
+    }
+
+    if (_listenerOptions.useUnixSockets) {
+        listenAddrs.emplace_back(makeUnixSockPath(_listenerOptions.port));
+    }
+
+    _listenerPort = _listenerOptions.port;
+
+    // Self-deduplicating list of unique endpoint addresses.
+    std::set<SockAddr> endpoints;
+    for (auto& ip : listenAddrs) {
+        if (ip.empty()) {
+            warning() << "Skipping empty bind address";
+            continue;
+        }
+
+        auto addrs = SockAddr::createAll(
+            ip, _listenerPort, _listenerOptions.enableIPv6 ? AF_UNSPEC : AF_INET);
+        if (addrs.empty()) {
+            warning() << "Found no addresses for " << ip;
+            continue;
+        }
+        endpoints.insert(addrs.begin(), addrs.end());
+    }
+
+    for (auto& addr : endpoints) {
+        if (addr.getType() == AF_UNIX) {
+            if (::unlink(addr.getAddr().c_str()) == -1 && errno != ENOENT) {
+                return {ErrorCodes::SocketException,
+                        str::stream() << "Failed to unlink socket file " << addr.getAddr() << " "
+                                      << errnoWithDescription()};
+            }
+        }
+
+        if (addr.getType() == AF_INET6 && !_listenerOptions.enableIPv6) {
+            return {ErrorCodes::BadValue, "Specified ipv6 bind address, but ipv6 is disabled"};
+        }
+
+        const int fd = ::socket(addr.getType(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return {ErrorCodes::SocketException,
+                    str::stream() << "Failed to create listening socket: "
+                                  << errnoWithDescription()};
+        }
+        _listeners.push_back({addr, fd});
+
+        const int one = 1;
+        if (addr.getType() != AF_UNIX) {
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        }
+        if (addr.getType() == AF_INET6) {
+            ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &one, sizeof(one));
+        }
+
+        if (::bind(fd, addr.raw(), addr.addressSize) != 0) {
+            return {ErrorCodes::SocketException,
+                    str::stream() << "Failed to bind to " << addr.toString() << ": "
+                                  << errnoWithDescription()};
+        }
+
+        if (addr.getType() == AF_UNIX) {
+            if (::chmod(addr.getAddr().c_str(), serverGlobalParams.unixSocketPermissions) == -1) {
+                return {ErrorCodes::SocketException,
+                        str::stream() << "Failed to chmod socket file " << addr.getAddr() << " "
+                                      << errnoWithDescription()};
+            }
+        }
+
+        if (_listenerOptions.port == 0 && addr.isIP()) {
+            if (_listenerPort != _listenerOptions.port) {
+                return Status(ErrorCodes::BadValue,
+                              "Port 0 (ephemeral port) is not allowed when"
+                              " listening on multiple IP interfaces");
+            }
+
+            sockaddr_storage bound;
+            socklen_t boundLen = sizeof(bound);
+            if (::getsockname(fd, reinterpret_cast<sockaddr*>(&bound), &boundLen) != 0) {
+                return {ErrorCodes::SocketException,
+                        str::stream() << "getsockname failed: " << errnoWithDescription()};
+            }
+            _listenerPort = SockAddr(bound, boundLen).getPort();
+        }
+    }
+
+    if (_listeners.empty()) {
+        return Status(ErrorCodes::SocketException, "No available addresses/ports to bind to");
+    }
+
+    auto swRing = IoUring::make(64);
+    if (!swRing.isOK()) {
+        return swRing.getStatus();
+    }
+    _acceptRing = std::move(swRing.getValue());
+
+    _acceptWakeFd = ::eventfd(0, EFD_CLOEXEC);
+    if (_acceptWakeFd < 0) {
+        return {ErrorCodes::OperationFailed,
+                str::stream() << "Failed to create an eventfd: " << errnoWithDescription()};
+    }
+
+    return Status::OK();
+}
+
+Status TransportLayerUring::start() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _running.store(true);
+
+    for (auto& listener : _listeners) {
+        if (::listen(listener.fd, serverGlobalParams.listenBacklog) != 0) {
+            return {ErrorCodes::SocketException,
+                    str::stream() << "Failed to listen on " << listener.addr.getAddr() << ": "
+                                  << errnoWithDescription()};
+        }
+        log() << "Listening on " << listener.addr.getAddr();
+    }
+
+    _listenerThread = stdx::thread([this] {
+        setThreadName("listener");
+        _runListener();
+    });
+
+    log() << "waiting for connections on port " << _listenerPort << " (io_uring)";
+    return Status::OK();
+}
+
+void TransportLayerUring::shutdown() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _running.store(false);
+
+    if (_listenerThread.joinable()) {
+        const uint64_t one = 1;
+        if (::write(_acceptWakeFd, &one, sizeof(one)) < 0) {
+            warning() << "Failed to wake the listener thread: " << errnoWithDescription();
+        }
+        _listenerThread.join();
+    }
+
+    for (auto& listener : _listeners) {
+        ::close(listener.fd);
+        auto& addr = listener.addr;
+        if (addr.getType() == AF_UNIX && !addr.isAnonymousUNIXSocket()) {
+            auto path = addr.getAddr();
+            log() << "removing socket file: " << path;
+            if (::unlink(path.c_str()) != 0) {
+                const auto ewd = errnoWithDescription();
+                warning() << "Unable to remove UNIX socket " << path << ": " << ewd;
+            }
+        }
+    }
+    _listeners.clear();
+
+    _acceptRing.reset();
+    if (_acceptWakeFd >= 0) {
+        ::close(_acceptWakeFd);
+        _acceptWakeFd = -1;
+    }
+}
+
+void TransportLayerUring::_runListener() {
+    // The user_data of an accept is the index of its listener plus one; zero is the wakeup read.
+    constexpr uint64_t kWakeup = 0;
+    uint64_t wakeValue = 0;
+
+    // SQEs which did not fit in the submission queue, moved into it once the kernel consumes
+    // entries.
+    std::deque<io_uring_sqe> overflow;
+    auto queueSqe = [&](const io_uring_sqe& entry) {
+        auto sqe = overflow.empty() ? _acceptRing->getSqe() : nullptr;
+        if (sqe) {
+            *sqe = entry;
+        } else {
+            overflow.push_back(entry);
+        }
+    };
+
+    auto armAccept = [&](size_t idx) {
+        io_uring_sqe entry{};
+        entry.opcode = IORING_OP_ACCEPT;
+        entry.fd = _listeners[idx].fd;
+        entry.accept_flags = SOCK_CLOEXEC;
+        if (multishotAcceptSupported.load()) {
+            entry.ioprio = IORING_ACCEPT_MULTISHOT;
+        }
+        entry.user_data = idx + 1;
+        queueSqe(entry);
+    };
+
+    io_uring_sqe wakeEntry{};
+    wakeEntry.opcode = IORING_OP_READ;
+    wakeEntry.fd = _acceptWakeFd;
+    wakeEntry.addr = reinterpret_cast<uint64_t>(&wakeValue);
+    wakeEntry.len = sizeof(wakeValue);
+    wakeEntry.user_data = kWakeup;
+    queueSqe(wakeEntry);
+
+    for (size_t idx = 0; idx < _listeners.size(); ++idx) {
+        armAccept(idx);
+    }
+
+    while (_running.load()) {
+        while (!overflow.empty()) {
+            auto sqe = _acceptRing->getSqe();
+            if (!sqe) {
+                break;
+            }
+            *sqe = overflow.front();
+            overflow.pop_front();
+        }
+
+        const auto ret = _acceptRing->submitAndWait(
+            _acceptRing->publishSqes(), overflow.empty() ? kMaxPollInterval : Milliseconds(0));
+        if (ret < 0 && ret != -EBUSY && ret != -EAGAIN) {
+            severe() << "io_uring_enter failed in the listener: " << errnoWithDescription(-ret);
+            fassertFailed(51262);
+        }
+
+        _acceptRing->reapCompletions([&](const io_uring_cqe& cqe) {
+            if (cqe.user_data == kWakeup || !_running.load()) {
+                if (cqe.res >= 0 && cqe.user_data != kWakeup) {
+                    ::close(cqe.res);
+                }
+                return;
+            }
+
+            const size_t idx = cqe.user_data - 1;
+            if (cqe.res >= 0) {
+                _acceptSession(cqe.res);
+            } else if (cqe.res == -EINVAL && multishotAcceptSupported.load()) {
+                LOG(1) << "Kernel does not support multishot accepts, falling back to single-shot";
+                multishotAcceptSupported.store(false);
+            } else {
+                log() << "Error accepting new connection on " << _listeners[idx].addr.toString()
+                      << ": " << errnoWithDescription(-cqe.res);
+            }
+
+            if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                armAccept(idx);
+            }
+        });
+    }
+}
+
+void TransportLayerUring::_acceptSession(int fd) {
+    sockaddr_storage storage;
+    socklen_t len = sizeof(storage);
+    if (::getsockname(fd, reinterpret_cast<sockaddr*>(&storage), &len) != 0) {
+        warning() << "Error accepting new connection: " << errnoWithDescription();
+        ::close(fd);
+        return;
+    }
+    SockAddr localAddr(storage, len);
+
+    len = sizeof(storage);
+    if (::getpeername(fd, reinterpret_cast<sockaddr*>(&storage), &len) != 0) {
+        warning() << "Error accepting new connection: " << errnoWithDescription();
+        ::close(fd);
+        return;
+    }
+    SockAddr remoteAddr(storage, len);
+
+    if (localAddr.isIP()) {
+        const int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        ::setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+        setSocketKeepAliveParams(fd);
+    }
+
+    std::shared_ptr<UringSession> session;
+    try {
+        session = std::make_shared<UringSession>(
+            this, _reactor, fd, std::move(localAddr), std::move(remoteAddr));
+    } catch (const DBException& e) {
+        warning() << "Error accepting new connection " << e;
+        ::close(fd);
+        return;
+    }
+
+    try {
+        _sep->startSession(std::move(session));
+    } catch (const DBException& e) {
+        warning() << "Error accepting new connection " << e;
+    }
+}
+
+}  // namespace transport
+}  // namespace mongo
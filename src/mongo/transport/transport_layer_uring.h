@@ -0,0 +1,136 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/status_with.h"
+#include "mongo/db/server_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/transport_layer.h"
+#include "mongo/util/net/sockaddr.h"
+
+namespace mongo {
+
+class ServiceEntryPoint;
+
+namespace transport {
+
+class IoUring;
+
+/**
+ * An ingress-only TransportLayer implementation built directly on Linux io_uring.
+ *
+ * A dedicated listener thread accepts connections with multishot accepts on its own ring. Each
+ * accepted session receives through a multishot recv that draws from a ring of kernel-registered
+ * provided buffers, so one submission keeps delivering data for the life of the connection.
+ * Sends and receive re-arms prepared while running reactor tasks are batched and handed to the
+ * kernel with a single io_uring_enter() per batch.
+ *
+ * The reactor is meant to be run by the adaptive ServiceExecutor. Outbound connections are not
+ * supported and must be made through a TransportLayerASIO configured for egress.
+ */
+class TransportLayerUring final : public TransportLayer {
+    TransportLayerUring(const TransportLayerUring&) = delete;
+    TransportLayerUring& operator=(const TransportLayerUring&) = delete;
+
+public:
+    struct Options {
+        explicit Options(const ServerGlobalParams* params);
+        Options() = default;
+
+        int port = ServerGlobalParams::DefaultDBPort;  // port to bind to
+        std::vector<std::string> ipList;               // addresses to bind to
+        bool useUnixSockets = true;                    // whether to allow UNIX sockets in ipList
+        bool enableIPv6 = false;                       // whether to allow IPv6 sockets in ipList
+    };
+
+    /**
+     * Throws if the running kernel does not support the io_uring features this transport layer
+     * needs.
+     */
+    TransportLayerUring(const Options& opts, ServiceEntryPoint* sep);
+
+    ~TransportLayerUring();
+
+    StatusWith<SessionHandle> connect(HostAndPort peer,
+                                      ConnectSSLMode sslMode,
+                                      Milliseconds timeout) final;
+
+    Future<SessionHandle> asyncConnect(HostAndPort peer,
+                                       ConnectSSLMode sslMode,
+                                       const ReactorHandle& reactor,
+                                       Milliseconds timeout) final;
+
+    Status setup() final;
+
+    ReactorHandle getReactor(WhichReactor which) final;
+
+    Status start() final;
+
+    void shutdown() final;
+
+    int listenerPort() const {
+        return _listenerPort;
+    }
+
+private:
+    class UringReactor;
+    class UringSession;
+    class UringTimer;
+
+    struct Listener {
+        SockAddr addr;
+        int fd;
+    };
+
+    void _runListener();
+    void _acceptSession(int fd);
+
+    std::shared_ptr<UringReactor> _reactor;
+    std::unique_ptr<IoUring> _acceptRing;
+    int _acceptWakeFd = -1;
+
+    stdx::mutex _mutex;
+    std::vector<Listener> _listeners;
+    stdx::thread _listenerThread;
+    AtomicWord<bool> _running{false};
+
+    ServiceEntryPoint* const _sep;
+    const Options _listenerOptions;
+    int _listenerPort = 0;
+};
+
+}  // namespace transport
+}  // namespace mongo
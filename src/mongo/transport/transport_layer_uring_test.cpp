@@ -0,0 +1,356 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_uring.h"
+
+#include "mongo/db/server_options.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/transport/transport_layer_uring_gen.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/sock.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace {
+
+class ServiceEntryPointUtil : public ServiceEntryPoint {
+public:
+    void startSession(transport::SessionHandle session) override {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _sessions.push_back(std::move(session));
+        _cv.notify_one();
+    }
+
+    void endAllSessions(transport::Session::TagMask tags) override {
+        std::vector<transport::SessionHandle> oldSessions;
+        {
+            stdx::unique_lock<stdx::mutex> lock(_mutex);
+            oldSessions.swap(_sessions);
+        }
+        for (auto& session : oldSessions) {
+            session->end();
+        }
+    }
+
+    Status start() override {
+        return Status::OK();
+    }
+
+    bool shutdown(Milliseconds timeout) override {
+        return true;
+    }
+
+    void appendStats(BSONObjBuilder*) const override {}
+
+    size_t numOpenSessions() const override {
+        stdx::unique_lock<stdx::mutex> lock(_mutex);
+        return _sessions.size();
+    }
+
+    DbResponse handleRequest(OperationContext* opCtx, const Message& request) override {
+        MONGO_UNREACHABLE;
+    }
+
+    transport::SessionHandle waitForSession() {
+        stdx::unique_lock<stdx::mutex> lock(_mutex);
+        _cv.wait(lock, [&] { return !_sessions.empty(); });
+        return _sessions.front();
+    }
+
+    std::vector<transport::SessionHandle> waitForSessions(size_t count) {
+        stdx::unique_lock<stdx::mutex> lock(_mutex);
+        _cv.wait(lock, [&] { return _sessions.size() >= count; });
+        return _sessions;
+    }
+
+private:
+    mutable stdx::mutex _mutex;
+    stdx::condition_variable _cv;
+    std::vector<transport::SessionHandle> _sessions;
+};
+
+/**
+ * Starts an io_uring transport layer listening on an ephemeral port with one thread running its
+ * reactor. Tests are skipped when the running kernel cannot support it.
+ */
+class UringFixture {
+public:
+    UringFixture() {
+        transport::TransportLayerUring::Options opts;
+        opts.port = 0;
+        opts.useUnixSockets = false;
+
+        try {
+            _tl = std::make_unique<transport::TransportLayerUring>(opts, &_sep);
+        } catch (const DBException& ex) {
+            log() << "Skipping io_uring transport layer test: " << ex.toStatus();
+            return;
+        }
+
+        ASSERT_OK(_tl->setup());
+        ASSERT_OK(_tl->start());
+        ASSERT_GT(_tl->listenerPort(), 0);
+
+        _reactor = _tl->getReactor(transport::TransportLayer::kIngress);
+        _reactorThread = stdx::thread([this] { _reactor->run(); });
+    }
+
+    ~UringFixture() {
+        if (!_tl) {
+            return;
+        }
+
+        _sep.endAllSessions({});
+        _tl->shutdown();
+        _reactor->stop();
+        _reactorThread.join();
+    }
+
+    bool supported() const {
+        return bool(_tl);
+    }
+
+    int port() const {
+        return _tl->listenerPort();
+    }
+
+    ServiceEntryPointUtil& sep() {
+        return _sep;
+    }
+
+private:
+    ServiceEntryPointUtil _sep;
+    std::unique_ptr<transport::TransportLayerUring> _tl;
+    transport::ReactorHandle _reactor;
+    stdx::thread _reactorThread;
+};
+
+Message makePing(int id) {
+    OpMsgBuilder builder;
+    builder.setBody(BSON("ping" << id));
+    Message msg = builder.finish();
+    msg.header().setResponseToMsgId(0);
+    msg.header().setId(id);
+    return msg;
+}
+
+TEST(TransportLayerUring, PortZeroConnect) {
+    UringFixture fixture;
+    if (!fixture.supported()) {
+        return;
+    }
+
+    Socket client;
+    SockAddr sa{"localhost", fixture.port(), AF_INET};
+    ASSERT_TRUE(client.connect(sa));
+
+    auto session = fixture.sep().waitForSession();
+    ASSERT_EQ(session->remote().port(), client.localAddr().getPort());
+    ASSERT_TRUE(session->isConnected());
+}
+
+TEST(TransportLayerUring, SourceAndSinkMessages) {
+    UringFixture fixture;
+    if (!fixture.supported()) {
+        return;
+    }
+
+    Socket client;
+    SockAddr sa{"localhost", fixture.port(), AF_INET};
+    ASSERT_TRUE(client.connect(sa));
+    auto session = fixture.sep().waitForSession();
+
+    // Send two messages back to back, splitting the first one across its header so the session
+    // has to reassemble it from separate receives.
+    auto first = makePing(1);
+    auto second = makePing(2);
+    client.send(first.buf(), 10, "first message header");
+    sleepmillis(10);
+    client.send(first.buf() + 10, first.size() - 10, "first message body");
+    client.send(second.buf(), second.size(), "second message");
+
+    for (auto&& expected : {first, second}) {
+        auto swMsg = session->asyncSourceMessage().getNoThrow();
+        ASSERT_OK(swMsg.getStatus());
+        auto& received = swMsg.getValue();
+        ASSERT_EQ(received.size(), expected.size());
+        ASSERT_EQ(memcmp(received.buf(), expected.buf(), expected.size()), 0);
+
+        ASSERT_OK(session->asyncSinkMessage(received).getNoThrow());
+
+        std::vector<char> echoed(expected.size());
+        client.recv(echoed.data(), echoed.size());
+        ASSERT_EQ(memcmp(echoed.data(), expected.buf(), expected.size()), 0);
+    }
+}
+
+TEST(TransportLayerUring, SourceFailsWhenPeerCloses) {
+    UringFixture fixture;
+    if (!fixture.supported()) {
+        return;
+    }
+
+    {
+        Socket client;
+        SockAddr sa{"localhost", fixture.port(), AF_INET};
+        ASSERT_TRUE(client.connect(sa));
+        fixture.sep().waitForSession();
+    }
+
+    auto session = fixture.sep().waitForSession();
+    ASSERT_NOT_OK(session->asyncSourceMessage().getNoThrow().getStatus());
+}
+
+TEST(TransportLayerUring, RejectsInvalidMessageLength) {
+    UringFixture fixture;
+    if (!fixture.supported()) {
+        return;
+    }
+
+    Socket client;
+    SockAddr sa{"localhost", fixture.port(), AF_INET};
+    ASSERT_TRUE(client.connect(sa));
+    auto session = fixture.sep().waitForSession();
+
+    auto msg = makePing(1);
+    msg.header().setLen(4);
+    client.send(msg.buf(), msg.size(), "invalid message");
+
+    ASSERT_EQ(session->asyncSourceMessage().getNoThrow().getStatus(), ErrorCodes::ProtocolError);
+}
+
+TEST(TransportLayerUring, KeepsWorkingWhenSubmissionQueueIsFull) {
+    // A ring this small cannot hold the receives of all the sessions at once, so requests have to
+    // wait for room in the submission queue, and completions overflow the completion queue.
+    const auto oldQueueDepth = transport::gIoUringTransportQueueDepth;
+    transport::gIoUringTransportQueueDepth = 1;
+    ON_BLOCK_EXIT([&] { transport::gIoUringTransportQueueDepth = oldQueueDepth; });
+
+    UringFixture fixture;
+    if (!fixture.supported()) {
+        return;
+    }
+
+    constexpr size_t kNumClients = 16;
+    std::vector<std::unique_ptr<Socket>> clients;
+    SockAddr sa{"localhost", fixture.port(), AF_INET};
+    for (size_t i = 0; i < kNumClients; ++i) {
+        clients.push_back(std::make_unique<Socket>());
+        ASSERT_TRUE(clients.back()->connect(sa));
+        fixture.sep().waitForSessions(i + 1);
+    }
+    auto sessions = fixture.sep().waitForSessions(kNumClients);
+
+    for (size_t i = 0; i < kNumClients; ++i) {
+        auto msg = makePing(i);
+        clients[i]->send(msg.buf(), msg.size(), "ping");
+    }
+
+    for (size_t i = 0; i < kNumClients; ++i) {
+        auto swMsg = sessions[i]->asyncSourceMessage().getNoThrow();
+        ASSERT_OK(swMsg.getStatus());
+        ASSERT_OK(sessions[i]->asyncSinkMessage(swMsg.getValue()).getNoThrow());
+
+        auto expected = makePing(i);
+        std::vector<char> echoed(expected.size());
+        clients[i]->recv(echoed.data(), echoed.size());
+        ASSERT_EQ(memcmp(echoed.data(), expected.buf(), expected.size()), 0);
+    }
+}
+
+TEST(TransportLayerUring, KeepsReceivingWhenProvidedBuffersRunOut) {
+    // With only two provided buffers, concurrent receives of large messages run out of buffers and
+    // have to wait for one to be recycled before they are armed again.
+    const auto oldProvidedBuffers = transport::gIoUringTransportProvidedBuffers;
+    const auto oldProvidedBufferSize = transport::gIoUringTransportProvidedBufferSizeBytes;
+    transport::gIoUringTransportProvidedBuffers = 2;
+    transport::gIoUringTransportProvidedBufferSizeBytes = 4096;
+    ON_BLOCK_EXIT([&] {
+        transport::gIoUringTransportProvidedBuffers = oldProvidedBuffers;
+        transport::gIoUringTransportProvidedBufferSizeBytes = oldProvidedBufferSize;
+    });
+
+    UringFixture fixture;
+    if (!fixture.supported()) {
+        return;
+    }
+
+    constexpr size_t kNumClients = 8;
+    std::vector<std::unique_ptr<Socket>> clients;
+    SockAddr sa{"localhost", fixture.port(), AF_INET};
+    for (size_t i = 0; i < kNumClients; ++i) {
+        clients.push_back(std::make_unique<Socket>());
+        ASSERT_TRUE(clients.back()->connect(sa));
+        fixture.sep().waitForSessions(i + 1);
+    }
+    auto sessions = fixture.sep().waitForSessions(kNumClients);
+
+    auto makeLargeMessage = [](int id) {
+        OpMsgBuilder builder;
+        builder.setBody(BSON("ping" << id << "payload" << std::string(256 * 1024, 'x')));
+        Message msg = builder.finish();
+        msg.header().setResponseToMsgId(0);
+        msg.header().setId(id);
+        return msg;
+    };
+
+    std::vector<stdx::thread> senders;
+    for (size_t i = 0; i < kNumClients; ++i) {
+        senders.emplace_back([&, i] {
+            auto msg = makeLargeMessage(i);
+            clients[i]->send(msg.buf(), msg.size(), "large message");
+        });
+    }
+    ON_BLOCK_EXIT([&] {
+        for (auto&& sender : senders) {
+            sender.join();
+        }
+    });
+
+    for (size_t i = 0; i < kNumClients; ++i) {
+        auto swMsg = sessions[i]->asyncSourceMessage().getNoThrow();
+        ASSERT_OK(swMsg.getStatus());
+
+        auto expected = makeLargeMessage(i);
+        ASSERT_EQ(swMsg.getValue().size(), expected.size());
+        ASSERT_EQ(memcmp(swMsg.getValue().buf(), expected.buf(), expected.size()), 0);
+    }
+}
+
+}  // namespace
+}  // namespace mongo
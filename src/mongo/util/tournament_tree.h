@@ -0,0 +1,153 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+/**
+ * A tournament (winner) tree over a fixed number of competitors, identified by their indexes
+ * [0, size()), for k-way merging. Each competitor is either entered, in which case it competes
+ * with the value it currently holds, or not, e.g. because its input is exhausted or not available
+ * yet.
+ *
+ * The tree does not hold the competitors' values itself. Instead 'Comparator' is a callable such
+ * that comp(lhs, rhs) is true if competitor 'lhs' must be taken before competitor 'rhs'. Whenever
+ * the value of a competitor changes, or it enters or leaves the tournament, update() must be
+ * called for it, which replays only the matches on its path to the root: that is log2(size())
+ * comparisons, against the roughly 2 * log2(size()) comparisons a binary heap needs to pop and
+ * push the same competitor. On ties, the competitor with the lower index wins.
+ *
+ * This structure is not thread safe.
+ */
+template <typename Comparator>
+class TournamentTree {
+public:
+    static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+    explicit TournamentTree(Comparator comp) : _comp(std::move(comp)) {}
+
+    /**
+     * Returns the number of competitors.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * Returns true if no competitor is entered.
+     */
+    bool empty() const {
+        return top() == kNone;
+    }
+
+    /**
+     * Returns the entered competitor which must be taken first, or kNone if there is none.
+     */
+    size_t top() const {
+        return _nodes.empty() ? kNone : _nodes[1];
+    }
+
+    /**
+     * Grows the tree to 'size' competitors. The new competitors are not entered.
+     */
+    void resize(size_t size) {
+        invariant(size >= _size);
+        _size = size;
+
+        size_t capacity = 1;
+        while (capacity < _size) {
+            capacity *= 2;
+        }
+
+        if (capacity * 2 == _nodes.size()) {
+            return;
+        }
+
+        // Re-seat the entered competitors at the leaves of the larger tree and replay every match.
+        std::vector<size_t> nodes(capacity * 2, kNone);
+        for (size_t i = 0; i < _capacity; ++i) {
+            nodes[capacity + i] = _nodes[_capacity + i];
+        }
+        _nodes = std::move(nodes);
+        _capacity = capacity;
+
+        for (size_t node = _capacity - 1; node > 0; --node) {
+            _nodes[node] = _winner(_nodes[2 * node], _nodes[2 * node + 1]);
+        }
+    }
+
+    /**
+     * Enters competitor 'index' into the tournament, or withdraws it if 'entered' is false, and
+     * replays its matches. Must also be called after the value of an entered competitor changed.
+     */
+    void update(size_t index, bool entered) {
+        invariant(index < _size);
+
+        size_t node = _capacity + index;
+        _nodes[node] = entered ? index : kNone;
+        for (node /= 2; node > 0; node /= 2) {
+            _nodes[node] = _winner(_nodes[2 * node], _nodes[2 * node + 1]);
+        }
+    }
+
+private:
+    size_t _winner(size_t left, size_t right) const {
+        if (left == kNone) {
+            return right;
+        }
+        if (right == kNone) {
+            return left;
+        }
+        // Every competitor on the left has a lower index than every competitor on the right, so
+        // the left one wins ties.
+        return _comp(right, left) ? right : left;
+    }
+
+    Comparator _comp;
+
+    // Number of competitors.
+    size_t _size{0};
+
+    // Number of leaves, the smallest power of two which is not less than '_size'.
+    size_t _capacity{0};
+
+    // Implicit complete binary tree: the root is at index 1, the children of node i are at 2i and
+    // 2i + 1, and the leaf of competitor i is at '_capacity' + i. Every node holds the winner of
+    // the matches in its subtree, or kNone if none of its competitors is entered.
+    std::vector<size_t> _nodes;
+};
+
+}  // namespace mongo
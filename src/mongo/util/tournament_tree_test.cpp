@@ -0,0 +1,167 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/tournament_tree.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+class TournamentTreeTest : public unittest::Test {
+protected:
+    using Tree = TournamentTree<std::function<bool(size_t, size_t)>>;
+
+    Tree makeTree() {
+        return Tree([this](size_t lhs, size_t rhs) { return values[lhs] < values[rhs]; });
+    }
+
+    std::vector<int> values;
+};
+
+TEST_F(TournamentTreeTest, EmptyTree) {
+    auto tree = makeTree();
+    ASSERT(tree.empty());
+    ASSERT_EQ(tree.top(), Tree::kNone);
+
+    tree.resize(5);
+    ASSERT_EQ(tree.size(), 5UL);
+    ASSERT(tree.empty());
+}
+
+TEST_F(TournamentTreeTest, SingleCompetitor) {
+    values = {7};
+    auto tree = makeTree();
+    tree.resize(1);
+
+    tree.update(0, true);
+    ASSERT_EQ(tree.top(), 0UL);
+
+    tree.update(0, false);
+    ASSERT(tree.empty());
+}
+
+TEST_F(TournamentTreeTest, TopFollowsUpdatedValues) {
+    values = {5, 3, 9};
+    auto tree = makeTree();
+    tree.resize(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        tree.update(i, true);
+    }
+    ASSERT_EQ(tree.top(), 1UL);
+
+    values[1] = 10;
+    tree.update(1, true);
+    ASSERT_EQ(tree.top(), 0UL);
+
+    tree.update(0, false);
+    ASSERT_EQ(tree.top(), 2UL);
+}
+
+TEST_F(TournamentTreeTest, LowerIndexWinsTies) {
+    values = {4, 4, 4, 4};
+    auto tree = makeTree();
+    tree.resize(values.size());
+    for (size_t i = values.size(); i-- > 0;) {
+        tree.update(i, true);
+    }
+    ASSERT_EQ(tree.top(), 0UL);
+
+    tree.update(0, false);
+    ASSERT_EQ(tree.top(), 1UL);
+}
+
+TEST_F(TournamentTreeTest, ResizeKeepsEnteredCompetitors) {
+    values = {8, 2, 6};
+    auto tree = makeTree();
+    tree.resize(values.size());
+    tree.update(0, true);
+    tree.update(2, true);
+    ASSERT_EQ(tree.top(), 2UL);
+
+    values.push_back(1);
+    values.push_back(0);
+    tree.resize(values.size());
+    ASSERT_EQ(tree.top(), 2UL);
+
+    tree.update(3, true);
+    ASSERT_EQ(tree.top(), 3UL);
+}
+
+TEST_F(TournamentTreeTest, MergesSortedRuns) {
+    const size_t kNumRuns = 13;
+    const int kRunLength = 50;
+
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<int> dist(0, 1000);
+
+    std::vector<std::vector<int>> runs(kNumRuns);
+    std::vector<int> expected;
+    for (auto& run : runs) {
+        for (int i = 0; i < kRunLength; ++i) {
+            run.push_back(dist(gen));
+        }
+        std::sort(run.begin(), run.end());
+        expected.insert(expected.end(), run.begin(), run.end());
+    }
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<size_t> positions(kNumRuns, 0);
+    values.resize(kNumRuns);
+    auto tree = makeTree();
+    tree.resize(kNumRuns);
+    for (size_t i = 0; i < kNumRuns; ++i) {
+        values[i] = runs[i][0];
+        tree.update(i, true);
+    }
+
+    std::vector<int> merged;
+    while (!tree.empty()) {
+        const auto run = tree.top();
+        merged.push_back(values[run]);
+
+        if (++positions[run] < runs[run].size()) {
+            values[run] = runs[run][positions[run]];
+            tree.update(run, true);
+        } else {
+            tree.update(run, false);
+        }
+    }
+
+    ASSERT(merged == expected);
+}
+
+}  // namespace
+}  // namespace mongo